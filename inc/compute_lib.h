@@ -120,6 +120,10 @@ typedef struct compute_lib_image2d_s {
     GLsizei width;
     /// 2D image height in pixels.
     GLsizei height;
+    /// Number of mip levels allocated by a single texture storage, level i has dimensions max(1, width >> i) x max(1, height >> i).
+    GLsizei levels;
+    /// Mip level bound to the image unit.
+    GLint level;
     /// Access type to be performed by shaders. Violations will lead to undefined results, possibly including program termination.
     /// Possible values: GL_READ_ONLY, GL_WRITE_ONLY, GL_READ_WRITE.
     GLenum access;
@@ -231,7 +235,7 @@ typedef struct compute_lib_uniform_s {
 /// \param num_components_ Number of components of the pixel, ranging from 1 (RED) to 4 (RGBA).
 /// \param type_ Data type of the pixel data.
 ///                Possible values: GL_UNSIGNED_BYTE, GL_BYTE, GL_UNSIGNED_SHORT, GL_SHORT, GL_UNSIGNED_INT, GL_INT, GL_HALF_FLOAT, GL_FLOAT, GL_UNSIGNED_SHORT_5_6_5, GL_UNSIGNED_SHORT_4_4_4_4, GL_UNSIGNED_SHORT_5_5_5_1, GL_UNSIGNED_INT_2_10_10_10_REV, GL_UNSIGNED_INT_10F_11F_11F_REV, GL_UNSIGNED_INT_5_9_9_9_REV, GL_UNSIGNED_INT_24_8, GL_FLOAT_32_UNSIGNED_INT_24_8_REV.
-#define COMPUTE_LIB_IMAGE2D_NEW(name_, texture_, width_, height_, access_, num_components_, type_) ((compute_lib_image2d_t) {.resource = COMPUTE_LIB_RESOURCE_NEW(name_, GL_IMAGE_2D), .texture = (texture_), .width = (width_), .height = (height_), .internal_format = 0, .compatibility_format = 0, .access = (access_), .texture_wrap = GL_CLAMP_TO_EDGE, .texture_filter = GL_LINEAR, .num_components = (num_components_), .format = 0, .type = (type_), .handle = 0, .data_size = 0, .px_size = 0, .framebuffer = COMPUTE_LIB_FRAMEBUFFER_NEW(0)})
+#define COMPUTE_LIB_IMAGE2D_NEW(name_, texture_, width_, height_, access_, num_components_, type_) ((compute_lib_image2d_t) {.resource = COMPUTE_LIB_RESOURCE_NEW(name_, GL_IMAGE_2D), .texture = (texture_), .width = (width_), .height = (height_), .levels = 1, .level = 0, .internal_format = 0, .compatibility_format = 0, .access = (access_), .texture_wrap = GL_CLAMP_TO_EDGE, .texture_filter = GL_LINEAR, .num_components = (num_components_), .format = 0, .type = (type_), .handle = 0, .data_size = 0, .px_size = 0, .framebuffer = COMPUTE_LIB_FRAMEBUFFER_NEW(0)})
 
 /// Macro for initialization of new GLES3ComputeLib shader storage buffer object (SSBO) instance.
 /// \param name_ String containing name of the SSBO as appears in the shader source.
@@ -315,7 +319,7 @@ GLuint compute_lib_program_print_resources(compute_lib_program_t* program, FILE*
 /// \return Allocated formatted string.
 GLchar* compute_lib_program_glsl_layout(compute_lib_program_t* program);
 
-/// Dispatches the compiled compute shader program.
+/// Dispatches the compiled compute shader program. Number of work groups is rounded up to cover the whole computation size.
 /// \param program Pointer to the GLES3ComputeLib program instance.
 /// \param size_x Size of the x-axis for parallel computation.
 /// \param size_y Size of the y-axis for parallel computation.
@@ -359,11 +363,40 @@ void compute_lib_image2d_setup_format(compute_lib_image2d_t* image2d);
 /// \return Number of captured OpenGL errors.
 GLuint compute_lib_image2d_init(compute_lib_image2d_t* image2d, GLenum framebuffer_attachment);
 
+/// Gets dimensions of the mip level of the 2D image.
+/// \param image2d Pointer to the GLES3ComputeLib 2D image instance.
+/// \param level Mip level of the 2D image.
+/// \param width Pointer to the level width in pixels.
+/// \param height Pointer to the level height in pixels.
+void compute_lib_image2d_level_size(compute_lib_image2d_t* image2d, GLint level, GLsizei* width, GLsizei* height);
+
 /// Formats GLSL 2D image layout string for the source.
 /// \param image2d Pointer to the GLES3ComputeLib 2D image instance.
 /// \return Allocated formatted string.
 GLchar* compute_lib_image2d_glsl_layout(compute_lib_image2d_t* image2d);
 
+/// Formats GLSL 2D sampler layout string for the source, the sampler is bound to the texture unit of the image.
+/// Read-only images declared this way are read by texelFetch or texture functions (texture cache, filtering and wrapping by the sampler).
+/// \param image2d Pointer to the GLES3ComputeLib 2D image instance.
+/// \return Allocated formatted string.
+GLchar* compute_lib_image2d_glsl_sampler_layout(compute_lib_image2d_t* image2d);
+
+/// Binds the 2D image to its image unit (resource value) again, e.g. after the unit was used by another program.
+/// \param image2d Pointer to the GLES3ComputeLib 2D image instance.
+/// \return Number of captured OpenGL errors.
+GLuint compute_lib_image2d_bind(compute_lib_image2d_t* image2d);
+
+/// Binds the mip level of the 2D image to its image unit (resource value), the level is kept for following binds.
+/// \param image2d Pointer to the GLES3ComputeLib 2D image instance.
+/// \param level Mip level of the 2D image.
+/// \return Number of captured OpenGL errors.
+GLuint compute_lib_image2d_bind_level(compute_lib_image2d_t* image2d, GLint level);
+
+/// Binds the 2D image texture to its texture unit to be read by a sampler.
+/// \param image2d Pointer to the GLES3ComputeLib 2D image instance.
+/// \return Number of captured OpenGL errors.
+GLuint compute_lib_image2d_bind_sampler(compute_lib_image2d_t* image2d);
+
 /// Destroys GLES3ComputeLib 2D image instance.
 /// \param image2d Pointer to the GLES3ComputeLib 2D image instance.
 /// \return Number of captured OpenGL errors.
@@ -391,12 +424,26 @@ GLuint compute_lib_image2d_reset_patch(compute_lib_image2d_t* image2d, void* px_
 /// \return Number of captured OpenGL errors.
 GLuint compute_lib_image2d_write(compute_lib_image2d_t* image2d, void* image_data);
 
+/// Writes the complete mip level of the 2D image (transfers from CPU to GPU).
+/// \param image2d Pointer to the GLES3ComputeLib 2D image instance.
+/// \param level Mip level of the 2D image.
+/// \param image_data Image data to be written. Number of available bytes must match the image format and level dimensions.
+/// \return Number of captured OpenGL errors.
+GLuint compute_lib_image2d_write_level(compute_lib_image2d_t* image2d, GLint level, void* image_data);
+
 /// Renders and reads the complete 2D image (transfers from GPU to CPU).
 /// \param image2d Pointer to the GLES3ComputeLib 2D image instance.
 /// \param image_data Image data to be read. Number of available bytes must match the image format and image dimensions.
 /// \return Number of captured OpenGL errors.
 GLuint compute_lib_image2d_read(compute_lib_image2d_t* image2d, void* image_data);
 
+/// Renders and reads the complete mip level of the 2D image (transfers from GPU to CPU).
+/// \param image2d Pointer to the GLES3ComputeLib 2D image instance.
+/// \param level Mip level of the 2D image.
+/// \param image_data Image data to be read. Number of available bytes must match the image format and level dimensions.
+/// \return Number of captured OpenGL errors.
+GLuint compute_lib_image2d_read_level(compute_lib_image2d_t* image2d, GLint level, void* image_data);
+
 /// Reads (and optionally renders at first) a patch of the 2D image (transfers from GPU to CPU).
 /// \param image2d Pointer to the GLES3ComputeLib 2D image instance.
 /// \param image_data Image data to be read. Number of available bytes must match the image format and patch dimensions.
@@ -460,6 +507,11 @@ GLuint compute_lib_ssbo_init(compute_lib_ssbo_t* ssbo, void* data, GLint len);
 /// \return Number of captured OpenGL errors.
 GLuint compute_lib_ssbo_destroy(compute_lib_ssbo_t* ssbo);
 
+/// Binds the SSBO to its binding point (resource value) again, e.g. after the binding point was used by another program.
+/// \param ssbo Pointer to the GLES3ComputeLib shader storage buffer object (SSBO) instance.
+/// \return Number of captured OpenGL errors.
+GLuint compute_lib_ssbo_bind(compute_lib_ssbo_t* ssbo);
+
 /// Formats GLSL SSBO layout string for the source.
 /// \param ssbo Pointer to the GLES3ComputeLib shader storage buffer object (SSBO) instance.
 /// \return Allocated formatted string.
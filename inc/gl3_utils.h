@@ -136,6 +136,11 @@ const GLchar* gl3_get_glsl_image2d_format_qualifier(GLenum compatibility_format)
 /// \return String containing variable type for GLSL source.
 const GLchar* gl3_get_glsl_image2d_type(GLenum compatibility_format);
 
+/// Gets GLSL sampler type string (sampler2D, usampler2D, isampler2D) based on the compatibility format.
+/// \param compatibility_format Compatibility format GL constant.
+/// \return String containing sampler type for GLSL source.
+const GLchar* gl3_get_glsl_sampler2d_type(GLenum compatibility_format);
+
 /// Gets GLSL access type string (readonly, writeonly or empty string).
 /// \param access Access type GL constant.
 /// \return String containing access type for GLSL source.
@@ -0,0 +1,240 @@
+/// \file background.h
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Header file of the GLES3ComputeLib library implementation of background subtraction (running Gaussian average, mixture of Gaussians) with the model kept on GPU.
+/// \copyright GNU Public License.
+
+#pragma once
+
+#ifndef GLES32COMPUTELIB_BACKGROUND_H
+#define GLES32COMPUTELIB_BACKGROUND_H
+
+#define _GNU_SOURCE // asprintf
+#include <stdio.h>
+
+#include "compute_lib.h"
+
+/// Maximum number of model images (Gaussian components of the mixture).
+#define COMPUTE_LIB_SHADERS_BACKGROUND_MAX_COMPONENTS 3
+
+extern char _binary_src_shaders_background_comp_start[];
+
+/// Enumeration of background models.
+enum compute_lib_shaders_background_method_e {
+    /// Running Gaussian average of RGB (mean of each channel, common variance).
+    COMPUTE_LIB_SHADERS_BACKGROUND_RUNNING_AVERAGE = 0,
+    /// Mixture of COMPUTE_LIB_SHADERS_BACKGROUND_MAX_COMPONENTS Gaussians of luma (Stauffer-Grimson).
+    COMPUTE_LIB_SHADERS_BACKGROUND_MOG = 1
+};
+
+/// Structure of the background subtraction instance.
+/// Model images stay on GPU, each frame reads the current model and writes the updated one (RGBA32F images cannot be read and written
+/// by the same program in GLES), then the model image handles are swapped. Work groups containing foreground pixels are optionally
+/// appended to the changed tiles SSBO through an atomic counter.
+typedef struct compute_lib_shaders_background_s {
+    compute_lib_program_t program;
+    /// Input RGBA8 frame.
+    compute_lib_image2d_t input_image2d;
+    /// Foreground mask (RGBA8), 255 at foreground pixels.
+    compute_lib_image2d_t mask_image2d;
+    /// Current model (RGBA32F), RGB mean and variance for the running average, weight, mean and variance of each component for the mixture
+    /// (components are sorted by weight / standard deviation).
+    compute_lib_image2d_t model_image2d[COMPUTE_LIB_SHADERS_BACKGROUND_MAX_COMPONENTS];
+    /// Model written by the next update.
+    compute_lib_image2d_t next_model_image2d[COMPUTE_LIB_SHADERS_BACKGROUND_MAX_COMPONENTS];
+    /// Changed tiles (pairs of (tile_y << 16) | tile_x and number of foreground pixels) in arbitrary order.
+    compute_lib_ssbo_t tiles_ssbo;
+    /// Number of changed tiles.
+    compute_lib_acbo_t tiles_acbo;
+    compute_lib_uniform_t initialize_uniform;
+    compute_lib_uniform_t learning_rate_uniform;
+    compute_lib_uniform_t threshold_uniform;
+    compute_lib_uniform_t initial_variance_uniform;
+    compute_lib_uniform_t min_variance_uniform;
+    compute_lib_uniform_t background_ratio_uniform;
+    /// Background model (compute_lib_shaders_background_method_e).
+    GLenum method;
+    int num_components;
+    /// Number of tiles (work groups) covering the frame, 0 if the changed tiles are not listed.
+    int max_tiles;
+    /// Variance of new model components (in squared 0-255 intensity units).
+    GLfloat initial_variance;
+    /// Lower bound of the model variances.
+    GLfloat min_variance;
+    /// Minimum total weight of the mixture components considered as background.
+    GLfloat background_ratio;
+    /// The next update initializes the model from the frame.
+    GLboolean initialize;
+} compute_lib_shaders_background_t;
+
+
+static inline void compute_lib_shaders_background_destroy(compute_lib_shaders_background_t* background)
+{
+    compute_lib_image2d_destroy(&(background->input_image2d));
+    compute_lib_image2d_destroy(&(background->mask_image2d));
+    for (int i = 0; i < background->num_components; i++) {
+        compute_lib_image2d_destroy(&(background->model_image2d[i]));
+        compute_lib_image2d_destroy(&(background->next_model_image2d[i]));
+    }
+    compute_lib_ssbo_destroy(&(background->tiles_ssbo));
+    compute_lib_acbo_destroy(&(background->tiles_acbo));
+    compute_lib_program_destroy(&(background->program), GL_TRUE);
+    free(background);
+}
+
+/// Initializes the background subtraction instance, the model is initialized from the first frame.
+/// \param method Background model (compute_lib_shaders_background_method_e).
+/// \param list_tiles Enables the list of changed tiles (work groups of local_size_x x local_size_y pixels).
+static inline compute_lib_shaders_background_t* compute_lib_shaders_background_init(compute_lib_instance_t* inst, int local_size_x, int local_size_y, int image_width, int image_height,
+        GLenum method, GLboolean list_tiles)
+{
+    int tiles_x = (image_width + local_size_x - 1) / local_size_x, tiles_y = (image_height + local_size_y - 1) / local_size_y;
+    if (method > COMPUTE_LIB_SHADERS_BACKGROUND_MOG || tiles_x > 65536 || tiles_y > 65536) {
+        return NULL;
+    }
+
+    compute_lib_shaders_background_t* background = (compute_lib_shaders_background_t*) malloc(sizeof(compute_lib_shaders_background_t));
+    background->method = method;
+    background->num_components = (method == COMPUTE_LIB_SHADERS_BACKGROUND_MOG) ? COMPUTE_LIB_SHADERS_BACKGROUND_MAX_COMPONENTS : 1;
+    background->max_tiles = list_tiles ? tiles_x * tiles_y : 0;
+    background->initial_variance = 225.0f;
+    background->min_variance = 16.0f;
+    background->background_ratio = 0.7f;
+    background->initialize = GL_TRUE;
+
+    background->input_image2d = COMPUTE_LIB_IMAGE2D_NEW("input_image2d", GL_TEXTURE0, image_width, image_height, GL_READ_ONLY, 4, GL_UNSIGNED_BYTE);
+    background->input_image2d.resource.value = 0;
+    compute_lib_image2d_setup_format(&(background->input_image2d));
+
+    background->mask_image2d = COMPUTE_LIB_IMAGE2D_NEW("mask_image2d", GL_TEXTURE1, image_width, image_height, GL_WRITE_ONLY, 4, GL_UNSIGNED_BYTE);
+    background->mask_image2d.resource.value = 1;
+    compute_lib_image2d_setup_format(&(background->mask_image2d));
+
+    // layouts of all components are declared, unused ones are never bound
+    static const GLchar* model_names[COMPUTE_LIB_SHADERS_BACKGROUND_MAX_COMPONENTS] = { "model0_image2d", "model1_image2d", "model2_image2d" };
+    static const GLchar* next_model_names[COMPUTE_LIB_SHADERS_BACKGROUND_MAX_COMPONENTS] = { "next_model0_image2d", "next_model1_image2d", "next_model2_image2d" };
+    for (int i = 0; i < COMPUTE_LIB_SHADERS_BACKGROUND_MAX_COMPONENTS; i++) {
+        background->model_image2d[i] = COMPUTE_LIB_IMAGE2D_NEW(model_names[i], GL_TEXTURE2 + i, image_width, image_height, GL_READ_ONLY, 4, GL_FLOAT);
+        background->model_image2d[i].resource.value = 2 + i;
+        compute_lib_image2d_setup_format(&(background->model_image2d[i]));
+        background->next_model_image2d[i] = COMPUTE_LIB_IMAGE2D_NEW(next_model_names[i], GL_TEXTURE2 + COMPUTE_LIB_SHADERS_BACKGROUND_MAX_COMPONENTS + i, image_width, image_height, GL_WRITE_ONLY, 4, GL_FLOAT);
+        background->next_model_image2d[i].resource.value = 2 + COMPUTE_LIB_SHADERS_BACKGROUND_MAX_COMPONENTS + i;
+        compute_lib_image2d_setup_format(&(background->next_model_image2d[i]));
+    }
+
+    background->tiles_ssbo = COMPUTE_LIB_SSBO_NEW("tiles_ssbo", GL_UNSIGNED_INT, GL_DYNAMIC_COPY);
+    background->tiles_ssbo.resource.value = 0;
+    background->tiles_acbo = COMPUTE_LIB_ACBO_NEW("tiles_counter", GL_UNSIGNED_INT, GL_DYNAMIC_COPY);
+    background->tiles_acbo.resource.value = 0;
+
+    background->program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+
+    GLchar* program_layout_str = compute_lib_program_glsl_layout(&(background->program));
+    GLchar* input_image2d_layout_str = compute_lib_image2d_glsl_layout(&(background->input_image2d));
+    GLchar* mask_image2d_layout_str = compute_lib_image2d_glsl_layout(&(background->mask_image2d));
+    GLchar* model_image2d_layout_str[COMPUTE_LIB_SHADERS_BACKGROUND_MAX_COMPONENTS];
+    GLchar* next_model_image2d_layout_str[COMPUTE_LIB_SHADERS_BACKGROUND_MAX_COMPONENTS];
+    for (int i = 0; i < COMPUTE_LIB_SHADERS_BACKGROUND_MAX_COMPONENTS; i++) {
+        model_image2d_layout_str[i] = compute_lib_image2d_glsl_layout(&(background->model_image2d[i]));
+        next_model_image2d_layout_str[i] = compute_lib_image2d_glsl_layout(&(background->next_model_image2d[i]));
+    }
+    GLchar* tiles_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(background->tiles_ssbo));
+    asprintf(&(background->program.source), _binary_src_shaders_background_comp_start, program_layout_str, input_image2d_layout_str, mask_image2d_layout_str,
+             model_image2d_layout_str[0], model_image2d_layout_str[1], model_image2d_layout_str[2], next_model_image2d_layout_str[0], next_model_image2d_layout_str[1], next_model_image2d_layout_str[2],
+             tiles_ssbo_layout_str, background->tiles_acbo.resource.value, method, background->max_tiles);
+    free(program_layout_str);
+    free(input_image2d_layout_str);
+    free(mask_image2d_layout_str);
+    for (int i = 0; i < COMPUTE_LIB_SHADERS_BACKGROUND_MAX_COMPONENTS; i++) {
+        free(model_image2d_layout_str[i]);
+        free(next_model_image2d_layout_str[i]);
+    }
+    free(tiles_ssbo_layout_str);
+
+    if (compute_lib_program_init(&(background->program)) != GL_NO_ERROR) {
+        compute_lib_shaders_background_destroy(background);
+        return NULL;
+    }
+
+    background->initialize_uniform = COMPUTE_LIB_UNIFORM_NEW("background_initialize");
+    background->learning_rate_uniform = COMPUTE_LIB_UNIFORM_NEW("background_learning_rate");
+    background->threshold_uniform = COMPUTE_LIB_UNIFORM_NEW("background_threshold");
+    background->initial_variance_uniform = COMPUTE_LIB_UNIFORM_NEW("background_initial_variance");
+    background->min_variance_uniform = COMPUTE_LIB_UNIFORM_NEW("background_min_variance");
+    background->background_ratio_uniform = COMPUTE_LIB_UNIFORM_NEW("background_ratio");
+    if (compute_lib_uniform_init(&(background->program), &(background->initialize_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(background->program), &(background->learning_rate_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(background->program), &(background->threshold_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(background->program), &(background->initial_variance_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(background->program), &(background->min_variance_uniform)) != GL_NO_ERROR ||
+            (method == COMPUTE_LIB_SHADERS_BACKGROUND_MOG && compute_lib_uniform_init(&(background->program), &(background->background_ratio_uniform)) != GL_NO_ERROR)) {
+        compute_lib_shaders_background_destroy(background);
+        return NULL;
+    }
+
+    GLuint errors_cnt = compute_lib_image2d_init(&(background->input_image2d), 0) + compute_lib_image2d_init(&(background->mask_image2d), GL_COLOR_ATTACHMENT0);
+    for (int i = 0; i < background->num_components; i++) {
+        errors_cnt += compute_lib_image2d_init(&(background->model_image2d[i]), GL_COLOR_ATTACHMENT0) + compute_lib_image2d_init(&(background->next_model_image2d[i]), GL_COLOR_ATTACHMENT0);
+    }
+    errors_cnt += compute_lib_ssbo_init(&(background->tiles_ssbo), NULL, 2 * ((background->max_tiles > 0) ? background->max_tiles : 1));
+    errors_cnt += compute_lib_acbo_init(&(background->tiles_acbo), NULL, 1);
+    if (errors_cnt != GL_NO_ERROR) {
+        compute_lib_shaders_background_destroy(background);
+        return NULL;
+    }
+
+    return background;
+}
+
+/// Classifies the input frame against the model, writes the foreground mask (and the changed tiles) and updates the model.
+/// \param learning_rate Weight of the frame in the model update (0 to 1).
+/// \param threshold Distance from the model mean classified as foreground (in standard deviations).
+static inline GLuint compute_lib_shaders_background_dispatch(compute_lib_shaders_background_t* background, GLfloat learning_rate, GLfloat threshold)
+{
+    GLuint initialize = background->initialize;
+    GLuint errors_cnt = compute_lib_uniform_write(&(background->program), &(background->initialize_uniform), &initialize);
+    errors_cnt += compute_lib_uniform_write(&(background->program), &(background->learning_rate_uniform), &learning_rate);
+    errors_cnt += compute_lib_uniform_write(&(background->program), &(background->threshold_uniform), &threshold);
+    errors_cnt += compute_lib_uniform_write(&(background->program), &(background->initial_variance_uniform), &(background->initial_variance));
+    errors_cnt += compute_lib_uniform_write(&(background->program), &(background->min_variance_uniform), &(background->min_variance));
+    if (background->method == COMPUTE_LIB_SHADERS_BACKGROUND_MOG) {
+        errors_cnt += compute_lib_uniform_write(&(background->program), &(background->background_ratio_uniform), &(background->background_ratio));
+    }
+
+    errors_cnt += compute_lib_image2d_bind(&(background->input_image2d)) + compute_lib_image2d_bind(&(background->mask_image2d));
+    for (int i = 0; i < background->num_components; i++) {
+        errors_cnt += compute_lib_image2d_bind(&(background->model_image2d[i])) + compute_lib_image2d_bind(&(background->next_model_image2d[i]));
+    }
+    if (background->max_tiles > 0) {
+        errors_cnt += compute_lib_acbo_write_uint_val(&(background->tiles_acbo), 0);
+        errors_cnt += compute_lib_ssbo_bind(&(background->tiles_ssbo));
+    }
+    errors_cnt += compute_lib_program_dispatch(&(background->program), background->input_image2d.width, background->input_image2d.height, 1);
+
+    // updated model becomes the current one
+    for (int i = 0; i < background->num_components; i++) {
+        GLuint handle = background->model_image2d[i].handle;
+        background->model_image2d[i].handle = background->next_model_image2d[i].handle;
+        background->next_model_image2d[i].handle = handle;
+    }
+    background->initialize = GL_FALSE;
+    return errors_cnt;
+}
+
+/// Reads the list of changed tiles of the last dispatch.
+/// \param tiles Output array of at least 2 * max_tiles entries (pairs of (tile_y << 16) | tile_x and number of foreground pixels).
+/// \param num_tiles Output number of changed tiles.
+static inline GLuint compute_lib_shaders_background_read_tiles(compute_lib_shaders_background_t* background, GLuint* tiles, GLuint* num_tiles)
+{
+    *num_tiles = 0;
+    if (background->max_tiles == 0) {
+        return GL_NO_ERROR;
+    }
+    GLuint errors_cnt = compute_lib_acbo_read_uint_val(&(background->tiles_acbo), num_tiles);
+    if (*num_tiles > 0 && errors_cnt == GL_NO_ERROR) {
+        errors_cnt += compute_lib_ssbo_read(&(background->tiles_ssbo), tiles, 2 * (*num_tiles));
+    }
+    return errors_cnt;
+}
+
+#endif // GLES32COMPUTELIB_BACKGROUND_H
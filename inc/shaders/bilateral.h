@@ -0,0 +1,168 @@
+/// \file bilateral.h
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Header file of the GLES3ComputeLib library implementation of the bilateral filter (shared-memory tiles, spatial and range weight lookup tables) of RGBA8 and RGBA32F images.
+/// \copyright GNU Public License.
+
+#pragma once
+
+#ifndef GLES32COMPUTELIB_BILATERAL_H
+#define GLES32COMPUTELIB_BILATERAL_H
+
+#define _GNU_SOURCE // asprintf
+#include <math.h>
+#include <stdio.h>
+
+#include "compute_lib.h"
+
+/// Number of range weights of float images, the table is linearly interpolated.
+#ifndef COMPUTE_LIB_SHADERS_BILATERAL_FLOAT_RANGE_LUT_SIZE
+#define COMPUTE_LIB_SHADERS_BILATERAL_FLOAT_RANGE_LUT_SIZE 1024
+#endif
+/// Range distance covered by the range weights of float images (in multiples of sigma_range), larger distances get the last weight.
+#define COMPUTE_LIB_SHADERS_BILATERAL_FLOAT_RANGE_SIGMAS 6.0f
+
+extern char _binary_src_shaders_bilateral_comp_start[];
+
+/// Structure of the bilateral filter instance.
+/// RGB channels are filtered with common weights, the range distance is the sum of absolute channel differences (L1),
+/// alpha channel is copied from the input. Pixels outside of the image replicate the border.
+/// Weights are stored in a single SSBO: (2*radius+1)^2 spatial weights followed by the range weights
+/// (one per integer distance 0..765 for RGBA8 images, COMPUTE_LIB_SHADERS_BILATERAL_FLOAT_RANGE_LUT_SIZE samples for RGBA32F images).
+typedef struct compute_lib_shaders_bilateral_s {
+    compute_lib_program_t program;
+    compute_lib_image2d_t input_image2d;
+    compute_lib_image2d_t output_image2d;
+    compute_lib_ssbo_t weights_ssbo;
+    /// Range weights per unit of distance (float images only).
+    compute_lib_uniform_t range_scale_uniform;
+    /// Pixel component type, GL_UNSIGNED_BYTE (RGBA8) or GL_FLOAT (RGBA32F).
+    GLenum type;
+    int radius;
+    int range_lut_size;
+    GLfloat range_scale;
+} compute_lib_shaders_bilateral_t;
+
+
+static inline void compute_lib_shaders_bilateral_destroy(compute_lib_shaders_bilateral_t* bilateral)
+{
+    compute_lib_image2d_destroy(&(bilateral->input_image2d));
+    compute_lib_image2d_destroy(&(bilateral->output_image2d));
+    compute_lib_ssbo_destroy(&(bilateral->weights_ssbo));
+    compute_lib_program_destroy(&(bilateral->program), GL_TRUE);
+    free(bilateral);
+}
+
+/// Computes Gaussian spatial and range weights of the filter.
+/// \param weights Output array of (2*radius+1)^2 + range_lut_size elements.
+static inline void compute_lib_shaders_bilateral_weights(compute_lib_shaders_bilateral_t* bilateral, GLfloat sigma_spatial, GLfloat sigma_range, GLfloat* weights)
+{
+    int window_size = 2 * bilateral->radius + 1;
+    for (int y = 0; y < window_size; y++) {
+        for (int x = 0; x < window_size; x++) {
+            float dx = x - bilateral->radius, dy = y - bilateral->radius;
+            weights[y * window_size + x] = expf(-(dx * dx + dy * dy) / (2.0f * sigma_spatial * sigma_spatial));
+        }
+    }
+    GLfloat* range_weights = weights + window_size * window_size;
+    for (int i = 0; i < bilateral->range_lut_size; i++) {
+        float distance = i / bilateral->range_scale;
+        range_weights[i] = expf(-(distance * distance) / (2.0f * sigma_range * sigma_range));
+    }
+}
+
+/// Updates spatial and range standard deviations of the filter (rewrites the weights).
+/// \param sigma_spatial Spatial standard deviation in pixels.
+/// \param sigma_range Range standard deviation in pixel value units (0-255 for RGBA8 images).
+static inline GLuint compute_lib_shaders_bilateral_set_sigmas(compute_lib_shaders_bilateral_t* bilateral, GLfloat sigma_spatial, GLfloat sigma_range)
+{
+    int window_size = 2 * bilateral->radius + 1;
+    if (bilateral->type == GL_FLOAT) {
+        bilateral->range_scale = (bilateral->range_lut_size - 1) / (COMPUTE_LIB_SHADERS_BILATERAL_FLOAT_RANGE_SIGMAS * sigma_range);
+    }
+    GLfloat* weights = (GLfloat*) malloc((window_size * window_size + bilateral->range_lut_size) * sizeof(GLfloat));
+    compute_lib_shaders_bilateral_weights(bilateral, sigma_spatial, sigma_range, weights);
+    GLuint errors_cnt = compute_lib_ssbo_write(&(bilateral->weights_ssbo), weights, window_size * window_size + bilateral->range_lut_size);
+    free(weights);
+    return errors_cnt;
+}
+
+/// Initializes the bilateral filter instance.
+/// \param type Pixel component type, GL_UNSIGNED_BYTE (RGBA8) or GL_FLOAT (RGBA32F).
+/// \param radius Half-size of the square window, the input tile of a work group (local_size + 2*radius)^2 has to fit into 16 kB of shared memory.
+/// \param sigma_spatial Spatial standard deviation in pixels.
+/// \param sigma_range Range standard deviation in pixel value units (0-255 for RGBA8 images).
+static inline compute_lib_shaders_bilateral_t* compute_lib_shaders_bilateral_init(compute_lib_instance_t* inst, int local_size_x, int local_size_y, int image_width, int image_height,
+        GLenum type, int radius, GLfloat sigma_spatial, GLfloat sigma_range)
+{
+    // tile pixels are packed into a single word (RGBA8) or stored as three floats (RGBA32F)
+    int tile_bytes = (local_size_x + 2 * radius) * (local_size_y + 2 * radius) * ((type == GL_FLOAT) ? 12 : 4);
+    if ((type != GL_UNSIGNED_BYTE && type != GL_FLOAT) || radius < 1 || tile_bytes > 16384 || sigma_spatial <= 0.0f || sigma_range <= 0.0f) {
+        return NULL;
+    }
+
+    compute_lib_shaders_bilateral_t* bilateral = (compute_lib_shaders_bilateral_t*) malloc(sizeof(compute_lib_shaders_bilateral_t));
+    bilateral->type = type;
+    bilateral->radius = radius;
+    bilateral->range_lut_size = (type == GL_FLOAT) ? COMPUTE_LIB_SHADERS_BILATERAL_FLOAT_RANGE_LUT_SIZE : 3 * 255 + 1;
+    bilateral->range_scale = 1.0f;
+
+    bilateral->input_image2d = COMPUTE_LIB_IMAGE2D_NEW("input_image2d", GL_TEXTURE0, image_width, image_height, GL_READ_ONLY, 4, type);
+    bilateral->input_image2d.resource.value = 0;
+    compute_lib_image2d_setup_format(&(bilateral->input_image2d));
+
+    bilateral->output_image2d = COMPUTE_LIB_IMAGE2D_NEW("output_image2d", GL_TEXTURE1, image_width, image_height, GL_WRITE_ONLY, 4, type);
+    bilateral->output_image2d.resource.value = 1;
+    compute_lib_image2d_setup_format(&(bilateral->output_image2d));
+
+    bilateral->weights_ssbo = COMPUTE_LIB_SSBO_NEW("weights_ssbo", GL_FLOAT, GL_STATIC_READ);
+    bilateral->weights_ssbo.resource.value = 2;
+
+    bilateral->program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+
+    GLchar* program_layout_str = compute_lib_program_glsl_layout(&(bilateral->program));
+    GLchar* input_image2d_layout_str = compute_lib_image2d_glsl_layout(&(bilateral->input_image2d));
+    GLchar* output_image2d_layout_str = compute_lib_image2d_glsl_layout(&(bilateral->output_image2d));
+    GLchar* weights_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(bilateral->weights_ssbo));
+    asprintf(&(bilateral->program.source), _binary_src_shaders_bilateral_comp_start, program_layout_str, input_image2d_layout_str, output_image2d_layout_str, weights_ssbo_layout_str,
+             radius, bilateral->range_lut_size, type == GL_FLOAT);
+    free(program_layout_str);
+    free(input_image2d_layout_str);
+    free(output_image2d_layout_str);
+    free(weights_ssbo_layout_str);
+
+    if (compute_lib_program_init(&(bilateral->program)) != GL_NO_ERROR) {
+        compute_lib_shaders_bilateral_destroy(bilateral);
+        return NULL;
+    }
+
+    bilateral->range_scale_uniform = COMPUTE_LIB_UNIFORM_NEW("bilateral_range_scale");
+    if (type == GL_FLOAT && compute_lib_uniform_init(&(bilateral->program), &(bilateral->range_scale_uniform)) != GL_NO_ERROR) {
+        compute_lib_shaders_bilateral_destroy(bilateral);
+        return NULL;
+    }
+
+    if (compute_lib_image2d_init(&(bilateral->input_image2d), 0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(bilateral->output_image2d), GL_COLOR_ATTACHMENT0) != GL_NO_ERROR ||
+            compute_lib_ssbo_init(&(bilateral->weights_ssbo), NULL, 0) != GL_NO_ERROR ||
+            compute_lib_shaders_bilateral_set_sigmas(bilateral, sigma_spatial, sigma_range) != GL_NO_ERROR) {
+        compute_lib_shaders_bilateral_destroy(bilateral);
+        return NULL;
+    }
+
+    return bilateral;
+}
+
+/// Filters the input image into the output image.
+static inline GLuint compute_lib_shaders_bilateral_dispatch(compute_lib_shaders_bilateral_t* bilateral)
+{
+    GLuint errors_cnt = compute_lib_image2d_bind(&(bilateral->input_image2d)) + compute_lib_image2d_bind(&(bilateral->output_image2d));
+    errors_cnt += compute_lib_ssbo_bind(&(bilateral->weights_ssbo));
+    if (bilateral->type == GL_FLOAT) {
+        errors_cnt += compute_lib_uniform_write(&(bilateral->program), &(bilateral->range_scale_uniform), &(bilateral->range_scale));
+    }
+    errors_cnt += compute_lib_program_dispatch(&(bilateral->program), bilateral->output_image2d.width, bilateral->output_image2d.height, 1);
+    return errors_cnt;
+}
+
+#endif // GLES32COMPUTELIB_BILATERAL_H
@@ -0,0 +1,239 @@
+/// \file canny.h
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Header file of the GLES3ComputeLib library implementation of Sobel gradients and Canny edge detection with hysteresis on GPU.
+/// \copyright GNU Public License.
+
+#pragma once
+
+#ifndef GLES32COMPUTELIB_CANNY_H
+#define GLES32COMPUTELIB_CANNY_H
+
+#define _GNU_SOURCE // asprintf
+#include <stdio.h>
+
+#include "compute_lib.h"
+
+/// Safety cap of hysteresis iterations of a single dispatch. Every iteration that changes the state promotes at least one weak pixel,
+/// so the loop always terminates, but a weak chain may cross tile boundaries many times (e.g. a spiral), each crossing costs one iteration.
+#ifndef COMPUTE_LIB_SHADERS_CANNY_MAX_ITERATIONS
+#define COMPUTE_LIB_SHADERS_CANNY_MAX_ITERATIONS 65536
+#endif
+
+extern char _binary_src_shaders_canny_gradient_comp_start[];
+extern char _binary_src_shaders_canny_nms_comp_start[];
+extern char _binary_src_shaders_canny_hysteresis_comp_start[];
+extern char _binary_src_shaders_canny_output_comp_start[];
+
+/// Structure of the Canny edge detector instance.
+/// All passes run on GPU, hysteresis is repeated until the atomic counter of changed work groups stays zero.
+typedef struct compute_lib_shaders_canny_s {
+    compute_lib_program_t gradient_program;
+    compute_lib_program_t nms_program;
+    compute_lib_program_t hysteresis_program;
+    compute_lib_program_t output_program;
+    /// Input RGBA8 image (luma is processed).
+    compute_lib_image2d_t input_image2d;
+    /// Sobel gradient (RGBA32F), components are x and y derivatives, magnitude and direction sector (0 to 3).
+    compute_lib_image2d_t gradient_image2d;
+    /// Pixel states (R32UI), 0 none, 1 weak edge, 2 strong edge.
+    compute_lib_image2d_t state_image2d;
+    /// Output edge map (RGBA8), 255 at edge pixels.
+    compute_lib_image2d_t output_image2d;
+    /// List of edge pixels ((y << 16) | x) in arbitrary order.
+    compute_lib_ssbo_t edges_ssbo;
+    /// Number of work groups changed by the last hysteresis iteration.
+    compute_lib_acbo_t changed_acbo;
+    /// Number of edge pixels (including those exceeding the capacity of the list).
+    compute_lib_acbo_t edges_acbo;
+    compute_lib_uniform_t low_threshold_uniform;
+    compute_lib_uniform_t high_threshold_uniform;
+    /// Capacity of the edge pixel list, 0 if the list is not produced.
+    int max_edge_pixels;
+    /// Number of hysteresis iterations of the last dispatch.
+    int iterations;
+} compute_lib_shaders_canny_t;
+
+
+static inline void compute_lib_shaders_canny_destroy(compute_lib_shaders_canny_t* canny)
+{
+    compute_lib_image2d_destroy(&(canny->input_image2d));
+    compute_lib_image2d_destroy(&(canny->gradient_image2d));
+    compute_lib_image2d_destroy(&(canny->state_image2d));
+    compute_lib_image2d_destroy(&(canny->output_image2d));
+    compute_lib_ssbo_destroy(&(canny->edges_ssbo));
+    compute_lib_acbo_destroy(&(canny->changed_acbo));
+    compute_lib_acbo_destroy(&(canny->edges_acbo));
+    compute_lib_program_destroy(&(canny->gradient_program), GL_TRUE);
+    compute_lib_program_destroy(&(canny->nms_program), GL_TRUE);
+    compute_lib_program_destroy(&(canny->hysteresis_program), GL_TRUE);
+    compute_lib_program_destroy(&(canny->output_program), GL_TRUE);
+    free(canny);
+}
+
+/// Initializes the Canny edge detector instance.
+/// \param max_edge_pixels Capacity of the edge pixel list, 0 to produce the edge map only.
+static inline compute_lib_shaders_canny_t* compute_lib_shaders_canny_init(compute_lib_instance_t* inst, int local_size_x, int local_size_y, int image_width, int image_height, int max_edge_pixels)
+{
+    if (max_edge_pixels < 0 || image_width > 65536 || image_height > 65536) {
+        return NULL;
+    }
+
+    compute_lib_shaders_canny_t* canny = (compute_lib_shaders_canny_t*) malloc(sizeof(compute_lib_shaders_canny_t));
+    canny->max_edge_pixels = max_edge_pixels;
+    canny->iterations = 0;
+
+    canny->input_image2d = COMPUTE_LIB_IMAGE2D_NEW("input_image2d", GL_TEXTURE0, image_width, image_height, GL_READ_ONLY, 4, GL_UNSIGNED_BYTE);
+    canny->input_image2d.resource.value = 0;
+    compute_lib_image2d_setup_format(&(canny->input_image2d));
+
+    canny->gradient_image2d = COMPUTE_LIB_IMAGE2D_NEW("gradient_image2d", GL_TEXTURE1, image_width, image_height, GL_WRITE_ONLY, 4, GL_FLOAT);
+    canny->gradient_image2d.resource.value = 1;
+    compute_lib_image2d_setup_format(&(canny->gradient_image2d));
+
+    canny->state_image2d = COMPUTE_LIB_IMAGE2D_NEW("state_image2d", GL_TEXTURE2, image_width, image_height, GL_READ_WRITE, 1, GL_UNSIGNED_INT);
+    canny->state_image2d.resource.value = 2;
+    compute_lib_image2d_setup_format(&(canny->state_image2d));
+
+    canny->output_image2d = COMPUTE_LIB_IMAGE2D_NEW("output_image2d", GL_TEXTURE3, image_width, image_height, GL_WRITE_ONLY, 4, GL_UNSIGNED_BYTE);
+    canny->output_image2d.resource.value = 3;
+    compute_lib_image2d_setup_format(&(canny->output_image2d));
+
+    canny->edges_ssbo = COMPUTE_LIB_SSBO_NEW("edges_ssbo", GL_UNSIGNED_INT, GL_DYNAMIC_COPY);
+    canny->edges_ssbo.resource.value = 0;
+    canny->changed_acbo = COMPUTE_LIB_ACBO_NEW("changed_counter", GL_UNSIGNED_INT, GL_DYNAMIC_COPY);
+    canny->changed_acbo.resource.value = 0;
+    canny->edges_acbo = COMPUTE_LIB_ACBO_NEW("edges_counter", GL_UNSIGNED_INT, GL_DYNAMIC_COPY);
+    canny->edges_acbo.resource.value = 1;
+
+    canny->gradient_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+    canny->nms_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+    canny->hysteresis_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+    canny->output_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+
+    // gradient image is read by the suppression pass, states are written by it and read by the output pass
+    compute_lib_image2d_t gradient_input_image2d = canny->gradient_image2d;
+    gradient_input_image2d.access = GL_READ_ONLY;
+    compute_lib_image2d_t state_output_image2d = canny->state_image2d;
+    state_output_image2d.access = GL_WRITE_ONLY;
+    compute_lib_image2d_t state_input_image2d = canny->state_image2d;
+    state_input_image2d.access = GL_READ_ONLY;
+
+    GLchar* program_layout_str = compute_lib_program_glsl_layout(&(canny->gradient_program));
+    GLchar* input_image2d_layout_str = compute_lib_image2d_glsl_layout(&(canny->input_image2d));
+    GLchar* gradient_image2d_layout_str = compute_lib_image2d_glsl_layout(&(canny->gradient_image2d));
+    GLchar* gradient_input_image2d_layout_str = compute_lib_image2d_glsl_layout(&gradient_input_image2d);
+    GLchar* state_image2d_layout_str = compute_lib_image2d_glsl_layout(&(canny->state_image2d));
+    GLchar* state_output_image2d_layout_str = compute_lib_image2d_glsl_layout(&state_output_image2d);
+    GLchar* state_input_image2d_layout_str = compute_lib_image2d_glsl_layout(&state_input_image2d);
+    GLchar* output_image2d_layout_str = compute_lib_image2d_glsl_layout(&(canny->output_image2d));
+    GLchar* edges_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(canny->edges_ssbo));
+    asprintf(&(canny->gradient_program.source), _binary_src_shaders_canny_gradient_comp_start, program_layout_str, input_image2d_layout_str, gradient_image2d_layout_str);
+    asprintf(&(canny->nms_program.source), _binary_src_shaders_canny_nms_comp_start, program_layout_str, gradient_input_image2d_layout_str, state_output_image2d_layout_str);
+    asprintf(&(canny->hysteresis_program.source), _binary_src_shaders_canny_hysteresis_comp_start, program_layout_str, state_image2d_layout_str, canny->changed_acbo.resource.value);
+    asprintf(&(canny->output_program.source), _binary_src_shaders_canny_output_comp_start, program_layout_str, state_input_image2d_layout_str, output_image2d_layout_str, edges_ssbo_layout_str,
+             canny->edges_acbo.resource.value, max_edge_pixels);
+    free(program_layout_str);
+    free(input_image2d_layout_str);
+    free(gradient_image2d_layout_str);
+    free(gradient_input_image2d_layout_str);
+    free(state_image2d_layout_str);
+    free(state_output_image2d_layout_str);
+    free(state_input_image2d_layout_str);
+    free(output_image2d_layout_str);
+    free(edges_ssbo_layout_str);
+
+    if (compute_lib_program_init(&(canny->gradient_program)) != GL_NO_ERROR ||
+            compute_lib_program_init(&(canny->nms_program)) != GL_NO_ERROR ||
+            compute_lib_program_init(&(canny->hysteresis_program)) != GL_NO_ERROR ||
+            compute_lib_program_init(&(canny->output_program)) != GL_NO_ERROR) {
+        compute_lib_shaders_canny_destroy(canny);
+        return NULL;
+    }
+
+    canny->low_threshold_uniform = COMPUTE_LIB_UNIFORM_NEW("canny_low_threshold");
+    canny->high_threshold_uniform = COMPUTE_LIB_UNIFORM_NEW("canny_high_threshold");
+    if (compute_lib_uniform_init(&(canny->nms_program), &(canny->low_threshold_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(canny->nms_program), &(canny->high_threshold_uniform)) != GL_NO_ERROR) {
+        compute_lib_shaders_canny_destroy(canny);
+        return NULL;
+    }
+
+    if (compute_lib_image2d_init(&(canny->input_image2d), 0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(canny->gradient_image2d), GL_COLOR_ATTACHMENT0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(canny->state_image2d), GL_COLOR_ATTACHMENT0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(canny->output_image2d), GL_COLOR_ATTACHMENT0) != GL_NO_ERROR ||
+            compute_lib_ssbo_init(&(canny->edges_ssbo), NULL, (max_edge_pixels > 0) ? max_edge_pixels : 1) != GL_NO_ERROR ||
+            compute_lib_acbo_init(&(canny->changed_acbo), NULL, 1) != GL_NO_ERROR ||
+            compute_lib_acbo_init(&(canny->edges_acbo), NULL, 1) != GL_NO_ERROR) {
+        compute_lib_shaders_canny_destroy(canny);
+        return NULL;
+    }
+
+    return canny;
+}
+
+/// Computes the Sobel gradient image only.
+static inline GLuint compute_lib_shaders_canny_gradient(compute_lib_shaders_canny_t* canny)
+{
+    GLuint errors_cnt = compute_lib_image2d_bind(&(canny->input_image2d)) + compute_lib_image2d_bind(&(canny->gradient_image2d));
+    errors_cnt += compute_lib_program_dispatch(&(canny->gradient_program), canny->input_image2d.width, canny->input_image2d.height, 1);
+    return errors_cnt;
+}
+
+/// Detects edges of the input image into the output edge map (and the edge pixel list), only the hysteresis counter is read back after each iteration.
+/// Hysteresis that does not converge within COMPUTE_LIB_SHADERS_CANNY_MAX_ITERATIONS is counted as an error (the output contains the incomplete edges).
+/// \param low_threshold Gradient magnitude of weak edge pixels (Sobel of luma in 0-255).
+/// \param high_threshold Gradient magnitude of strong edge pixels.
+static inline GLuint compute_lib_shaders_canny_dispatch(compute_lib_shaders_canny_t* canny, GLfloat low_threshold, GLfloat high_threshold)
+{
+    int width = canny->input_image2d.width, height = canny->input_image2d.height;
+    GLuint errors_cnt = compute_lib_shaders_canny_gradient(canny);
+
+    compute_lib_image2d_t gradient_input_image2d = canny->gradient_image2d;
+    gradient_input_image2d.access = GL_READ_ONLY;
+    compute_lib_image2d_t state_output_image2d = canny->state_image2d;
+    state_output_image2d.access = GL_WRITE_ONLY;
+    errors_cnt += compute_lib_uniform_write(&(canny->nms_program), &(canny->low_threshold_uniform), &low_threshold);
+    errors_cnt += compute_lib_uniform_write(&(canny->nms_program), &(canny->high_threshold_uniform), &high_threshold);
+    errors_cnt += compute_lib_image2d_bind(&gradient_input_image2d) + compute_lib_image2d_bind(&state_output_image2d);
+    errors_cnt += compute_lib_program_dispatch(&(canny->nms_program), width, height, 1);
+
+    // each iteration propagates strong edges through whole work group tiles, repeated until no work group changes
+    GLuint changed = 1;
+    errors_cnt += compute_lib_image2d_bind(&(canny->state_image2d));
+    for (canny->iterations = 0; changed != 0 && canny->iterations < COMPUTE_LIB_SHADERS_CANNY_MAX_ITERATIONS && errors_cnt == GL_NO_ERROR; canny->iterations++) {
+        errors_cnt += compute_lib_acbo_write_uint_val(&(canny->changed_acbo), 0);
+        errors_cnt += compute_lib_program_dispatch(&(canny->hysteresis_program), width, height, 1);
+        errors_cnt += compute_lib_acbo_read_uint_val(&(canny->changed_acbo), &changed);
+    }
+    errors_cnt += (changed != 0);
+
+    compute_lib_image2d_t state_input_image2d = canny->state_image2d;
+    state_input_image2d.access = GL_READ_ONLY;
+    errors_cnt += compute_lib_acbo_write_uint_val(&(canny->edges_acbo), 0);
+    errors_cnt += compute_lib_ssbo_bind(&(canny->edges_ssbo));
+    errors_cnt += compute_lib_image2d_bind(&state_input_image2d) + compute_lib_image2d_bind(&(canny->output_image2d));
+    errors_cnt += compute_lib_program_dispatch(&(canny->output_program), width, height, 1);
+    return errors_cnt;
+}
+
+/// Reads the edge pixel list.
+/// \param pixels Output array of at least max_edge_pixels entries ((y << 16) | x).
+/// \param num_pixels Output number of entries written.
+/// \param total_pixels Output number of edge pixels (may exceed the capacity), NULL if not needed.
+static inline GLuint compute_lib_shaders_canny_read_edges(compute_lib_shaders_canny_t* canny, GLuint* pixels, GLuint* num_pixels, GLuint* total_pixels)
+{
+    GLuint total;
+    GLuint errors_cnt = compute_lib_acbo_read_uint_val(&(canny->edges_acbo), &total);
+    *num_pixels = (total < (GLuint) canny->max_edge_pixels) ? total : (GLuint) canny->max_edge_pixels;
+    if (total_pixels != NULL) {
+        *total_pixels = total;
+    }
+    if (*num_pixels > 0 && errors_cnt == GL_NO_ERROR) {
+        errors_cnt += compute_lib_ssbo_read(&(canny->edges_ssbo), pixels, *num_pixels);
+    }
+    return errors_cnt;
+}
+
+#endif // GLES32COMPUTELIB_CANNY_H
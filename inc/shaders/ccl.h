@@ -0,0 +1,210 @@
+/// \file ccl.h
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Header file of the GLES3ComputeLib library implementation of connected-component labelling with per-component statistics (area, bounding box, moments).
+/// \copyright GNU Public License.
+
+#pragma once
+
+#ifndef GLES32COMPUTELIB_CCL_H
+#define GLES32COMPUTELIB_CCL_H
+
+#define _GNU_SOURCE // asprintf
+#include <stdio.h>
+
+#include "compute_lib.h"
+
+/// Number of uint words of a component entry in the component table.
+#define COMPUTE_LIB_SHADERS_CCL_COMPONENT_STRIDE 16
+/// Number of pixels of a row processed by one invocation of the statistics pass.
+#define COMPUTE_LIB_SHADERS_CCL_SEGMENT_LENGTH 32
+/// Maximum image dimension (sums of a row segment must fit 32 bits).
+#define COMPUTE_LIB_SHADERS_CCL_MAX_SIZE 4096
+
+extern char _binary_src_shaders_ccl_comp_start[];
+
+/// Enumeration of passes of the labelling.
+enum compute_lib_shaders_ccl_pass_e {
+    /// Foreground pixels are labelled by their own index.
+    COMPUTE_LIB_SHADERS_CCL_PASS_INIT = 0,
+    /// Neighbouring foreground pixels are merged by lock-free union-find (atomic minimum of roots).
+    COMPUTE_LIB_SHADERS_CCL_PASS_MERGE = 1,
+    /// Labels are replaced by their roots.
+    COMPUTE_LIB_SHADERS_CCL_PASS_COMPRESS = 2,
+    /// Roots are numbered by the atomic counter.
+    COMPUTE_LIB_SHADERS_CCL_PASS_NUMBER = 3,
+    /// Component statistics are accumulated and the label image is written.
+    COMPUTE_LIB_SHADERS_CCL_PASS_STATS = 4,
+    COMPUTE_LIB_SHADERS_CCL_NUM_PASSES = 5
+};
+
+/// Structure of the connected-component labelling instance.
+/// Only the component counter and the used part of the component table need to be read back.
+typedef struct compute_lib_shaders_ccl_s {
+    compute_lib_program_t programs[COMPUTE_LIB_SHADERS_CCL_NUM_PASSES];
+    /// Input RGBA8 image, foreground pixels have red channel at least the threshold.
+    compute_lib_image2d_t input_image2d;
+    /// Output label image (R32UI), component index + 1 of each pixel, 0 for background.
+    compute_lib_image2d_t output_image2d;
+    /// Union-find labels of pixels.
+    compute_lib_ssbo_t labels_ssbo;
+    /// Component table, COMPUTE_LIB_SHADERS_CCL_COMPONENT_STRIDE words per component.
+    compute_lib_ssbo_t components_ssbo;
+    /// Number of components found.
+    compute_lib_acbo_t counter_acbo;
+    compute_lib_uniform_t threshold_uniform;
+    /// Capacity of the component table (components beyond it are labelled, but have no statistics).
+    int max_components;
+    /// Number of components found by the last dispatch (valid after compute_lib_shaders_ccl_read).
+    GLuint num_components;
+} compute_lib_shaders_ccl_t;
+
+/// Structure of component statistics.
+typedef struct compute_lib_shaders_ccl_component_s {
+    GLuint area;
+    /// Bounding box (inclusive).
+    GLuint min_x, min_y, max_x, max_y;
+    double centroid_x, centroid_y;
+    /// Central second-order moments (not normalised by the area).
+    double mu20, mu11, mu02;
+} compute_lib_shaders_ccl_component_t;
+
+
+static inline void compute_lib_shaders_ccl_destroy(compute_lib_shaders_ccl_t* ccl)
+{
+    compute_lib_image2d_destroy(&(ccl->input_image2d));
+    compute_lib_image2d_destroy(&(ccl->output_image2d));
+    compute_lib_ssbo_destroy(&(ccl->labels_ssbo));
+    compute_lib_ssbo_destroy(&(ccl->components_ssbo));
+    compute_lib_acbo_destroy(&(ccl->counter_acbo));
+    for (int i = 0; i < COMPUTE_LIB_SHADERS_CCL_NUM_PASSES; i++) {
+        compute_lib_program_destroy(&(ccl->programs[i]), GL_TRUE);
+    }
+    free(ccl);
+}
+
+/// Initializes the connected-component labelling instance.
+/// \param connectivity Pixel connectivity, 4 or 8.
+/// \param max_components Capacity of the component table.
+static inline compute_lib_shaders_ccl_t* compute_lib_shaders_ccl_init(compute_lib_instance_t* inst, int local_size_x, int local_size_y, int image_width, int image_height, int connectivity, int max_components)
+{
+    if ((connectivity != 4 && connectivity != 8) || max_components < 1 ||
+            image_width > COMPUTE_LIB_SHADERS_CCL_MAX_SIZE || image_height > COMPUTE_LIB_SHADERS_CCL_MAX_SIZE) {
+        return NULL;
+    }
+
+    compute_lib_shaders_ccl_t* ccl = (compute_lib_shaders_ccl_t*) malloc(sizeof(compute_lib_shaders_ccl_t));
+    ccl->max_components = max_components;
+    ccl->num_components = 0;
+
+    ccl->input_image2d = COMPUTE_LIB_IMAGE2D_NEW("input_image2d", GL_TEXTURE0, image_width, image_height, GL_READ_ONLY, 4, GL_UNSIGNED_BYTE);
+    ccl->input_image2d.resource.value = 0;
+    compute_lib_image2d_setup_format(&(ccl->input_image2d));
+
+    ccl->output_image2d = COMPUTE_LIB_IMAGE2D_NEW("output_image2d", GL_TEXTURE1, image_width, image_height, GL_WRITE_ONLY, 1, GL_UNSIGNED_INT);
+    ccl->output_image2d.resource.value = 1;
+    compute_lib_image2d_setup_format(&(ccl->output_image2d));
+
+    ccl->labels_ssbo = COMPUTE_LIB_SSBO_NEW("labels_ssbo", GL_UNSIGNED_INT, GL_DYNAMIC_COPY);
+    ccl->labels_ssbo.resource.value = 0;
+    ccl->components_ssbo = COMPUTE_LIB_SSBO_NEW("components_ssbo", GL_UNSIGNED_INT, GL_DYNAMIC_COPY);
+    ccl->components_ssbo.resource.value = 1;
+    ccl->counter_acbo = COMPUTE_LIB_ACBO_NEW("components_counter", GL_UNSIGNED_INT, GL_DYNAMIC_COPY);
+    ccl->counter_acbo.resource.value = 0;
+
+    for (int i = 0; i < COMPUTE_LIB_SHADERS_CCL_NUM_PASSES; i++) {
+        ccl->programs[i] = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+    }
+
+    GLchar* program_layout_str = compute_lib_program_glsl_layout(&(ccl->programs[0]));
+    GLchar* input_image2d_layout_str = compute_lib_image2d_glsl_layout(&(ccl->input_image2d));
+    GLchar* output_image2d_layout_str = compute_lib_image2d_glsl_layout(&(ccl->output_image2d));
+    GLchar* labels_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(ccl->labels_ssbo));
+    GLchar* components_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(ccl->components_ssbo));
+    for (int i = 0; i < COMPUTE_LIB_SHADERS_CCL_NUM_PASSES; i++) {
+        asprintf(&(ccl->programs[i].source), _binary_src_shaders_ccl_comp_start, program_layout_str, input_image2d_layout_str, output_image2d_layout_str, labels_ssbo_layout_str, components_ssbo_layout_str,
+                 ccl->counter_acbo.resource.value, i, connectivity, max_components, COMPUTE_LIB_SHADERS_CCL_COMPONENT_STRIDE, COMPUTE_LIB_SHADERS_CCL_SEGMENT_LENGTH);
+    }
+    free(program_layout_str);
+    free(input_image2d_layout_str);
+    free(output_image2d_layout_str);
+    free(labels_ssbo_layout_str);
+    free(components_ssbo_layout_str);
+
+    for (int i = 0; i < COMPUTE_LIB_SHADERS_CCL_NUM_PASSES; i++) {
+        if (compute_lib_program_init(&(ccl->programs[i])) != GL_NO_ERROR) {
+            compute_lib_shaders_ccl_destroy(ccl);
+            return NULL;
+        }
+    }
+
+    ccl->threshold_uniform = COMPUTE_LIB_UNIFORM_NEW("ccl_threshold");
+    if (compute_lib_uniform_init(&(ccl->programs[COMPUTE_LIB_SHADERS_CCL_PASS_INIT]), &(ccl->threshold_uniform)) != GL_NO_ERROR) {
+        compute_lib_shaders_ccl_destroy(ccl);
+        return NULL;
+    }
+
+    if (compute_lib_image2d_init(&(ccl->input_image2d), 0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(ccl->output_image2d), GL_COLOR_ATTACHMENT0) != GL_NO_ERROR ||
+            compute_lib_ssbo_init(&(ccl->labels_ssbo), NULL, image_width * image_height) != GL_NO_ERROR ||
+            compute_lib_ssbo_init(&(ccl->components_ssbo), NULL, max_components * COMPUTE_LIB_SHADERS_CCL_COMPONENT_STRIDE) != GL_NO_ERROR ||
+            compute_lib_acbo_init(&(ccl->counter_acbo), NULL, 1) != GL_NO_ERROR) {
+        compute_lib_shaders_ccl_destroy(ccl);
+        return NULL;
+    }
+
+    return ccl;
+}
+
+/// Labels connected components of the thresholded input image and accumulates their statistics, no data are read back.
+/// \param threshold Minimum red channel value of foreground pixels.
+static inline GLuint compute_lib_shaders_ccl_dispatch(compute_lib_shaders_ccl_t* ccl, GLuint threshold)
+{
+    int width = ccl->input_image2d.width, height = ccl->input_image2d.height;
+    GLuint errors_cnt = compute_lib_uniform_write(&(ccl->programs[COMPUTE_LIB_SHADERS_CCL_PASS_INIT]), &(ccl->threshold_uniform), &threshold);
+    errors_cnt += compute_lib_acbo_write_uint_val(&(ccl->counter_acbo), 0);
+    errors_cnt += compute_lib_image2d_bind(&(ccl->input_image2d)) + compute_lib_image2d_bind(&(ccl->output_image2d));
+    errors_cnt += compute_lib_ssbo_bind(&(ccl->labels_ssbo)) + compute_lib_ssbo_bind(&(ccl->components_ssbo));
+    for (int i = COMPUTE_LIB_SHADERS_CCL_PASS_INIT; i < COMPUTE_LIB_SHADERS_CCL_PASS_STATS; i++) {
+        errors_cnt += compute_lib_program_dispatch(&(ccl->programs[i]), width, height, 1);
+    }
+    int segments = (width + COMPUTE_LIB_SHADERS_CCL_SEGMENT_LENGTH - 1) / COMPUTE_LIB_SHADERS_CCL_SEGMENT_LENGTH;
+    errors_cnt += compute_lib_program_dispatch(&(ccl->programs[COMPUTE_LIB_SHADERS_CCL_PASS_STATS]), segments, height, 1);
+    return errors_cnt;
+}
+
+/// Reads the number of components and the used part of the component table, computes centroids and central moments.
+/// \param components Output array of at least max_components entries.
+/// \param num_components Output number of entries written (total number of components found is stored in the instance).
+static inline GLuint compute_lib_shaders_ccl_read(compute_lib_shaders_ccl_t* ccl, compute_lib_shaders_ccl_component_t* components, GLuint* num_components)
+{
+    GLuint errors_cnt = compute_lib_acbo_read_uint_val(&(ccl->counter_acbo), &(ccl->num_components));
+    *num_components = (ccl->num_components < (GLuint) ccl->max_components) ? ccl->num_components : (GLuint) ccl->max_components;
+    if (*num_components == 0 || errors_cnt != GL_NO_ERROR) {
+        return errors_cnt;
+    }
+
+    GLuint* table = (GLuint*) malloc(*num_components * COMPUTE_LIB_SHADERS_CCL_COMPONENT_STRIDE * sizeof(GLuint));
+    errors_cnt += compute_lib_ssbo_read(&(ccl->components_ssbo), table, *num_components * COMPUTE_LIB_SHADERS_CCL_COMPONENT_STRIDE);
+    for (GLuint i = 0; i < *num_components; i++) {
+        const GLuint* entry = &table[i * COMPUTE_LIB_SHADERS_CCL_COMPONENT_STRIDE];
+        compute_lib_shaders_ccl_component_t* component = &components[i];
+        // sums are stored as low and high words
+        double m10 = entry[6] + 4294967296.0 * entry[7], m01 = entry[8] + 4294967296.0 * entry[9];
+        double m20 = entry[10] + 4294967296.0 * entry[11], m11 = entry[12] + 4294967296.0 * entry[13], m02 = entry[14] + 4294967296.0 * entry[15];
+        component->area = entry[0];
+        component->min_x = entry[1];
+        component->min_y = entry[2];
+        component->max_x = entry[3];
+        component->max_y = entry[4];
+        component->centroid_x = m10 / entry[0];
+        component->centroid_y = m01 / entry[0];
+        component->mu20 = m20 - component->centroid_x * m10;
+        component->mu11 = m11 - component->centroid_x * m01;
+        component->mu02 = m02 - component->centroid_y * m01;
+    }
+    free(table);
+    return errors_cnt;
+}
+
+#endif // GLES32COMPUTELIB_CCL_H
@@ -0,0 +1,140 @@
+/// \file clahe.h
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Header file of the GLES3ComputeLib library implementation of contrast limited adaptive histogram equalisation (CLAHE).
+/// \copyright GNU Public License.
+
+#pragma once
+
+#ifndef GLES32COMPUTELIB_CLAHE_H
+#define GLES32COMPUTELIB_CLAHE_H
+
+#define _GNU_SOURCE // asprintf
+#include <stdio.h>
+
+#include "compute_lib.h"
+#include "shaders/histogram.h"
+
+extern char _binary_src_shaders_clahe_lut_comp_start[];
+extern char _binary_src_shaders_clahe_apply_comp_start[];
+
+/// Structure of the CLAHE instance.
+/// Image is divided into a grid of tiles, one work group per tile accumulates the 256-bin histogram in shared memory, clips it,
+/// redistributes the clipped counts uniformly and stores the equalisation look-up table of the tile. Output pixels interpolate
+/// bilinearly between the tables of the four nearest tile centres. Nothing is read back between the passes.
+typedef struct compute_lib_shaders_clahe_s {
+    compute_lib_program_t lut_program;
+    compute_lib_program_t apply_program;
+    compute_lib_image2d_t input_image2d;
+    /// Equalised gray image (RGBA8).
+    compute_lib_image2d_t output_image2d;
+    /// Look-up tables of the tiles (uint), 256 elements per tile in row-major order of the tiles.
+    compute_lib_ssbo_t lut_ssbo;
+    compute_lib_uniform_t clip_limit_uniform;
+    /// Histogram mode, COMPUTE_LIB_SHADERS_HISTOGRAM_RED or COMPUTE_LIB_SHADERS_HISTOGRAM_LUMA.
+    GLenum mode;
+    int tiles_x;
+    int tiles_y;
+    /// Tile size in pixels, tiles of the last column and row are clipped to the image.
+    int tile_width;
+    int tile_height;
+} compute_lib_shaders_clahe_t;
+
+
+static inline void compute_lib_shaders_clahe_destroy(compute_lib_shaders_clahe_t* clahe)
+{
+    compute_lib_image2d_destroy(&(clahe->input_image2d));
+    compute_lib_image2d_destroy(&(clahe->output_image2d));
+    compute_lib_ssbo_destroy(&(clahe->lut_ssbo));
+    compute_lib_program_destroy(&(clahe->lut_program), GL_TRUE);
+    compute_lib_program_destroy(&(clahe->apply_program), GL_TRUE);
+    free(clahe);
+}
+
+/// Initializes the CLAHE instance.
+/// \param mode Histogram mode, COMPUTE_LIB_SHADERS_HISTOGRAM_RED or COMPUTE_LIB_SHADERS_HISTOGRAM_LUMA.
+/// \param tiles_x Number of tile columns, tile width is image_width / tiles_x rounded up.
+/// \param tiles_y Number of tile rows, tile height is image_height / tiles_y rounded up.
+static inline compute_lib_shaders_clahe_t* compute_lib_shaders_clahe_init(compute_lib_instance_t* inst, int local_size_x, int local_size_y, int image_width, int image_height, GLenum mode,
+        int tiles_x, int tiles_y)
+{
+    int tile_width = (tiles_x > 0) ? (image_width + tiles_x - 1) / tiles_x : 0, tile_height = (tiles_y > 0) ? (image_height + tiles_y - 1) / tiles_y : 0;
+    // every tile has to contain at least one pixel
+    if ((mode != COMPUTE_LIB_SHADERS_HISTOGRAM_RED && mode != COMPUTE_LIB_SHADERS_HISTOGRAM_LUMA) || tiles_x < 1 || tiles_y < 1 ||
+            (tiles_x - 1) * tile_width >= image_width || (tiles_y - 1) * tile_height >= image_height) {
+        return NULL;
+    }
+
+    compute_lib_shaders_clahe_t* clahe = (compute_lib_shaders_clahe_t*) malloc(sizeof(compute_lib_shaders_clahe_t));
+    clahe->mode = mode;
+    clahe->tiles_x = tiles_x;
+    clahe->tiles_y = tiles_y;
+    clahe->tile_width = tile_width;
+    clahe->tile_height = tile_height;
+
+    clahe->input_image2d = COMPUTE_LIB_IMAGE2D_NEW("input_image2d", GL_TEXTURE0, image_width, image_height, GL_READ_ONLY, 4, GL_UNSIGNED_BYTE);
+    clahe->input_image2d.resource.value = 0;
+    compute_lib_image2d_setup_format(&(clahe->input_image2d));
+
+    clahe->output_image2d = COMPUTE_LIB_IMAGE2D_NEW("output_image2d", GL_TEXTURE1, image_width, image_height, GL_WRITE_ONLY, 4, GL_UNSIGNED_BYTE);
+    clahe->output_image2d.resource.value = 1;
+    compute_lib_image2d_setup_format(&(clahe->output_image2d));
+
+    clahe->lut_ssbo = COMPUTE_LIB_SSBO_NEW("lut_ssbo", GL_UNSIGNED_INT, GL_DYNAMIC_COPY);
+    clahe->lut_ssbo.resource.value = 2;
+
+    // one invocation per bin builds the table of a tile
+    clahe->lut_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, 256, 1, 1);
+    clahe->apply_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+
+    GLchar* lut_layout_str = compute_lib_program_glsl_layout(&(clahe->lut_program));
+    GLchar* apply_layout_str = compute_lib_program_glsl_layout(&(clahe->apply_program));
+    GLchar* input_image2d_layout_str = compute_lib_image2d_glsl_layout(&(clahe->input_image2d));
+    GLchar* output_image2d_layout_str = compute_lib_image2d_glsl_layout(&(clahe->output_image2d));
+    GLchar* lut_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(clahe->lut_ssbo));
+    asprintf(&(clahe->lut_program.source), _binary_src_shaders_clahe_lut_comp_start, lut_layout_str, input_image2d_layout_str, lut_ssbo_layout_str, mode,
+             tiles_x, tiles_y, clahe->tile_width, clahe->tile_height);
+    asprintf(&(clahe->apply_program.source), _binary_src_shaders_clahe_apply_comp_start, apply_layout_str, input_image2d_layout_str, output_image2d_layout_str, lut_ssbo_layout_str, mode,
+             tiles_x, tiles_y, clahe->tile_width, clahe->tile_height);
+    free(lut_layout_str);
+    free(apply_layout_str);
+    free(input_image2d_layout_str);
+    free(output_image2d_layout_str);
+    free(lut_ssbo_layout_str);
+
+    if (compute_lib_program_init(&(clahe->lut_program)) != GL_NO_ERROR ||
+            compute_lib_program_init(&(clahe->apply_program)) != GL_NO_ERROR) {
+        compute_lib_shaders_clahe_destroy(clahe);
+        return NULL;
+    }
+
+    clahe->clip_limit_uniform = COMPUTE_LIB_UNIFORM_NEW("clahe_clip_limit");
+    if (compute_lib_uniform_init(&(clahe->lut_program), &(clahe->clip_limit_uniform)) != GL_NO_ERROR) {
+        compute_lib_shaders_clahe_destroy(clahe);
+        return NULL;
+    }
+
+    if (compute_lib_image2d_init(&(clahe->input_image2d), 0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(clahe->output_image2d), GL_COLOR_ATTACHMENT0) != GL_NO_ERROR ||
+            compute_lib_ssbo_init(&(clahe->lut_ssbo), NULL, tiles_x * tiles_y * 256) != GL_NO_ERROR) {
+        compute_lib_shaders_clahe_destroy(clahe);
+        return NULL;
+    }
+
+    return clahe;
+}
+
+/// Computes the look-up tables of all tiles and writes the equalised image.
+/// \param clip_limit Limit of the histogram bins relative to the uniform distribution (bin limit is clip_limit * tile_pixels / 256, at least 1),
+///                   zero or negative disables clipping (plain adaptive histogram equalisation).
+static inline GLuint compute_lib_shaders_clahe_dispatch(compute_lib_shaders_clahe_t* clahe, GLfloat clip_limit)
+{
+    GLuint errors_cnt = compute_lib_uniform_write(&(clahe->lut_program), &(clahe->clip_limit_uniform), &clip_limit);
+    errors_cnt += compute_lib_image2d_bind(&(clahe->input_image2d)) + compute_lib_image2d_bind(&(clahe->output_image2d));
+    errors_cnt += compute_lib_ssbo_bind(&(clahe->lut_ssbo));
+    errors_cnt += compute_lib_program_dispatch(&(clahe->lut_program), 256 * clahe->tiles_x, clahe->tiles_y, 1);
+    errors_cnt += compute_lib_program_dispatch(&(clahe->apply_program), clahe->output_image2d.width, clahe->output_image2d.height, 1);
+    return errors_cnt;
+}
+
+#endif // GLES32COMPUTELIB_CLAHE_H
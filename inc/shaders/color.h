@@ -0,0 +1,375 @@
+/// \file color.h
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Header file of the GLES3ComputeLib library implementation of Bayer demosaicing and YUV (I420, NV12, YUYV) and grey to/from RGB conversions.
+/// \copyright GNU Public License.
+
+#pragma once
+
+#ifndef GLES32COMPUTELIB_COLOR_H
+#define GLES32COMPUTELIB_COLOR_H
+
+#define _GNU_SOURCE // asprintf
+#include <stdio.h>
+
+#include "compute_lib.h"
+#include "shaders/warp.h"
+
+extern char _binary_src_shaders_demosaic_comp_start[];
+extern char _binary_src_shaders_yuv_to_rgb_comp_start[];
+extern char _binary_src_shaders_rgb_to_yuv_comp_start[];
+
+/// Enumeration of Bayer patterns (colours of the top-left 2x2 block, row by row).
+enum compute_lib_shaders_bayer_pattern_e {
+    COMPUTE_LIB_SHADERS_BAYER_RGGB = 0,
+    COMPUTE_LIB_SHADERS_BAYER_BGGR = 1,
+    COMPUTE_LIB_SHADERS_BAYER_GRBG = 2,
+    COMPUTE_LIB_SHADERS_BAYER_GBRG = 3
+};
+
+/// Enumeration of demosaicing methods.
+enum compute_lib_shaders_demosaic_method_e {
+    /// Bilinear interpolation of each colour from its nearest samples (single pass).
+    COMPUTE_LIB_SHADERS_DEMOSAIC_BILINEAR = 0,
+    /// Hamilton-Adams green interpolation along edges, red and blue interpolated as differences from green (two passes).
+    COMPUTE_LIB_SHADERS_DEMOSAIC_EDGE_AWARE = 1
+};
+
+/// Enumeration of YUV frame formats, all of them 8-bit with even image dimensions.
+enum compute_lib_shaders_yuv_format_e {
+    /// Planar 4:2:0, Y plane followed by U and V planes subsampled 2x2.
+    COMPUTE_LIB_SHADERS_YUV_I420 = 0,
+    /// Semi-planar 4:2:0, Y plane followed by interleaved UV plane subsampled 2x2.
+    COMPUTE_LIB_SHADERS_YUV_NV12 = 1,
+    /// Packed 4:2:2, Y0 U Y1 V bytes for each pair of pixels.
+    COMPUTE_LIB_SHADERS_YUV_YUYV = 2,
+    /// Y plane only (grey image).
+    COMPUTE_LIB_SHADERS_YUV_GRAY = 3
+};
+
+/// Enumeration of YUV colour standards.
+enum compute_lib_shaders_yuv_standard_e {
+    /// ITU-R BT.601 with limited (video) range, Y in 16..235 and chroma in 16..240.
+    COMPUTE_LIB_SHADERS_YUV_BT601 = 0,
+    /// ITU-R BT.709 with limited (video) range.
+    COMPUTE_LIB_SHADERS_YUV_BT709 = 1,
+    /// ITU-R BT.601 with full range (JPEG/JFIF).
+    COMPUTE_LIB_SHADERS_YUV_BT601_FULL = 2
+};
+
+/// Structure of the demosaicing instance.
+/// Raw image (R8UI) is uploaded at its native size and read through a sampler, output is RGBA8 image.
+typedef struct compute_lib_shaders_demosaic_s {
+    compute_lib_program_t program;
+    /// Second pass of the edge-aware method.
+    compute_lib_program_t rb_program;
+    compute_lib_image2d_t raw_image2d;
+    /// Raw values and interpolated green of the edge-aware method (RGBA8).
+    compute_lib_image2d_t green_image2d;
+    compute_lib_image2d_t output_image2d;
+    /// Demosaicing method (compute_lib_shaders_demosaic_method_e).
+    GLenum method;
+} compute_lib_shaders_demosaic_t;
+
+/// Structure of the YUV conversion instance.
+/// YUV planes are 8-bit images read through samplers: Y plane R8UI (YUYV frame RGBA8UI of half width), U and V planes R8UI, UV plane RG8UI.
+/// RGB to YUV conversion writes the complete frame in its native byte layout into a SSBO (four bytes per uint, little endian).
+typedef struct compute_lib_shaders_yuv_s {
+    compute_lib_program_t to_rgb_program;
+    compute_lib_program_t from_rgb_program;
+    compute_lib_image2d_t y_image2d;
+    /// U plane (I420) or interleaved UV plane (NV12).
+    compute_lib_image2d_t u_image2d;
+    /// V plane (I420).
+    compute_lib_image2d_t v_image2d;
+    /// RGBA8 image, output of conversion to RGB and input of conversion from RGB.
+    compute_lib_image2d_t rgba_image2d;
+    /// Packed frame written by the conversion from RGB.
+    compute_lib_ssbo_t frame_ssbo;
+    compute_lib_uniform_t to_rgb_matrix_uniform;
+    compute_lib_uniform_t to_rgb_offset_uniform;
+    compute_lib_uniform_t from_rgb_matrix_uniform;
+    compute_lib_uniform_t from_rgb_offset_uniform;
+    /// Frame format (compute_lib_shaders_yuv_format_e).
+    GLenum format;
+    /// Size of the packed frame in bytes.
+    int frame_size;
+} compute_lib_shaders_yuv_t;
+
+
+static inline void compute_lib_shaders_demosaic_destroy(compute_lib_shaders_demosaic_t* demosaic)
+{
+    compute_lib_image2d_destroy(&(demosaic->raw_image2d));
+    compute_lib_image2d_destroy(&(demosaic->green_image2d));
+    compute_lib_image2d_destroy(&(demosaic->output_image2d));
+    compute_lib_program_destroy(&(demosaic->program), GL_TRUE);
+    compute_lib_program_destroy(&(demosaic->rb_program), GL_TRUE);
+    free(demosaic);
+}
+
+/// Initializes the demosaicing instance.
+/// \param pattern Bayer pattern of the sensor (compute_lib_shaders_bayer_pattern_e).
+/// \param method Demosaicing method (compute_lib_shaders_demosaic_method_e).
+static inline compute_lib_shaders_demosaic_t* compute_lib_shaders_demosaic_init(compute_lib_instance_t* inst, int local_size_x, int local_size_y, int image_width, int image_height, GLenum pattern, GLenum method)
+{
+    static const int red_positions[4][2] = { { 0, 0 }, { 1, 1 }, { 1, 0 }, { 0, 1 } };
+    if (pattern > COMPUTE_LIB_SHADERS_BAYER_GBRG || method > COMPUTE_LIB_SHADERS_DEMOSAIC_EDGE_AWARE) {
+        return NULL;
+    }
+
+    compute_lib_shaders_demosaic_t* demosaic = (compute_lib_shaders_demosaic_t*) malloc(sizeof(compute_lib_shaders_demosaic_t));
+    demosaic->method = method;
+
+    demosaic->raw_image2d = COMPUTE_LIB_IMAGE2D_NEW("input_image2d", GL_TEXTURE0, image_width, image_height, GL_READ_ONLY, 1, GL_UNSIGNED_BYTE);
+    demosaic->raw_image2d.resource.value = 0;
+    compute_lib_image2d_setup_format(&(demosaic->raw_image2d));
+
+    demosaic->green_image2d = COMPUTE_LIB_IMAGE2D_NEW("input_image2d", GL_TEXTURE1, image_width, image_height, GL_WRITE_ONLY, 4, GL_UNSIGNED_BYTE);
+    demosaic->green_image2d.resource.value = 1;
+    compute_lib_image2d_setup_format(&(demosaic->green_image2d));
+
+    demosaic->output_image2d = COMPUTE_LIB_IMAGE2D_NEW("output_image2d", GL_TEXTURE2, image_width, image_height, GL_WRITE_ONLY, 4, GL_UNSIGNED_BYTE);
+    demosaic->output_image2d.resource.value = 1;
+    compute_lib_image2d_setup_format(&(demosaic->output_image2d));
+
+    demosaic->program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+    demosaic->rb_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+
+    GLchar* program_layout_str = compute_lib_program_glsl_layout(&(demosaic->program));
+    GLchar* raw_sampler_layout_str = compute_lib_image2d_glsl_sampler_layout(&(demosaic->raw_image2d));
+    GLchar* green_sampler_layout_str = compute_lib_image2d_glsl_sampler_layout(&(demosaic->green_image2d));
+    GLchar* output_image2d_layout_str = compute_lib_image2d_glsl_layout(&(demosaic->output_image2d));
+    asprintf(&(demosaic->program.source), _binary_src_shaders_demosaic_comp_start, program_layout_str, raw_sampler_layout_str, output_image2d_layout_str, method, 0,
+             red_positions[pattern][0], red_positions[pattern][1]);
+    asprintf(&(demosaic->rb_program.source), _binary_src_shaders_demosaic_comp_start, program_layout_str, green_sampler_layout_str, output_image2d_layout_str, method, 1,
+             red_positions[pattern][0], red_positions[pattern][1]);
+    free(program_layout_str);
+    free(raw_sampler_layout_str);
+    free(green_sampler_layout_str);
+    free(output_image2d_layout_str);
+
+    if (compute_lib_program_init(&(demosaic->program)) != GL_NO_ERROR ||
+            (method == COMPUTE_LIB_SHADERS_DEMOSAIC_EDGE_AWARE && compute_lib_program_init(&(demosaic->rb_program)) != GL_NO_ERROR)) {
+        compute_lib_shaders_demosaic_destroy(demosaic);
+        return NULL;
+    }
+
+    if (compute_lib_image2d_init(&(demosaic->raw_image2d), 0) != GL_NO_ERROR ||
+            (method == COMPUTE_LIB_SHADERS_DEMOSAIC_EDGE_AWARE && compute_lib_image2d_init(&(demosaic->green_image2d), 0) != GL_NO_ERROR) ||
+            compute_lib_image2d_init(&(demosaic->output_image2d), GL_COLOR_ATTACHMENT0) != GL_NO_ERROR) {
+        compute_lib_shaders_demosaic_destroy(demosaic);
+        return NULL;
+    }
+
+    return demosaic;
+}
+
+/// Demosaics the raw image into the output image.
+static inline GLuint compute_lib_shaders_demosaic_dispatch(compute_lib_shaders_demosaic_t* demosaic)
+{
+    int width = demosaic->output_image2d.width, height = demosaic->output_image2d.height;
+    GLuint errors_cnt = compute_lib_image2d_bind_sampler(&(demosaic->raw_image2d));
+    if (demosaic->method == COMPUTE_LIB_SHADERS_DEMOSAIC_BILINEAR) {
+        errors_cnt += compute_lib_image2d_bind(&(demosaic->output_image2d));
+        errors_cnt += compute_lib_program_dispatch(&(demosaic->program), width, height, 1);
+        return errors_cnt;
+    }
+    errors_cnt += compute_lib_image2d_bind(&(demosaic->green_image2d));
+    errors_cnt += compute_lib_program_dispatch(&(demosaic->program), width, height, 1);
+    errors_cnt += compute_lib_image2d_bind_sampler(&(demosaic->green_image2d));
+    errors_cnt += compute_lib_image2d_bind(&(demosaic->output_image2d));
+    errors_cnt += compute_lib_program_dispatch(&(demosaic->rb_program), width, height, 1);
+    return errors_cnt;
+}
+
+static inline void compute_lib_shaders_yuv_destroy(compute_lib_shaders_yuv_t* yuv)
+{
+    compute_lib_image2d_destroy(&(yuv->y_image2d));
+    compute_lib_image2d_destroy(&(yuv->u_image2d));
+    compute_lib_image2d_destroy(&(yuv->v_image2d));
+    compute_lib_image2d_destroy(&(yuv->rgba_image2d));
+    compute_lib_ssbo_destroy(&(yuv->frame_ssbo));
+    compute_lib_program_destroy(&(yuv->to_rgb_program), GL_TRUE);
+    compute_lib_program_destroy(&(yuv->from_rgb_program), GL_TRUE);
+    free(yuv);
+}
+
+/// Computes column-major matrices and offsets of the conversions, YUV = to_yuv * RGB + offset and RGB = to_rgb * (YUV - offset).
+static inline void compute_lib_shaders_yuv_matrices(GLenum standard, GLfloat* to_yuv, GLfloat* to_rgb, GLfloat* offset)
+{
+    double kr = (standard == COMPUTE_LIB_SHADERS_YUV_BT709) ? 0.2126 : 0.299;
+    double kb = (standard == COMPUTE_LIB_SHADERS_YUV_BT709) ? 0.0722 : 0.114;
+    double kg = 1.0 - kr - kb;
+    int full_range = standard == COMPUTE_LIB_SHADERS_YUV_BT601_FULL;
+    double luma_scale = full_range ? 1.0 : 219.0 / 255.0;
+    double chroma_scale = full_range ? 1.0 : 224.0 / 255.0;
+
+    double m[9] = {
+        luma_scale * kr, luma_scale * kg, luma_scale * kb,
+        chroma_scale * -0.5 * kr / (1.0 - kb), chroma_scale * -0.5 * kg / (1.0 - kb), chroma_scale * 0.5,
+        chroma_scale * 0.5, chroma_scale * -0.5 * kg / (1.0 - kr), chroma_scale * -0.5 * kb / (1.0 - kr)
+    };
+    double inv[9];
+    compute_lib_shaders_warp_invert(m, inv);
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) {
+            to_yuv[3 * c + r] = (GLfloat) m[3 * r + c];
+            to_rgb[3 * c + r] = (GLfloat) inv[3 * r + c];
+        }
+    }
+    offset[0] = full_range ? 0.0f : 16.0f;
+    offset[1] = offset[2] = 128.0f;
+}
+
+/// Initializes the YUV conversion instance.
+/// \param image_width Even image width.
+/// \param image_height Even image height.
+/// \param format Frame format (compute_lib_shaders_yuv_format_e).
+/// \param standard Colour standard (compute_lib_shaders_yuv_standard_e).
+static inline compute_lib_shaders_yuv_t* compute_lib_shaders_yuv_init(compute_lib_instance_t* inst, int local_size_x, int local_size_y, int image_width, int image_height, GLenum format, GLenum standard)
+{
+    if ((image_width & 1) != 0 || (image_height & 1) != 0 || format > COMPUTE_LIB_SHADERS_YUV_GRAY || standard > COMPUTE_LIB_SHADERS_YUV_BT601_FULL) {
+        return NULL;
+    }
+
+    compute_lib_shaders_yuv_t* yuv = (compute_lib_shaders_yuv_t*) malloc(sizeof(compute_lib_shaders_yuv_t));
+    yuv->format = format;
+    switch (format) {
+        case COMPUTE_LIB_SHADERS_YUV_I420:
+        case COMPUTE_LIB_SHADERS_YUV_NV12:
+            yuv->frame_size = image_width * image_height * 3 / 2;
+            break;
+        case COMPUTE_LIB_SHADERS_YUV_YUYV:
+            yuv->frame_size = image_width * image_height * 2;
+            break;
+        default:
+            yuv->frame_size = image_width * image_height;
+            break;
+    }
+
+    if (format == COMPUTE_LIB_SHADERS_YUV_YUYV) {
+        yuv->y_image2d = COMPUTE_LIB_IMAGE2D_NEW("y_image2d", GL_TEXTURE0, image_width / 2, image_height, GL_READ_ONLY, 4, GL_UNSIGNED_BYTE);
+    } else {
+        yuv->y_image2d = COMPUTE_LIB_IMAGE2D_NEW("y_image2d", GL_TEXTURE0, image_width, image_height, GL_READ_ONLY, 1, GL_UNSIGNED_BYTE);
+    }
+    yuv->y_image2d.resource.value = 0;
+    compute_lib_image2d_setup_format(&(yuv->y_image2d));
+
+    yuv->u_image2d = COMPUTE_LIB_IMAGE2D_NEW("u_image2d", GL_TEXTURE1, image_width / 2, image_height / 2, GL_READ_ONLY, (format == COMPUTE_LIB_SHADERS_YUV_NV12) ? 2 : 1, GL_UNSIGNED_BYTE);
+    yuv->u_image2d.resource.value = 1;
+    compute_lib_image2d_setup_format(&(yuv->u_image2d));
+
+    yuv->v_image2d = COMPUTE_LIB_IMAGE2D_NEW("v_image2d", GL_TEXTURE2, image_width / 2, image_height / 2, GL_READ_ONLY, 1, GL_UNSIGNED_BYTE);
+    yuv->v_image2d.resource.value = 2;
+    compute_lib_image2d_setup_format(&(yuv->v_image2d));
+
+    yuv->rgba_image2d = COMPUTE_LIB_IMAGE2D_NEW("output_image2d", GL_TEXTURE3, image_width, image_height, GL_WRITE_ONLY, 4, GL_UNSIGNED_BYTE);
+    yuv->rgba_image2d.resource.value = 3;
+    compute_lib_image2d_setup_format(&(yuv->rgba_image2d));
+
+    yuv->frame_ssbo = COMPUTE_LIB_SSBO_NEW("frame_ssbo", GL_UNSIGNED_INT, GL_DYNAMIC_COPY);
+    yuv->frame_ssbo.resource.value = 0;
+
+    yuv->to_rgb_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+    yuv->from_rgb_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x * local_size_y, 1, 1);
+
+    // conversion from RGB samples the RGBA image under the input name
+    compute_lib_image2d_t rgba_input_image2d = yuv->rgba_image2d;
+    rgba_input_image2d.resource.name = "input_image2d";
+
+    GLchar* to_rgb_layout_str = compute_lib_program_glsl_layout(&(yuv->to_rgb_program));
+    GLchar* from_rgb_layout_str = compute_lib_program_glsl_layout(&(yuv->from_rgb_program));
+    GLchar* y_sampler_layout_str = compute_lib_image2d_glsl_sampler_layout(&(yuv->y_image2d));
+    GLchar* u_sampler_layout_str = compute_lib_image2d_glsl_sampler_layout(&(yuv->u_image2d));
+    GLchar* v_sampler_layout_str = compute_lib_image2d_glsl_sampler_layout(&(yuv->v_image2d));
+    GLchar* rgba_image2d_layout_str = compute_lib_image2d_glsl_layout(&(yuv->rgba_image2d));
+    GLchar* rgba_sampler_layout_str = compute_lib_image2d_glsl_sampler_layout(&rgba_input_image2d);
+    GLchar* frame_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(yuv->frame_ssbo));
+    asprintf(&(yuv->to_rgb_program.source), _binary_src_shaders_yuv_to_rgb_comp_start, to_rgb_layout_str, y_sampler_layout_str, u_sampler_layout_str, v_sampler_layout_str, rgba_image2d_layout_str, format);
+    asprintf(&(yuv->from_rgb_program.source), _binary_src_shaders_rgb_to_yuv_comp_start, from_rgb_layout_str, rgba_sampler_layout_str, frame_ssbo_layout_str, format, image_width, image_height);
+    free(to_rgb_layout_str);
+    free(from_rgb_layout_str);
+    free(y_sampler_layout_str);
+    free(u_sampler_layout_str);
+    free(v_sampler_layout_str);
+    free(rgba_image2d_layout_str);
+    free(rgba_sampler_layout_str);
+    free(frame_ssbo_layout_str);
+
+    if (compute_lib_program_init(&(yuv->to_rgb_program)) != GL_NO_ERROR ||
+            compute_lib_program_init(&(yuv->from_rgb_program)) != GL_NO_ERROR) {
+        compute_lib_shaders_yuv_destroy(yuv);
+        return NULL;
+    }
+
+    yuv->to_rgb_matrix_uniform = COMPUTE_LIB_UNIFORM_NEW("color_matrix");
+    yuv->to_rgb_offset_uniform = COMPUTE_LIB_UNIFORM_NEW("color_offset");
+    yuv->from_rgb_matrix_uniform = COMPUTE_LIB_UNIFORM_NEW("color_matrix");
+    yuv->from_rgb_offset_uniform = COMPUTE_LIB_UNIFORM_NEW("color_offset");
+    if (compute_lib_uniform_init(&(yuv->to_rgb_program), &(yuv->to_rgb_matrix_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(yuv->to_rgb_program), &(yuv->to_rgb_offset_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(yuv->from_rgb_program), &(yuv->from_rgb_matrix_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(yuv->from_rgb_program), &(yuv->from_rgb_offset_uniform)) != GL_NO_ERROR) {
+        compute_lib_shaders_yuv_destroy(yuv);
+        return NULL;
+    }
+
+    GLfloat to_yuv[9], to_rgb[9], offset[3];
+    compute_lib_shaders_yuv_matrices(standard, to_yuv, to_rgb, offset);
+    GLuint errors_cnt = compute_lib_uniform_write(&(yuv->to_rgb_program), &(yuv->to_rgb_matrix_uniform), to_rgb);
+    errors_cnt += compute_lib_uniform_write(&(yuv->to_rgb_program), &(yuv->to_rgb_offset_uniform), offset);
+    errors_cnt += compute_lib_uniform_write(&(yuv->from_rgb_program), &(yuv->from_rgb_matrix_uniform), to_yuv);
+    errors_cnt += compute_lib_uniform_write(&(yuv->from_rgb_program), &(yuv->from_rgb_offset_uniform), offset);
+
+    GLboolean chroma_planes = format == COMPUTE_LIB_SHADERS_YUV_I420 || format == COMPUTE_LIB_SHADERS_YUV_NV12;
+    if (errors_cnt != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(yuv->y_image2d), 0) != GL_NO_ERROR ||
+            (chroma_planes && compute_lib_image2d_init(&(yuv->u_image2d), 0) != GL_NO_ERROR) ||
+            (format == COMPUTE_LIB_SHADERS_YUV_I420 && compute_lib_image2d_init(&(yuv->v_image2d), 0) != GL_NO_ERROR) ||
+            compute_lib_image2d_init(&(yuv->rgba_image2d), GL_COLOR_ATTACHMENT0) != GL_NO_ERROR ||
+            compute_lib_ssbo_init(&(yuv->frame_ssbo), NULL, (yuv->frame_size + 3) / 4) != GL_NO_ERROR) {
+        compute_lib_shaders_yuv_destroy(yuv);
+        return NULL;
+    }
+
+    return yuv;
+}
+
+/// Uploads the frame in its native byte layout into the plane images.
+static inline GLuint compute_lib_shaders_yuv_write(compute_lib_shaders_yuv_t* yuv, const GLubyte* frame)
+{
+    int luma_size = yuv->rgba_image2d.width * yuv->rgba_image2d.height;
+    GLuint errors_cnt = compute_lib_image2d_write(&(yuv->y_image2d), (void*) frame);
+    if (yuv->format == COMPUTE_LIB_SHADERS_YUV_I420 || yuv->format == COMPUTE_LIB_SHADERS_YUV_NV12) {
+        errors_cnt += compute_lib_image2d_write(&(yuv->u_image2d), (void*) (frame + luma_size));
+    }
+    if (yuv->format == COMPUTE_LIB_SHADERS_YUV_I420) {
+        errors_cnt += compute_lib_image2d_write(&(yuv->v_image2d), (void*) (frame + luma_size + luma_size / 4));
+    }
+    return errors_cnt;
+}
+
+/// Converts the YUV planes to the RGBA image.
+static inline GLuint compute_lib_shaders_yuv_to_rgb(compute_lib_shaders_yuv_t* yuv)
+{
+    GLuint errors_cnt = compute_lib_image2d_bind_sampler(&(yuv->y_image2d));
+    if (yuv->format == COMPUTE_LIB_SHADERS_YUV_I420 || yuv->format == COMPUTE_LIB_SHADERS_YUV_NV12) {
+        errors_cnt += compute_lib_image2d_bind_sampler(&(yuv->u_image2d));
+    }
+    if (yuv->format == COMPUTE_LIB_SHADERS_YUV_I420) {
+        errors_cnt += compute_lib_image2d_bind_sampler(&(yuv->v_image2d));
+    }
+    errors_cnt += compute_lib_image2d_bind(&(yuv->rgba_image2d));
+    errors_cnt += compute_lib_program_dispatch(&(yuv->to_rgb_program), yuv->rgba_image2d.width, yuv->rgba_image2d.height, 1);
+    return errors_cnt;
+}
+
+/// Converts the RGBA image to the packed frame in the frame SSBO (chroma is averaged over the subsampled pixels).
+static inline GLuint compute_lib_shaders_yuv_from_rgb(compute_lib_shaders_yuv_t* yuv)
+{
+    GLuint errors_cnt = compute_lib_image2d_bind_sampler(&(yuv->rgba_image2d)) + compute_lib_ssbo_bind(&(yuv->frame_ssbo));
+    errors_cnt += compute_lib_program_dispatch(&(yuv->from_rgb_program), (yuv->frame_size + 3) / 4, 1, 1);
+    return errors_cnt;
+}
+
+#endif // GLES32COMPUTELIB_COLOR_H
@@ -11,16 +11,34 @@
 
 #define _GNU_SOURCE // asprintf
 #include <stdio.h>
+#include <math.h>
 
 #include "compute_lib.h"
+#include "shaders/fft.h"
+
+/// Kernel area (number of kernel elements) from which the FFT-based convolution is used instead of the direct one.
+/// Default is the break-even measured by test_fft on Mesa 22.3.6 llvmpipe (LLVM 15.0.6, 256 bits) for 480x480 and 1000x700 images (FFT faster from the 15x15 kernel).
+/// The break-even point depends on the GPU and image size, run test_fft on the target device and redefine the value before including this header.
+#ifndef COMPUTE_LIB_SHADERS_CONV2D_FFT_MIN_KERNEL_AREA
+#define COMPUTE_LIB_SHADERS_CONV2D_FFT_MIN_KERNEL_AREA 225
+#endif
+
+/// Offset added to the convolution result before it is truncated to the output integer (same in both methods), covers float round-off of exact integer results.
+#define COMPUTE_LIB_SHADERS_CONV2D_ROUNDING_EPSILON 0.01f
 
 extern char _binary_src_shaders_conv2d_comp_start[];
+extern char _binary_src_shaders_conv2d_fft_pack_comp_start[];
+extern char _binary_src_shaders_conv2d_fft_unpack_comp_start[];
 
 typedef struct compute_lib_shaders_conv2d_s {
     compute_lib_program_t program;
     compute_lib_image2d_t input_image2d;
     compute_lib_image2d_t output_image2d;
     compute_lib_ssbo_t kernel_ssbo;
+    /// FFT instance used for large kernels, NULL if the direct convolution is used.
+    compute_lib_shaders_fft_t* fft;
+    compute_lib_program_t fft_pack_program;
+    compute_lib_program_t fft_unpack_program;
 } compute_lib_shaders_conv2d_t;
 
 
@@ -30,12 +48,74 @@ static inline void compute_lib_shaders_conv2d_destroy(compute_lib_shaders_conv2d
     compute_lib_image2d_destroy(&(conv2d->output_image2d));
     compute_lib_ssbo_destroy(&(conv2d->kernel_ssbo));
     compute_lib_program_destroy(&(conv2d->program), GL_TRUE);
+    compute_lib_program_destroy(&(conv2d->fft_pack_program), GL_TRUE);
+    compute_lib_program_destroy(&(conv2d->fft_unpack_program), GL_TRUE);
+    if (conv2d->fft != NULL) {
+        compute_lib_shaders_fft_destroy(conv2d->fft);
+    }
     free(conv2d);
 }
 
-static inline compute_lib_shaders_conv2d_t* compute_lib_shaders_conv2d_init(compute_lib_instance_t* inst, int local_size_x, int local_size_y, int image_width, int image_height, float* kernel, int kernel_length)
+/// Prepares the FFT path: compiles pack/unpack programs and stores the spectrum of the (flipped, wrapped) kernel.
+static inline GLuint compute_lib_shaders_conv2d_fft_init(compute_lib_shaders_conv2d_t* conv2d, compute_lib_instance_t* inst, float* kernel, int kernel_length)
+{
+    int kernel_size = (int) sqrtf((float) kernel_length);
+    int kernel_span = (kernel_size - 1) / 2;
+    int fft_width = compute_lib_shaders_fft_size(conv2d->input_image2d.width);
+    int fft_height = compute_lib_shaders_fft_size(conv2d->input_image2d.height);
+
+    if ((conv2d->fft = compute_lib_shaders_fft_init(inst, 64, fft_width, fft_height)) == NULL) {
+        return (GLuint) -1;
+    }
+
+    GLchar* program_layout_str = compute_lib_program_glsl_layout(&(conv2d->fft_pack_program));
+    GLchar* input_image2d_layout_str = compute_lib_image2d_glsl_layout(&(conv2d->input_image2d));
+    GLchar* output_image2d_layout_str = compute_lib_image2d_glsl_layout(&(conv2d->output_image2d));
+    GLchar* data_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(conv2d->fft->data_ssbo));
+    asprintf(&(conv2d->fft_pack_program.source), _binary_src_shaders_conv2d_fft_pack_comp_start, program_layout_str, input_image2d_layout_str, data_ssbo_layout_str, fft_width, fft_height);
+    asprintf(&(conv2d->fft_unpack_program.source), _binary_src_shaders_conv2d_fft_unpack_comp_start, program_layout_str, output_image2d_layout_str, data_ssbo_layout_str, fft_width, kernel_span,
+             COMPUTE_LIB_SHADERS_CONV2D_ROUNDING_EPSILON);
+    free(program_layout_str);
+    free(input_image2d_layout_str);
+    free(output_image2d_layout_str);
+    free(data_ssbo_layout_str);
+
+    GLuint errors_cnt = compute_lib_program_init(&(conv2d->fft_pack_program));
+    errors_cnt += compute_lib_program_init(&(conv2d->fft_unpack_program));
+    if (errors_cnt != GL_NO_ERROR) {
+        return errors_cnt;
+    }
+
+    // kernel is correlated with the image, so element at offset d is placed at -d (wrapped around the padded size)
+    float* kernel_data = (float*) calloc(2 * fft_width * fft_height, sizeof(float));
+    for (int y = 0; y < kernel_size; y++) {
+        for (int x = 0; x < kernel_size; x++) {
+            int px = (fft_width - (x - kernel_span)) & (fft_width - 1);
+            int py = (fft_height - (y - kernel_span)) & (fft_height - 1);
+            kernel_data[2 * (py * fft_width + px)] = kernel[y * kernel_size + x];
+        }
+    }
+    errors_cnt += compute_lib_ssbo_write(&(conv2d->fft->data_ssbo), kernel_data, 2 * fft_width * fft_height);
+    free(kernel_data);
+
+    errors_cnt += compute_lib_shaders_fft_transform(conv2d->fft, GL_FALSE);
+    errors_cnt += compute_lib_shaders_fft_swap_spectrum(conv2d->fft);
+    return errors_cnt;
+}
+
+/// Initializes the 2D convolution instance with explicit selection of the convolution method.
+/// \param kernel_length Number of kernel elements, the kernel has to be a square with odd size (NULL is returned otherwise).
+/// \param use_fft If GL_TRUE, the convolution is computed by multiplication of spectra, otherwise the kernel is applied directly.
+static inline compute_lib_shaders_conv2d_t* compute_lib_shaders_conv2d_init_ex(compute_lib_instance_t* inst, int local_size_x, int local_size_y, int image_width, int image_height, float* kernel, int kernel_length, GLboolean use_fft)
 {
+    // kernel has to be a square with odd size
+    int kernel_size = (int) (sqrtf((float) kernel_length) + 0.5f);
+    if (kernel_size * kernel_size != kernel_length || (kernel_size & 1) == 0) {
+        return NULL;
+    }
+
     compute_lib_shaders_conv2d_t* conv2d = (compute_lib_shaders_conv2d_t*) malloc(sizeof(compute_lib_shaders_conv2d_t));
+    conv2d->fft = NULL;
 
     conv2d->input_image2d = COMPUTE_LIB_IMAGE2D_NEW("input_image2d", GL_TEXTURE0, image_width, image_height, GL_READ_ONLY, 4, GL_UNSIGNED_BYTE);
     conv2d->input_image2d.resource.value = 0;
@@ -48,15 +128,18 @@ static inline compute_lib_shaders_conv2d_t* compute_lib_shaders_conv2d_init(comp
     conv2d->kernel_ssbo = COMPUTE_LIB_SSBO_NEW("kernel_ssbo", GL_FLOAT, GL_STATIC_READ);
     conv2d->kernel_ssbo.resource.value = 2;
 
-    conv2d->program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, 16, 16, 1);
+    conv2d->program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+    conv2d->fft_pack_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+    conv2d->fft_unpack_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
 
     GLchar* program_layout_str = compute_lib_program_glsl_layout(&(conv2d->program));
-    GLchar* input_image2d_layout_str = compute_lib_image2d_glsl_layout(&(conv2d->input_image2d));
+    GLchar* input_sampler_layout_str = compute_lib_image2d_glsl_sampler_layout(&(conv2d->input_image2d));
     GLchar* output_image2d_layout_str = compute_lib_image2d_glsl_layout(&(conv2d->output_image2d));
     GLchar* kernel_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(conv2d->kernel_ssbo));
-    asprintf(&(conv2d->program.source), _binary_src_shaders_conv2d_comp_start, program_layout_str, input_image2d_layout_str, output_image2d_layout_str, kernel_ssbo_layout_str);
+    asprintf(&(conv2d->program.source), _binary_src_shaders_conv2d_comp_start, program_layout_str, input_sampler_layout_str, output_image2d_layout_str, kernel_ssbo_layout_str,
+             COMPUTE_LIB_SHADERS_CONV2D_ROUNDING_EPSILON);
     free(program_layout_str);
-    free(input_image2d_layout_str);
+    free(input_sampler_layout_str);
     free(output_image2d_layout_str);
     free(kernel_ssbo_layout_str);
 
@@ -92,7 +175,40 @@ static inline compute_lib_shaders_conv2d_t* compute_lib_shaders_conv2d_init(comp
         return NULL;
     }
 
+    if (use_fft && compute_lib_shaders_conv2d_fft_init(conv2d, inst, kernel, kernel_length) != GL_NO_ERROR) {
+        compute_lib_shaders_conv2d_destroy(conv2d);
+        return NULL;
+    }
+
     return conv2d;
 }
 
+/// Initializes the 2D convolution instance, FFT-based convolution is selected for kernels with at least COMPUTE_LIB_SHADERS_CONV2D_FFT_MIN_KERNEL_AREA elements.
+static inline compute_lib_shaders_conv2d_t* compute_lib_shaders_conv2d_init(compute_lib_instance_t* inst, int local_size_x, int local_size_y, int image_width, int image_height, float* kernel, int kernel_length)
+{
+    return compute_lib_shaders_conv2d_init_ex(inst, local_size_x, local_size_y, image_width, image_height, kernel, kernel_length, kernel_length >= COMPUTE_LIB_SHADERS_CONV2D_FFT_MIN_KERNEL_AREA);
+}
+
+/// Runs the 2D convolution of the input image using the selected method.
+static inline GLuint compute_lib_shaders_conv2d_dispatch(compute_lib_shaders_conv2d_t* conv2d)
+{
+    GLuint errors_cnt = compute_lib_image2d_bind(&(conv2d->input_image2d)) + compute_lib_image2d_bind(&(conv2d->output_image2d));
+
+    if (conv2d->fft == NULL) {
+        // direct convolution reads the input through a sampler (texture cache)
+        errors_cnt += compute_lib_image2d_bind_sampler(&(conv2d->input_image2d));
+        errors_cnt += compute_lib_ssbo_bind(&(conv2d->kernel_ssbo));
+        errors_cnt += compute_lib_program_dispatch(&(conv2d->program), conv2d->input_image2d.width, conv2d->input_image2d.height, 1);
+        return errors_cnt;
+    }
+
+    errors_cnt += compute_lib_ssbo_bind(&(conv2d->fft->data_ssbo));
+    errors_cnt += compute_lib_program_dispatch(&(conv2d->fft_pack_program), conv2d->fft->width, conv2d->fft->height, 1);
+    errors_cnt += compute_lib_shaders_fft_transform(conv2d->fft, GL_FALSE);
+    errors_cnt += compute_lib_shaders_fft_multiply(conv2d->fft, 1.0f / (conv2d->fft->width * conv2d->fft->height));
+    errors_cnt += compute_lib_shaders_fft_transform(conv2d->fft, GL_TRUE);
+    errors_cnt += compute_lib_program_dispatch(&(conv2d->fft_unpack_program), conv2d->output_image2d.width, conv2d->output_image2d.height, 1);
+    return errors_cnt;
+}
+
 #endif // GLES32COMPUTELIB_CONV2D_H
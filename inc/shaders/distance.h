@@ -0,0 +1,166 @@
+/// \file distance.h
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Header file of the GLES3ComputeLib library implementation of the exact Euclidean distance transform (separable Felzenszwalb-Huttenlocher algorithm).
+/// \copyright GNU Public License.
+
+#pragma once
+
+#ifndef GLES32COMPUTELIB_DISTANCE_H
+#define GLES32COMPUTELIB_DISTANCE_H
+
+#define _GNU_SOURCE // asprintf
+#include <stdio.h>
+
+#include "compute_lib.h"
+
+/// Number of fractional bits of the 16-bit fixed-point output (distances up to 65534 / 2^bits pixels are representable).
+#ifndef COMPUTE_LIB_SHADERS_DISTANCE_FRACTION_BITS
+#define COMPUTE_LIB_SHADERS_DISTANCE_FRACTION_BITS 4
+#endif
+
+/// Output value of pixels without any obstacle in the image (16-bit fixed-point output, the float output holds positive infinity).
+#define COMPUTE_LIB_SHADERS_DISTANCE_INFINITY 0xFFFF
+
+/// Maximum image size, squared distances of the lower envelope have to be exact in float.
+#define COMPUTE_LIB_SHADERS_DISTANCE_MAX_SIZE 2048
+
+extern char _binary_src_shaders_distance_comp_start[];
+
+/// Enumeration of distance transform passes.
+enum compute_lib_shaders_distance_pass_e {
+    /// Distance to the nearest obstacle of the column (downward and upward sweep per column).
+    COMPUTE_LIB_SHADERS_DISTANCE_PASS_COLUMNS = 0,
+    /// Lower envelope of the parabolas given by the column distances of a row.
+    COMPUTE_LIB_SHADERS_DISTANCE_PASS_ROWS = 1
+};
+
+/// Structure of the distance transform instance.
+/// Every pixel of the output holds the Euclidean distance (in pixels) to the nearest obstacle, pixels of the input with nonzero red channel (RGBA8).
+/// The column pass runs one invocation per column, the row pass one invocation per row, so the cost is linear in the number of pixels
+/// and does not depend on the density of obstacles.
+typedef struct compute_lib_shaders_distance_s {
+    compute_lib_program_t programs[2];
+    compute_lib_image2d_t input_image2d;
+    /// Distances in pixels (R32F), or 16-bit fixed-point distances (RGBA16UI) of four consecutive pixels of a row per texel.
+    compute_lib_image2d_t output_image2d;
+    /// Distance to the nearest obstacle of the column (R32UI), 0xFFFFFFFF if the column has no obstacle.
+    compute_lib_image2d_t columns_image2d;
+    /// Vertices of the parabolas of the lower envelope of each row.
+    compute_lib_ssbo_t vertices_ssbo;
+    /// Boundaries between the parabolas of the lower envelope of each row.
+    compute_lib_ssbo_t boundaries_ssbo;
+    /// Output type, GL_FLOAT or GL_UNSIGNED_SHORT (fixed point with COMPUTE_LIB_SHADERS_DISTANCE_FRACTION_BITS fractional bits).
+    GLenum type;
+} compute_lib_shaders_distance_t;
+
+
+static inline void compute_lib_shaders_distance_destroy(compute_lib_shaders_distance_t* distance)
+{
+    compute_lib_image2d_destroy(&(distance->input_image2d));
+    compute_lib_image2d_destroy(&(distance->output_image2d));
+    compute_lib_image2d_destroy(&(distance->columns_image2d));
+    compute_lib_ssbo_destroy(&(distance->vertices_ssbo));
+    compute_lib_ssbo_destroy(&(distance->boundaries_ssbo));
+    for (int i = 0; i < 2; i++) {
+        compute_lib_program_destroy(&(distance->programs[i]), GL_TRUE);
+    }
+    free(distance);
+}
+
+/// Initializes the distance transform instance.
+/// \param local_size Number of invocations of a work group (columns of the column pass, rows of the row pass).
+/// \param type Output type, GL_FLOAT (R32F) or GL_UNSIGNED_SHORT (RGBA16UI with four pixels per texel, the output image is (image_width + 3) / 4 texels wide).
+static inline compute_lib_shaders_distance_t* compute_lib_shaders_distance_init(compute_lib_instance_t* inst, int local_size, int image_width, int image_height, GLenum type)
+{
+    if ((type != GL_FLOAT && type != GL_UNSIGNED_SHORT) || image_width > COMPUTE_LIB_SHADERS_DISTANCE_MAX_SIZE || image_height > COMPUTE_LIB_SHADERS_DISTANCE_MAX_SIZE) {
+        return NULL;
+    }
+
+    compute_lib_shaders_distance_t* distance = (compute_lib_shaders_distance_t*) malloc(sizeof(compute_lib_shaders_distance_t));
+    distance->type = type;
+
+    distance->input_image2d = COMPUTE_LIB_IMAGE2D_NEW("input_image2d", GL_TEXTURE0, image_width, image_height, GL_READ_ONLY, 4, GL_UNSIGNED_BYTE);
+    distance->input_image2d.resource.value = 0;
+    compute_lib_image2d_setup_format(&(distance->input_image2d));
+
+    if (type == GL_FLOAT) {
+        distance->output_image2d = COMPUTE_LIB_IMAGE2D_NEW("output_image2d", GL_TEXTURE1, image_width, image_height, GL_WRITE_ONLY, 1, GL_FLOAT);
+    } else {
+        distance->output_image2d = COMPUTE_LIB_IMAGE2D_NEW("output_image2d", GL_TEXTURE1, (image_width + 3) / 4, image_height, GL_WRITE_ONLY, 4, GL_UNSIGNED_SHORT);
+    }
+    distance->output_image2d.resource.value = 1;
+    compute_lib_image2d_setup_format(&(distance->output_image2d));
+
+    distance->columns_image2d = COMPUTE_LIB_IMAGE2D_NEW("columns_image2d", GL_TEXTURE2, image_width, image_height, GL_READ_WRITE, 1, GL_UNSIGNED_INT);
+    distance->columns_image2d.resource.value = 2;
+    compute_lib_image2d_setup_format(&(distance->columns_image2d));
+
+    distance->vertices_ssbo = COMPUTE_LIB_SSBO_NEW("vertices_ssbo", GL_INT, GL_DYNAMIC_COPY);
+    distance->vertices_ssbo.resource.value = 3;
+    distance->boundaries_ssbo = COMPUTE_LIB_SSBO_NEW("boundaries_ssbo", GL_FLOAT, GL_DYNAMIC_COPY);
+    distance->boundaries_ssbo.resource.value = 4;
+
+    for (int i = 0; i < 2; i++) {
+        distance->programs[i] = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size, 1, 1);
+    }
+
+    // the row pass only reads the column distances
+    compute_lib_image2d_t columns_input_image2d = distance->columns_image2d;
+    columns_input_image2d.access = GL_READ_ONLY;
+
+    GLchar* input_image2d_layout_str = compute_lib_image2d_glsl_layout(&(distance->input_image2d));
+    GLchar* output_image2d_layout_str = compute_lib_image2d_glsl_layout(&(distance->output_image2d));
+    GLchar* columns_image2d_layout_str = compute_lib_image2d_glsl_layout(&(distance->columns_image2d));
+    GLchar* columns_input_image2d_layout_str = compute_lib_image2d_glsl_layout(&columns_input_image2d);
+    GLchar* vertices_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(distance->vertices_ssbo));
+    GLchar* boundaries_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(distance->boundaries_ssbo));
+    for (int i = 0; i < 2; i++) {
+        GLchar* program_layout_str = compute_lib_program_glsl_layout(&(distance->programs[i]));
+        asprintf(&(distance->programs[i].source), _binary_src_shaders_distance_comp_start, program_layout_str, input_image2d_layout_str, output_image2d_layout_str,
+                 (i == COMPUTE_LIB_SHADERS_DISTANCE_PASS_COLUMNS) ? columns_image2d_layout_str : columns_input_image2d_layout_str, vertices_ssbo_layout_str, boundaries_ssbo_layout_str,
+                 i, type == GL_FLOAT, COMPUTE_LIB_SHADERS_DISTANCE_FRACTION_BITS);
+        free(program_layout_str);
+    }
+    free(input_image2d_layout_str);
+    free(output_image2d_layout_str);
+    free(columns_image2d_layout_str);
+    free(columns_input_image2d_layout_str);
+    free(vertices_ssbo_layout_str);
+    free(boundaries_ssbo_layout_str);
+
+    for (int i = 0; i < 2; i++) {
+        if (compute_lib_program_init(&(distance->programs[i])) != GL_NO_ERROR) {
+            compute_lib_shaders_distance_destroy(distance);
+            return NULL;
+        }
+    }
+
+    if (compute_lib_image2d_init(&(distance->input_image2d), 0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(distance->output_image2d), GL_COLOR_ATTACHMENT0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(distance->columns_image2d), 0) != GL_NO_ERROR ||
+            compute_lib_ssbo_init(&(distance->vertices_ssbo), NULL, image_width * image_height) != GL_NO_ERROR ||
+            compute_lib_ssbo_init(&(distance->boundaries_ssbo), NULL, image_width * image_height) != GL_NO_ERROR) {
+        compute_lib_shaders_distance_destroy(distance);
+        return NULL;
+    }
+
+    return distance;
+}
+
+/// Computes the distance transform of the input image into the output image.
+static inline GLuint compute_lib_shaders_distance_dispatch(compute_lib_shaders_distance_t* distance)
+{
+    compute_lib_image2d_t columns_input_image2d = distance->columns_image2d;
+    columns_input_image2d.access = GL_READ_ONLY;
+
+    GLuint errors_cnt = compute_lib_image2d_bind(&(distance->input_image2d)) + compute_lib_image2d_bind(&(distance->columns_image2d));
+    errors_cnt += compute_lib_program_dispatch(&(distance->programs[COMPUTE_LIB_SHADERS_DISTANCE_PASS_COLUMNS]), distance->input_image2d.width, 1, 1);
+
+    errors_cnt += compute_lib_image2d_bind(&columns_input_image2d) + compute_lib_image2d_bind(&(distance->output_image2d));
+    errors_cnt += compute_lib_ssbo_bind(&(distance->vertices_ssbo)) + compute_lib_ssbo_bind(&(distance->boundaries_ssbo));
+    errors_cnt += compute_lib_program_dispatch(&(distance->programs[COMPUTE_LIB_SHADERS_DISTANCE_PASS_ROWS]), distance->input_image2d.height, 1, 1);
+    return errors_cnt;
+}
+
+#endif // GLES32COMPUTELIB_DISTANCE_H
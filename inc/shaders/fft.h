@@ -0,0 +1,194 @@
+/// \file fft.h
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Header file of the GLES3ComputeLib library implementation of 2D fast Fourier transform (Stockham radix-4/radix-2 passes over SSBO complex data).
+/// \copyright GNU Public License.
+
+#pragma once
+
+#ifndef GLES32COMPUTELIB_FFT_H
+#define GLES32COMPUTELIB_FFT_H
+
+#define _GNU_SOURCE // asprintf
+#include <stdio.h>
+
+#include "compute_lib.h"
+
+extern char _binary_src_shaders_fft_comp_start[];
+extern char _binary_src_shaders_fft_multiply_comp_start[];
+
+/// Structure of the 2D FFT instance.
+/// Complex data are stored as interleaved (real, imaginary) float pairs in row-major order, dimensions must be powers of two.
+typedef struct compute_lib_shaders_fft_s {
+    compute_lib_program_t pass_program;
+    compute_lib_program_t multiply_program;
+    /// Complex data to be transformed in place.
+    compute_lib_ssbo_t data_ssbo;
+    /// Temporary buffer for out-of-place Stockham passes (swapped with data after every pass).
+    compute_lib_ssbo_t temp_ssbo;
+    /// Complex spectrum used as the second operand of the pointwise multiplication.
+    compute_lib_ssbo_t spectrum_ssbo;
+    compute_lib_uniform_t length_uniform;
+    compute_lib_uniform_t lines_uniform;
+    compute_lib_uniform_t strides_uniform;
+    compute_lib_uniform_t p_uniform;
+    compute_lib_uniform_t sign_uniform;
+    compute_lib_uniform_t radix_uniform;
+    compute_lib_uniform_t size_uniform;
+    compute_lib_uniform_t scale_uniform;
+    /// Width of the complex data (power of two).
+    int width;
+    /// Height of the complex data (power of two).
+    int height;
+} compute_lib_shaders_fft_t;
+
+
+static inline void compute_lib_shaders_fft_destroy(compute_lib_shaders_fft_t* fft)
+{
+    compute_lib_ssbo_destroy(&(fft->data_ssbo));
+    compute_lib_ssbo_destroy(&(fft->temp_ssbo));
+    compute_lib_ssbo_destroy(&(fft->spectrum_ssbo));
+    compute_lib_program_destroy(&(fft->pass_program), GL_TRUE);
+    compute_lib_program_destroy(&(fft->multiply_program), GL_TRUE);
+    free(fft);
+}
+
+/// Gets the smallest power of two greater or equal to the value.
+static inline int compute_lib_shaders_fft_size(int value)
+{
+    int size = 1;
+    while (size < value) size <<= 1;
+    return size;
+}
+
+static inline compute_lib_shaders_fft_t* compute_lib_shaders_fft_init(compute_lib_instance_t* inst, int local_size_x, int width, int height)
+{
+    if (width <= 0 || height <= 0 || (width & (width - 1)) != 0 || (height & (height - 1)) != 0) {
+        return NULL;
+    }
+
+    compute_lib_shaders_fft_t* fft = (compute_lib_shaders_fft_t*) malloc(sizeof(compute_lib_shaders_fft_t));
+    fft->width = width;
+    fft->height = height;
+
+    fft->data_ssbo = COMPUTE_LIB_SSBO_NEW("fft_data_ssbo", GL_FLOAT, GL_DYNAMIC_COPY);
+    fft->data_ssbo.resource.value = 0;
+    fft->temp_ssbo = COMPUTE_LIB_SSBO_NEW("fft_temp_ssbo", GL_FLOAT, GL_DYNAMIC_COPY);
+    fft->temp_ssbo.resource.value = 1;
+    fft->spectrum_ssbo = COMPUTE_LIB_SSBO_NEW("fft_spectrum_ssbo", GL_FLOAT, GL_DYNAMIC_COPY);
+    fft->spectrum_ssbo.resource.value = 2;
+
+    fft->pass_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, 1, 1);
+    fft->multiply_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, 1, 1);
+
+    GLchar* program_layout_str = compute_lib_program_glsl_layout(&(fft->pass_program));
+    GLchar* data_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(fft->data_ssbo));
+    GLchar* temp_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(fft->temp_ssbo));
+    GLchar* spectrum_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(fft->spectrum_ssbo));
+    asprintf(&(fft->pass_program.source), _binary_src_shaders_fft_comp_start, program_layout_str, data_ssbo_layout_str, temp_ssbo_layout_str);
+    asprintf(&(fft->multiply_program.source), _binary_src_shaders_fft_multiply_comp_start, program_layout_str, data_ssbo_layout_str, spectrum_ssbo_layout_str);
+    free(program_layout_str);
+    free(data_ssbo_layout_str);
+    free(temp_ssbo_layout_str);
+    free(spectrum_ssbo_layout_str);
+
+    if (compute_lib_program_init(&(fft->pass_program)) != GL_NO_ERROR || compute_lib_program_init(&(fft->multiply_program)) != GL_NO_ERROR) {
+        compute_lib_shaders_fft_destroy(fft);
+        return NULL;
+    }
+
+    fft->length_uniform = COMPUTE_LIB_UNIFORM_NEW("fft_length");
+    fft->lines_uniform = COMPUTE_LIB_UNIFORM_NEW("fft_lines");
+    fft->strides_uniform = COMPUTE_LIB_UNIFORM_NEW("fft_strides");
+    fft->p_uniform = COMPUTE_LIB_UNIFORM_NEW("fft_p");
+    fft->sign_uniform = COMPUTE_LIB_UNIFORM_NEW("fft_sign");
+    fft->radix_uniform = COMPUTE_LIB_UNIFORM_NEW("fft_radix");
+    fft->size_uniform = COMPUTE_LIB_UNIFORM_NEW("fft_size");
+    fft->scale_uniform = COMPUTE_LIB_UNIFORM_NEW("fft_scale");
+    if (compute_lib_uniform_init(&(fft->pass_program), &(fft->length_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(fft->pass_program), &(fft->lines_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(fft->pass_program), &(fft->strides_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(fft->pass_program), &(fft->p_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(fft->pass_program), &(fft->sign_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(fft->pass_program), &(fft->radix_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(fft->multiply_program), &(fft->size_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(fft->multiply_program), &(fft->scale_uniform)) != GL_NO_ERROR) {
+        compute_lib_shaders_fft_destroy(fft);
+        return NULL;
+    }
+
+    GLint size[2] = { width, height };
+    if (compute_lib_uniform_write(&(fft->multiply_program), &(fft->size_uniform), size) != GL_NO_ERROR) {
+        compute_lib_shaders_fft_destroy(fft);
+        return NULL;
+    }
+
+    if (compute_lib_ssbo_init(&(fft->data_ssbo), NULL, 2 * width * height) != GL_NO_ERROR ||
+            compute_lib_ssbo_init(&(fft->temp_ssbo), NULL, 2 * width * height) != GL_NO_ERROR ||
+            compute_lib_ssbo_init(&(fft->spectrum_ssbo), NULL, 2 * width * height) != GL_NO_ERROR) {
+        compute_lib_shaders_fft_destroy(fft);
+        return NULL;
+    }
+
+    return fft;
+}
+
+/// Swaps buffer handles of two SSBOs sharing the same type and size and binds them to their binding points.
+static inline GLuint compute_lib_shaders_fft_swap(compute_lib_ssbo_t* a, compute_lib_ssbo_t* b)
+{
+    GLuint handle = a->handle;
+    a->handle = b->handle;
+    b->handle = handle;
+    return compute_lib_ssbo_bind(a) + compute_lib_ssbo_bind(b);
+}
+
+/// Keeps the current content of the data buffer as the spectrum for the pointwise multiplication (no copy is performed).
+static inline GLuint compute_lib_shaders_fft_swap_spectrum(compute_lib_shaders_fft_t* fft)
+{
+    return compute_lib_shaders_fft_swap(&(fft->data_ssbo), &(fft->spectrum_ssbo));
+}
+
+/// Runs 1D transforms of all lines along one axis, radix-4 passes are used while possible followed by a single radix-2 pass for odd powers of two.
+static inline GLuint compute_lib_shaders_fft_transform_axis(compute_lib_shaders_fft_t* fft, int length, int lines, int element_stride, int line_stride, GLfloat sign)
+{
+    GLuint errors_cnt = 0;
+    GLint strides[2] = { element_stride, line_stride };
+    GLint p, radix;
+
+    errors_cnt += compute_lib_uniform_write(&(fft->pass_program), &(fft->length_uniform), &length);
+    errors_cnt += compute_lib_uniform_write(&(fft->pass_program), &(fft->lines_uniform), &lines);
+    errors_cnt += compute_lib_uniform_write(&(fft->pass_program), &(fft->strides_uniform), strides);
+    errors_cnt += compute_lib_uniform_write(&(fft->pass_program), &(fft->sign_uniform), &sign);
+
+    for (p = 1; p < length; p *= radix) {
+        radix = (length / p) >= 4 ? 4 : 2;
+        errors_cnt += compute_lib_uniform_write(&(fft->pass_program), &(fft->p_uniform), &p);
+        errors_cnt += compute_lib_uniform_write(&(fft->pass_program), &(fft->radix_uniform), &radix);
+        errors_cnt += compute_lib_program_dispatch(&(fft->pass_program), length / radix, lines, 1);
+        errors_cnt += compute_lib_shaders_fft_swap(&(fft->data_ssbo), &(fft->temp_ssbo));
+    }
+
+    return errors_cnt;
+}
+
+/// Runs 2D transform of the data buffer in place (rows first, then columns).
+/// \param inverse If GL_TRUE, the inverse transform is computed. Result is not normalized (scale by 1/(width*height) using the multiplication).
+static inline GLuint compute_lib_shaders_fft_transform(compute_lib_shaders_fft_t* fft, GLboolean inverse)
+{
+    GLuint errors_cnt = compute_lib_ssbo_bind(&(fft->data_ssbo)) + compute_lib_ssbo_bind(&(fft->temp_ssbo));
+    GLfloat sign = inverse ? 1.0f : -1.0f;
+    errors_cnt += compute_lib_shaders_fft_transform_axis(fft, fft->width, fft->height, 1, fft->width, sign);
+    errors_cnt += compute_lib_shaders_fft_transform_axis(fft, fft->height, fft->width, fft->width, 1, sign);
+    return errors_cnt;
+}
+
+/// Multiplies the data buffer by the spectrum buffer element-wise (complex product) and by the provided scale.
+static inline GLuint compute_lib_shaders_fft_multiply(compute_lib_shaders_fft_t* fft, GLfloat scale)
+{
+    GLuint errors_cnt = compute_lib_ssbo_bind(&(fft->data_ssbo)) + compute_lib_ssbo_bind(&(fft->spectrum_ssbo));
+    errors_cnt += compute_lib_uniform_write(&(fft->multiply_program), &(fft->scale_uniform), &scale);
+    errors_cnt += compute_lib_program_dispatch(&(fft->multiply_program), fft->width, fft->height, 1);
+    return errors_cnt;
+}
+
+#endif // GLES32COMPUTELIB_FFT_H
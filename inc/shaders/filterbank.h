@@ -0,0 +1,115 @@
+/// \file filterbank.h
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Header file of the GLES3ComputeLib library implementation of filter-bank 2D convolution (many kernels in a single dispatch).
+/// \copyright GNU Public License.
+
+#pragma once
+
+#ifndef GLES32COMPUTELIB_FILTERBANK_H
+#define GLES32COMPUTELIB_FILTERBANK_H
+
+#define _GNU_SOURCE // asprintf
+#include <stdio.h>
+
+#include "compute_lib.h"
+
+extern char _binary_src_shaders_filterbank_comp_start[];
+
+/// Structure of the filter-bank convolution instance.
+/// Responses of kernels 4*l .. 4*l+3 are packed into RGBA channels of output layer l,
+/// layers are stacked vertically in the output image (layer l starts at row l*image_height).
+typedef struct compute_lib_shaders_filterbank_s {
+    compute_lib_program_t program;
+    compute_lib_image2d_t input_image2d;
+    compute_lib_image2d_t output_image2d;
+    compute_lib_ssbo_t kernels_ssbo;
+    /// Number of kernels in the bank.
+    int num_kernels;
+    /// Number of output layers (RGBA32F, four kernels per layer).
+    int num_layers;
+    /// Kernel width and height (odd).
+    int kernel_size;
+} compute_lib_shaders_filterbank_t;
+
+
+static inline void compute_lib_shaders_filterbank_destroy(compute_lib_shaders_filterbank_t* filterbank)
+{
+    compute_lib_image2d_destroy(&(filterbank->input_image2d));
+    compute_lib_image2d_destroy(&(filterbank->output_image2d));
+    compute_lib_ssbo_destroy(&(filterbank->kernels_ssbo));
+    compute_lib_program_destroy(&(filterbank->program), GL_TRUE);
+    free(filterbank);
+}
+
+/// Initializes the filter-bank instance.
+/// \param kernels Row-major kernels stored one after another, num_kernels * kernel_size^2 elements.
+static inline compute_lib_shaders_filterbank_t* compute_lib_shaders_filterbank_init(compute_lib_instance_t* inst, int local_size_x, int local_size_y, int image_width, int image_height, float* kernels, int kernel_size, int num_kernels)
+{
+    if (kernel_size <= 0 || kernel_size % 2 != 1 || num_kernels <= 0) {
+        return NULL;
+    }
+
+    compute_lib_shaders_filterbank_t* filterbank = (compute_lib_shaders_filterbank_t*) malloc(sizeof(compute_lib_shaders_filterbank_t));
+    filterbank->num_kernels = num_kernels;
+    filterbank->num_layers = (num_kernels + 3) / 4;
+    filterbank->kernel_size = kernel_size;
+
+    filterbank->input_image2d = COMPUTE_LIB_IMAGE2D_NEW("input_image2d", GL_TEXTURE0, image_width, image_height, GL_READ_ONLY, 4, GL_UNSIGNED_BYTE);
+    filterbank->input_image2d.resource.value = 0;
+    compute_lib_image2d_setup_format(&(filterbank->input_image2d));
+
+    filterbank->output_image2d = COMPUTE_LIB_IMAGE2D_NEW("output_image2d", GL_TEXTURE1, image_width, image_height * filterbank->num_layers, GL_WRITE_ONLY, 4, GL_FLOAT);
+    filterbank->output_image2d.resource.value = 1;
+    compute_lib_image2d_setup_format(&(filterbank->output_image2d));
+
+    filterbank->kernels_ssbo = COMPUTE_LIB_SSBO_NEW("kernels_ssbo", GL_FLOAT, GL_STATIC_READ);
+    filterbank->kernels_ssbo.resource.value = 2;
+
+    filterbank->program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+
+    GLchar* program_layout_str = compute_lib_program_glsl_layout(&(filterbank->program));
+    GLchar* input_image2d_layout_str = compute_lib_image2d_glsl_layout(&(filterbank->input_image2d));
+    GLchar* output_image2d_layout_str = compute_lib_image2d_glsl_layout(&(filterbank->output_image2d));
+    GLchar* kernels_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(filterbank->kernels_ssbo));
+    asprintf(&(filterbank->program.source), _binary_src_shaders_filterbank_comp_start, program_layout_str, input_image2d_layout_str, output_image2d_layout_str, kernels_ssbo_layout_str, kernel_size, filterbank->num_layers);
+    free(program_layout_str);
+    free(input_image2d_layout_str);
+    free(output_image2d_layout_str);
+    free(kernels_ssbo_layout_str);
+
+    if (compute_lib_program_init(&(filterbank->program)) != GL_NO_ERROR) {
+        compute_lib_shaders_filterbank_destroy(filterbank);
+        return NULL;
+    }
+
+    if (compute_lib_image2d_init(&(filterbank->input_image2d), 0) != GL_NO_ERROR) {
+        compute_lib_shaders_filterbank_destroy(filterbank);
+        return NULL;
+    }
+
+    if (compute_lib_image2d_init(&(filterbank->output_image2d), GL_COLOR_ATTACHMENT0) != GL_NO_ERROR) {
+        compute_lib_shaders_filterbank_destroy(filterbank);
+        return NULL;
+    }
+
+    // interleave kernels by four so that a single tap of four kernels is one vec4 (missing kernels are zero)
+    int kernel_area = kernel_size * kernel_size;
+    int packed_length = filterbank->num_layers * kernel_area * 4;
+    float* packed = (float*) calloc(packed_length, sizeof(float));
+    for (int k = 0; k < num_kernels; k++) {
+        for (int i = 0; i < kernel_area; i++) {
+            packed[((k / 4) * kernel_area + i) * 4 + (k % 4)] = kernels[k * kernel_area + i];
+        }
+    }
+    GLuint errors_cnt = compute_lib_ssbo_init(&(filterbank->kernels_ssbo), packed, packed_length);
+    free(packed);
+    if (errors_cnt != GL_NO_ERROR) {
+        compute_lib_shaders_filterbank_destroy(filterbank);
+        return NULL;
+    }
+
+    return filterbank;
+}
+
+#endif // GLES32COMPUTELIB_FILTERBANK_H
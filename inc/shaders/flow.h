@@ -0,0 +1,240 @@
+/// \file flow.h
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Header file of the GLES3ComputeLib library implementation of pyramidal Lucas-Kanade optical flow (sparse point tracking and dense flow field).
+/// \copyright GNU Public License.
+
+#pragma once
+
+#ifndef GLES32COMPUTELIB_FLOW_H
+#define GLES32COMPUTELIB_FLOW_H
+
+#define _GNU_SOURCE // asprintf
+#include <stdio.h>
+
+#include "compute_lib.h"
+#include "shaders/pyramid.h"
+
+extern char _binary_src_shaders_flow_comp_start[];
+
+/// Enumeration of optical flow modes.
+enum compute_lib_shaders_flow_mode_e {
+    /// Points from the points SSBO are tracked by one work group each.
+    COMPUTE_LIB_SHADERS_FLOW_SPARSE = 0,
+    /// Flow of every pixel, windows of a work group are read from a shared-memory tile.
+    COMPUTE_LIB_SHADERS_FLOW_DENSE = 1
+};
+
+/// Structure of the optical flow instance.
+/// Frames are stored in two Gaussian pyramids (RGBA8, luma is tracked), each new frame is written into the pyramid of the frame before the previous one,
+/// so the pyramid of the previous frame is reused as the reference. Levels are processed from the coarsest one, the flow of a level is the initial guess
+/// of the next finer level, all dispatches run without any CPU synchronisation.
+typedef struct compute_lib_shaders_flow_s {
+    compute_lib_program_t program;
+    /// Pyramids of the last two frames.
+    compute_lib_shaders_pyramid_t* pyramids[2];
+    /// Index of the pyramid of the last frame.
+    int current;
+    /// Tracked points (float pairs x, y in pixels of the full resolution image).
+    compute_lib_ssbo_t points_ssbo;
+    /// Tracking results (float quadruplets): tracked position x, y, status (1 if tracked, 0 if lost) and mean absolute luma difference of the window.
+    compute_lib_ssbo_t tracks_ssbo;
+    /// Dense flow (RGBA32F), one mip level per pyramid level: flow x, y, status and mean absolute luma difference of the window.
+    compute_lib_image2d_t flow_image2d;
+    compute_lib_uniform_t level_uniform;
+    /// Optical flow mode (compute_lib_shaders_flow_mode_e).
+    GLenum mode;
+    int num_levels;
+    int window_radius;
+    int max_points;
+    int num_points;
+    /// Number of frames written so far (flow needs at least two).
+    int num_frames;
+} compute_lib_shaders_flow_t;
+
+
+static inline void compute_lib_shaders_flow_destroy(compute_lib_shaders_flow_t* flow)
+{
+    for (int i = 0; i < 2; i++) {
+        if (flow->pyramids[i] != NULL) {
+            compute_lib_shaders_pyramid_destroy(flow->pyramids[i]);
+        }
+    }
+    compute_lib_ssbo_destroy(&(flow->points_ssbo));
+    compute_lib_ssbo_destroy(&(flow->tracks_ssbo));
+    compute_lib_image2d_destroy(&(flow->flow_image2d));
+    compute_lib_program_destroy(&(flow->program), GL_TRUE);
+    free(flow);
+}
+
+/// Initializes the optical flow instance.
+/// \param local_size_x Local workers group size along x-axis (pixels of a dense tile, the sparse mode uses local_size_x * local_size_y invocations per point).
+/// \param mode Optical flow mode (compute_lib_shaders_flow_mode_e).
+/// \param num_levels Number of pyramid levels including the full resolution one.
+/// \param window_radius Half-size of the square tracking window.
+/// \param max_iterations Maximum number of Gauss-Newton iterations per level (iterations stop earlier when the update is below 0.01 px).
+/// \param max_points Capacity of the points SSBO (sparse mode).
+static inline compute_lib_shaders_flow_t* compute_lib_shaders_flow_init(compute_lib_instance_t* inst, int local_size_x, int local_size_y, int image_width, int image_height,
+        GLenum mode, int num_levels, int window_radius, int max_iterations, int max_points)
+{
+    // shared memory holds the window with its gradient border (sparse: patch, gradients and vec3 reduction buffer padded to 4 floats, dense: tile of the work group)
+    int window_size = 2 * window_radius + 1;
+    int shared_floats = (mode == COMPUTE_LIB_SHADERS_FLOW_SPARSE) ? (window_size + 2) * (window_size + 2) + 2 * window_size * window_size + 4 * local_size_x * local_size_y :
+                        (local_size_x + window_size + 1) * (local_size_y + window_size + 1);
+    if (mode > COMPUTE_LIB_SHADERS_FLOW_DENSE || num_levels < 1 || num_levels > compute_lib_shaders_pyramid_max_levels(image_width, image_height) || window_radius < 1 ||
+            max_iterations < 1 || shared_floats * 4 > 16384 || (mode == COMPUTE_LIB_SHADERS_FLOW_SPARSE && max_points < 1)) {
+        return NULL;
+    }
+
+    compute_lib_shaders_flow_t* flow = (compute_lib_shaders_flow_t*) malloc(sizeof(compute_lib_shaders_flow_t));
+    flow->mode = mode;
+    flow->num_levels = num_levels;
+    flow->window_radius = window_radius;
+    flow->max_points = (mode == COMPUTE_LIB_SHADERS_FLOW_SPARSE) ? max_points : 0;
+    flow->num_points = 0;
+    flow->num_frames = 0;
+    flow->current = 0;
+
+    flow->pyramids[0] = compute_lib_shaders_pyramid_init(inst, local_size_x, local_size_y, image_width, image_height, GL_UNSIGNED_BYTE, COMPUTE_LIB_SHADERS_PYRAMID_GAUSSIAN, num_levels);
+    flow->pyramids[1] = compute_lib_shaders_pyramid_init(inst, local_size_x, local_size_y, image_width, image_height, GL_UNSIGNED_BYTE, COMPUTE_LIB_SHADERS_PYRAMID_GAUSSIAN, num_levels);
+
+    flow->points_ssbo = COMPUTE_LIB_SSBO_NEW("points_ssbo", GL_FLOAT, GL_DYNAMIC_COPY);
+    flow->points_ssbo.resource.value = 0;
+    flow->tracks_ssbo = COMPUTE_LIB_SSBO_NEW("tracks_ssbo", GL_FLOAT, GL_DYNAMIC_COPY);
+    flow->tracks_ssbo.resource.value = 1;
+
+    // the sparse mode never accesses the flow image
+    flow->flow_image2d = (mode == COMPUTE_LIB_SHADERS_FLOW_DENSE) ? COMPUTE_LIB_IMAGE2D_NEW("flow_output_image2d", GL_TEXTURE2, image_width, image_height, GL_WRITE_ONLY, 4, GL_FLOAT) :
+                         COMPUTE_LIB_IMAGE2D_NEW("flow_output_image2d", GL_TEXTURE2, 1, 1, GL_WRITE_ONLY, 4, GL_FLOAT);
+    flow->flow_image2d.resource.value = 3;
+    flow->flow_image2d.levels = (mode == COMPUTE_LIB_SHADERS_FLOW_DENSE) ? num_levels : 1;
+    compute_lib_image2d_setup_format(&(flow->flow_image2d));
+
+    if (mode == COMPUTE_LIB_SHADERS_FLOW_SPARSE) {
+        flow->program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x * local_size_y, 1, 1);
+    } else {
+        flow->program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+    }
+
+    // levels of both pyramids and of the flow are bound through views with own names and units
+    compute_lib_image2d_t previous_image2d = COMPUTE_LIB_IMAGE2D_NEW("previous_image2d", GL_TEXTURE0, image_width, image_height, GL_READ_ONLY, 4, GL_UNSIGNED_BYTE);
+    previous_image2d.resource.value = 0;
+    compute_lib_image2d_setup_format(&previous_image2d);
+    compute_lib_image2d_t next_image2d = previous_image2d;
+    next_image2d.resource = COMPUTE_LIB_RESOURCE_NEW("next_image2d", GL_IMAGE_2D);
+    next_image2d.resource.value = 1;
+    compute_lib_image2d_t flow_input_image2d = flow->flow_image2d;
+    flow_input_image2d.resource = COMPUTE_LIB_RESOURCE_NEW("flow_input_image2d", GL_IMAGE_2D);
+    flow_input_image2d.resource.value = 2;
+    flow_input_image2d.access = GL_READ_ONLY;
+
+    GLchar* program_layout_str = compute_lib_program_glsl_layout(&(flow->program));
+    GLchar* previous_image2d_layout_str = compute_lib_image2d_glsl_layout(&previous_image2d);
+    GLchar* next_image2d_layout_str = compute_lib_image2d_glsl_layout(&next_image2d);
+    GLchar* flow_input_image2d_layout_str = compute_lib_image2d_glsl_layout(&flow_input_image2d);
+    GLchar* flow_output_image2d_layout_str = compute_lib_image2d_glsl_layout(&(flow->flow_image2d));
+    GLchar* points_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(flow->points_ssbo));
+    GLchar* tracks_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(flow->tracks_ssbo));
+    asprintf(&(flow->program.source), _binary_src_shaders_flow_comp_start, program_layout_str, previous_image2d_layout_str, next_image2d_layout_str, flow_input_image2d_layout_str,
+             flow_output_image2d_layout_str, points_ssbo_layout_str, tracks_ssbo_layout_str, mode, num_levels, window_radius, max_iterations);
+    free(program_layout_str);
+    free(previous_image2d_layout_str);
+    free(next_image2d_layout_str);
+    free(flow_input_image2d_layout_str);
+    free(flow_output_image2d_layout_str);
+    free(points_ssbo_layout_str);
+    free(tracks_ssbo_layout_str);
+
+    if (flow->pyramids[0] == NULL || flow->pyramids[1] == NULL || compute_lib_program_init(&(flow->program)) != GL_NO_ERROR) {
+        compute_lib_shaders_flow_destroy(flow);
+        return NULL;
+    }
+
+    flow->level_uniform = COMPUTE_LIB_UNIFORM_NEW("flow_level");
+    if (compute_lib_uniform_init(&(flow->program), &(flow->level_uniform)) != GL_NO_ERROR) {
+        compute_lib_shaders_flow_destroy(flow);
+        return NULL;
+    }
+
+    if (compute_lib_ssbo_init(&(flow->points_ssbo), NULL, 2 * ((flow->max_points > 0) ? flow->max_points : 1)) != GL_NO_ERROR ||
+            compute_lib_ssbo_init(&(flow->tracks_ssbo), NULL, 4 * ((flow->max_points > 0) ? flow->max_points : 1)) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(flow->flow_image2d), (mode == COMPUTE_LIB_SHADERS_FLOW_DENSE) ? GL_COLOR_ATTACHMENT0 : 0) != GL_NO_ERROR) {
+        compute_lib_shaders_flow_destroy(flow);
+        return NULL;
+    }
+
+    return flow;
+}
+
+/// Writes a new frame (RGBA8) into the pyramid of the frame before the previous one and computes its coarser levels, the previous frame becomes the reference.
+static inline GLuint compute_lib_shaders_flow_frame(compute_lib_shaders_flow_t* flow, void* image_data)
+{
+    flow->current = 1 - flow->current;
+    flow->num_frames++;
+    compute_lib_shaders_pyramid_t* pyramid = flow->pyramids[flow->current];
+    GLuint errors_cnt = compute_lib_image2d_write(&(pyramid->image2d), image_data);
+    errors_cnt += compute_lib_shaders_pyramid_dispatch(pyramid);
+    return errors_cnt;
+}
+
+/// Writes points tracked by the next sparse dispatch.
+/// \param points Float pairs x, y in pixels of the full resolution image.
+static inline GLuint compute_lib_shaders_flow_write_points(compute_lib_shaders_flow_t* flow, GLfloat* points, int num_points)
+{
+    if (num_points > flow->max_points) {
+        return 1;
+    }
+    flow->num_points = num_points;
+    return (num_points > 0) ? compute_lib_ssbo_write(&(flow->points_ssbo), points, 2 * num_points) : GL_NO_ERROR;
+}
+
+/// Computes the flow from the previous frame to the last one, level by level from the coarsest one.
+static inline GLuint compute_lib_shaders_flow_dispatch(compute_lib_shaders_flow_t* flow)
+{
+    if (flow->num_frames < 2) {
+        return 1;
+    }
+
+    compute_lib_image2d_t previous_image2d = flow->pyramids[1 - flow->current]->image2d;
+    previous_image2d.resource = COMPUTE_LIB_RESOURCE_NEW("previous_image2d", GL_IMAGE_2D);
+    previous_image2d.resource.value = 0;
+    compute_lib_image2d_t next_image2d = flow->pyramids[flow->current]->image2d;
+    next_image2d.resource = COMPUTE_LIB_RESOURCE_NEW("next_image2d", GL_IMAGE_2D);
+    next_image2d.resource.value = 1;
+    compute_lib_image2d_t flow_input_image2d = flow->flow_image2d;
+    flow_input_image2d.resource.value = 2;
+    flow_input_image2d.access = GL_READ_ONLY;
+    compute_lib_image2d_t flow_output_image2d = flow->flow_image2d;
+
+    GLuint errors_cnt = 0;
+    if (flow->mode == COMPUTE_LIB_SHADERS_FLOW_SPARSE) {
+        if (flow->num_points == 0) {
+            return GL_NO_ERROR;
+        }
+        errors_cnt += compute_lib_ssbo_bind(&(flow->points_ssbo)) + compute_lib_ssbo_bind(&(flow->tracks_ssbo));
+    }
+    for (int level = flow->num_levels - 1; level >= 0; level--) {
+        GLsizei width, height;
+        compute_lib_image2d_level_size(&(flow->pyramids[0]->image2d), level, &width, &height);
+        errors_cnt += compute_lib_uniform_write(&(flow->program), &(flow->level_uniform), &level);
+        errors_cnt += compute_lib_image2d_bind_level(&previous_image2d, level) + compute_lib_image2d_bind_level(&next_image2d, level);
+        if (flow->mode == COMPUTE_LIB_SHADERS_FLOW_SPARSE) {
+            errors_cnt += compute_lib_program_dispatch(&(flow->program), flow->num_points * flow->program.local_size_x, 1, 1);
+        } else {
+            // the coarsest level has no initial guess, its input view is never read
+            errors_cnt += compute_lib_image2d_bind_level(&flow_input_image2d, (level + 1 < flow->num_levels) ? level + 1 : level);
+            errors_cnt += compute_lib_image2d_bind_level(&flow_output_image2d, level);
+            errors_cnt += compute_lib_program_dispatch(&(flow->program), width, height, 1);
+        }
+    }
+    return errors_cnt;
+}
+
+/// Reads tracking results of the last sparse dispatch.
+/// \param tracks Output array of 4 * num_points floats (tracked x, y, status and mean absolute luma difference).
+static inline GLuint compute_lib_shaders_flow_read_tracks(compute_lib_shaders_flow_t* flow, GLfloat* tracks)
+{
+    return (flow->num_points > 0) ? compute_lib_ssbo_read(&(flow->tracks_ssbo), tracks, 4 * flow->num_points) : GL_NO_ERROR;
+}
+
+#endif // GLES32COMPUTELIB_FLOW_H
@@ -0,0 +1,200 @@
+/// \file gemm.h
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Header file of the GLES3ComputeLib library implementation of tiled matrix multiplication (SGEMM, batched SGEMM) and matrix-vector product over SSBOs.
+/// \copyright GNU Public License.
+
+#pragma once
+
+#ifndef GLES32COMPUTELIB_GEMM_H
+#define GLES32COMPUTELIB_GEMM_H
+
+#define _GNU_SOURCE // asprintf
+#include <stdio.h>
+
+#include "compute_lib.h"
+
+/// Default output tile size of a work group (rows and columns), can be overridden per device.
+#ifndef COMPUTE_LIB_SHADERS_GEMM_TILE
+#define COMPUTE_LIB_SHADERS_GEMM_TILE 32
+#endif
+/// Default depth of the shared memory tiles.
+#ifndef COMPUTE_LIB_SHADERS_GEMM_TILE_K
+#define COMPUTE_LIB_SHADERS_GEMM_TILE_K 16
+#endif
+/// Default number of output rows and columns computed by a single invocation.
+#ifndef COMPUTE_LIB_SHADERS_GEMM_WORK
+#define COMPUTE_LIB_SHADERS_GEMM_WORK 4
+#endif
+
+extern char _binary_src_shaders_gemm_comp_start[];
+extern char _binary_src_shaders_gemv_comp_start[];
+
+/// Structure of the matrix multiplication instance.
+/// Matrices are packed row-major float SSBOs owned by the caller, they are bound to the programs at dispatch time.
+/// Each work group computes TILE x TILE block of the output from TILE x TILE_K tiles of the inputs in shared memory,
+/// each invocation accumulates WORK x WORK outputs in registers.
+typedef struct compute_lib_shaders_gemm_s {
+    compute_lib_program_t gemm_program;
+    compute_lib_program_t gemv_program;
+    compute_lib_uniform_t gemm_size_uniform;
+    compute_lib_uniform_t gemm_transpose_uniform;
+    compute_lib_uniform_t gemm_scale_uniform;
+    compute_lib_uniform_t gemm_batch_stride_uniform;
+    compute_lib_uniform_t gemv_size_uniform;
+    compute_lib_uniform_t gemv_transpose_uniform;
+    compute_lib_uniform_t gemv_scale_uniform;
+    int tile;
+    int tile_k;
+    int work;
+} compute_lib_shaders_gemm_t;
+
+
+static inline void compute_lib_shaders_gemm_destroy(compute_lib_shaders_gemm_t* gemm)
+{
+    compute_lib_program_destroy(&(gemm->gemm_program), GL_TRUE);
+    compute_lib_program_destroy(&(gemm->gemv_program), GL_TRUE);
+    free(gemm);
+}
+
+/// Initializes the matrix multiplication instance with device specific tiling.
+/// \param tile Output tile size of a work group, multiple of work (e.g. 16 to 64).
+/// \param tile_k Depth of the shared memory tiles (shared memory of 8*tile*tile_k bytes is used).
+/// \param work Number of output rows and columns computed by a single invocation (work group has (tile/work)^2 invocations).
+/// \param gemv_local_size Number of invocations in a work group of matrix-vector product, must be a power of two.
+static inline compute_lib_shaders_gemm_t* compute_lib_shaders_gemm_init_ex(compute_lib_instance_t* inst, int tile, int tile_k, int work, int gemv_local_size)
+{
+    if (tile <= 0 || tile_k <= 0 || work <= 0 || tile % work != 0 || (gemv_local_size & (gemv_local_size - 1)) != 0) {
+        return NULL;
+    }
+
+    compute_lib_shaders_gemm_t* gemm = (compute_lib_shaders_gemm_t*) malloc(sizeof(compute_lib_shaders_gemm_t));
+    gemm->tile = tile;
+    gemm->tile_k = tile_k;
+    gemm->work = work;
+
+    compute_lib_ssbo_t a_ssbo = COMPUTE_LIB_SSBO_NEW("a_ssbo", GL_FLOAT, GL_STATIC_DRAW);
+    a_ssbo.resource.value = 0;
+    compute_lib_ssbo_t b_ssbo = COMPUTE_LIB_SSBO_NEW("b_ssbo", GL_FLOAT, GL_STATIC_DRAW);
+    b_ssbo.resource.value = 1;
+    compute_lib_ssbo_t c_ssbo = COMPUTE_LIB_SSBO_NEW("c_ssbo", GL_FLOAT, GL_DYNAMIC_COPY);
+    c_ssbo.resource.value = 2;
+    compute_lib_ssbo_t x_ssbo = COMPUTE_LIB_SSBO_NEW("x_ssbo", GL_FLOAT, GL_STATIC_DRAW);
+    x_ssbo.resource.value = 1;
+    compute_lib_ssbo_t y_ssbo = COMPUTE_LIB_SSBO_NEW("y_ssbo", GL_FLOAT, GL_DYNAMIC_COPY);
+    y_ssbo.resource.value = 2;
+
+    gemm->gemm_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, tile / work, tile / work, 1);
+    gemm->gemv_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, gemv_local_size, 1, 1);
+
+    GLchar* gemm_layout_str = compute_lib_program_glsl_layout(&(gemm->gemm_program));
+    GLchar* gemv_layout_str = compute_lib_program_glsl_layout(&(gemm->gemv_program));
+    GLchar* a_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&a_ssbo);
+    GLchar* b_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&b_ssbo);
+    GLchar* c_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&c_ssbo);
+    GLchar* x_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&x_ssbo);
+    GLchar* y_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&y_ssbo);
+    asprintf(&(gemm->gemm_program.source), _binary_src_shaders_gemm_comp_start, gemm_layout_str, a_ssbo_layout_str, b_ssbo_layout_str, c_ssbo_layout_str, tile, tile_k, work);
+    asprintf(&(gemm->gemv_program.source), _binary_src_shaders_gemv_comp_start, gemv_layout_str, a_ssbo_layout_str, x_ssbo_layout_str, y_ssbo_layout_str);
+    free(gemm_layout_str);
+    free(gemv_layout_str);
+    free(a_ssbo_layout_str);
+    free(b_ssbo_layout_str);
+    free(c_ssbo_layout_str);
+    free(x_ssbo_layout_str);
+    free(y_ssbo_layout_str);
+
+    if (compute_lib_program_init(&(gemm->gemm_program)) != GL_NO_ERROR || compute_lib_program_init(&(gemm->gemv_program)) != GL_NO_ERROR) {
+        compute_lib_shaders_gemm_destroy(gemm);
+        return NULL;
+    }
+
+    gemm->gemm_size_uniform = COMPUTE_LIB_UNIFORM_NEW("gemm_size");
+    gemm->gemm_transpose_uniform = COMPUTE_LIB_UNIFORM_NEW("gemm_transpose");
+    gemm->gemm_scale_uniform = COMPUTE_LIB_UNIFORM_NEW("gemm_scale");
+    gemm->gemm_batch_stride_uniform = COMPUTE_LIB_UNIFORM_NEW("gemm_batch_stride");
+    gemm->gemv_size_uniform = COMPUTE_LIB_UNIFORM_NEW("gemv_size");
+    gemm->gemv_transpose_uniform = COMPUTE_LIB_UNIFORM_NEW("gemv_transpose");
+    gemm->gemv_scale_uniform = COMPUTE_LIB_UNIFORM_NEW("gemv_scale");
+    if (compute_lib_uniform_init(&(gemm->gemm_program), &(gemm->gemm_size_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(gemm->gemm_program), &(gemm->gemm_transpose_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(gemm->gemm_program), &(gemm->gemm_scale_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(gemm->gemm_program), &(gemm->gemm_batch_stride_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(gemm->gemv_program), &(gemm->gemv_size_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(gemm->gemv_program), &(gemm->gemv_transpose_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(gemm->gemv_program), &(gemm->gemv_scale_uniform)) != GL_NO_ERROR) {
+        compute_lib_shaders_gemm_destroy(gemm);
+        return NULL;
+    }
+
+    return gemm;
+}
+
+/// Initializes the matrix multiplication instance with the default tiling.
+static inline compute_lib_shaders_gemm_t* compute_lib_shaders_gemm_init(compute_lib_instance_t* inst)
+{
+    return compute_lib_shaders_gemm_init_ex(inst, COMPUTE_LIB_SHADERS_GEMM_TILE, COMPUTE_LIB_SHADERS_GEMM_TILE_K, COMPUTE_LIB_SHADERS_GEMM_WORK, 64);
+}
+
+/// Binds the caller's buffer to the binding point of the programs.
+static inline GLuint compute_lib_shaders_gemm_bind(compute_lib_ssbo_t* ssbo, GLint binding)
+{
+    compute_lib_ssbo_t bound_ssbo = *ssbo;
+    bound_ssbo.resource.value = binding;
+    return compute_lib_ssbo_bind(&bound_ssbo);
+}
+
+/// Computes batch of products C = alpha * op(A) * op(B) + beta * C of matrices stored one after another.
+/// \param a_ssbo Float SSBO with batch matrices MxK (KxM if transposed).
+/// \param b_ssbo Float SSBO with batch matrices KxN (NxK if transposed).
+/// \param c_ssbo Float SSBO with batch output matrices MxN (not read if beta is zero).
+/// \param batch Number of matrix products, each is computed by separate work groups along z-axis (at least 65535 are supported).
+static inline GLuint compute_lib_shaders_gemm_batched(compute_lib_shaders_gemm_t* gemm, compute_lib_ssbo_t* a_ssbo, compute_lib_ssbo_t* b_ssbo, compute_lib_ssbo_t* c_ssbo, GLuint m, GLuint n, GLuint k,
+                                                      GLboolean transpose_a, GLboolean transpose_b, GLfloat alpha, GLfloat beta, GLuint batch)
+{
+    GLuint size[3] = { m, n, k };
+    GLuint transpose[2] = { transpose_a ? 1 : 0, transpose_b ? 1 : 0 };
+    GLfloat scale[2] = { alpha, beta };
+    GLuint batch_stride[3] = { m * k, k * n, m * n };
+    GLuint threads = gemm->tile / gemm->work;
+
+    GLuint errors_cnt = compute_lib_shaders_gemm_bind(a_ssbo, 0) + compute_lib_shaders_gemm_bind(b_ssbo, 1) + compute_lib_shaders_gemm_bind(c_ssbo, 2);
+    errors_cnt += compute_lib_uniform_write(&(gemm->gemm_program), &(gemm->gemm_size_uniform), size);
+    errors_cnt += compute_lib_uniform_write(&(gemm->gemm_program), &(gemm->gemm_transpose_uniform), transpose);
+    errors_cnt += compute_lib_uniform_write(&(gemm->gemm_program), &(gemm->gemm_scale_uniform), scale);
+    errors_cnt += compute_lib_uniform_write(&(gemm->gemm_program), &(gemm->gemm_batch_stride_uniform), batch_stride);
+    errors_cnt += compute_lib_program_dispatch(&(gemm->gemm_program), (n + gemm->tile - 1) / gemm->tile * threads, (m + gemm->tile - 1) / gemm->tile * threads, batch);
+    return errors_cnt;
+}
+
+/// Computes product C = alpha * op(A) * op(B) + beta * C.
+/// \param a_ssbo Float SSBO with matrix MxK (KxM if transposed).
+/// \param b_ssbo Float SSBO with matrix KxN (NxK if transposed).
+/// \param c_ssbo Float SSBO with output matrix MxN (not read if beta is zero).
+static inline GLuint compute_lib_shaders_gemm_dispatch(compute_lib_shaders_gemm_t* gemm, compute_lib_ssbo_t* a_ssbo, compute_lib_ssbo_t* b_ssbo, compute_lib_ssbo_t* c_ssbo, GLuint m, GLuint n, GLuint k,
+                                                       GLboolean transpose_a, GLboolean transpose_b, GLfloat alpha, GLfloat beta)
+{
+    return compute_lib_shaders_gemm_batched(gemm, a_ssbo, b_ssbo, c_ssbo, m, n, k, transpose_a, transpose_b, alpha, beta, 1);
+}
+
+/// Computes matrix-vector product y = alpha * op(A) * x + beta * y.
+/// \param a_ssbo Float SSBO with matrix MxN.
+/// \param x_ssbo Float SSBO with vector of N elements (M if transposed).
+/// \param y_ssbo Float SSBO with output vector of M elements (N if transposed), not read if beta is zero.
+static inline GLuint compute_lib_shaders_gemm_gemv(compute_lib_shaders_gemm_t* gemm, compute_lib_ssbo_t* a_ssbo, compute_lib_ssbo_t* x_ssbo, compute_lib_ssbo_t* y_ssbo, GLuint m, GLuint n,
+                                                   GLboolean transpose, GLfloat alpha, GLfloat beta)
+{
+    GLuint size[2] = { m, n };
+    GLuint transpose_value = transpose ? 1 : 0;
+    GLfloat scale[2] = { alpha, beta };
+
+    GLuint errors_cnt = compute_lib_shaders_gemm_bind(a_ssbo, 0) + compute_lib_shaders_gemm_bind(x_ssbo, 1) + compute_lib_shaders_gemm_bind(y_ssbo, 2);
+    errors_cnt += compute_lib_uniform_write(&(gemm->gemv_program), &(gemm->gemv_size_uniform), size);
+    errors_cnt += compute_lib_uniform_write(&(gemm->gemv_program), &(gemm->gemv_transpose_uniform), &transpose_value);
+    errors_cnt += compute_lib_uniform_write(&(gemm->gemv_program), &(gemm->gemv_scale_uniform), scale);
+    // work group per row, or invocation per column of the transposed matrix
+    errors_cnt += compute_lib_program_dispatch(&(gemm->gemv_program), transpose ? n : m * gemm->gemv_program.local_size_x, 1, 1);
+    return errors_cnt;
+}
+
+#endif // GLES32COMPUTELIB_GEMM_H
@@ -0,0 +1,239 @@
+/// \file guided.h
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Header file of the GLES3ComputeLib library implementation of the guided filter (O(1) box filters by sliding sums) of RGBA8 and RGBA32F images.
+/// \copyright GNU Public License.
+
+#pragma once
+
+#ifndef GLES32COMPUTELIB_GUIDED_H
+#define GLES32COMPUTELIB_GUIDED_H
+
+#define _GNU_SOURCE // asprintf
+#include <stdio.h>
+
+#include "compute_lib.h"
+
+/// Number of pixels of a row or column processed by a single invocation of the box filter passes (initialisation of the sliding sum is amortised over them).
+#ifndef COMPUTE_LIB_SHADERS_GUIDED_STRIP_LENGTH
+#define COMPUTE_LIB_SHADERS_GUIDED_STRIP_LENGTH 64
+#endif
+
+extern char _binary_src_shaders_guided_comp_start[];
+
+/// Enumeration of guided filter passes.
+enum compute_lib_shaders_guided_pass_e {
+    /// Row sums of the input, the guide and their products.
+    COMPUTE_LIB_SHADERS_GUIDED_PASS_MOMENTS_ROWS = 0,
+    /// Column sums of the moments and the linear coefficients of each window.
+    COMPUTE_LIB_SHADERS_GUIDED_PASS_COEFFICIENTS = 1,
+    /// Row sums of the coefficients.
+    COMPUTE_LIB_SHADERS_GUIDED_PASS_COEFFICIENTS_ROWS = 2,
+    /// Column sums of the coefficients and the output.
+    COMPUTE_LIB_SHADERS_GUIDED_PASS_OUTPUT = 3
+};
+
+/// Structure of the guided filter instance.
+/// RGB channels of the input are filtered by the luma of the guide image (output is a locally linear function of the guide),
+/// alpha channel is copied from the input. Windows are clipped to the image. Every mean is computed by a row pass and a column pass
+/// of sliding sums, so the cost does not depend on the radius.
+typedef struct compute_lib_shaders_guided_s {
+    compute_lib_program_t programs[4];
+    compute_lib_image2d_t input_image2d;
+    compute_lib_image2d_t guide_image2d;
+    compute_lib_image2d_t output_image2d;
+    /// Row sums (RGBA32F): input RGB and guide luma, then mean coefficients a.
+    compute_lib_image2d_t rows0_image2d;
+    /// Row sums (RGBA32F): products of input RGB and guide luma and squared guide luma, then mean coefficients b.
+    compute_lib_image2d_t rows1_image2d;
+    /// Coefficients a of RGB channels (RGBA32F).
+    compute_lib_image2d_t coefficients_a_image2d;
+    /// Coefficients b of RGB channels (RGBA32F).
+    compute_lib_image2d_t coefficients_b_image2d;
+    compute_lib_uniform_t radius_uniforms[4];
+    compute_lib_uniform_t epsilon_uniform;
+    /// Pixel component type, GL_UNSIGNED_BYTE (RGBA8) or GL_FLOAT (RGBA32F).
+    GLenum type;
+} compute_lib_shaders_guided_t;
+
+
+static inline void compute_lib_shaders_guided_destroy(compute_lib_shaders_guided_t* guided)
+{
+    compute_lib_image2d_destroy(&(guided->input_image2d));
+    compute_lib_image2d_destroy(&(guided->guide_image2d));
+    compute_lib_image2d_destroy(&(guided->output_image2d));
+    compute_lib_image2d_destroy(&(guided->rows0_image2d));
+    compute_lib_image2d_destroy(&(guided->rows1_image2d));
+    compute_lib_image2d_destroy(&(guided->coefficients_a_image2d));
+    compute_lib_image2d_destroy(&(guided->coefficients_b_image2d));
+    for (int i = 0; i < 4; i++) {
+        compute_lib_program_destroy(&(guided->programs[i]), GL_TRUE);
+    }
+    free(guided);
+}
+
+/// Initializes the guided filter instance.
+/// \param local_size Number of invocations of a work group, each invocation processes a strip of COMPUTE_LIB_SHADERS_GUIDED_STRIP_LENGTH pixels.
+/// \param type Pixel component type of the input, guide and output images, GL_UNSIGNED_BYTE (RGBA8) or GL_FLOAT (RGBA32F).
+static inline compute_lib_shaders_guided_t* compute_lib_shaders_guided_init(compute_lib_instance_t* inst, int local_size, int image_width, int image_height, GLenum type)
+{
+    if (type != GL_UNSIGNED_BYTE && type != GL_FLOAT) {
+        return NULL;
+    }
+
+    compute_lib_shaders_guided_t* guided = (compute_lib_shaders_guided_t*) malloc(sizeof(compute_lib_shaders_guided_t));
+    guided->type = type;
+
+    guided->input_image2d = COMPUTE_LIB_IMAGE2D_NEW("input_image2d", GL_TEXTURE0, image_width, image_height, GL_READ_ONLY, 4, type);
+    guided->input_image2d.resource.value = 0;
+    compute_lib_image2d_setup_format(&(guided->input_image2d));
+
+    guided->guide_image2d = COMPUTE_LIB_IMAGE2D_NEW("guide_image2d", GL_TEXTURE1, image_width, image_height, GL_READ_ONLY, 4, type);
+    guided->guide_image2d.resource.value = 1;
+    compute_lib_image2d_setup_format(&(guided->guide_image2d));
+
+    guided->output_image2d = COMPUTE_LIB_IMAGE2D_NEW("output_image2d", GL_TEXTURE2, image_width, image_height, GL_WRITE_ONLY, 4, type);
+    guided->output_image2d.resource.value = 2;
+    compute_lib_image2d_setup_format(&(guided->output_image2d));
+
+    guided->rows0_image2d = COMPUTE_LIB_IMAGE2D_NEW("rows0_image2d", GL_TEXTURE3, image_width, image_height, GL_WRITE_ONLY, 4, GL_FLOAT);
+    guided->rows0_image2d.resource.value = 3;
+    compute_lib_image2d_setup_format(&(guided->rows0_image2d));
+
+    guided->rows1_image2d = COMPUTE_LIB_IMAGE2D_NEW("rows1_image2d", GL_TEXTURE4, image_width, image_height, GL_WRITE_ONLY, 4, GL_FLOAT);
+    guided->rows1_image2d.resource.value = 4;
+    compute_lib_image2d_setup_format(&(guided->rows1_image2d));
+
+    guided->coefficients_a_image2d = COMPUTE_LIB_IMAGE2D_NEW("coefficients_a_image2d", GL_TEXTURE5, image_width, image_height, GL_WRITE_ONLY, 4, GL_FLOAT);
+    guided->coefficients_a_image2d.resource.value = 5;
+    compute_lib_image2d_setup_format(&(guided->coefficients_a_image2d));
+
+    guided->coefficients_b_image2d = COMPUTE_LIB_IMAGE2D_NEW("coefficients_b_image2d", GL_TEXTURE6, image_width, image_height, GL_WRITE_ONLY, 4, GL_FLOAT);
+    guided->coefficients_b_image2d.resource.value = 6;
+    compute_lib_image2d_setup_format(&(guided->coefficients_b_image2d));
+
+    // row passes run one invocation per strip of a row, column passes one invocation per strip of a column
+    for (int i = 0; i < 4; i++) {
+        if (i == COMPUTE_LIB_SHADERS_GUIDED_PASS_MOMENTS_ROWS || i == COMPUTE_LIB_SHADERS_GUIDED_PASS_COEFFICIENTS_ROWS) {
+            guided->programs[i] = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, 1, local_size, 1);
+        } else {
+            guided->programs[i] = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size, 1, 1);
+        }
+    }
+
+    // intermediate images are written by a pass and read by the next one
+    compute_lib_image2d_t rows0_input_image2d = guided->rows0_image2d;
+    rows0_input_image2d.access = GL_READ_ONLY;
+    compute_lib_image2d_t rows1_input_image2d = guided->rows1_image2d;
+    rows1_input_image2d.access = GL_READ_ONLY;
+    compute_lib_image2d_t coefficients_a_input_image2d = guided->coefficients_a_image2d;
+    coefficients_a_input_image2d.access = GL_READ_ONLY;
+    compute_lib_image2d_t coefficients_b_input_image2d = guided->coefficients_b_image2d;
+    coefficients_b_input_image2d.access = GL_READ_ONLY;
+
+    GLchar* input_image2d_layout_str = compute_lib_image2d_glsl_layout(&(guided->input_image2d));
+    GLchar* guide_image2d_layout_str = compute_lib_image2d_glsl_layout(&(guided->guide_image2d));
+    GLchar* output_image2d_layout_str = compute_lib_image2d_glsl_layout(&(guided->output_image2d));
+    GLchar* rows0_image2d_layout_str = compute_lib_image2d_glsl_layout(&(guided->rows0_image2d));
+    GLchar* rows1_image2d_layout_str = compute_lib_image2d_glsl_layout(&(guided->rows1_image2d));
+    GLchar* rows0_input_image2d_layout_str = compute_lib_image2d_glsl_layout(&rows0_input_image2d);
+    GLchar* rows1_input_image2d_layout_str = compute_lib_image2d_glsl_layout(&rows1_input_image2d);
+    GLchar* coefficients_a_image2d_layout_str = compute_lib_image2d_glsl_layout(&(guided->coefficients_a_image2d));
+    GLchar* coefficients_b_image2d_layout_str = compute_lib_image2d_glsl_layout(&(guided->coefficients_b_image2d));
+    GLchar* coefficients_a_input_image2d_layout_str = compute_lib_image2d_glsl_layout(&coefficients_a_input_image2d);
+    GLchar* coefficients_b_input_image2d_layout_str = compute_lib_image2d_glsl_layout(&coefficients_b_input_image2d);
+    for (int i = 0; i < 4; i++) {
+        GLboolean rows_written = (i == COMPUTE_LIB_SHADERS_GUIDED_PASS_MOMENTS_ROWS || i == COMPUTE_LIB_SHADERS_GUIDED_PASS_COEFFICIENTS_ROWS);
+        GLboolean coefficients_written = (i == COMPUTE_LIB_SHADERS_GUIDED_PASS_COEFFICIENTS);
+        GLchar* program_layout_str = compute_lib_program_glsl_layout(&(guided->programs[i]));
+        asprintf(&(guided->programs[i].source), _binary_src_shaders_guided_comp_start, program_layout_str, input_image2d_layout_str, guide_image2d_layout_str, output_image2d_layout_str,
+                 rows_written ? rows0_image2d_layout_str : rows0_input_image2d_layout_str, rows_written ? rows1_image2d_layout_str : rows1_input_image2d_layout_str,
+                 coefficients_written ? coefficients_a_image2d_layout_str : coefficients_a_input_image2d_layout_str,
+                 coefficients_written ? coefficients_b_image2d_layout_str : coefficients_b_input_image2d_layout_str, i, type == GL_FLOAT, COMPUTE_LIB_SHADERS_GUIDED_STRIP_LENGTH);
+        free(program_layout_str);
+    }
+    free(input_image2d_layout_str);
+    free(guide_image2d_layout_str);
+    free(output_image2d_layout_str);
+    free(rows0_image2d_layout_str);
+    free(rows1_image2d_layout_str);
+    free(rows0_input_image2d_layout_str);
+    free(rows1_input_image2d_layout_str);
+    free(coefficients_a_image2d_layout_str);
+    free(coefficients_b_image2d_layout_str);
+    free(coefficients_a_input_image2d_layout_str);
+    free(coefficients_b_input_image2d_layout_str);
+
+    for (int i = 0; i < 4; i++) {
+        if (compute_lib_program_init(&(guided->programs[i])) != GL_NO_ERROR) {
+            compute_lib_shaders_guided_destroy(guided);
+            return NULL;
+        }
+        guided->radius_uniforms[i] = COMPUTE_LIB_UNIFORM_NEW("guided_radius");
+        if (compute_lib_uniform_init(&(guided->programs[i]), &(guided->radius_uniforms[i])) != GL_NO_ERROR) {
+            compute_lib_shaders_guided_destroy(guided);
+            return NULL;
+        }
+    }
+    guided->epsilon_uniform = COMPUTE_LIB_UNIFORM_NEW("guided_epsilon");
+    if (compute_lib_uniform_init(&(guided->programs[COMPUTE_LIB_SHADERS_GUIDED_PASS_COEFFICIENTS]), &(guided->epsilon_uniform)) != GL_NO_ERROR) {
+        compute_lib_shaders_guided_destroy(guided);
+        return NULL;
+    }
+
+    if (compute_lib_image2d_init(&(guided->input_image2d), 0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(guided->guide_image2d), 0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(guided->output_image2d), GL_COLOR_ATTACHMENT0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(guided->rows0_image2d), 0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(guided->rows1_image2d), 0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(guided->coefficients_a_image2d), 0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(guided->coefficients_b_image2d), 0) != GL_NO_ERROR) {
+        compute_lib_shaders_guided_destroy(guided);
+        return NULL;
+    }
+
+    return guided;
+}
+
+/// Filters the input image by the guide image into the output image.
+/// \param radius Half-size of the square window, the window is (2*radius+1) pixels wide.
+/// \param epsilon Regularization of the coefficients (in squared pixel value units, 0-255 for RGBA8 images), larger values smooth more edges.
+static inline GLuint compute_lib_shaders_guided_dispatch(compute_lib_shaders_guided_t* guided, int radius, GLfloat epsilon)
+{
+    int width = guided->input_image2d.width, height = guided->input_image2d.height;
+    int strips_x = (width + COMPUTE_LIB_SHADERS_GUIDED_STRIP_LENGTH - 1) / COMPUTE_LIB_SHADERS_GUIDED_STRIP_LENGTH;
+    int strips_y = (height + COMPUTE_LIB_SHADERS_GUIDED_STRIP_LENGTH - 1) / COMPUTE_LIB_SHADERS_GUIDED_STRIP_LENGTH;
+    compute_lib_image2d_t rows0_input_image2d = guided->rows0_image2d;
+    rows0_input_image2d.access = GL_READ_ONLY;
+    compute_lib_image2d_t rows1_input_image2d = guided->rows1_image2d;
+    rows1_input_image2d.access = GL_READ_ONLY;
+    compute_lib_image2d_t coefficients_a_input_image2d = guided->coefficients_a_image2d;
+    coefficients_a_input_image2d.access = GL_READ_ONLY;
+    compute_lib_image2d_t coefficients_b_input_image2d = guided->coefficients_b_image2d;
+    coefficients_b_input_image2d.access = GL_READ_ONLY;
+
+    GLuint errors_cnt = 0;
+    for (int i = 0; i < 4; i++) {
+        errors_cnt += compute_lib_uniform_write(&(guided->programs[i]), &(guided->radius_uniforms[i]), &radius);
+    }
+    errors_cnt += compute_lib_uniform_write(&(guided->programs[COMPUTE_LIB_SHADERS_GUIDED_PASS_COEFFICIENTS]), &(guided->epsilon_uniform), &epsilon);
+
+    errors_cnt += compute_lib_image2d_bind(&(guided->input_image2d)) + compute_lib_image2d_bind(&(guided->guide_image2d));
+    errors_cnt += compute_lib_image2d_bind(&(guided->rows0_image2d)) + compute_lib_image2d_bind(&(guided->rows1_image2d));
+    errors_cnt += compute_lib_program_dispatch(&(guided->programs[COMPUTE_LIB_SHADERS_GUIDED_PASS_MOMENTS_ROWS]), strips_x, height, 1);
+
+    errors_cnt += compute_lib_image2d_bind(&rows0_input_image2d) + compute_lib_image2d_bind(&rows1_input_image2d);
+    errors_cnt += compute_lib_image2d_bind(&(guided->coefficients_a_image2d)) + compute_lib_image2d_bind(&(guided->coefficients_b_image2d));
+    errors_cnt += compute_lib_program_dispatch(&(guided->programs[COMPUTE_LIB_SHADERS_GUIDED_PASS_COEFFICIENTS]), width, strips_y, 1);
+
+    errors_cnt += compute_lib_image2d_bind(&coefficients_a_input_image2d) + compute_lib_image2d_bind(&coefficients_b_input_image2d);
+    errors_cnt += compute_lib_image2d_bind(&(guided->rows0_image2d)) + compute_lib_image2d_bind(&(guided->rows1_image2d));
+    errors_cnt += compute_lib_program_dispatch(&(guided->programs[COMPUTE_LIB_SHADERS_GUIDED_PASS_COEFFICIENTS_ROWS]), strips_x, height, 1);
+
+    errors_cnt += compute_lib_image2d_bind(&rows0_input_image2d) + compute_lib_image2d_bind(&rows1_input_image2d);
+    errors_cnt += compute_lib_image2d_bind(&(guided->output_image2d));
+    errors_cnt += compute_lib_program_dispatch(&(guided->programs[COMPUTE_LIB_SHADERS_GUIDED_PASS_OUTPUT]), width, strips_y, 1);
+    return errors_cnt;
+}
+
+#endif // GLES32COMPUTELIB_GUIDED_H
@@ -0,0 +1,163 @@
+/// \file histogram.h
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Header file of the GLES3ComputeLib library implementation of image histograms (shared-memory privatised bins) and histogram equalisation.
+/// \copyright GNU Public License.
+
+#pragma once
+
+#ifndef GLES32COMPUTELIB_HISTOGRAM_H
+#define GLES32COMPUTELIB_HISTOGRAM_H
+
+#define _GNU_SOURCE // asprintf
+#include <stdio.h>
+
+#include "compute_lib.h"
+
+extern char _binary_src_shaders_histogram_comp_start[];
+extern char _binary_src_shaders_histogram_cdf_comp_start[];
+extern char _binary_src_shaders_histogram_equalize_comp_start[];
+
+/// Enumeration of histogram modes.
+enum compute_lib_shaders_histogram_mode_e {
+    /// Single histogram of the red channel.
+    COMPUTE_LIB_SHADERS_HISTOGRAM_RED = 0,
+    /// Single histogram of BT.601 luma.
+    COMPUTE_LIB_SHADERS_HISTOGRAM_LUMA = 1,
+    /// Four histograms, one per RGBA channel (stored one after another).
+    COMPUTE_LIB_SHADERS_HISTOGRAM_RGBA = 2
+};
+
+/// Structure of the histogram instance.
+/// Each work group accumulates its pixels into shared-memory bins and merges them into the histogram SSBO with atomic adds.
+/// Histograms stay on GPU, cumulative distributions and equalisation look-up tables are computed from them by another program.
+typedef struct compute_lib_shaders_histogram_s {
+    compute_lib_program_t program;
+    compute_lib_program_t cdf_program;
+    compute_lib_program_t equalize_program;
+    compute_lib_image2d_t input_image2d;
+    /// Equalised image (RGBA8), single channel modes produce gray image.
+    compute_lib_image2d_t output_image2d;
+    /// Histogram bins (uint), num_histograms * num_bins elements.
+    compute_lib_ssbo_t histogram_ssbo;
+    /// Inclusive cumulative sums of the bins (uint), same layout as the histogram.
+    compute_lib_ssbo_t cdf_ssbo;
+    /// Equalisation look-up tables of bins to 8-bit values (uint), same layout as the histogram.
+    compute_lib_ssbo_t lut_ssbo;
+    /// Histogram mode (compute_lib_shaders_histogram_mode_e).
+    GLenum mode;
+    int num_bins;
+    int num_histograms;
+} compute_lib_shaders_histogram_t;
+
+
+static inline void compute_lib_shaders_histogram_destroy(compute_lib_shaders_histogram_t* histogram)
+{
+    compute_lib_image2d_destroy(&(histogram->input_image2d));
+    compute_lib_image2d_destroy(&(histogram->output_image2d));
+    compute_lib_ssbo_destroy(&(histogram->histogram_ssbo));
+    compute_lib_ssbo_destroy(&(histogram->cdf_ssbo));
+    compute_lib_ssbo_destroy(&(histogram->lut_ssbo));
+    compute_lib_program_destroy(&(histogram->program), GL_TRUE);
+    compute_lib_program_destroy(&(histogram->cdf_program), GL_TRUE);
+    compute_lib_program_destroy(&(histogram->equalize_program), GL_TRUE);
+    free(histogram);
+}
+
+/// Initializes the histogram instance.
+/// \param mode Histogram mode (compute_lib_shaders_histogram_mode_e).
+/// \param num_bins Number of bins of each histogram, power of two from 2 to 256 (8-bit values are mapped to bins uniformly).
+static inline compute_lib_shaders_histogram_t* compute_lib_shaders_histogram_init(compute_lib_instance_t* inst, int local_size_x, int local_size_y, int image_width, int image_height, GLenum mode, int num_bins)
+{
+    if (num_bins < 2 || num_bins > 256 || (num_bins & (num_bins - 1)) != 0 || mode > COMPUTE_LIB_SHADERS_HISTOGRAM_RGBA) {
+        return NULL;
+    }
+
+    compute_lib_shaders_histogram_t* histogram = (compute_lib_shaders_histogram_t*) malloc(sizeof(compute_lib_shaders_histogram_t));
+    histogram->mode = mode;
+    histogram->num_bins = num_bins;
+    histogram->num_histograms = (mode == COMPUTE_LIB_SHADERS_HISTOGRAM_RGBA) ? 4 : 1;
+
+    histogram->input_image2d = COMPUTE_LIB_IMAGE2D_NEW("input_image2d", GL_TEXTURE0, image_width, image_height, GL_READ_ONLY, 4, GL_UNSIGNED_BYTE);
+    histogram->input_image2d.resource.value = 0;
+    compute_lib_image2d_setup_format(&(histogram->input_image2d));
+
+    histogram->output_image2d = COMPUTE_LIB_IMAGE2D_NEW("output_image2d", GL_TEXTURE1, image_width, image_height, GL_WRITE_ONLY, 4, GL_UNSIGNED_BYTE);
+    histogram->output_image2d.resource.value = 1;
+    compute_lib_image2d_setup_format(&(histogram->output_image2d));
+
+    histogram->histogram_ssbo = COMPUTE_LIB_SSBO_NEW("histogram_ssbo", GL_UNSIGNED_INT, GL_DYNAMIC_COPY);
+    histogram->histogram_ssbo.resource.value = 2;
+    histogram->cdf_ssbo = COMPUTE_LIB_SSBO_NEW("cdf_ssbo", GL_UNSIGNED_INT, GL_DYNAMIC_COPY);
+    histogram->cdf_ssbo.resource.value = 3;
+    histogram->lut_ssbo = COMPUTE_LIB_SSBO_NEW("lut_ssbo", GL_UNSIGNED_INT, GL_DYNAMIC_COPY);
+    histogram->lut_ssbo.resource.value = 4;
+
+    histogram->program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+    histogram->cdf_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, num_bins, 1, 1);
+    histogram->equalize_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+
+    GLchar* program_layout_str = compute_lib_program_glsl_layout(&(histogram->program));
+    GLchar* cdf_layout_str = compute_lib_program_glsl_layout(&(histogram->cdf_program));
+    GLchar* input_image2d_layout_str = compute_lib_image2d_glsl_layout(&(histogram->input_image2d));
+    GLchar* output_image2d_layout_str = compute_lib_image2d_glsl_layout(&(histogram->output_image2d));
+    GLchar* histogram_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(histogram->histogram_ssbo));
+    GLchar* cdf_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(histogram->cdf_ssbo));
+    GLchar* lut_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(histogram->lut_ssbo));
+    asprintf(&(histogram->program.source), _binary_src_shaders_histogram_comp_start, program_layout_str, input_image2d_layout_str, histogram_ssbo_layout_str, mode, num_bins);
+    asprintf(&(histogram->cdf_program.source), _binary_src_shaders_histogram_cdf_comp_start, cdf_layout_str, histogram_ssbo_layout_str, cdf_ssbo_layout_str, lut_ssbo_layout_str, num_bins);
+    asprintf(&(histogram->equalize_program.source), _binary_src_shaders_histogram_equalize_comp_start, program_layout_str, input_image2d_layout_str, output_image2d_layout_str, lut_ssbo_layout_str, mode, num_bins);
+    free(program_layout_str);
+    free(cdf_layout_str);
+    free(input_image2d_layout_str);
+    free(output_image2d_layout_str);
+    free(histogram_ssbo_layout_str);
+    free(cdf_ssbo_layout_str);
+    free(lut_ssbo_layout_str);
+
+    if (compute_lib_program_init(&(histogram->program)) != GL_NO_ERROR ||
+            compute_lib_program_init(&(histogram->cdf_program)) != GL_NO_ERROR ||
+            compute_lib_program_init(&(histogram->equalize_program)) != GL_NO_ERROR) {
+        compute_lib_shaders_histogram_destroy(histogram);
+        return NULL;
+    }
+
+    int length = histogram->num_histograms * num_bins;
+    if (compute_lib_image2d_init(&(histogram->input_image2d), 0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(histogram->output_image2d), GL_COLOR_ATTACHMENT0) != GL_NO_ERROR ||
+            compute_lib_ssbo_init(&(histogram->histogram_ssbo), NULL, length) != GL_NO_ERROR ||
+            compute_lib_ssbo_init(&(histogram->cdf_ssbo), NULL, length) != GL_NO_ERROR ||
+            compute_lib_ssbo_init(&(histogram->lut_ssbo), NULL, length) != GL_NO_ERROR) {
+        compute_lib_shaders_histogram_destroy(histogram);
+        return NULL;
+    }
+
+    return histogram;
+}
+
+/// Computes histogram(s) of the input image. Bins are cleared first, only the zeroed bins are transferred from CPU.
+static inline GLuint compute_lib_shaders_histogram_dispatch(compute_lib_shaders_histogram_t* histogram)
+{
+    int length = histogram->num_histograms * histogram->num_bins;
+    GLuint* zeros = (GLuint*) calloc(length, sizeof(GLuint));
+    GLuint errors_cnt = compute_lib_ssbo_write(&(histogram->histogram_ssbo), zeros, length);
+    free(zeros);
+    errors_cnt += compute_lib_image2d_bind(&(histogram->input_image2d));
+    errors_cnt += compute_lib_program_dispatch(&(histogram->program), histogram->input_image2d.width, histogram->input_image2d.height, 1);
+    return errors_cnt;
+}
+
+/// Computes cumulative distributions and equalisation look-up tables from the last histogram(s), and writes the equalised image.
+static inline GLuint compute_lib_shaders_histogram_equalize(compute_lib_shaders_histogram_t* histogram)
+{
+    GLuint errors_cnt = compute_lib_ssbo_bind(&(histogram->histogram_ssbo));
+    errors_cnt += compute_lib_ssbo_bind(&(histogram->cdf_ssbo));
+    errors_cnt += compute_lib_ssbo_bind(&(histogram->lut_ssbo));
+    errors_cnt += compute_lib_program_dispatch(&(histogram->cdf_program), histogram->num_histograms * histogram->num_bins, 1, 1);
+    errors_cnt += compute_lib_image2d_bind(&(histogram->input_image2d));
+    errors_cnt += compute_lib_image2d_bind(&(histogram->output_image2d));
+    errors_cnt += compute_lib_program_dispatch(&(histogram->equalize_program), histogram->output_image2d.width, histogram->output_image2d.height, 1);
+    return errors_cnt;
+}
+
+#endif // GLES32COMPUTELIB_HISTOGRAM_H
@@ -0,0 +1,195 @@
+/// \file keypoints.h
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Header file of the GLES3ComputeLib library implementation of keypoint detection (FAST-9, Harris, Shi-Tomasi) with non-maximum suppression and compacted output.
+/// \copyright GNU Public License.
+
+#pragma once
+
+#ifndef GLES32COMPUTELIB_KEYPOINTS_H
+#define GLES32COMPUTELIB_KEYPOINTS_H
+
+#define _GNU_SOURCE // asprintf
+#include <stdio.h>
+
+#include "compute_lib.h"
+
+/// Maximum size of a grid cell (strict local maxima of the cell must fit the shared candidate list).
+#define COMPUTE_LIB_SHADERS_KEYPOINTS_MAX_CELL_SIZE 32
+/// Maximum radius of the non-maximum suppression window.
+#define COMPUTE_LIB_SHADERS_KEYPOINTS_MAX_NMS_RADIUS 3
+
+extern char _binary_src_shaders_keypoints_response_comp_start[];
+extern char _binary_src_shaders_keypoints_select_comp_start[];
+
+/// Enumeration of keypoint response methods.
+enum compute_lib_shaders_keypoints_method_e {
+    /// FAST-9 segment test on the circle of radius 3, score is the sum of differences above the intensity threshold.
+    COMPUTE_LIB_SHADERS_KEYPOINTS_FAST = 0,
+    /// Harris response (k = 0.04) of the structure tensor of Sobel gradients summed over 3x3 window.
+    COMPUTE_LIB_SHADERS_KEYPOINTS_HARRIS = 1,
+    /// Shi-Tomasi response (smaller eigenvalue) of the same structure tensor.
+    COMPUTE_LIB_SHADERS_KEYPOINTS_SHI_TOMASI = 2
+};
+
+/// Structure of a keypoint as stored in the keypoints SSBO.
+typedef struct compute_lib_shaders_keypoint_s {
+    GLfloat x, y;
+    GLfloat response;
+    GLfloat reserved;
+} compute_lib_shaders_keypoint_t;
+
+/// Structure of the keypoint detector instance.
+/// Response of each pixel is computed from the luma of the input image, local maxima are selected per grid cell by one work group
+/// (optionally limited to the strongest ones) and appended to the keypoints SSBO through an atomic counter.
+typedef struct compute_lib_shaders_keypoints_s {
+    compute_lib_program_t response_program;
+    compute_lib_program_t select_program;
+    /// Input RGBA8 image.
+    compute_lib_image2d_t input_image2d;
+    /// Response image (R32F), zero near the image border.
+    compute_lib_image2d_t response_image2d;
+    /// Detected keypoints (compute_lib_shaders_keypoint_t) in arbitrary order.
+    compute_lib_ssbo_t keypoints_ssbo;
+    /// Number of detected keypoints (including those exceeding the capacity).
+    compute_lib_acbo_t counter_acbo;
+    compute_lib_uniform_t fast_threshold_uniform;
+    compute_lib_uniform_t response_threshold_uniform;
+    /// Response method (compute_lib_shaders_keypoints_method_e).
+    GLenum method;
+    int cell_size;
+    int max_keypoints;
+    /// Number of keypoints detected by the last dispatch (valid after compute_lib_shaders_keypoints_read).
+    GLuint num_keypoints;
+} compute_lib_shaders_keypoints_t;
+
+
+static inline void compute_lib_shaders_keypoints_destroy(compute_lib_shaders_keypoints_t* keypoints)
+{
+    compute_lib_image2d_destroy(&(keypoints->input_image2d));
+    compute_lib_image2d_destroy(&(keypoints->response_image2d));
+    compute_lib_ssbo_destroy(&(keypoints->keypoints_ssbo));
+    compute_lib_acbo_destroy(&(keypoints->counter_acbo));
+    compute_lib_program_destroy(&(keypoints->response_program), GL_TRUE);
+    compute_lib_program_destroy(&(keypoints->select_program), GL_TRUE);
+    free(keypoints);
+}
+
+/// Initializes the keypoint detector instance.
+/// \param method Response method (compute_lib_shaders_keypoints_method_e).
+/// \param nms_radius Radius of the non-maximum suppression window (1 to COMPUTE_LIB_SHADERS_KEYPOINTS_MAX_NMS_RADIUS).
+/// \param cell_size Size of the grid cells (2 to COMPUTE_LIB_SHADERS_KEYPOINTS_MAX_CELL_SIZE), each processed by one work group.
+/// \param per_cell Maximum number of the strongest keypoints of each cell, 0 for no limit.
+/// \param max_keypoints Capacity of the keypoints SSBO.
+static inline compute_lib_shaders_keypoints_t* compute_lib_shaders_keypoints_init(compute_lib_instance_t* inst, int local_size_x, int local_size_y, int image_width, int image_height, GLenum method, int nms_radius, int cell_size, int per_cell, int max_keypoints)
+{
+    if (method > COMPUTE_LIB_SHADERS_KEYPOINTS_SHI_TOMASI || nms_radius < 1 || nms_radius > COMPUTE_LIB_SHADERS_KEYPOINTS_MAX_NMS_RADIUS ||
+            cell_size < 2 || cell_size > COMPUTE_LIB_SHADERS_KEYPOINTS_MAX_CELL_SIZE || per_cell < 0 || max_keypoints < 1) {
+        return NULL;
+    }
+
+    compute_lib_shaders_keypoints_t* keypoints = (compute_lib_shaders_keypoints_t*) malloc(sizeof(compute_lib_shaders_keypoints_t));
+    keypoints->method = method;
+    keypoints->cell_size = cell_size;
+    keypoints->max_keypoints = max_keypoints;
+    keypoints->num_keypoints = 0;
+
+    keypoints->input_image2d = COMPUTE_LIB_IMAGE2D_NEW("input_image2d", GL_TEXTURE0, image_width, image_height, GL_READ_ONLY, 4, GL_UNSIGNED_BYTE);
+    keypoints->input_image2d.resource.value = 0;
+    compute_lib_image2d_setup_format(&(keypoints->input_image2d));
+
+    keypoints->response_image2d = COMPUTE_LIB_IMAGE2D_NEW("response_image2d", GL_TEXTURE1, image_width, image_height, GL_WRITE_ONLY, 1, GL_FLOAT);
+    keypoints->response_image2d.resource.value = 1;
+    compute_lib_image2d_setup_format(&(keypoints->response_image2d));
+
+    keypoints->keypoints_ssbo = COMPUTE_LIB_SSBO_NEW("keypoints_ssbo", GL_FLOAT, GL_DYNAMIC_COPY);
+    keypoints->keypoints_ssbo.resource.value = 0;
+    keypoints->counter_acbo = COMPUTE_LIB_ACBO_NEW("keypoints_counter", GL_UNSIGNED_INT, GL_DYNAMIC_COPY);
+    keypoints->counter_acbo.resource.value = 0;
+
+    keypoints->response_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+    keypoints->select_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+
+    // selection program reads the response image
+    compute_lib_image2d_t response_input_image2d = keypoints->response_image2d;
+    response_input_image2d.access = GL_READ_ONLY;
+
+    GLchar* program_layout_str = compute_lib_program_glsl_layout(&(keypoints->response_program));
+    GLchar* input_image2d_layout_str = compute_lib_image2d_glsl_layout(&(keypoints->input_image2d));
+    GLchar* response_image2d_layout_str = compute_lib_image2d_glsl_layout(&(keypoints->response_image2d));
+    GLchar* response_input_image2d_layout_str = compute_lib_image2d_glsl_layout(&response_input_image2d);
+    GLchar* keypoints_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(keypoints->keypoints_ssbo));
+    asprintf(&(keypoints->response_program.source), _binary_src_shaders_keypoints_response_comp_start, program_layout_str, input_image2d_layout_str, response_image2d_layout_str, method);
+    asprintf(&(keypoints->select_program.source), _binary_src_shaders_keypoints_select_comp_start, program_layout_str, response_input_image2d_layout_str, keypoints_ssbo_layout_str,
+             keypoints->counter_acbo.resource.value, nms_radius, cell_size, per_cell, max_keypoints);
+    free(program_layout_str);
+    free(input_image2d_layout_str);
+    free(response_image2d_layout_str);
+    free(response_input_image2d_layout_str);
+    free(keypoints_ssbo_layout_str);
+
+    if (compute_lib_program_init(&(keypoints->response_program)) != GL_NO_ERROR ||
+            compute_lib_program_init(&(keypoints->select_program)) != GL_NO_ERROR) {
+        compute_lib_shaders_keypoints_destroy(keypoints);
+        return NULL;
+    }
+
+    keypoints->fast_threshold_uniform = COMPUTE_LIB_UNIFORM_NEW("fast_threshold");
+    keypoints->response_threshold_uniform = COMPUTE_LIB_UNIFORM_NEW("response_threshold");
+    if ((method == COMPUTE_LIB_SHADERS_KEYPOINTS_FAST && compute_lib_uniform_init(&(keypoints->response_program), &(keypoints->fast_threshold_uniform)) != GL_NO_ERROR) ||
+            compute_lib_uniform_init(&(keypoints->select_program), &(keypoints->response_threshold_uniform)) != GL_NO_ERROR) {
+        compute_lib_shaders_keypoints_destroy(keypoints);
+        return NULL;
+    }
+
+    if (compute_lib_image2d_init(&(keypoints->input_image2d), 0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(keypoints->response_image2d), GL_COLOR_ATTACHMENT0) != GL_NO_ERROR ||
+            compute_lib_ssbo_init(&(keypoints->keypoints_ssbo), NULL, 4 * max_keypoints) != GL_NO_ERROR ||
+            compute_lib_acbo_init(&(keypoints->counter_acbo), NULL, 1) != GL_NO_ERROR) {
+        compute_lib_shaders_keypoints_destroy(keypoints);
+        return NULL;
+    }
+
+    return keypoints;
+}
+
+/// Detects keypoints of the input image, no data are read back.
+/// \param threshold Minimum intensity difference (0-255) of the FAST segment test, or minimum Harris/Shi-Tomasi response (gradients normalised to [-1, 1]).
+static inline GLuint compute_lib_shaders_keypoints_dispatch(compute_lib_shaders_keypoints_t* keypoints, GLfloat threshold)
+{
+    int width = keypoints->input_image2d.width, height = keypoints->input_image2d.height;
+    GLfloat response_threshold = (keypoints->method == COMPUTE_LIB_SHADERS_KEYPOINTS_FAST) ? 0.0f : threshold;
+    GLuint errors_cnt = 0;
+    if (keypoints->method == COMPUTE_LIB_SHADERS_KEYPOINTS_FAST) {
+        errors_cnt += compute_lib_uniform_write(&(keypoints->response_program), &(keypoints->fast_threshold_uniform), &threshold);
+    }
+    errors_cnt += compute_lib_uniform_write(&(keypoints->select_program), &(keypoints->response_threshold_uniform), &response_threshold);
+    errors_cnt += compute_lib_acbo_write_uint_val(&(keypoints->counter_acbo), 0);
+    errors_cnt += compute_lib_ssbo_bind(&(keypoints->keypoints_ssbo));
+
+    errors_cnt += compute_lib_image2d_bind(&(keypoints->input_image2d)) + compute_lib_image2d_bind(&(keypoints->response_image2d));
+    errors_cnt += compute_lib_program_dispatch(&(keypoints->response_program), width, height, 1);
+
+    // one work group per cell
+    compute_lib_image2d_t response_input_image2d = keypoints->response_image2d;
+    response_input_image2d.access = GL_READ_ONLY;
+    int cells_x = (width + keypoints->cell_size - 1) / keypoints->cell_size, cells_y = (height + keypoints->cell_size - 1) / keypoints->cell_size;
+    errors_cnt += compute_lib_image2d_bind(&response_input_image2d);
+    errors_cnt += compute_lib_program_dispatch(&(keypoints->select_program), cells_x * keypoints->select_program.local_size_x, cells_y * keypoints->select_program.local_size_y, 1);
+    return errors_cnt;
+}
+
+/// Reads the detected keypoints.
+/// \param output Output array of at least max_keypoints entries.
+/// \param num_keypoints Output number of entries written (total number of detected keypoints is stored in the instance).
+static inline GLuint compute_lib_shaders_keypoints_read(compute_lib_shaders_keypoints_t* keypoints, compute_lib_shaders_keypoint_t* output, GLuint* num_keypoints)
+{
+    GLuint errors_cnt = compute_lib_acbo_read_uint_val(&(keypoints->counter_acbo), &(keypoints->num_keypoints));
+    *num_keypoints = (keypoints->num_keypoints < (GLuint) keypoints->max_keypoints) ? keypoints->num_keypoints : (GLuint) keypoints->max_keypoints;
+    if (*num_keypoints > 0 && errors_cnt == GL_NO_ERROR) {
+        errors_cnt += compute_lib_ssbo_read(&(keypoints->keypoints_ssbo), output, 4 * *num_keypoints);
+    }
+    return errors_cnt;
+}
+
+#endif // GLES32COMPUTELIB_KEYPOINTS_H
@@ -0,0 +1,211 @@
+/// \file match.h
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Header file of the GLES3ComputeLib library implementation of template matching (SSD, NCC) over a search window with the best match reduced and refined on GPU.
+/// \copyright GNU Public License.
+
+#pragma once
+
+#ifndef GLES32COMPUTELIB_MATCH_H
+#define GLES32COMPUTELIB_MATCH_H
+
+#define _GNU_SOURCE // asprintf
+#include <stdio.h>
+
+#include "compute_lib.h"
+#include "shaders/reduce.h"
+
+/// Maximum width and height of the template.
+#define COMPUTE_LIB_SHADERS_MATCH_MAX_TEMPLATE_SIZE 32
+/// Maximum number of shared memory elements of the response pass (input tile and template, 16 kB).
+#define COMPUTE_LIB_SHADERS_MATCH_MAX_SHARED_ELEMENTS 4096
+/// Number of invocations in a work group of the argmin/argmax reduction.
+#define COMPUTE_LIB_SHADERS_MATCH_REDUCE_LOCAL_SIZE 256
+
+extern char _binary_src_shaders_match_response_comp_start[];
+extern char _binary_src_shaders_match_refine_comp_start[];
+
+/// Enumeration of template matching methods.
+enum compute_lib_shaders_match_method_e {
+    /// Sum of squared differences of luma, the best match is the minimum.
+    COMPUTE_LIB_SHADERS_MATCH_SSD = 0,
+    /// Normalized cross-correlation of luma (-1 to 1), the best match is the maximum.
+    COMPUTE_LIB_SHADERS_MATCH_NCC = 1
+};
+
+/// Structure of the best match as stored in the result SSBO.
+typedef struct compute_lib_shaders_match_result_s {
+    /// Sub-pixel position of the template top-left corner in the input image.
+    GLfloat x, y;
+    /// Response at the best integer position.
+    GLfloat score;
+} compute_lib_shaders_match_result_t;
+
+/// Structure of the template matching instance.
+/// Response map of all template positions within the search window is computed from shared-memory tiles of luma,
+/// its extreme is found by the parallel reduction and refined by parabola fits on GPU, so only the result is read back.
+typedef struct compute_lib_shaders_match_s {
+    compute_lib_program_t response_program;
+    compute_lib_program_t refine_program;
+    /// Input RGBA8 image (reads outside the image are clamped to its edge).
+    compute_lib_image2d_t input_image2d;
+    /// Template RGBA8 image.
+    compute_lib_image2d_t template_image2d;
+    /// Response map (R32F), (search_width - template_width + 1) x (search_height - template_height + 1).
+    compute_lib_image2d_t response_image2d;
+    /// Best match (compute_lib_shaders_match_result_t).
+    compute_lib_ssbo_t result_ssbo;
+    /// Argmin (SSD) or argmax (NCC) reduction of the response map.
+    compute_lib_shaders_reduce_t* reduce;
+    compute_lib_uniform_t response_origin_uniform;
+    compute_lib_uniform_t refine_origin_uniform;
+    /// Matching method (compute_lib_shaders_match_method_e).
+    GLenum method;
+} compute_lib_shaders_match_t;
+
+
+static inline void compute_lib_shaders_match_destroy(compute_lib_shaders_match_t* match)
+{
+    if (match->reduce != NULL) {
+        compute_lib_shaders_reduce_destroy(match->reduce);
+    }
+    compute_lib_image2d_destroy(&(match->input_image2d));
+    compute_lib_image2d_destroy(&(match->template_image2d));
+    compute_lib_image2d_destroy(&(match->response_image2d));
+    compute_lib_ssbo_destroy(&(match->result_ssbo));
+    compute_lib_program_destroy(&(match->response_program), GL_TRUE);
+    compute_lib_program_destroy(&(match->refine_program), GL_TRUE);
+    free(match);
+}
+
+/// Initializes the template matching instance.
+/// \param template_width Template width (at most COMPUTE_LIB_SHADERS_MATCH_MAX_TEMPLATE_SIZE).
+/// \param template_height Template height (at most COMPUTE_LIB_SHADERS_MATCH_MAX_TEMPLATE_SIZE).
+/// \param search_width Width of the search window (at least template_width).
+/// \param search_height Height of the search window (at least template_height).
+/// \param method Matching method (compute_lib_shaders_match_method_e).
+static inline compute_lib_shaders_match_t* compute_lib_shaders_match_init(compute_lib_instance_t* inst, int local_size_x, int local_size_y, int image_width, int image_height,
+        int template_width, int template_height, int search_width, int search_height, GLenum method)
+{
+    if (template_width < 1 || template_height < 1 || template_width > COMPUTE_LIB_SHADERS_MATCH_MAX_TEMPLATE_SIZE || template_height > COMPUTE_LIB_SHADERS_MATCH_MAX_TEMPLATE_SIZE ||
+            search_width < template_width || search_height < template_height ||
+            (local_size_x + template_width - 1) * (local_size_y + template_height - 1) + template_width * template_height > COMPUTE_LIB_SHADERS_MATCH_MAX_SHARED_ELEMENTS) {
+        return NULL;
+    }
+
+    compute_lib_shaders_match_t* match = (compute_lib_shaders_match_t*) malloc(sizeof(compute_lib_shaders_match_t));
+    match->method = method;
+    match->reduce = NULL;
+
+    match->input_image2d = COMPUTE_LIB_IMAGE2D_NEW("input_image2d", GL_TEXTURE0, image_width, image_height, GL_READ_ONLY, 4, GL_UNSIGNED_BYTE);
+    match->input_image2d.resource.value = 0;
+    compute_lib_image2d_setup_format(&(match->input_image2d));
+
+    match->template_image2d = COMPUTE_LIB_IMAGE2D_NEW("template_image2d", GL_TEXTURE1, template_width, template_height, GL_READ_ONLY, 4, GL_UNSIGNED_BYTE);
+    match->template_image2d.resource.value = 1;
+    compute_lib_image2d_setup_format(&(match->template_image2d));
+
+    match->response_image2d = COMPUTE_LIB_IMAGE2D_NEW("response_image2d", GL_TEXTURE2, search_width - template_width + 1, search_height - template_height + 1, GL_WRITE_ONLY, 1, GL_FLOAT);
+    match->response_image2d.resource.value = 2;
+    compute_lib_image2d_setup_format(&(match->response_image2d));
+
+    match->result_ssbo = COMPUTE_LIB_SSBO_NEW("result_ssbo", GL_FLOAT, GL_DYNAMIC_COPY);
+    match->result_ssbo.resource.value = 5;
+
+    match->response_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+    match->refine_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, 1, 1, 1);
+
+    // reduced values and indices of the last pass are bound to the input binding points of the partial results
+    match->reduce = compute_lib_shaders_reduce_init(inst, COMPUTE_LIB_SHADERS_MATCH_REDUCE_LOCAL_SIZE, (method == COMPUTE_LIB_SHADERS_MATCH_SSD) ? COMPUTE_LIB_SHADERS_REDUCE_MIN : COMPUTE_LIB_SHADERS_REDUCE_MAX,
+                    &(match->response_image2d), NULL, match->response_image2d.width * match->response_image2d.height);
+    if (match->reduce == NULL) {
+        compute_lib_shaders_match_destroy(match);
+        return NULL;
+    }
+
+    compute_lib_image2d_t response_input_image2d = match->response_image2d;
+    response_input_image2d.access = GL_READ_ONLY;
+
+    GLchar* program_layout_str = compute_lib_program_glsl_layout(&(match->response_program));
+    GLchar* refine_program_layout_str = compute_lib_program_glsl_layout(&(match->refine_program));
+    GLchar* input_image2d_layout_str = compute_lib_image2d_glsl_layout(&(match->input_image2d));
+    GLchar* template_image2d_layout_str = compute_lib_image2d_glsl_layout(&(match->template_image2d));
+    GLchar* response_image2d_layout_str = compute_lib_image2d_glsl_layout(&(match->response_image2d));
+    GLchar* response_input_image2d_layout_str = compute_lib_image2d_glsl_layout(&response_input_image2d);
+    GLchar* values_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(match->reduce->values_in_ssbo));
+    GLchar* indices_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(match->reduce->indices_in_ssbo));
+    GLchar* result_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(match->result_ssbo));
+    asprintf(&(match->response_program.source), _binary_src_shaders_match_response_comp_start, program_layout_str, input_image2d_layout_str, template_image2d_layout_str, response_image2d_layout_str,
+             template_width, template_height, method);
+    asprintf(&(match->refine_program.source), _binary_src_shaders_match_refine_comp_start, refine_program_layout_str, response_input_image2d_layout_str, values_ssbo_layout_str, indices_ssbo_layout_str,
+             result_ssbo_layout_str);
+    free(program_layout_str);
+    free(refine_program_layout_str);
+    free(input_image2d_layout_str);
+    free(template_image2d_layout_str);
+    free(response_image2d_layout_str);
+    free(response_input_image2d_layout_str);
+    free(values_ssbo_layout_str);
+    free(indices_ssbo_layout_str);
+    free(result_ssbo_layout_str);
+
+    if (compute_lib_program_init(&(match->response_program)) != GL_NO_ERROR || compute_lib_program_init(&(match->refine_program)) != GL_NO_ERROR) {
+        compute_lib_shaders_match_destroy(match);
+        return NULL;
+    }
+
+    match->response_origin_uniform = COMPUTE_LIB_UNIFORM_NEW("match_origin");
+    match->refine_origin_uniform = COMPUTE_LIB_UNIFORM_NEW("match_origin");
+    if (compute_lib_uniform_init(&(match->response_program), &(match->response_origin_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(match->refine_program), &(match->refine_origin_uniform)) != GL_NO_ERROR) {
+        compute_lib_shaders_match_destroy(match);
+        return NULL;
+    }
+
+    if (compute_lib_image2d_init(&(match->input_image2d), 0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(match->template_image2d), 0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(match->response_image2d), GL_COLOR_ATTACHMENT0) != GL_NO_ERROR ||
+            compute_lib_ssbo_init(&(match->result_ssbo), NULL, 3) != GL_NO_ERROR) {
+        compute_lib_shaders_match_destroy(match);
+        return NULL;
+    }
+
+    return match;
+}
+
+/// Computes the response map of the search window only.
+/// \param origin_x Column of the search window top-left corner in the input image (may be outside of the image).
+/// \param origin_y Row of the search window top-left corner in the input image.
+static inline GLuint compute_lib_shaders_match_response(compute_lib_shaders_match_t* match, GLint origin_x, GLint origin_y)
+{
+    GLint origin[2] = { origin_x, origin_y };
+    GLuint errors_cnt = compute_lib_uniform_write(&(match->response_program), &(match->response_origin_uniform), origin);
+    errors_cnt += compute_lib_image2d_bind(&(match->input_image2d)) + compute_lib_image2d_bind(&(match->template_image2d)) + compute_lib_image2d_bind(&(match->response_image2d));
+    errors_cnt += compute_lib_program_dispatch(&(match->response_program), match->response_image2d.width, match->response_image2d.height, 1);
+    return errors_cnt;
+}
+
+/// Matches the template within the search window, the best match is kept on GPU until it is read.
+/// \param origin_x Column of the search window top-left corner in the input image (may be outside of the image).
+/// \param origin_y Row of the search window top-left corner in the input image.
+static inline GLuint compute_lib_shaders_match_dispatch(compute_lib_shaders_match_t* match, GLint origin_x, GLint origin_y)
+{
+    GLint origin[2] = { origin_x, origin_y };
+    GLuint errors_cnt = compute_lib_shaders_match_response(match, origin_x, origin_y);
+    errors_cnt += compute_lib_shaders_reduce_image2d(match->reduce, &(match->response_image2d));
+
+    compute_lib_image2d_t response_input_image2d = match->response_image2d;
+    response_input_image2d.access = GL_READ_ONLY;
+    errors_cnt += compute_lib_uniform_write(&(match->refine_program), &(match->refine_origin_uniform), origin);
+    errors_cnt += compute_lib_image2d_bind(&response_input_image2d) + compute_lib_ssbo_bind(&(match->result_ssbo));
+    errors_cnt += compute_lib_program_dispatch(&(match->refine_program), 1, 1, 1);
+    return errors_cnt;
+}
+
+/// Reads the best match of the last dispatch (transfers only the result from GPU to CPU).
+static inline GLuint compute_lib_shaders_match_read(compute_lib_shaders_match_t* match, compute_lib_shaders_match_result_t* result)
+{
+    return compute_lib_ssbo_read(&(match->result_ssbo), result, 3);
+}
+
+#endif // GLES32COMPUTELIB_MATCH_H
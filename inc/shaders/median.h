@@ -0,0 +1,204 @@
+/// \file median.h
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Header file of the GLES3ComputeLib library implementation of median and rank filters (sorting networks, sliding histograms) of 8-bit and 16-bit single channel images.
+/// \copyright GNU Public License.
+
+#pragma once
+
+#ifndef GLES32COMPUTELIB_MEDIAN_H
+#define GLES32COMPUTELIB_MEDIAN_H
+
+#define _GNU_SOURCE // asprintf
+#include <stdio.h>
+#include <string.h>
+
+#include "compute_lib.h"
+
+/// Largest window size for which the automatic selection uses sorting networks.
+#ifndef COMPUTE_LIB_SHADERS_MEDIAN_MAX_NETWORK_WINDOW
+#define COMPUTE_LIB_SHADERS_MEDIAN_MAX_NETWORK_WINDOW 5
+#endif
+/// Number of output rows processed by a single invocation of the histogram method (initialisation of the histogram is amortised over them).
+#ifndef COMPUTE_LIB_SHADERS_MEDIAN_STRIP_HEIGHT
+#define COMPUTE_LIB_SHADERS_MEDIAN_STRIP_HEIGHT 64
+#endif
+/// Largest work group of the histogram method for 8-bit images (256 bytes of shared memory per invocation, 16 kB in total), half of it for 16-bit images (two histogram levels).
+#define COMPUTE_LIB_SHADERS_MEDIAN_MAX_HISTOGRAM_LOCAL_SIZE 64
+/// Largest window size of the sorting network method.
+#define COMPUTE_LIB_SHADERS_MEDIAN_MAX_NETWORK_SIZE 7
+
+extern char _binary_src_shaders_median_comp_start[];
+
+/// Enumeration of rank filter methods.
+enum compute_lib_shaders_median_method_e {
+    /// Sorting network for windows up to COMPUTE_LIB_SHADERS_MEDIAN_MAX_NETWORK_WINDOW, histogram otherwise.
+    COMPUTE_LIB_SHADERS_MEDIAN_AUTO = 0,
+    /// Window is loaded into registers and the selected rank is found by a pruned Batcher odd-even merge sorting network (up to 7x7 windows).
+    COMPUTE_LIB_SHADERS_MEDIAN_NETWORK = 1,
+    /// Histogram of the window slides down a strip of rows (Huang, 2 * window_size updates per pixel), histograms are kept in shared memory.
+    /// 16-bit images slide a coarse histogram of upper bytes and a fine histogram of lower bytes of the coarse bin containing the rank,
+    /// the fine histogram is rebuilt from the window only when that coarse bin changes.
+    COMPUTE_LIB_SHADERS_MEDIAN_HISTOGRAM = 2
+};
+
+/// Structure of the median/rank filter instance.
+/// Input image (R8UI or R16UI) is read through an unsigned integer sampler, output image is R32UI (single channel unsigned images writable by compute shaders).
+/// Pixels outside of the image replicate the border.
+typedef struct compute_lib_shaders_median_s {
+    compute_lib_program_t program;
+    compute_lib_image2d_t input_image2d;
+    compute_lib_image2d_t output_image2d;
+    /// Selected method (compute_lib_shaders_median_method_e), never AUTO.
+    GLenum method;
+    int window_size;
+    /// Rank of the output value in the sorted window, (window_size^2 - 1) / 2 for median.
+    int rank;
+} compute_lib_shaders_median_t;
+
+
+static inline void compute_lib_shaders_median_destroy(compute_lib_shaders_median_t* median)
+{
+    compute_lib_image2d_destroy(&(median->input_image2d));
+    compute_lib_image2d_destroy(&(median->output_image2d));
+    compute_lib_program_destroy(&(median->program), GL_TRUE);
+    free(median);
+}
+
+/// Generates GLSL compare-exchange sequence of Batcher odd-even merge sort of length elements, pruned to comparators that affect the element at the rank.
+static inline GLchar* compute_lib_shaders_median_network(int length, int rank)
+{
+    int padded = 1;
+    while (padded < length) {
+        padded <<= 1;
+    }
+
+    // elements above length are considered infinite, so their comparators never swap
+    int num_comparators = 0;
+    int* comparators = (int*) malloc(2 * padded * padded * sizeof(int));
+    for (int p = 1; p < padded; p <<= 1) {
+        for (int k = p; k >= 1; k >>= 1) {
+            for (int j = k % p; j + k < padded; j += 2 * k) {
+                for (int i = 0; i < k && i + j + k < padded; i++) {
+                    if ((i + j) / (2 * p) == (i + j + k) / (2 * p) && i + j + k < length) {
+                        comparators[2 * num_comparators] = i + j;
+                        comparators[2 * num_comparators + 1] = i + j + k;
+                        num_comparators++;
+                    }
+                }
+            }
+        }
+    }
+
+    // backward pass keeps only comparators whose outputs reach the selected element
+    GLboolean* needed = (GLboolean*) calloc(length, sizeof(GLboolean));
+    GLboolean* kept = (GLboolean*) calloc(num_comparators, sizeof(GLboolean));
+    needed[rank] = GL_TRUE;
+    for (int c = num_comparators - 1; c >= 0; c--) {
+        int a = comparators[2 * c], b = comparators[2 * c + 1];
+        if (needed[a] || needed[b]) {
+            kept[c] = needed[a] = needed[b] = GL_TRUE;
+        }
+    }
+
+    size_t str_length = 1;
+    GLchar* str = (GLchar*) calloc(num_comparators * 16 + 1, sizeof(GLchar));
+    for (int c = 0; c < num_comparators; c++) {
+        if (kept[c]) {
+            str_length += sprintf(str + str_length - 1, "CE(%d, %d) ", comparators[2 * c], comparators[2 * c + 1]);
+        }
+    }
+
+    free(comparators);
+    free(needed);
+    free(kept);
+    return str;
+}
+
+/// Initializes the median/rank filter instance with explicit selection of the method.
+/// \param local_size_x Work group width of the sorting network method, the histogram method runs work groups of local_size_x * local_size_y invocations
+///                     clamped to COMPUTE_LIB_SHADERS_MEDIAN_MAX_HISTOGRAM_LOCAL_SIZE (half of it for 16-bit images).
+/// \param type Input value type, GL_UNSIGNED_BYTE (R8UI) or GL_UNSIGNED_SHORT (R16UI).
+/// \param window_size Odd window size from 3 to 15 (up to COMPUTE_LIB_SHADERS_MEDIAN_MAX_NETWORK_SIZE for the sorting network method).
+/// \param rank Rank of the output value in the sorted window (0 for minimum, window_size^2 - 1 for maximum), negative for median.
+/// \param method Rank filter method (compute_lib_shaders_median_method_e).
+static inline compute_lib_shaders_median_t* compute_lib_shaders_median_init_ex(compute_lib_instance_t* inst, int local_size_x, int local_size_y, int image_width, int image_height, GLenum type, int window_size, int rank, GLenum method)
+{
+    int window_length = window_size * window_size;
+    if ((type != GL_UNSIGNED_BYTE && type != GL_UNSIGNED_SHORT) || window_size < 3 || window_size > 15 || (window_size & 1) == 0 || rank >= window_length ||
+            method > COMPUTE_LIB_SHADERS_MEDIAN_HISTOGRAM) {
+        return NULL;
+    }
+    if (method == COMPUTE_LIB_SHADERS_MEDIAN_AUTO) {
+        method = (window_size <= COMPUTE_LIB_SHADERS_MEDIAN_MAX_NETWORK_WINDOW) ? COMPUTE_LIB_SHADERS_MEDIAN_NETWORK : COMPUTE_LIB_SHADERS_MEDIAN_HISTOGRAM;
+    }
+    if (method == COMPUTE_LIB_SHADERS_MEDIAN_NETWORK && window_size > COMPUTE_LIB_SHADERS_MEDIAN_MAX_NETWORK_SIZE) {
+        return NULL;
+    }
+
+    compute_lib_shaders_median_t* median = (compute_lib_shaders_median_t*) malloc(sizeof(compute_lib_shaders_median_t));
+    median->method = method;
+    median->window_size = window_size;
+    median->rank = (rank < 0) ? (window_length - 1) / 2 : rank;
+
+    median->input_image2d = COMPUTE_LIB_IMAGE2D_NEW("input_image2d", GL_TEXTURE0, image_width, image_height, GL_READ_ONLY, 1, type);
+    median->input_image2d.resource.value = 0;
+    compute_lib_image2d_setup_format(&(median->input_image2d));
+
+    median->output_image2d = COMPUTE_LIB_IMAGE2D_NEW("output_image2d", GL_TEXTURE1, image_width, image_height, GL_WRITE_ONLY, 1, GL_UNSIGNED_INT);
+    median->output_image2d.resource.value = 1;
+    compute_lib_image2d_setup_format(&(median->output_image2d));
+
+    // histogram method runs one invocation per column of a strip
+    if (method == COMPUTE_LIB_SHADERS_MEDIAN_NETWORK) {
+        median->program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+    } else {
+        int local_size = local_size_x * local_size_y;
+        int max_local_size = (type == GL_UNSIGNED_SHORT) ? COMPUTE_LIB_SHADERS_MEDIAN_MAX_HISTOGRAM_LOCAL_SIZE / 2 : COMPUTE_LIB_SHADERS_MEDIAN_MAX_HISTOGRAM_LOCAL_SIZE;
+        median->program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, (local_size < max_local_size) ? local_size : max_local_size, 1, 1);
+    }
+
+    GLchar* network_str = (method == COMPUTE_LIB_SHADERS_MEDIAN_NETWORK) ? compute_lib_shaders_median_network(window_length, median->rank) : strdup("");
+    GLchar* program_layout_str = compute_lib_program_glsl_layout(&(median->program));
+    GLchar* input_sampler_layout_str = compute_lib_image2d_glsl_sampler_layout(&(median->input_image2d));
+    GLchar* output_image2d_layout_str = compute_lib_image2d_glsl_layout(&(median->output_image2d));
+    asprintf(&(median->program.source), _binary_src_shaders_median_comp_start, program_layout_str, input_sampler_layout_str, output_image2d_layout_str, method, window_size, median->rank,
+             COMPUTE_LIB_SHADERS_MEDIAN_STRIP_HEIGHT, (type == GL_UNSIGNED_SHORT) ? 16 : 8, network_str);
+    free(network_str);
+    free(program_layout_str);
+    free(input_sampler_layout_str);
+    free(output_image2d_layout_str);
+
+    if (compute_lib_program_init(&(median->program)) != GL_NO_ERROR) {
+        compute_lib_shaders_median_destroy(median);
+        return NULL;
+    }
+
+    if (compute_lib_image2d_init(&(median->input_image2d), 0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(median->output_image2d), GL_COLOR_ATTACHMENT0) != GL_NO_ERROR) {
+        compute_lib_shaders_median_destroy(median);
+        return NULL;
+    }
+
+    return median;
+}
+
+/// Initializes the median filter instance, the method is selected by the window size.
+static inline compute_lib_shaders_median_t* compute_lib_shaders_median_init(compute_lib_instance_t* inst, int local_size_x, int local_size_y, int image_width, int image_height, GLenum type, int window_size)
+{
+    return compute_lib_shaders_median_init_ex(inst, local_size_x, local_size_y, image_width, image_height, type, window_size, -1, COMPUTE_LIB_SHADERS_MEDIAN_AUTO);
+}
+
+/// Filters the input image into the output image.
+static inline GLuint compute_lib_shaders_median_dispatch(compute_lib_shaders_median_t* median)
+{
+    GLuint errors_cnt = compute_lib_image2d_bind_sampler(&(median->input_image2d)) + compute_lib_image2d_bind(&(median->output_image2d));
+    if (median->method == COMPUTE_LIB_SHADERS_MEDIAN_NETWORK) {
+        errors_cnt += compute_lib_program_dispatch(&(median->program), median->output_image2d.width, median->output_image2d.height, 1);
+    } else {
+        errors_cnt += compute_lib_program_dispatch(&(median->program), median->output_image2d.width, (median->output_image2d.height + COMPUTE_LIB_SHADERS_MEDIAN_STRIP_HEIGHT - 1) / COMPUTE_LIB_SHADERS_MEDIAN_STRIP_HEIGHT, 1);
+    }
+    return errors_cnt;
+}
+
+#endif // GLES32COMPUTELIB_MEDIAN_H
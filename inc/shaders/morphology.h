@@ -0,0 +1,368 @@
+/// \file morphology.h
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Header file of the GLES3ComputeLib library implementation of morphological operations (erosion, dilation, opening, closing) of grey and packed binary images.
+/// \copyright GNU Public License.
+
+#pragma once
+
+#ifndef GLES32COMPUTELIB_MORPHOLOGY_H
+#define GLES32COMPUTELIB_MORPHOLOGY_H
+
+#define _GNU_SOURCE // asprintf
+#include <stdio.h>
+
+#include "compute_lib.h"
+
+/// Maximum width or height of rectangular structuring elements.
+#define COMPUTE_LIB_SHADERS_MORPHOLOGY_MAX_ELEMENT_SIZE 255
+
+extern char _binary_src_shaders_morphology_comp_start[];
+extern char _binary_src_shaders_morphology_mask_comp_start[];
+extern char _binary_src_shaders_morphology_pack_comp_start[];
+
+/// Enumeration of morphological operations.
+enum compute_lib_shaders_morphology_op_e {
+    COMPUTE_LIB_SHADERS_MORPHOLOGY_ERODE = 0,
+    COMPUTE_LIB_SHADERS_MORPHOLOGY_DILATE = 1,
+    /// Erosion followed by dilation.
+    COMPUTE_LIB_SHADERS_MORPHOLOGY_OPEN = 2,
+    /// Dilation followed by erosion.
+    COMPUTE_LIB_SHADERS_MORPHOLOGY_CLOSE = 3
+};
+
+/// Structure of the morphology instance.
+/// Grey images (RGBA8, per channel) with rectangular elements are processed by separable van Herk/Gil-Werman row and column passes,
+/// i.e. with constant cost per pixel regardless of the element size. Binary images (R32UI) pack 32 pixels of a row into one word
+/// (pixel x is bit x & 31 of word x >> 5) and are processed bit-parallel. Arbitrary masks are applied directly by the mask program.
+/// Pixels outside of the image do not affect the result.
+typedef struct compute_lib_shaders_morphology_s {
+    /// Row and column passes for rectangular elements.
+    compute_lib_program_t row_program;
+    compute_lib_program_t column_program;
+    /// Single pass for arbitrary masks.
+    compute_lib_program_t mask_program;
+    /// Conversions between binary and RGBA8 images (binary mode only).
+    compute_lib_program_t pack_program;
+    compute_lib_program_t unpack_program;
+    compute_lib_image2d_t input_image2d;
+    /// Intermediate image of the separable passes and compound operations.
+    compute_lib_image2d_t temp_image2d;
+    compute_lib_image2d_t output_image2d;
+    /// RGBA8 image packed to the input image and unpacked from the output image (binary mode only).
+    compute_lib_image2d_t rgba_image2d;
+    /// Offsets (dx, dy) of non-zero mask elements relative to the mask centre (int pairs).
+    compute_lib_ssbo_t mask_ssbo;
+    compute_lib_uniform_t row_dilate_uniform;
+    compute_lib_uniform_t column_dilate_uniform;
+    compute_lib_uniform_t mask_dilate_uniform;
+    compute_lib_uniform_t pack_threshold_uniform;
+    /// Morphological operation (compute_lib_shaders_morphology_op_e).
+    GLenum op;
+    GLboolean binary;
+    /// GL_TRUE if an arbitrary mask is used instead of the rectangular element.
+    GLboolean use_mask;
+    int image_width;
+    int image_height;
+} compute_lib_shaders_morphology_t;
+
+
+static inline void compute_lib_shaders_morphology_destroy(compute_lib_shaders_morphology_t* morphology)
+{
+    compute_lib_image2d_destroy(&(morphology->input_image2d));
+    compute_lib_image2d_destroy(&(morphology->temp_image2d));
+    compute_lib_image2d_destroy(&(morphology->output_image2d));
+    compute_lib_image2d_destroy(&(morphology->rgba_image2d));
+    compute_lib_ssbo_destroy(&(morphology->mask_ssbo));
+    compute_lib_program_destroy(&(morphology->row_program), GL_TRUE);
+    compute_lib_program_destroy(&(morphology->column_program), GL_TRUE);
+    compute_lib_program_destroy(&(morphology->mask_program), GL_TRUE);
+    compute_lib_program_destroy(&(morphology->pack_program), GL_TRUE);
+    compute_lib_program_destroy(&(morphology->unpack_program), GL_TRUE);
+    free(morphology);
+}
+
+/// Allocates the instance and prepares images and programs common to both element types.
+static inline compute_lib_shaders_morphology_t* compute_lib_shaders_morphology_alloc(compute_lib_instance_t* inst, int local_size_x, int local_size_y, int image_width, int image_height, GLboolean binary, GLenum op)
+{
+    compute_lib_shaders_morphology_t* morphology = (compute_lib_shaders_morphology_t*) malloc(sizeof(compute_lib_shaders_morphology_t));
+    morphology->op = op;
+    morphology->binary = binary;
+    morphology->image_width = image_width;
+    morphology->image_height = image_height;
+
+    int width = binary ? (image_width + 31) / 32 : image_width;
+    int num_components = binary ? 1 : 4;
+    GLenum type = binary ? GL_UNSIGNED_INT : GL_UNSIGNED_BYTE;
+    morphology->input_image2d = COMPUTE_LIB_IMAGE2D_NEW("input_image2d", GL_TEXTURE0, width, image_height, GL_READ_ONLY, num_components, type);
+    morphology->input_image2d.resource.value = 0;
+    compute_lib_image2d_setup_format(&(morphology->input_image2d));
+
+    morphology->temp_image2d = COMPUTE_LIB_IMAGE2D_NEW("temp_image2d", GL_TEXTURE1, width, image_height, GL_READ_ONLY, num_components, type);
+    morphology->temp_image2d.resource.value = 0;
+    compute_lib_image2d_setup_format(&(morphology->temp_image2d));
+
+    morphology->output_image2d = COMPUTE_LIB_IMAGE2D_NEW("output_image2d", GL_TEXTURE2, width, image_height, GL_WRITE_ONLY, num_components, type);
+    morphology->output_image2d.resource.value = 1;
+    compute_lib_image2d_setup_format(&(morphology->output_image2d));
+
+    morphology->rgba_image2d = COMPUTE_LIB_IMAGE2D_NEW("input_image2d", GL_TEXTURE3, image_width, image_height, GL_READ_ONLY, 4, GL_UNSIGNED_BYTE);
+    morphology->rgba_image2d.resource.value = 0;
+    compute_lib_image2d_setup_format(&(morphology->rgba_image2d));
+
+    morphology->mask_ssbo = COMPUTE_LIB_SSBO_NEW("mask_ssbo", GL_INT, GL_STATIC_READ);
+    morphology->mask_ssbo.resource.value = 2;
+
+    morphology->row_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x * local_size_y, 1, 1);
+    morphology->column_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x * local_size_y, 1, 1);
+    morphology->mask_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+    morphology->pack_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+    morphology->unpack_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+
+    if (binary) {
+        // pack reads the RGBA image and writes binary one, unpack the other way round
+        compute_lib_image2d_t output_image2d = morphology->output_image2d;
+        compute_lib_image2d_t rgba_output_image2d = morphology->rgba_image2d;
+        rgba_output_image2d.resource.name = "output_image2d";
+        rgba_output_image2d.resource.value = 1;
+        rgba_output_image2d.access = GL_WRITE_ONLY;
+
+        GLchar* program_layout_str = compute_lib_program_glsl_layout(&(morphology->pack_program));
+        GLchar* input_image2d_layout_str = compute_lib_image2d_glsl_layout(&(morphology->input_image2d));
+        GLchar* output_image2d_layout_str = compute_lib_image2d_glsl_layout(&output_image2d);
+        GLchar* rgba_input_image2d_layout_str = compute_lib_image2d_glsl_layout(&(morphology->rgba_image2d));
+        GLchar* rgba_output_image2d_layout_str = compute_lib_image2d_glsl_layout(&rgba_output_image2d);
+        asprintf(&(morphology->pack_program.source), _binary_src_shaders_morphology_pack_comp_start, program_layout_str, rgba_input_image2d_layout_str, output_image2d_layout_str, 1);
+        asprintf(&(morphology->unpack_program.source), _binary_src_shaders_morphology_pack_comp_start, program_layout_str, input_image2d_layout_str, rgba_output_image2d_layout_str, 0);
+        free(program_layout_str);
+        free(input_image2d_layout_str);
+        free(output_image2d_layout_str);
+        free(rgba_input_image2d_layout_str);
+        free(rgba_output_image2d_layout_str);
+
+        if (compute_lib_program_init(&(morphology->pack_program)) != GL_NO_ERROR ||
+                compute_lib_program_init(&(morphology->unpack_program)) != GL_NO_ERROR) {
+            compute_lib_shaders_morphology_destroy(morphology);
+            return NULL;
+        }
+
+        morphology->pack_threshold_uniform = COMPUTE_LIB_UNIFORM_NEW("morphology_threshold");
+        if (compute_lib_uniform_init(&(morphology->pack_program), &(morphology->pack_threshold_uniform)) != GL_NO_ERROR ||
+                compute_lib_image2d_init(&(morphology->rgba_image2d), GL_COLOR_ATTACHMENT0) != GL_NO_ERROR) {
+            compute_lib_shaders_morphology_destroy(morphology);
+            return NULL;
+        }
+    }
+
+    if (compute_lib_image2d_init(&(morphology->input_image2d), 0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(morphology->temp_image2d), 0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(morphology->output_image2d), GL_COLOR_ATTACHMENT0) != GL_NO_ERROR) {
+        compute_lib_shaders_morphology_destroy(morphology);
+        return NULL;
+    }
+
+    return morphology;
+}
+
+/// Initializes the morphology instance with rectangular structuring element (anchored at its centre).
+/// \param local_size_x Work group width of 2D programs, row and column passes of grey images use work groups of local_size_x * local_size_y invocations along the lines.
+/// \param binary If GL_TRUE, input and output are packed binary images (R32UI, (image_width + 31) / 32 words per row), otherwise RGBA8 images.
+/// \param op Morphological operation (compute_lib_shaders_morphology_op_e).
+/// \param element_width Odd element width up to COMPUTE_LIB_SHADERS_MORPHOLOGY_MAX_ELEMENT_SIZE.
+/// \param element_height Odd element height up to COMPUTE_LIB_SHADERS_MORPHOLOGY_MAX_ELEMENT_SIZE.
+static inline compute_lib_shaders_morphology_t* compute_lib_shaders_morphology_init(compute_lib_instance_t* inst, int local_size_x, int local_size_y, int image_width, int image_height, GLboolean binary, GLenum op,
+                                                                                    int element_width, int element_height)
+{
+    if (op > COMPUTE_LIB_SHADERS_MORPHOLOGY_CLOSE || element_width < 1 || element_height < 1 || (element_width & 1) == 0 || (element_height & 1) == 0 ||
+            element_width > COMPUTE_LIB_SHADERS_MORPHOLOGY_MAX_ELEMENT_SIZE || element_height > COMPUTE_LIB_SHADERS_MORPHOLOGY_MAX_ELEMENT_SIZE) {
+        return NULL;
+    }
+    // two shared buffers of segment pixels extended by the element (uvec4 each) must fit into 16 kB
+    int element_size = (element_width > element_height) ? element_width : element_height;
+    if (!binary && (local_size_x * local_size_y + element_size - 1) * 2 * 16 > 16384) {
+        return NULL;
+    }
+
+    compute_lib_shaders_morphology_t* morphology;
+    if ((morphology = compute_lib_shaders_morphology_alloc(inst, local_size_x, local_size_y, image_width, image_height, binary, op)) == NULL) {
+        return NULL;
+    }
+    morphology->use_mask = GL_FALSE;
+
+    // bit-parallel passes run one invocation per word, van Herk/Gil-Werman passes one work group per line segment
+    if (binary) {
+        morphology->row_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+        morphology->column_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+    }
+
+    compute_lib_image2d_t output_image2d = morphology->output_image2d;
+    GLchar* program_layout_str = compute_lib_program_glsl_layout(&(morphology->row_program));
+    GLchar* input_image2d_layout_str = compute_lib_image2d_glsl_layout(&(morphology->input_image2d));
+    GLchar* output_image2d_layout_str = compute_lib_image2d_glsl_layout(&output_image2d);
+    asprintf(&(morphology->row_program.source), _binary_src_shaders_morphology_comp_start, program_layout_str, input_image2d_layout_str, output_image2d_layout_str, binary, 0, element_width, image_width);
+    asprintf(&(morphology->column_program.source), _binary_src_shaders_morphology_comp_start, program_layout_str, input_image2d_layout_str, output_image2d_layout_str, binary, 1, element_height, image_width);
+    free(program_layout_str);
+    free(input_image2d_layout_str);
+    free(output_image2d_layout_str);
+
+    if (compute_lib_program_init(&(morphology->row_program)) != GL_NO_ERROR ||
+            compute_lib_program_init(&(morphology->column_program)) != GL_NO_ERROR) {
+        compute_lib_shaders_morphology_destroy(morphology);
+        return NULL;
+    }
+
+    morphology->row_dilate_uniform = COMPUTE_LIB_UNIFORM_NEW("morphology_dilate");
+    morphology->column_dilate_uniform = COMPUTE_LIB_UNIFORM_NEW("morphology_dilate");
+    if (compute_lib_uniform_init(&(morphology->row_program), &(morphology->row_dilate_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(morphology->column_program), &(morphology->column_dilate_uniform)) != GL_NO_ERROR) {
+        compute_lib_shaders_morphology_destroy(morphology);
+        return NULL;
+    }
+
+    return morphology;
+}
+
+/// Initializes the morphology instance with arbitrary mask (cost per pixel is proportional to the number of its non-zero elements).
+/// \param binary If GL_TRUE, input and output are packed binary images (R32UI, (image_width + 31) / 32 words per row), otherwise RGBA8 images.
+/// \param op Morphological operation (compute_lib_shaders_morphology_op_e).
+/// \param mask Row-major mask of mask_width x mask_height elements, non-zero elements belong to the structuring element, the anchor is in the centre
+///             (dilation uses the mask reflected about the anchor, so opening and closing are dual).
+static inline compute_lib_shaders_morphology_t* compute_lib_shaders_morphology_init_mask(compute_lib_instance_t* inst, int local_size_x, int local_size_y, int image_width, int image_height, GLboolean binary, GLenum op,
+                                                                                         const GLubyte* mask, int mask_width, int mask_height)
+{
+    if (op > COMPUTE_LIB_SHADERS_MORPHOLOGY_CLOSE || mask_width < 1 || mask_height < 1) {
+        return NULL;
+    }
+
+    GLint* offsets = (GLint*) malloc(2 * mask_width * mask_height * sizeof(GLint));
+    int mask_length = 0;
+    for (int y = 0; y < mask_height; y++) {
+        for (int x = 0; x < mask_width; x++) {
+            if (mask[y * mask_width + x] != 0) {
+                offsets[2 * mask_length] = x - (mask_width - 1) / 2;
+                offsets[2 * mask_length + 1] = y - (mask_height - 1) / 2;
+                mask_length++;
+            }
+        }
+    }
+    if (mask_length == 0) {
+        free(offsets);
+        return NULL;
+    }
+
+    compute_lib_shaders_morphology_t* morphology;
+    if ((morphology = compute_lib_shaders_morphology_alloc(inst, local_size_x, local_size_y, image_width, image_height, binary, op)) == NULL) {
+        free(offsets);
+        return NULL;
+    }
+    morphology->use_mask = GL_TRUE;
+
+    compute_lib_image2d_t output_image2d = morphology->output_image2d;
+    GLchar* program_layout_str = compute_lib_program_glsl_layout(&(morphology->mask_program));
+    GLchar* input_image2d_layout_str = compute_lib_image2d_glsl_layout(&(morphology->input_image2d));
+    GLchar* output_image2d_layout_str = compute_lib_image2d_glsl_layout(&output_image2d);
+    GLchar* mask_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(morphology->mask_ssbo));
+    asprintf(&(morphology->mask_program.source), _binary_src_shaders_morphology_mask_comp_start, program_layout_str, input_image2d_layout_str, output_image2d_layout_str, mask_ssbo_layout_str, binary, image_width);
+    free(program_layout_str);
+    free(input_image2d_layout_str);
+    free(output_image2d_layout_str);
+    free(mask_ssbo_layout_str);
+
+    morphology->mask_dilate_uniform = COMPUTE_LIB_UNIFORM_NEW("morphology_dilate");
+    if (compute_lib_program_init(&(morphology->mask_program)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(morphology->mask_program), &(morphology->mask_dilate_uniform)) != GL_NO_ERROR ||
+            compute_lib_ssbo_init(&(morphology->mask_ssbo), offsets, 2 * mask_length) != GL_NO_ERROR) {
+        free(offsets);
+        compute_lib_shaders_morphology_destroy(morphology);
+        return NULL;
+    }
+
+    free(offsets);
+    return morphology;
+}
+
+/// Runs a single pass of the program from the source image to the destination image (bound to units 0 and 1).
+static inline GLuint compute_lib_shaders_morphology_pass(compute_lib_program_t* program, compute_lib_uniform_t* dilate_uniform, compute_lib_image2d_t* src_image2d, compute_lib_image2d_t* dst_image2d,
+                                                         GLuint dilate, GLuint size_x, GLuint size_y)
+{
+    compute_lib_image2d_t bound_src_image2d = *src_image2d;
+    compute_lib_image2d_t bound_dst_image2d = *dst_image2d;
+    bound_src_image2d.resource.value = 0;
+    bound_src_image2d.access = GL_READ_ONLY;
+    bound_dst_image2d.resource.value = 1;
+    bound_dst_image2d.access = GL_WRITE_ONLY;
+
+    GLuint errors_cnt = compute_lib_image2d_bind(&bound_src_image2d) + compute_lib_image2d_bind(&bound_dst_image2d);
+    errors_cnt += compute_lib_uniform_write(program, dilate_uniform, &dilate);
+    errors_cnt += compute_lib_program_dispatch(program, size_x, size_y, 1);
+    return errors_cnt;
+}
+
+/// Erodes or dilates the source image into the destination image (the temporary image is used by the separable passes).
+static inline GLuint compute_lib_shaders_morphology_apply(compute_lib_shaders_morphology_t* morphology, compute_lib_image2d_t* src_image2d, compute_lib_image2d_t* dst_image2d, GLuint dilate)
+{
+    int width = src_image2d->width, height = src_image2d->height;
+    if (morphology->use_mask) {
+        return compute_lib_shaders_morphology_pass(&(morphology->mask_program), &(morphology->mask_dilate_uniform), src_image2d, dst_image2d, dilate, width, height);
+    }
+
+    GLuint errors_cnt;
+    if (morphology->binary) {
+        errors_cnt = compute_lib_shaders_morphology_pass(&(morphology->row_program), &(morphology->row_dilate_uniform), src_image2d, &(morphology->temp_image2d), dilate, width, height);
+        errors_cnt += compute_lib_shaders_morphology_pass(&(morphology->column_program), &(morphology->column_dilate_uniform), &(morphology->temp_image2d), dst_image2d, dilate, width, height);
+        return errors_cnt;
+    }
+    // work group per line segment, lines are indexed by the second dimension
+    errors_cnt = compute_lib_shaders_morphology_pass(&(morphology->row_program), &(morphology->row_dilate_uniform), src_image2d, &(morphology->temp_image2d), dilate, width, height);
+    errors_cnt += compute_lib_shaders_morphology_pass(&(morphology->column_program), &(morphology->column_dilate_uniform), &(morphology->temp_image2d), dst_image2d, dilate, height, width);
+    return errors_cnt;
+}
+
+/// Applies the morphological operation to the input image, the result is stored in the output image.
+static inline GLuint compute_lib_shaders_morphology_dispatch(compute_lib_shaders_morphology_t* morphology)
+{
+    compute_lib_image2d_t* temp_image2d = morphology->use_mask ? &(morphology->temp_image2d) : &(morphology->output_image2d);
+    switch (morphology->op) {
+        case COMPUTE_LIB_SHADERS_MORPHOLOGY_ERODE:
+            return compute_lib_shaders_morphology_apply(morphology, &(morphology->input_image2d), &(morphology->output_image2d), 0);
+        case COMPUTE_LIB_SHADERS_MORPHOLOGY_DILATE:
+            return compute_lib_shaders_morphology_apply(morphology, &(morphology->input_image2d), &(morphology->output_image2d), 1);
+        case COMPUTE_LIB_SHADERS_MORPHOLOGY_OPEN:
+            return compute_lib_shaders_morphology_apply(morphology, &(morphology->input_image2d), temp_image2d, 0) +
+                   compute_lib_shaders_morphology_apply(morphology, temp_image2d, &(morphology->output_image2d), 1);
+        default:
+            return compute_lib_shaders_morphology_apply(morphology, &(morphology->input_image2d), temp_image2d, 1) +
+                   compute_lib_shaders_morphology_apply(morphology, temp_image2d, &(morphology->output_image2d), 0);
+    }
+}
+
+/// Packs the RGBA image into the binary input image (binary mode only).
+/// \param threshold Pixels with red component greater or equal to the threshold are set.
+static inline GLuint compute_lib_shaders_morphology_pack(compute_lib_shaders_morphology_t* morphology, GLuint threshold)
+{
+    compute_lib_image2d_t output_image2d = morphology->input_image2d;
+    output_image2d.resource.value = 1;
+    output_image2d.access = GL_WRITE_ONLY;
+
+    GLuint errors_cnt = compute_lib_image2d_bind(&(morphology->rgba_image2d)) + compute_lib_image2d_bind(&output_image2d);
+    errors_cnt += compute_lib_uniform_write(&(morphology->pack_program), &(morphology->pack_threshold_uniform), &threshold);
+    errors_cnt += compute_lib_program_dispatch(&(morphology->pack_program), output_image2d.width, output_image2d.height, 1);
+    return errors_cnt;
+}
+
+/// Unpacks the binary output image into the RGBA image (binary mode only), set pixels are white, others black.
+static inline GLuint compute_lib_shaders_morphology_unpack(compute_lib_shaders_morphology_t* morphology)
+{
+    compute_lib_image2d_t input_image2d = morphology->output_image2d;
+    compute_lib_image2d_t output_image2d = morphology->rgba_image2d;
+    input_image2d.resource.value = 0;
+    input_image2d.access = GL_READ_ONLY;
+    output_image2d.resource.value = 1;
+    output_image2d.access = GL_WRITE_ONLY;
+
+    GLuint errors_cnt = compute_lib_image2d_bind(&input_image2d) + compute_lib_image2d_bind(&output_image2d);
+    errors_cnt += compute_lib_program_dispatch(&(morphology->unpack_program), output_image2d.width, output_image2d.height, 1);
+    return errors_cnt;
+}
+
+#endif // GLES32COMPUTELIB_MORPHOLOGY_H
@@ -0,0 +1,131 @@
+/// \file pyramid.h
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Header file of the GLES3ComputeLib library implementation of image pyramids (Gaussian or box downsampling) stored in mip levels of a single 2D image.
+/// \copyright GNU Public License.
+
+#pragma once
+
+#ifndef GLES32COMPUTELIB_PYRAMID_H
+#define GLES32COMPUTELIB_PYRAMID_H
+
+#define _GNU_SOURCE // asprintf
+#include <stdio.h>
+
+#include "compute_lib.h"
+
+extern char _binary_src_shaders_pyramid_comp_start[];
+
+/// Enumeration of pyramid downsampling methods.
+enum compute_lib_shaders_pyramid_method_e {
+    /// Separable 5x5 Gaussian kernel [1 4 6 4 1] / 16 centred at even pixels of the finer level (clamped at borders).
+    COMPUTE_LIB_SHADERS_PYRAMID_GAUSSIAN = 0,
+    /// Average of 2x2 pixels of the finer level.
+    COMPUTE_LIB_SHADERS_PYRAMID_BOX = 1
+};
+
+/// Structure of the pyramid instance.
+/// All levels live in mip levels of one texture (single allocation), level i has dimensions max(1, width >> i) x max(1, height >> i).
+/// Each level is computed from the previous one, which is bound read-only at unit 0 while the level is bound write-only at unit 1.
+typedef struct compute_lib_shaders_pyramid_s {
+    compute_lib_program_t program;
+    /// Pyramid image (RGBA8 or RGBA32F), level 0 is written by the caller.
+    compute_lib_image2d_t image2d;
+    /// Downsampling method (compute_lib_shaders_pyramid_method_e).
+    GLenum method;
+    int num_levels;
+} compute_lib_shaders_pyramid_t;
+
+
+static inline void compute_lib_shaders_pyramid_destroy(compute_lib_shaders_pyramid_t* pyramid)
+{
+    compute_lib_image2d_destroy(&(pyramid->image2d));
+    compute_lib_program_destroy(&(pyramid->program), GL_TRUE);
+    free(pyramid);
+}
+
+/// Gets the number of levels of the full pyramid (down to the 1x1 level).
+static inline int compute_lib_shaders_pyramid_max_levels(int image_width, int image_height)
+{
+    int num_levels = 1;
+    for (int size = (image_width > image_height) ? image_width : image_height; size > 1; size >>= 1) {
+        num_levels++;
+    }
+    return num_levels;
+}
+
+/// Initializes the pyramid instance.
+/// \param type Pixel component type, GL_UNSIGNED_BYTE (RGBA8) or GL_FLOAT (RGBA32F).
+/// \param method Downsampling method (compute_lib_shaders_pyramid_method_e).
+/// \param num_levels Number of levels including the full resolution one, 0 for the full pyramid.
+static inline compute_lib_shaders_pyramid_t* compute_lib_shaders_pyramid_init(compute_lib_instance_t* inst, int local_size_x, int local_size_y, int image_width, int image_height, GLenum type, GLenum method, int num_levels)
+{
+    int max_levels = compute_lib_shaders_pyramid_max_levels(image_width, image_height);
+    if ((type != GL_UNSIGNED_BYTE && type != GL_FLOAT) || method > COMPUTE_LIB_SHADERS_PYRAMID_BOX || num_levels < 0 || num_levels > max_levels) {
+        return NULL;
+    }
+
+    compute_lib_shaders_pyramid_t* pyramid = (compute_lib_shaders_pyramid_t*) malloc(sizeof(compute_lib_shaders_pyramid_t));
+    pyramid->method = method;
+    pyramid->num_levels = (num_levels == 0) ? max_levels : num_levels;
+
+    pyramid->image2d = COMPUTE_LIB_IMAGE2D_NEW("input_image2d", GL_TEXTURE0, image_width, image_height, GL_READ_ONLY, 4, type);
+    pyramid->image2d.resource.value = 0;
+    pyramid->image2d.levels = pyramid->num_levels;
+    compute_lib_image2d_setup_format(&(pyramid->image2d));
+
+    // view of the same texture used for the coarser (written) level
+    compute_lib_image2d_t output_image2d = pyramid->image2d;
+    output_image2d.resource.name = "output_image2d";
+    output_image2d.resource.value = 1;
+    output_image2d.access = GL_WRITE_ONLY;
+
+    pyramid->program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+
+    GLchar* program_layout_str = compute_lib_program_glsl_layout(&(pyramid->program));
+    GLchar* input_image2d_layout_str = compute_lib_image2d_glsl_layout(&(pyramid->image2d));
+    GLchar* output_image2d_layout_str = compute_lib_image2d_glsl_layout(&output_image2d);
+    asprintf(&(pyramid->program.source), _binary_src_shaders_pyramid_comp_start, program_layout_str, input_image2d_layout_str, output_image2d_layout_str, method, type == GL_FLOAT);
+    free(program_layout_str);
+    free(input_image2d_layout_str);
+    free(output_image2d_layout_str);
+
+    if (compute_lib_program_init(&(pyramid->program)) != GL_NO_ERROR) {
+        compute_lib_shaders_pyramid_destroy(pyramid);
+        return NULL;
+    }
+
+    if (compute_lib_image2d_init(&(pyramid->image2d), GL_COLOR_ATTACHMENT0) != GL_NO_ERROR) {
+        compute_lib_shaders_pyramid_destroy(pyramid);
+        return NULL;
+    }
+
+    return pyramid;
+}
+
+/// Computes levels first_level to last_level (inclusive) from their preceding levels, the programs are dispatched back to back without any CPU synchronisation.
+static inline GLuint compute_lib_shaders_pyramid_dispatch_levels(compute_lib_shaders_pyramid_t* pyramid, int first_level, int last_level)
+{
+    compute_lib_image2d_t input_image2d = pyramid->image2d;
+    compute_lib_image2d_t output_image2d = pyramid->image2d;
+    output_image2d.resource.value = 1;
+    output_image2d.access = GL_WRITE_ONLY;
+
+    GLuint errors_cnt = 0;
+    for (int level = (first_level > 1) ? first_level : 1; level <= last_level && level < pyramid->num_levels; level++) {
+        GLsizei width, height;
+        compute_lib_image2d_level_size(&(pyramid->image2d), level, &width, &height);
+        errors_cnt += compute_lib_image2d_bind_level(&input_image2d, level - 1);
+        errors_cnt += compute_lib_image2d_bind_level(&output_image2d, level);
+        errors_cnt += compute_lib_program_dispatch(&(pyramid->program), width, height, 1);
+    }
+    return errors_cnt;
+}
+
+/// Computes all coarser levels of the pyramid from level 0.
+static inline GLuint compute_lib_shaders_pyramid_dispatch(compute_lib_shaders_pyramid_t* pyramid)
+{
+    return compute_lib_shaders_pyramid_dispatch_levels(pyramid, 1, pyramid->num_levels - 1);
+}
+
+#endif // GLES32COMPUTELIB_PYRAMID_H
@@ -0,0 +1,245 @@
+/// \file reduce.h
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Header file of the GLES3ComputeLib library implementation of parallel reductions (sum, min/argmin, max/argmax) over 2D images and SSBOs.
+/// \copyright GNU Public License.
+
+#pragma once
+
+#ifndef GLES32COMPUTELIB_REDUCE_H
+#define GLES32COMPUTELIB_REDUCE_H
+
+#define _GNU_SOURCE // asprintf
+#include <stdio.h>
+
+#include "compute_lib.h"
+
+/// Number of elements reduced by each invocation of the first pass (must match REDUCE_ITEMS of the shader).
+#define COMPUTE_LIB_SHADERS_REDUCE_ITEMS 8
+
+extern char _binary_src_shaders_reduce_comp_start[];
+
+/// Enumeration of reduction operators. Minimum and maximum also return index of the first extreme element (argmin, argmax).
+enum compute_lib_shaders_reduce_op_e {
+    COMPUTE_LIB_SHADERS_REDUCE_SUM = 0,
+    COMPUTE_LIB_SHADERS_REDUCE_MIN = 1,
+    COMPUTE_LIB_SHADERS_REDUCE_MAX = 2
+};
+
+/// Structure of the reduction instance.
+/// The reduced image or SSBO is not owned by the instance, it is bound to the input binding point at dispatch time,
+/// so results of other programs can be reduced without transfers to CPU. Partial results are reduced hierarchically
+/// by further passes until a single value (and index) remains.
+typedef struct compute_lib_shaders_reduce_s {
+    compute_lib_program_t input_program;
+    compute_lib_program_t partial_program;
+    /// Layout of the reduced 2D image (format must match the image passed to dispatch), no texture is allocated.
+    compute_lib_image2d_t input_image2d;
+    /// Layout of the reduced SSBO (type must match the SSBO passed to dispatch), no buffer is allocated.
+    compute_lib_ssbo_t input_ssbo;
+    compute_lib_ssbo_t values_in_ssbo;
+    compute_lib_ssbo_t indices_in_ssbo;
+    compute_lib_ssbo_t values_out_ssbo;
+    compute_lib_ssbo_t indices_out_ssbo;
+    compute_lib_uniform_t input_length_uniform;
+    compute_lib_uniform_t partial_length_uniform;
+    /// Reduction operator (compute_lib_shaders_reduce_op_e).
+    GLenum op;
+    /// Data type of the accumulated values (GL_FLOAT, GL_INT or GL_UNSIGNED_INT).
+    GLenum type;
+    /// GL_IMAGE_2D or GL_SHADER_STORAGE_BUFFER.
+    GLenum input_type;
+} compute_lib_shaders_reduce_t;
+
+
+static inline void compute_lib_shaders_reduce_destroy(compute_lib_shaders_reduce_t* reduce)
+{
+    compute_lib_ssbo_destroy(&(reduce->values_in_ssbo));
+    compute_lib_ssbo_destroy(&(reduce->indices_in_ssbo));
+    compute_lib_ssbo_destroy(&(reduce->values_out_ssbo));
+    compute_lib_ssbo_destroy(&(reduce->indices_out_ssbo));
+    compute_lib_program_destroy(&(reduce->input_program), GL_TRUE);
+    compute_lib_program_destroy(&(reduce->partial_program), GL_TRUE);
+    free(reduce);
+}
+
+/// Gets the GLSL literals of the lowest and highest values of the accumulator type.
+static inline void compute_lib_shaders_reduce_type_limits(GLenum type, const GLchar** lowest, const GLchar** highest)
+{
+    switch (type) {
+        case GL_UNSIGNED_INT:
+            *lowest = "0u";
+            *highest = "0xFFFFFFFFu";
+            break;
+        case GL_INT:
+            *lowest = "(-2147483647 - 1)";
+            *highest = "2147483647";
+            break;
+        default:
+            *lowest = "(-3.402823466e+38f)";
+            *highest = "3.402823466e+38f";
+            break;
+    }
+}
+
+/// Number of partial results (work groups) produced by a pass over the provided number of elements.
+static inline int compute_lib_shaders_reduce_groups(compute_lib_shaders_reduce_t* reduce, int length)
+{
+    int group_length = reduce->input_program.local_size_x * COMPUTE_LIB_SHADERS_REDUCE_ITEMS;
+    return (length + group_length - 1) / group_length;
+}
+
+/// Initializes the reduction instance for 2D image or SSBO input.
+/// \param local_size Number of invocations in a work group, must be a power of two.
+/// \param op Reduction operator (compute_lib_shaders_reduce_op_e).
+/// \param input_image2d 2D image which format is used for the input (NULL for SSBO input). Red channel is reduced.
+/// \param input_ssbo SSBO which type is used for the input (NULL for 2D image input).
+/// \param max_length Maximum number of reduced elements (pixels).
+static inline compute_lib_shaders_reduce_t* compute_lib_shaders_reduce_init(compute_lib_instance_t* inst, int local_size, GLenum op, compute_lib_image2d_t* input_image2d, compute_lib_ssbo_t* input_ssbo, int max_length)
+{
+    if ((local_size & (local_size - 1)) != 0 || (input_image2d == NULL) == (input_ssbo == NULL)) {
+        return NULL;
+    }
+
+    compute_lib_shaders_reduce_t* reduce = (compute_lib_shaders_reduce_t*) malloc(sizeof(compute_lib_shaders_reduce_t));
+    reduce->op = op;
+    GLchar* input_layout_str;
+    if (input_image2d != NULL) {
+        reduce->input_type = GL_IMAGE_2D;
+        reduce->input_image2d = *input_image2d;
+        reduce->input_image2d.resource = COMPUTE_LIB_RESOURCE_NEW("input_image2d", GL_IMAGE_2D);
+        reduce->input_image2d.resource.value = 0;
+        reduce->input_image2d.access = GL_READ_ONLY;
+        const GLchar* glsl_type = gl3_get_glsl_image2d_type(input_image2d->compatibility_format);
+        reduce->type = (glsl_type[0] == 'u') ? GL_UNSIGNED_INT : ((glsl_type[0] == 'i' && glsl_type[1] == 'i') ? GL_INT : GL_FLOAT);
+        input_layout_str = compute_lib_image2d_glsl_layout(&(reduce->input_image2d));
+    } else {
+        reduce->input_type = GL_SHADER_STORAGE_BUFFER;
+        reduce->input_ssbo = COMPUTE_LIB_SSBO_NEW("input_ssbo", input_ssbo->type, input_ssbo->usage);
+        reduce->input_ssbo.resource.value = 0;
+        reduce->type = input_ssbo->type;
+        input_layout_str = compute_lib_ssbo_glsl_layout(&(reduce->input_ssbo));
+    }
+
+    reduce->values_in_ssbo = COMPUTE_LIB_SSBO_NEW("values_in_ssbo", reduce->type, GL_DYNAMIC_COPY);
+    reduce->values_in_ssbo.resource.value = 1;
+    reduce->indices_in_ssbo = COMPUTE_LIB_SSBO_NEW("indices_in_ssbo", GL_UNSIGNED_INT, GL_DYNAMIC_COPY);
+    reduce->indices_in_ssbo.resource.value = 2;
+    reduce->values_out_ssbo = COMPUTE_LIB_SSBO_NEW("values_out_ssbo", reduce->type, GL_DYNAMIC_COPY);
+    reduce->values_out_ssbo.resource.value = 3;
+    reduce->indices_out_ssbo = COMPUTE_LIB_SSBO_NEW("indices_out_ssbo", GL_UNSIGNED_INT, GL_DYNAMIC_COPY);
+    reduce->indices_out_ssbo.resource.value = 4;
+
+    reduce->input_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size, 1, 1);
+    reduce->partial_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size, 1, 1);
+
+    const GLchar* type_lowest;
+    const GLchar* type_highest;
+    compute_lib_shaders_reduce_type_limits(reduce->type, &type_lowest, &type_highest);
+    GLchar* program_layout_str = compute_lib_program_glsl_layout(&(reduce->input_program));
+    GLchar* values_in_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(reduce->values_in_ssbo));
+    GLchar* indices_in_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(reduce->indices_in_ssbo));
+    GLchar* values_out_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(reduce->values_out_ssbo));
+    GLchar* indices_out_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(reduce->indices_out_ssbo));
+    asprintf(&(reduce->input_program.source), _binary_src_shaders_reduce_comp_start, program_layout_str, input_layout_str, values_in_ssbo_layout_str, indices_in_ssbo_layout_str, values_out_ssbo_layout_str, indices_out_ssbo_layout_str,
+             (reduce->input_type == GL_IMAGE_2D) ? 0 : 1, op, gl3_get_glsl_data_type(reduce->type), type_lowest, type_highest);
+    asprintf(&(reduce->partial_program.source), _binary_src_shaders_reduce_comp_start, program_layout_str, input_layout_str, values_in_ssbo_layout_str, indices_in_ssbo_layout_str, values_out_ssbo_layout_str, indices_out_ssbo_layout_str,
+             2, op, gl3_get_glsl_data_type(reduce->type), type_lowest, type_highest);
+    free(program_layout_str);
+    free(input_layout_str);
+    free(values_in_ssbo_layout_str);
+    free(indices_in_ssbo_layout_str);
+    free(values_out_ssbo_layout_str);
+    free(indices_out_ssbo_layout_str);
+
+    if (compute_lib_program_init(&(reduce->input_program)) != GL_NO_ERROR || compute_lib_program_init(&(reduce->partial_program)) != GL_NO_ERROR) {
+        compute_lib_shaders_reduce_destroy(reduce);
+        return NULL;
+    }
+
+    reduce->input_length_uniform = COMPUTE_LIB_UNIFORM_NEW("reduce_length");
+    reduce->partial_length_uniform = COMPUTE_LIB_UNIFORM_NEW("reduce_length");
+    if (compute_lib_uniform_init(&(reduce->input_program), &(reduce->input_length_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(reduce->partial_program), &(reduce->partial_length_uniform)) != GL_NO_ERROR) {
+        compute_lib_shaders_reduce_destroy(reduce);
+        return NULL;
+    }
+
+    int max_groups = compute_lib_shaders_reduce_groups(reduce, max_length);
+    if (compute_lib_ssbo_init(&(reduce->values_in_ssbo), NULL, max_groups) != GL_NO_ERROR ||
+            compute_lib_ssbo_init(&(reduce->indices_in_ssbo), NULL, max_groups) != GL_NO_ERROR ||
+            compute_lib_ssbo_init(&(reduce->values_out_ssbo), NULL, max_groups) != GL_NO_ERROR ||
+            compute_lib_ssbo_init(&(reduce->indices_out_ssbo), NULL, max_groups) != GL_NO_ERROR) {
+        compute_lib_shaders_reduce_destroy(reduce);
+        return NULL;
+    }
+
+    return reduce;
+}
+
+/// Swaps partial input and output buffers (by handles) and binds them to their binding points.
+static inline GLuint compute_lib_shaders_reduce_swap(compute_lib_shaders_reduce_t* reduce)
+{
+    GLuint handle = reduce->values_in_ssbo.handle;
+    reduce->values_in_ssbo.handle = reduce->values_out_ssbo.handle;
+    reduce->values_out_ssbo.handle = handle;
+    handle = reduce->indices_in_ssbo.handle;
+    reduce->indices_in_ssbo.handle = reduce->indices_out_ssbo.handle;
+    reduce->indices_out_ssbo.handle = handle;
+    return compute_lib_ssbo_bind(&(reduce->values_in_ssbo)) + compute_lib_ssbo_bind(&(reduce->indices_in_ssbo)) +
+           compute_lib_ssbo_bind(&(reduce->values_out_ssbo)) + compute_lib_ssbo_bind(&(reduce->indices_out_ssbo));
+}
+
+/// Runs the first pass over the bound input followed by passes over partial results until a single result remains.
+static inline GLuint compute_lib_shaders_reduce_run(compute_lib_shaders_reduce_t* reduce, GLuint length)
+{
+    GLuint errors_cnt = compute_lib_ssbo_bind(&(reduce->values_out_ssbo)) + compute_lib_ssbo_bind(&(reduce->indices_out_ssbo));
+    GLuint groups = compute_lib_shaders_reduce_groups(reduce, length);
+
+    errors_cnt += compute_lib_uniform_write(&(reduce->input_program), &(reduce->input_length_uniform), &length);
+    errors_cnt += compute_lib_program_dispatch(&(reduce->input_program), groups * reduce->input_program.local_size_x, 1, 1);
+    errors_cnt += compute_lib_shaders_reduce_swap(reduce);
+
+    while (groups > 1) {
+        length = groups;
+        groups = compute_lib_shaders_reduce_groups(reduce, length);
+        errors_cnt += compute_lib_uniform_write(&(reduce->partial_program), &(reduce->partial_length_uniform), &length);
+        errors_cnt += compute_lib_program_dispatch(&(reduce->partial_program), groups * reduce->partial_program.local_size_x, 1, 1);
+        errors_cnt += compute_lib_shaders_reduce_swap(reduce);
+    }
+
+    return errors_cnt;
+}
+
+/// Reduces red channel of the 2D image (e.g. output of another program). Image format must match the one used for initialization.
+static inline GLuint compute_lib_shaders_reduce_image2d(compute_lib_shaders_reduce_t* reduce, compute_lib_image2d_t* image2d)
+{
+    compute_lib_image2d_t input_image2d = *image2d;
+    input_image2d.resource.value = reduce->input_image2d.resource.value;
+    input_image2d.access = GL_READ_ONLY;
+    GLuint errors_cnt = compute_lib_image2d_bind(&input_image2d);
+    return errors_cnt + compute_lib_shaders_reduce_run(reduce, image2d->width * image2d->height);
+}
+
+/// Reduces the first length elements of the SSBO (e.g. output of another program). SSBO type must match the one used for initialization.
+static inline GLuint compute_lib_shaders_reduce_ssbo(compute_lib_shaders_reduce_t* reduce, compute_lib_ssbo_t* ssbo, GLuint length)
+{
+    compute_lib_ssbo_t input_ssbo = *ssbo;
+    input_ssbo.resource.value = reduce->input_ssbo.resource.value;
+    GLuint errors_cnt = compute_lib_ssbo_bind(&input_ssbo);
+    return errors_cnt + compute_lib_shaders_reduce_run(reduce, length);
+}
+
+/// Reads the result of the last reduction (transfers only the single value and index from GPU to CPU).
+/// \param value Pointer to the result value, size of the accumulator type (GLfloat, GLint or GLuint).
+/// \param index Pointer to the index of the extreme element (for minimum and maximum), can be NULL.
+static inline GLuint compute_lib_shaders_reduce_read(compute_lib_shaders_reduce_t* reduce, void* value, GLuint* index)
+{
+    GLuint errors_cnt = compute_lib_ssbo_read(&(reduce->values_in_ssbo), value, 1);
+    if (index != NULL) {
+        errors_cnt += compute_lib_ssbo_read(&(reduce->indices_in_ssbo), index, 1);
+    }
+    return errors_cnt;
+}
+
+#endif // GLES32COMPUTELIB_REDUCE_H
@@ -0,0 +1,183 @@
+/// \file remap.h
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Header file of the GLES3ComputeLib library implementation of image remapping by precomputed coordinate maps (including lens undistortion maps).
+/// \copyright GNU Public License.
+
+#pragma once
+
+#ifndef GLES32COMPUTELIB_REMAP_H
+#define GLES32COMPUTELIB_REMAP_H
+
+#define _GNU_SOURCE // asprintf
+#include <stdio.h>
+#include <math.h>
+
+#include "compute_lib.h"
+#include "shaders/warp.h"
+
+/// Number of fractional bits of fixed-point map coordinates (1/16 px, coordinates up to +-2047 px).
+#define COMPUTE_LIB_SHADERS_REMAP_FIXED_POINT_BITS 4
+/// Largest input width and height of fixed-point maps (larger coordinates would saturate).
+#define COMPUTE_LIB_SHADERS_REMAP_FIXED_POINT_MAX_SIZE ((1 << (15 - COMPUTE_LIB_SHADERS_REMAP_FIXED_POINT_BITS)) - 1)
+
+extern char _binary_src_shaders_remap_comp_start[];
+
+/// Structure of the remap instance.
+/// Map of input pixel coordinates (one pair per output pixel) is kept in a RG32F or fixed-point RG16I texture, so it is uploaded once and reused by each dispatch.
+typedef struct compute_lib_shaders_remap_s {
+    compute_lib_program_t program;
+    /// Input image (normalised RGBA8 or RGBA32F) sampled by the program.
+    compute_lib_image2d_t input_image2d;
+    /// Output image of the same format.
+    compute_lib_image2d_t output_image2d;
+    /// Map of input coordinates (RG32F or RG16I) of the output dimensions, read through a sampler.
+    compute_lib_image2d_t map_image2d;
+    /// Border value (vec4, normalised for RGBA8 images).
+    compute_lib_uniform_t remap_border_uniform;
+    /// Interpolation method, COMPUTE_LIB_SHADERS_WARP_NEAREST or COMPUTE_LIB_SHADERS_WARP_BILINEAR.
+    GLenum method;
+} compute_lib_shaders_remap_t;
+
+/// Structure of pinhole camera model with radial and tangential distortion (same coefficients as OpenCV).
+typedef struct compute_lib_shaders_remap_camera_s {
+    double fx, fy, cx, cy;
+    /// Radial distortion coefficients.
+    double k1, k2, k3;
+    /// Tangential distortion coefficients.
+    double p1, p2;
+} compute_lib_shaders_remap_camera_t;
+
+
+static inline void compute_lib_shaders_remap_destroy(compute_lib_shaders_remap_t* remap)
+{
+    compute_lib_image2d_destroy(&(remap->input_image2d));
+    compute_lib_image2d_destroy(&(remap->output_image2d));
+    compute_lib_image2d_destroy(&(remap->map_image2d));
+    compute_lib_program_destroy(&(remap->program), GL_TRUE);
+    free(remap);
+}
+
+/// Initializes the remap instance.
+/// \param type Pixel component type, GL_UNSIGNED_BYTE (RGBA8) or GL_FLOAT (RGBA32F, bilinear method requires OES_texture_float_linear).
+/// \param map_type Map component type, GL_FLOAT (RG32F) or GL_SHORT (RG16I with COMPUTE_LIB_SHADERS_REMAP_FIXED_POINT_BITS fractional bits,
+///                 input up to COMPUTE_LIB_SHADERS_REMAP_FIXED_POINT_MAX_SIZE pixels wide and high).
+/// \param method Interpolation method, COMPUTE_LIB_SHADERS_WARP_NEAREST or COMPUTE_LIB_SHADERS_WARP_BILINEAR.
+static inline compute_lib_shaders_remap_t* compute_lib_shaders_remap_init(compute_lib_instance_t* inst, int local_size_x, int local_size_y, int input_width, int input_height, int output_width, int output_height, GLenum type, GLenum map_type, GLenum method)
+{
+    if ((type != GL_UNSIGNED_BYTE && type != GL_FLOAT) || (map_type != GL_FLOAT && map_type != GL_SHORT) || method > COMPUTE_LIB_SHADERS_WARP_BILINEAR ||
+            (map_type == GL_SHORT && (input_width > COMPUTE_LIB_SHADERS_REMAP_FIXED_POINT_MAX_SIZE || input_height > COMPUTE_LIB_SHADERS_REMAP_FIXED_POINT_MAX_SIZE))) {
+        return NULL;
+    }
+
+    compute_lib_shaders_remap_t* remap = (compute_lib_shaders_remap_t*) malloc(sizeof(compute_lib_shaders_remap_t));
+    remap->method = method;
+
+    remap->input_image2d = COMPUTE_LIB_IMAGE2D_NEW("input_image2d", GL_TEXTURE0, input_width, input_height, GL_READ_ONLY, 4, type);
+    compute_lib_shaders_warp_setup_image(&(remap->input_image2d), 0, (method == COMPUTE_LIB_SHADERS_WARP_BILINEAR) ? GL_LINEAR : GL_NEAREST);
+
+    remap->output_image2d = COMPUTE_LIB_IMAGE2D_NEW("output_image2d", GL_TEXTURE1, output_width, output_height, GL_WRITE_ONLY, 4, type);
+    compute_lib_shaders_warp_setup_image(&(remap->output_image2d), 1, GL_NEAREST);
+
+    remap->map_image2d = COMPUTE_LIB_IMAGE2D_NEW("map_image2d", GL_TEXTURE2, output_width, output_height, GL_READ_ONLY, 2, map_type);
+    remap->map_image2d.resource.value = 2;
+    remap->map_image2d.texture_filter = GL_NEAREST;
+    compute_lib_image2d_setup_format(&(remap->map_image2d));
+
+    remap->program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+
+    GLchar* program_layout_str = compute_lib_program_glsl_layout(&(remap->program));
+    GLchar* input_sampler_layout_str = compute_lib_image2d_glsl_sampler_layout(&(remap->input_image2d));
+    GLchar* map_sampler_layout_str = compute_lib_image2d_glsl_sampler_layout(&(remap->map_image2d));
+    GLchar* output_image2d_layout_str = compute_lib_image2d_glsl_layout(&(remap->output_image2d));
+    asprintf(&(remap->program.source), _binary_src_shaders_remap_comp_start, program_layout_str, input_sampler_layout_str, map_sampler_layout_str, output_image2d_layout_str,
+             method, (map_type == GL_SHORT) ? (1 << COMPUTE_LIB_SHADERS_REMAP_FIXED_POINT_BITS) : 0, _binary_src_shaders_warp_sample_glsl_start);
+    free(program_layout_str);
+    free(input_sampler_layout_str);
+    free(map_sampler_layout_str);
+    free(output_image2d_layout_str);
+
+    if (compute_lib_program_init(&(remap->program)) != GL_NO_ERROR) {
+        compute_lib_shaders_remap_destroy(remap);
+        return NULL;
+    }
+
+    remap->remap_border_uniform = COMPUTE_LIB_UNIFORM_NEW("remap_border");
+    if (compute_lib_uniform_init(&(remap->program), &(remap->remap_border_uniform)) != GL_NO_ERROR) {
+        compute_lib_shaders_remap_destroy(remap);
+        return NULL;
+    }
+
+    if (compute_lib_image2d_init(&(remap->input_image2d), 0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(remap->output_image2d), GL_COLOR_ATTACHMENT0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(remap->map_image2d), 0) != GL_NO_ERROR) {
+        compute_lib_shaders_remap_destroy(remap);
+        return NULL;
+    }
+
+    return remap;
+}
+
+/// Uploads the map of input pixel coordinates, converted to fixed point for RG16I maps (rounded and saturated).
+/// \param map Interleaved (x, y) input coordinates of each output pixel, row by row.
+static inline GLuint compute_lib_shaders_remap_write_map(compute_lib_shaders_remap_t* remap, const float* map)
+{
+    int length = 2 * remap->map_image2d.width * remap->map_image2d.height;
+    if (remap->map_image2d.type == GL_FLOAT) {
+        return compute_lib_image2d_write(&(remap->map_image2d), (void*) map);
+    }
+
+    GLshort* fixed_map = (GLshort*) malloc(length * sizeof(GLshort));
+    for (int i = 0; i < length; i++) {
+        float value = floorf(map[i] * (1 << COMPUTE_LIB_SHADERS_REMAP_FIXED_POINT_BITS) + 0.5f);
+        fixed_map[i] = (GLshort) ((value < -32768.0f) ? -32768.0f : ((value > 32767.0f) ? 32767.0f : value));
+    }
+    GLuint errors_cnt = compute_lib_image2d_write(&(remap->map_image2d), fixed_map);
+    free(fixed_map);
+    return errors_cnt;
+}
+
+/// Computes the undistortion map (for each pixel of the undistorted output image, its coordinates in the distorted input image).
+/// \param camera Camera matrix and distortion coefficients of the input image.
+/// \param new_camera Camera matrix of the output image (distortion coefficients are ignored), NULL to keep the camera matrix.
+/// \param map Output array of 2 * width * height interleaved (x, y) coordinates.
+static inline void compute_lib_shaders_remap_undistort_map(const compute_lib_shaders_remap_camera_t* camera, const compute_lib_shaders_remap_camera_t* new_camera, int width, int height, float* map)
+{
+    if (new_camera == NULL) {
+        new_camera = camera;
+    }
+    for (int v = 0; v < height; v++) {
+        for (int u = 0; u < width; u++) {
+            double x = (u - new_camera->cx) / new_camera->fx, y = (v - new_camera->cy) / new_camera->fy;
+            double r2 = x * x + y * y;
+            double radial = 1.0 + r2 * (camera->k1 + r2 * (camera->k2 + r2 * camera->k3));
+            double xd = x * radial + 2.0 * camera->p1 * x * y + camera->p2 * (r2 + 2.0 * x * x);
+            double yd = y * radial + camera->p1 * (r2 + 2.0 * y * y) + 2.0 * camera->p2 * x * y;
+            map[2 * (v * width + u)] = (float) (camera->fx * xd + camera->cx);
+            map[2 * (v * width + u) + 1] = (float) (camera->fy * yd + camera->cy);
+        }
+    }
+}
+
+/// Builds the undistortion map of the output dimensions on CPU and caches it in the map texture.
+static inline GLuint compute_lib_shaders_remap_init_undistort(compute_lib_shaders_remap_t* remap, const compute_lib_shaders_remap_camera_t* camera, const compute_lib_shaders_remap_camera_t* new_camera)
+{
+    float* map = (float*) malloc(2 * remap->map_image2d.width * remap->map_image2d.height * sizeof(float));
+    compute_lib_shaders_remap_undistort_map(camera, new_camera, remap->map_image2d.width, remap->map_image2d.height, map);
+    GLuint errors_cnt = compute_lib_shaders_remap_write_map(remap, map);
+    free(map);
+    return errors_cnt;
+}
+
+/// Resamples the input image at the map coordinates into the output image in a single dispatch.
+/// \param border Border value of RGBA components (normalised for RGBA8 images) used outside of the input image.
+static inline GLuint compute_lib_shaders_remap_dispatch(compute_lib_shaders_remap_t* remap, const float* border)
+{
+    GLuint errors_cnt = compute_lib_uniform_write(&(remap->program), &(remap->remap_border_uniform), (void*) border);
+    errors_cnt += compute_lib_image2d_bind_sampler(&(remap->input_image2d)) + compute_lib_image2d_bind_sampler(&(remap->map_image2d));
+    errors_cnt += compute_lib_image2d_bind(&(remap->output_image2d));
+    errors_cnt += compute_lib_program_dispatch(&(remap->program), remap->output_image2d.width, remap->output_image2d.height, 1);
+    return errors_cnt;
+}
+
+#endif // GLES32COMPUTELIB_REMAP_H
@@ -0,0 +1,154 @@
+/// \file sat.h
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Header file of the GLES3ComputeLib library implementation of summed-area tables (integral images) and O(1) box/mean/variance filter.
+/// \copyright GNU Public License.
+
+#pragma once
+
+#ifndef GLES32COMPUTELIB_SAT_H
+#define GLES32COMPUTELIB_SAT_H
+
+#define _GNU_SOURCE // asprintf
+#include <stdio.h>
+
+#include "compute_lib.h"
+
+extern char _binary_src_shaders_sat_comp_start[];
+extern char _binary_src_shaders_sat_box_comp_start[];
+
+/// Structure of the summed-area table instance.
+/// Tables of pixel values and of their squares are stored as R32UI images (RGBA8 input) or R32F images (R32F input).
+/// Integer sums wrap around modulo 2^32, box sums computed from the tables are exact as long as the box sum itself fits into 32 bits.
+/// Float tables accumulate round-off relative to the sum of the whole image, box sums of small values lose precision on large images.
+typedef struct compute_lib_shaders_sat_s {
+    compute_lib_program_t rows_program;
+    compute_lib_program_t columns_program;
+    compute_lib_program_t box_program;
+    compute_lib_image2d_t input_image2d;
+    compute_lib_image2d_t sat_image2d;
+    compute_lib_image2d_t sqsat_image2d;
+    /// Box filter output (RGBA32F): sum, mean, variance and number of pixels of the box clipped to the image.
+    compute_lib_image2d_t output_image2d;
+    compute_lib_uniform_t radius_uniform;
+    /// Element type of the tables: GL_UNSIGNED_INT or GL_FLOAT.
+    GLenum type;
+} compute_lib_shaders_sat_t;
+
+
+static inline void compute_lib_shaders_sat_destroy(compute_lib_shaders_sat_t* sat)
+{
+    compute_lib_image2d_destroy(&(sat->input_image2d));
+    compute_lib_image2d_destroy(&(sat->sat_image2d));
+    compute_lib_image2d_destroy(&(sat->sqsat_image2d));
+    compute_lib_image2d_destroy(&(sat->output_image2d));
+    compute_lib_program_destroy(&(sat->rows_program), GL_TRUE);
+    compute_lib_program_destroy(&(sat->columns_program), GL_TRUE);
+    compute_lib_program_destroy(&(sat->box_program), GL_TRUE);
+    free(sat);
+}
+
+/// Initializes the summed-area table instance.
+/// \param scan_local_size Number of invocations scanning a single row or column (one work group per line).
+/// \param local_size_x Box filter local workers group size along x-axis.
+/// \param local_size_y Box filter local workers group size along y-axis.
+/// \param input_type GL_UNSIGNED_BYTE for RGBA8 input and R32UI tables or GL_FLOAT for R32F input and R32F tables (red channel is summed).
+static inline compute_lib_shaders_sat_t* compute_lib_shaders_sat_init(compute_lib_instance_t* inst, int scan_local_size, int local_size_x, int local_size_y, int image_width, int image_height,
+        GLenum input_type)
+{
+    if (input_type != GL_UNSIGNED_BYTE && input_type != GL_FLOAT) {
+        return NULL;
+    }
+
+    compute_lib_shaders_sat_t* sat = (compute_lib_shaders_sat_t*) malloc(sizeof(compute_lib_shaders_sat_t));
+    sat->type = (input_type == GL_FLOAT) ? GL_FLOAT : GL_UNSIGNED_INT;
+
+    sat->input_image2d = COMPUTE_LIB_IMAGE2D_NEW("input_image2d", GL_TEXTURE0, image_width, image_height, GL_READ_ONLY, (input_type == GL_FLOAT) ? 1 : 4, input_type);
+    sat->input_image2d.resource.value = 0;
+    compute_lib_image2d_setup_format(&(sat->input_image2d));
+
+    sat->sat_image2d = COMPUTE_LIB_IMAGE2D_NEW("sat_image2d", GL_TEXTURE1, image_width, image_height, GL_READ_WRITE, 1, sat->type);
+    sat->sat_image2d.resource.value = 1;
+    compute_lib_image2d_setup_format(&(sat->sat_image2d));
+
+    sat->sqsat_image2d = COMPUTE_LIB_IMAGE2D_NEW("sqsat_image2d", GL_TEXTURE2, image_width, image_height, GL_READ_WRITE, 1, sat->type);
+    sat->sqsat_image2d.resource.value = 2;
+    compute_lib_image2d_setup_format(&(sat->sqsat_image2d));
+
+    sat->output_image2d = COMPUTE_LIB_IMAGE2D_NEW("output_image2d", GL_TEXTURE3, image_width, image_height, GL_WRITE_ONLY, 4, GL_FLOAT);
+    sat->output_image2d.resource.value = 3;
+    compute_lib_image2d_setup_format(&(sat->output_image2d));
+
+    sat->rows_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, scan_local_size, 1, 1);
+    sat->columns_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, scan_local_size, 1, 1);
+    sat->box_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+
+    GLchar* scan_layout_str = compute_lib_program_glsl_layout(&(sat->rows_program));
+    GLchar* box_layout_str = compute_lib_program_glsl_layout(&(sat->box_program));
+    GLchar* input_image2d_layout_str = compute_lib_image2d_glsl_layout(&(sat->input_image2d));
+    GLchar* sat_image2d_layout_str = compute_lib_image2d_glsl_layout(&(sat->sat_image2d));
+    GLchar* sqsat_image2d_layout_str = compute_lib_image2d_glsl_layout(&(sat->sqsat_image2d));
+    GLchar* output_image2d_layout_str = compute_lib_image2d_glsl_layout(&(sat->output_image2d));
+    asprintf(&(sat->rows_program.source), _binary_src_shaders_sat_comp_start, scan_layout_str, input_image2d_layout_str, sat_image2d_layout_str, sqsat_image2d_layout_str, 0,
+             (sat->type == GL_FLOAT) ? 1 : 0);
+    asprintf(&(sat->columns_program.source), _binary_src_shaders_sat_comp_start, scan_layout_str, input_image2d_layout_str, sat_image2d_layout_str, sqsat_image2d_layout_str, 1,
+             (sat->type == GL_FLOAT) ? 1 : 0);
+    asprintf(&(sat->box_program.source), _binary_src_shaders_sat_box_comp_start, box_layout_str, sat_image2d_layout_str, sqsat_image2d_layout_str, output_image2d_layout_str,
+             (sat->type == GL_FLOAT) ? 1 : 0);
+    free(scan_layout_str);
+    free(box_layout_str);
+    free(input_image2d_layout_str);
+    free(sat_image2d_layout_str);
+    free(sqsat_image2d_layout_str);
+    free(output_image2d_layout_str);
+
+    if (compute_lib_program_init(&(sat->rows_program)) != GL_NO_ERROR ||
+            compute_lib_program_init(&(sat->columns_program)) != GL_NO_ERROR ||
+            compute_lib_program_init(&(sat->box_program)) != GL_NO_ERROR) {
+        compute_lib_shaders_sat_destroy(sat);
+        return NULL;
+    }
+
+    sat->radius_uniform = COMPUTE_LIB_UNIFORM_NEW("box_radius");
+    if (compute_lib_uniform_init(&(sat->box_program), &(sat->radius_uniform)) != GL_NO_ERROR) {
+        compute_lib_shaders_sat_destroy(sat);
+        return NULL;
+    }
+
+    if (compute_lib_image2d_init(&(sat->input_image2d), 0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(sat->sat_image2d), GL_COLOR_ATTACHMENT0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(sat->sqsat_image2d), GL_COLOR_ATTACHMENT0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(sat->output_image2d), GL_COLOR_ATTACHMENT0) != GL_NO_ERROR) {
+        compute_lib_shaders_sat_destroy(sat);
+        return NULL;
+    }
+
+    return sat;
+}
+
+/// Computes summed-area tables of the input image (red channel): prefix scans along rows followed by scans along columns.
+static inline GLuint compute_lib_shaders_sat_dispatch(compute_lib_shaders_sat_t* sat)
+{
+    GLuint errors_cnt = compute_lib_image2d_bind(&(sat->input_image2d));
+    errors_cnt += compute_lib_image2d_bind(&(sat->sat_image2d));
+    errors_cnt += compute_lib_image2d_bind(&(sat->sqsat_image2d));
+    errors_cnt += compute_lib_program_dispatch(&(sat->rows_program), sat->rows_program.local_size_x * sat->sat_image2d.height, 1, 1);
+    errors_cnt += compute_lib_program_dispatch(&(sat->columns_program), sat->columns_program.local_size_x * sat->sat_image2d.width, 1, 1);
+    return errors_cnt;
+}
+
+/// Runs the O(1) box filter over already computed summed-area tables.
+/// \param radius_x Horizontal half-size of the box, the box is (2*radius_x+1) pixels wide.
+/// \param radius_y Vertical half-size of the box, the box is (2*radius_y+1) pixels high.
+static inline GLuint compute_lib_shaders_sat_box_filter(compute_lib_shaders_sat_t* sat, int radius_x, int radius_y)
+{
+    GLint radius[2] = { radius_x, radius_y };
+    GLuint errors_cnt = compute_lib_image2d_bind(&(sat->sat_image2d));
+    errors_cnt += compute_lib_image2d_bind(&(sat->sqsat_image2d));
+    errors_cnt += compute_lib_image2d_bind(&(sat->output_image2d));
+    errors_cnt += compute_lib_uniform_write(&(sat->box_program), &(sat->radius_uniform), radius);
+    errors_cnt += compute_lib_program_dispatch(&(sat->box_program), sat->output_image2d.width, sat->output_image2d.height, 1);
+    return errors_cnt;
+}
+
+#endif // GLES32COMPUTELIB_SAT_H
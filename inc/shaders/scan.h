@@ -0,0 +1,318 @@
+/// \file scan.h
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Header file of the GLES3ComputeLib library implementation of prefix scans (exclusive/inclusive) and stream compaction/partition over SSBOs.
+/// \copyright GNU Public License.
+
+#pragma once
+
+#ifndef GLES32COMPUTELIB_SCAN_H
+#define GLES32COMPUTELIB_SCAN_H
+
+#define _GNU_SOURCE // asprintf
+#include <stdio.h>
+
+#include "compute_lib.h"
+
+/// Number of elements scanned by each invocation (must match SCAN_ITEMS of the shader).
+#define COMPUTE_LIB_SHADERS_SCAN_ITEMS 8
+/// Maximum number of scan levels (block totals of a level are scanned by the next level).
+#define COMPUTE_LIB_SHADERS_SCAN_MAX_LEVELS 4
+
+extern char _binary_src_shaders_scan_comp_start[];
+extern char _binary_src_shaders_scan_scatter_comp_start[];
+
+/// Structure of the prefix scan instance.
+/// Each work group scans a block of local_size*8 elements and stores the block total. Block totals are scanned
+/// recursively by the next levels and added back to the blocks, so the scanned SSBOs are never transferred to CPU.
+typedef struct compute_lib_shaders_scan_s {
+    compute_lib_program_t scan_program;
+    compute_lib_program_t add_program;
+    /// Block totals of each level (scanned in place by the next level).
+    compute_lib_ssbo_t sums_ssbo[COMPUTE_LIB_SHADERS_SCAN_MAX_LEVELS];
+    compute_lib_uniform_t scan_length_uniform;
+    compute_lib_uniform_t scan_inclusive_uniform;
+    compute_lib_uniform_t scan_predicate_uniform;
+    compute_lib_uniform_t add_length_uniform;
+    /// Data type of the scanned elements (GL_FLOAT, GL_INT or GL_UNSIGNED_INT).
+    GLenum type;
+    /// Number of levels needed for the maximum length.
+    int num_levels;
+    /// Input elements are scanned as ones if nonzero and zeros otherwise.
+    GLboolean predicate;
+} compute_lib_shaders_scan_t;
+
+/// Structure of the stream compaction instance.
+/// Nonzero flags are scanned into output positions, flagged elements (or their indices) are then scattered
+/// to a dense list keeping their order. Partition additionally appends the rejected elements after the selected ones.
+typedef struct compute_lib_shaders_compact_s {
+    compute_lib_shaders_scan_t* scan;
+    compute_lib_program_t scatter_program;
+    /// Exclusive scan of the flags, followed by the number of selected elements (max_length + 1 elements).
+    compute_lib_ssbo_t positions_ssbo;
+    /// Layouts of the caller's flags (uint) and values SSBOs, no buffers are allocated.
+    compute_lib_ssbo_t flags_ssbo;
+    compute_lib_ssbo_t values_in_ssbo;
+    compute_lib_ssbo_t values_out_ssbo;
+    compute_lib_uniform_t length_uniform;
+    compute_lib_uniform_t partition_uniform;
+    /// Number of elements of the last dispatch.
+    GLuint length;
+} compute_lib_shaders_compact_t;
+
+
+static inline void compute_lib_shaders_scan_destroy(compute_lib_shaders_scan_t* scan)
+{
+    for (int l = 0; l < COMPUTE_LIB_SHADERS_SCAN_MAX_LEVELS; l++) {
+        compute_lib_ssbo_destroy(&(scan->sums_ssbo[l]));
+    }
+    compute_lib_program_destroy(&(scan->scan_program), GL_TRUE);
+    compute_lib_program_destroy(&(scan->add_program), GL_TRUE);
+    free(scan);
+}
+
+/// Number of blocks (work groups) scanning the provided number of elements.
+static inline GLuint compute_lib_shaders_scan_groups(compute_lib_shaders_scan_t* scan, GLuint length)
+{
+    GLuint block_length = scan->scan_program.local_size_x * COMPUTE_LIB_SHADERS_SCAN_ITEMS;
+    return (length + block_length - 1) / block_length;
+}
+
+/// Initializes the prefix scan instance.
+/// \param local_size Number of invocations in a work group, must be a power of two.
+/// \param type Data type of the scanned elements (GL_FLOAT, GL_INT or GL_UNSIGNED_INT).
+/// \param max_length Maximum number of scanned elements.
+/// \param predicate Scan ones in place of nonzero elements and zeros otherwise (used for compaction flags).
+static inline compute_lib_shaders_scan_t* compute_lib_shaders_scan_init_ex(compute_lib_instance_t* inst, int local_size, GLenum type, GLuint max_length, GLboolean predicate)
+{
+    if ((local_size & (local_size - 1)) != 0 || (type != GL_FLOAT && type != GL_INT && type != GL_UNSIGNED_INT)) {
+        return NULL;
+    }
+
+    compute_lib_shaders_scan_t* scan = (compute_lib_shaders_scan_t*) malloc(sizeof(compute_lib_shaders_scan_t));
+    scan->type = type;
+    scan->predicate = predicate;
+
+    compute_lib_ssbo_t input_ssbo = COMPUTE_LIB_SSBO_NEW("input_ssbo", type, GL_DYNAMIC_COPY);
+    input_ssbo.resource.value = 0;
+    compute_lib_ssbo_t output_ssbo = COMPUTE_LIB_SSBO_NEW("output_ssbo", type, GL_DYNAMIC_COPY);
+    output_ssbo.resource.value = 1;
+    for (int l = 0; l < COMPUTE_LIB_SHADERS_SCAN_MAX_LEVELS; l++) {
+        scan->sums_ssbo[l] = COMPUTE_LIB_SSBO_NEW("sums_ssbo", type, GL_DYNAMIC_COPY);
+        scan->sums_ssbo[l].resource.value = 2;
+    }
+
+    scan->scan_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size, 1, 1);
+    scan->add_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size, 1, 1);
+
+    GLchar* program_layout_str = compute_lib_program_glsl_layout(&(scan->scan_program));
+    GLchar* input_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&input_ssbo);
+    GLchar* output_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&output_ssbo);
+    GLchar* sums_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(scan->sums_ssbo[0]));
+    asprintf(&(scan->scan_program.source), _binary_src_shaders_scan_comp_start, program_layout_str, input_ssbo_layout_str, output_ssbo_layout_str, sums_ssbo_layout_str, 0, gl3_get_glsl_data_type(type));
+    asprintf(&(scan->add_program.source), _binary_src_shaders_scan_comp_start, program_layout_str, input_ssbo_layout_str, output_ssbo_layout_str, sums_ssbo_layout_str, 1, gl3_get_glsl_data_type(type));
+    free(program_layout_str);
+    free(input_ssbo_layout_str);
+    free(output_ssbo_layout_str);
+    free(sums_ssbo_layout_str);
+
+    if (compute_lib_program_init(&(scan->scan_program)) != GL_NO_ERROR || compute_lib_program_init(&(scan->add_program)) != GL_NO_ERROR) {
+        compute_lib_shaders_scan_destroy(scan);
+        return NULL;
+    }
+
+    scan->scan_length_uniform = COMPUTE_LIB_UNIFORM_NEW("scan_length");
+    scan->scan_inclusive_uniform = COMPUTE_LIB_UNIFORM_NEW("scan_inclusive");
+    scan->scan_predicate_uniform = COMPUTE_LIB_UNIFORM_NEW("scan_predicate");
+    scan->add_length_uniform = COMPUTE_LIB_UNIFORM_NEW("scan_length");
+    if (compute_lib_uniform_init(&(scan->scan_program), &(scan->scan_length_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(scan->scan_program), &(scan->scan_inclusive_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(scan->scan_program), &(scan->scan_predicate_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(scan->add_program), &(scan->add_length_uniform)) != GL_NO_ERROR) {
+        compute_lib_shaders_scan_destroy(scan);
+        return NULL;
+    }
+
+    // block totals of each level, the last level fits into a single block
+    GLuint length = max_length;
+    scan->num_levels = 0;
+    do {
+        if (scan->num_levels == COMPUTE_LIB_SHADERS_SCAN_MAX_LEVELS) {
+            compute_lib_shaders_scan_destroy(scan);
+            return NULL;
+        }
+        length = compute_lib_shaders_scan_groups(scan, length);
+        if (compute_lib_ssbo_init(&(scan->sums_ssbo[scan->num_levels++]), NULL, length) != GL_NO_ERROR) {
+            compute_lib_shaders_scan_destroy(scan);
+            return NULL;
+        }
+    } while (length > 1);
+
+    return scan;
+}
+
+/// Initializes the prefix scan instance.
+/// \param local_size Number of invocations in a work group, must be a power of two.
+/// \param type Data type of the scanned elements (GL_FLOAT, GL_INT or GL_UNSIGNED_INT).
+/// \param max_length Maximum number of scanned elements.
+static inline compute_lib_shaders_scan_t* compute_lib_shaders_scan_init(compute_lib_instance_t* inst, int local_size, GLenum type, GLuint max_length)
+{
+    return compute_lib_shaders_scan_init_ex(inst, local_size, type, max_length, GL_FALSE);
+}
+
+/// Runs the block scan program with the provided buffers bound to input, output and block totals binding points.
+static inline GLuint compute_lib_shaders_scan_pass(compute_lib_shaders_scan_t* scan, compute_lib_ssbo_t* input_ssbo, compute_lib_ssbo_t* output_ssbo, compute_lib_ssbo_t* sums_ssbo, GLuint length, GLuint inclusive, GLuint predicate)
+{
+    compute_lib_ssbo_t input = *input_ssbo;
+    compute_lib_ssbo_t output = *output_ssbo;
+    input.resource.value = 0;
+    output.resource.value = 1;
+    GLuint errors_cnt = compute_lib_ssbo_bind(&input) + compute_lib_ssbo_bind(&output) + compute_lib_ssbo_bind(sums_ssbo);
+    errors_cnt += compute_lib_uniform_write(&(scan->scan_program), &(scan->scan_length_uniform), &length);
+    errors_cnt += compute_lib_uniform_write(&(scan->scan_program), &(scan->scan_inclusive_uniform), &inclusive);
+    errors_cnt += compute_lib_uniform_write(&(scan->scan_program), &(scan->scan_predicate_uniform), &predicate);
+    errors_cnt += compute_lib_program_dispatch(&(scan->scan_program), compute_lib_shaders_scan_groups(scan, length) * scan->scan_program.local_size_x, 1, 1);
+    return errors_cnt;
+}
+
+/// Runs the program adding scanned block totals to the blocks of the output buffer.
+static inline GLuint compute_lib_shaders_scan_add_pass(compute_lib_shaders_scan_t* scan, compute_lib_ssbo_t* output_ssbo, compute_lib_ssbo_t* sums_ssbo, GLuint length)
+{
+    compute_lib_ssbo_t output = *output_ssbo;
+    output.resource.value = 1;
+    GLuint errors_cnt = compute_lib_ssbo_bind(&output) + compute_lib_ssbo_bind(sums_ssbo);
+    errors_cnt += compute_lib_uniform_write(&(scan->add_program), &(scan->add_length_uniform), &length);
+    errors_cnt += compute_lib_program_dispatch(&(scan->add_program), compute_lib_shaders_scan_groups(scan, length) * scan->add_program.local_size_x, 1, 1);
+    return errors_cnt;
+}
+
+/// Computes prefix sums of the first length elements of the input SSBO into the output SSBO (can be the same SSBO).
+/// \param inclusive Inclusive scan (element i includes input element i) if GL_TRUE, exclusive scan otherwise.
+static inline GLuint compute_lib_shaders_scan_dispatch(compute_lib_shaders_scan_t* scan, compute_lib_ssbo_t* input_ssbo, compute_lib_ssbo_t* output_ssbo, GLuint length, GLboolean inclusive)
+{
+    GLuint lengths[COMPUTE_LIB_SHADERS_SCAN_MAX_LEVELS + 1];
+    GLuint errors_cnt = compute_lib_shaders_scan_pass(scan, input_ssbo, output_ssbo, &(scan->sums_ssbo[0]), length, inclusive ? 1 : 0, scan->predicate ? 1 : 0);
+    lengths[0] = length;
+    lengths[1] = compute_lib_shaders_scan_groups(scan, length);
+
+    // exclusive scans of block totals until they fit into a single block
+    int level = 0;
+    while (lengths[level + 1] > 1) {
+        errors_cnt += compute_lib_shaders_scan_pass(scan, &(scan->sums_ssbo[level]), &(scan->sums_ssbo[level]), &(scan->sums_ssbo[level + 1]), lengths[level + 1], 0, 0);
+        level++;
+        lengths[level + 1] = compute_lib_shaders_scan_groups(scan, lengths[level]);
+    }
+
+    // propagation of the scanned block totals down to the output (totals of the last level are not scanned)
+    for (level--; level > 0; level--) {
+        errors_cnt += compute_lib_shaders_scan_add_pass(scan, &(scan->sums_ssbo[level - 1]), &(scan->sums_ssbo[level]), lengths[level]);
+    }
+    if (lengths[1] > 1) {
+        errors_cnt += compute_lib_shaders_scan_add_pass(scan, output_ssbo, &(scan->sums_ssbo[0]), length);
+    }
+    return errors_cnt;
+}
+
+
+static inline void compute_lib_shaders_compact_destroy(compute_lib_shaders_compact_t* compact)
+{
+    if (compact->scan != NULL) {
+        compute_lib_shaders_scan_destroy(compact->scan);
+    }
+    compute_lib_ssbo_destroy(&(compact->positions_ssbo));
+    compute_lib_program_destroy(&(compact->scatter_program), GL_TRUE);
+    free(compact);
+}
+
+/// Initializes the stream compaction instance.
+/// \param local_size Number of invocations in a work group, must be a power of two.
+/// \param values_type Data type of the compacted values (GL_FLOAT, GL_INT or GL_UNSIGNED_INT), or GL_NONE to output indices (uint) of the flagged elements.
+/// \param max_length Maximum number of input elements.
+static inline compute_lib_shaders_compact_t* compute_lib_shaders_compact_init(compute_lib_instance_t* inst, int local_size, GLenum values_type, GLuint max_length)
+{
+    compute_lib_shaders_compact_t* compact = (compute_lib_shaders_compact_t*) malloc(sizeof(compute_lib_shaders_compact_t));
+    compact->length = 0;
+    compact->positions_ssbo = COMPUTE_LIB_SSBO_NEW("positions_ssbo", GL_UNSIGNED_INT, GL_DYNAMIC_COPY);
+    compact->positions_ssbo.resource.value = 1;
+    compact->scatter_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size, 1, 1);
+    if ((compact->scan = compute_lib_shaders_scan_init_ex(inst, local_size, GL_UNSIGNED_INT, max_length, GL_TRUE)) == NULL) {
+        compute_lib_shaders_compact_destroy(compact);
+        return NULL;
+    }
+
+    compact->flags_ssbo = COMPUTE_LIB_SSBO_NEW("flags_ssbo", GL_UNSIGNED_INT, GL_DYNAMIC_COPY);
+    compact->flags_ssbo.resource.value = 0;
+    compact->values_in_ssbo = COMPUTE_LIB_SSBO_NEW("values_in_ssbo", (values_type == GL_NONE) ? GL_UNSIGNED_INT : values_type, GL_DYNAMIC_COPY);
+    compact->values_in_ssbo.resource.value = 2;
+    compact->values_out_ssbo = COMPUTE_LIB_SSBO_NEW("values_out_ssbo", compact->values_in_ssbo.type, GL_DYNAMIC_COPY);
+    compact->values_out_ssbo.resource.value = 3;
+
+    GLchar* program_layout_str = compute_lib_program_glsl_layout(&(compact->scatter_program));
+    GLchar* flags_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(compact->flags_ssbo));
+    GLchar* positions_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(compact->positions_ssbo));
+    GLchar* values_in_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(compact->values_in_ssbo));
+    GLchar* values_out_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(compact->values_out_ssbo));
+    asprintf(&(compact->scatter_program.source), _binary_src_shaders_scan_scatter_comp_start, program_layout_str, flags_ssbo_layout_str, positions_ssbo_layout_str, values_in_ssbo_layout_str, values_out_ssbo_layout_str, (values_type == GL_NONE) ? 0 : 1);
+    free(program_layout_str);
+    free(flags_ssbo_layout_str);
+    free(positions_ssbo_layout_str);
+    free(values_in_ssbo_layout_str);
+    free(values_out_ssbo_layout_str);
+
+    if (compute_lib_program_init(&(compact->scatter_program)) != GL_NO_ERROR) {
+        compute_lib_shaders_compact_destroy(compact);
+        return NULL;
+    }
+
+    compact->length_uniform = COMPUTE_LIB_UNIFORM_NEW("scatter_length");
+    compact->partition_uniform = COMPUTE_LIB_UNIFORM_NEW("scatter_partition");
+    if (compute_lib_uniform_init(&(compact->scatter_program), &(compact->length_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(compact->scatter_program), &(compact->partition_uniform)) != GL_NO_ERROR ||
+            compute_lib_ssbo_init(&(compact->positions_ssbo), NULL, max_length + 1) != GL_NO_ERROR) {
+        compute_lib_shaders_compact_destroy(compact);
+        return NULL;
+    }
+
+    return compact;
+}
+
+/// Compacts (or partitions) the first length elements by their flags.
+/// \param flags_ssbo Flags SSBO (uint), elements with nonzero flags are selected.
+/// \param values_in_ssbo Input values SSBO of the type used for initialization (unused and can be NULL if indices are compacted).
+/// \param values_out_ssbo Output SSBO for the selected values or indices (length elements are needed for partition).
+/// \param partition Append rejected elements after the selected ones if GL_TRUE, drop them otherwise.
+static inline GLuint compute_lib_shaders_compact_dispatch(compute_lib_shaders_compact_t* compact, compute_lib_ssbo_t* flags_ssbo, compute_lib_ssbo_t* values_in_ssbo, compute_lib_ssbo_t* values_out_ssbo, GLuint length, GLboolean partition)
+{
+    GLuint partition_value = partition ? 1 : 0;
+    compact->length = length;
+    GLuint errors_cnt = compute_lib_shaders_scan_dispatch(compact->scan, flags_ssbo, &(compact->positions_ssbo), length, GL_FALSE);
+
+    compute_lib_ssbo_t flags = *flags_ssbo;
+    compute_lib_ssbo_t values_out = *values_out_ssbo;
+    flags.resource.value = compact->flags_ssbo.resource.value;
+    values_out.resource.value = compact->values_out_ssbo.resource.value;
+    errors_cnt += compute_lib_ssbo_bind(&flags) + compute_lib_ssbo_bind(&(compact->positions_ssbo)) + compute_lib_ssbo_bind(&values_out);
+    if (values_in_ssbo != NULL) {
+        compute_lib_ssbo_t values_in = *values_in_ssbo;
+        values_in.resource.value = compact->values_in_ssbo.resource.value;
+        errors_cnt += compute_lib_ssbo_bind(&values_in);
+    }
+    errors_cnt += compute_lib_uniform_write(&(compact->scatter_program), &(compact->length_uniform), &length);
+    errors_cnt += compute_lib_uniform_write(&(compact->scatter_program), &(compact->partition_uniform), &partition_value);
+    errors_cnt += compute_lib_program_dispatch(&(compact->scatter_program), length, 1, 1);
+    return errors_cnt;
+}
+
+/// Reads the number of selected elements of the last dispatch (single element transfer from GPU to CPU).
+static inline GLuint compute_lib_shaders_compact_read_count(compute_lib_shaders_compact_t* compact, GLuint* count)
+{
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, compact->positions_ssbo.handle);
+    GLuint* data = (GLuint*) glMapBufferRange(GL_SHADER_STORAGE_BUFFER, compact->length * sizeof(GLuint), sizeof(GLuint), GL_MAP_READ_BIT);
+    if (data != NULL) {
+        *count = *data;
+    }
+    glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+    return compute_lib_gl_errors_count();
+}
+
+#endif // GLES32COMPUTELIB_SCAN_H
@@ -0,0 +1,197 @@
+/// \file sort.h
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Header file of the GLES3ComputeLib library implementation of LSD radix sort of 32-bit keys (with optional 32-bit payloads) in SSBOs.
+/// \copyright GNU Public License.
+
+#pragma once
+
+#ifndef GLES32COMPUTELIB_SORT_H
+#define GLES32COMPUTELIB_SORT_H
+
+#define _GNU_SOURCE // asprintf
+#include <stdio.h>
+
+#include "compute_lib.h"
+#include "shaders/scan.h"
+
+/// Number of keys processed by each invocation (must match SORT_ITEMS of the shader).
+#define COMPUTE_LIB_SHADERS_SORT_ITEMS 8
+/// Number of key bits sorted by a single pass (must match RADIX_BITS of the shader).
+#define COMPUTE_LIB_SHADERS_SORT_RADIX_BITS 4
+
+extern char _binary_src_shaders_sort_comp_start[];
+
+/// Structure of the radix sort instance.
+/// Each pass counts digits of the blocks in shared memory, scans the digit-major counts into global offsets
+/// and scatters the keys (and values) stably to a temporary buffer. Passes alternate between the sorted and the temporary
+/// buffers, an even number of passes leaves the sorted keys in the caller's SSBO.
+typedef struct compute_lib_shaders_sort_s {
+    compute_lib_program_t count_program;
+    compute_lib_program_t scatter_program;
+    compute_lib_shaders_scan_t* scan;
+    compute_lib_ssbo_t keys_temp_ssbo;
+    compute_lib_ssbo_t values_temp_ssbo;
+    /// Digit counts of the blocks (digit-major), scanned in place to the offsets.
+    compute_lib_ssbo_t offsets_ssbo;
+    compute_lib_uniform_t count_length_uniform;
+    compute_lib_uniform_t count_shift_uniform;
+    compute_lib_uniform_t scatter_length_uniform;
+    compute_lib_uniform_t scatter_shift_uniform;
+    /// Key type (GL_UNSIGNED_INT, GL_INT or GL_FLOAT).
+    GLenum key_type;
+    /// Payload values are sorted together with the keys.
+    GLboolean values;
+} compute_lib_shaders_sort_t;
+
+
+static inline void compute_lib_shaders_sort_destroy(compute_lib_shaders_sort_t* sort)
+{
+    if (sort->scan != NULL) {
+        compute_lib_shaders_scan_destroy(sort->scan);
+    }
+    compute_lib_ssbo_destroy(&(sort->keys_temp_ssbo));
+    compute_lib_ssbo_destroy(&(sort->values_temp_ssbo));
+    compute_lib_ssbo_destroy(&(sort->offsets_ssbo));
+    compute_lib_program_destroy(&(sort->count_program), GL_TRUE);
+    compute_lib_program_destroy(&(sort->scatter_program), GL_TRUE);
+    free(sort);
+}
+
+/// Number of blocks (work groups) sorting the provided number of keys.
+static inline GLuint compute_lib_shaders_sort_groups(compute_lib_shaders_sort_t* sort, GLuint length)
+{
+    GLuint block_length = sort->count_program.local_size_x * COMPUTE_LIB_SHADERS_SORT_ITEMS;
+    return (length + block_length - 1) / block_length;
+}
+
+/// Initializes the radix sort instance.
+/// \param local_size Number of invocations in a work group, power of two (shared memory of 64*local_size bytes is used, 128 is recommended).
+/// \param key_type Type of the keys (GL_UNSIGNED_INT, GL_INT or GL_FLOAT).
+/// \param values Move 32-bit payload values together with the keys.
+/// \param descending Sort in descending order (sorting stays stable).
+/// \param max_length Maximum number of sorted keys.
+static inline compute_lib_shaders_sort_t* compute_lib_shaders_sort_init(compute_lib_instance_t* inst, int local_size, GLenum key_type, GLboolean values, GLboolean descending, GLuint max_length)
+{
+    if ((local_size & (local_size - 1)) != 0 || local_size < 16 || (key_type != GL_FLOAT && key_type != GL_INT && key_type != GL_UNSIGNED_INT)) {
+        return NULL;
+    }
+
+    compute_lib_shaders_sort_t* sort = (compute_lib_shaders_sort_t*) malloc(sizeof(compute_lib_shaders_sort_t));
+    sort->key_type = key_type;
+    sort->values = values;
+    sort->scan = NULL;
+
+    // keys and values are handled as raw 32-bit words
+    compute_lib_ssbo_t keys_in_ssbo = COMPUTE_LIB_SSBO_NEW("keys_in_ssbo", GL_UNSIGNED_INT, GL_DYNAMIC_COPY);
+    keys_in_ssbo.resource.value = 0;
+    compute_lib_ssbo_t keys_out_ssbo = COMPUTE_LIB_SSBO_NEW("keys_out_ssbo", GL_UNSIGNED_INT, GL_DYNAMIC_COPY);
+    keys_out_ssbo.resource.value = 1;
+    compute_lib_ssbo_t values_in_ssbo = COMPUTE_LIB_SSBO_NEW("values_in_ssbo", GL_UNSIGNED_INT, GL_DYNAMIC_COPY);
+    values_in_ssbo.resource.value = 2;
+    compute_lib_ssbo_t values_out_ssbo = COMPUTE_LIB_SSBO_NEW("values_out_ssbo", GL_UNSIGNED_INT, GL_DYNAMIC_COPY);
+    values_out_ssbo.resource.value = 3;
+    sort->keys_temp_ssbo = COMPUTE_LIB_SSBO_NEW("keys_temp_ssbo", GL_UNSIGNED_INT, GL_DYNAMIC_COPY);
+    sort->values_temp_ssbo = COMPUTE_LIB_SSBO_NEW("values_temp_ssbo", GL_UNSIGNED_INT, GL_DYNAMIC_COPY);
+    sort->offsets_ssbo = COMPUTE_LIB_SSBO_NEW("offsets_ssbo", GL_UNSIGNED_INT, GL_DYNAMIC_COPY);
+    sort->offsets_ssbo.resource.value = 4;
+
+    sort->count_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size, 1, 1);
+    sort->scatter_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size, 1, 1);
+
+    GLchar* program_layout_str = compute_lib_program_glsl_layout(&(sort->count_program));
+    GLchar* keys_in_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&keys_in_ssbo);
+    GLchar* keys_out_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&keys_out_ssbo);
+    GLchar* values_in_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&values_in_ssbo);
+    GLchar* values_out_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&values_out_ssbo);
+    GLchar* offsets_ssbo_layout_str = compute_lib_ssbo_glsl_layout(&(sort->offsets_ssbo));
+    int key_type_id = (key_type == GL_UNSIGNED_INT) ? 0 : ((key_type == GL_INT) ? 1 : 2);
+    asprintf(&(sort->count_program.source), _binary_src_shaders_sort_comp_start, program_layout_str, keys_in_ssbo_layout_str, keys_out_ssbo_layout_str, values_in_ssbo_layout_str, values_out_ssbo_layout_str, offsets_ssbo_layout_str,
+             0, key_type_id, descending ? 1 : 0, values ? 1 : 0);
+    asprintf(&(sort->scatter_program.source), _binary_src_shaders_sort_comp_start, program_layout_str, keys_in_ssbo_layout_str, keys_out_ssbo_layout_str, values_in_ssbo_layout_str, values_out_ssbo_layout_str, offsets_ssbo_layout_str,
+             1, key_type_id, descending ? 1 : 0, values ? 1 : 0);
+    free(program_layout_str);
+    free(keys_in_ssbo_layout_str);
+    free(keys_out_ssbo_layout_str);
+    free(values_in_ssbo_layout_str);
+    free(values_out_ssbo_layout_str);
+    free(offsets_ssbo_layout_str);
+
+    if (compute_lib_program_init(&(sort->count_program)) != GL_NO_ERROR || compute_lib_program_init(&(sort->scatter_program)) != GL_NO_ERROR) {
+        compute_lib_shaders_sort_destroy(sort);
+        return NULL;
+    }
+
+    sort->count_length_uniform = COMPUTE_LIB_UNIFORM_NEW("sort_length");
+    sort->count_shift_uniform = COMPUTE_LIB_UNIFORM_NEW("sort_shift");
+    sort->scatter_length_uniform = COMPUTE_LIB_UNIFORM_NEW("sort_length");
+    sort->scatter_shift_uniform = COMPUTE_LIB_UNIFORM_NEW("sort_shift");
+    if (compute_lib_uniform_init(&(sort->count_program), &(sort->count_length_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(sort->count_program), &(sort->count_shift_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(sort->scatter_program), &(sort->scatter_length_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(sort->scatter_program), &(sort->scatter_shift_uniform)) != GL_NO_ERROR) {
+        compute_lib_shaders_sort_destroy(sort);
+        return NULL;
+    }
+
+    GLuint num_offsets = (1 << COMPUTE_LIB_SHADERS_SORT_RADIX_BITS) * compute_lib_shaders_sort_groups(sort, max_length);
+    if ((sort->scan = compute_lib_shaders_scan_init(inst, local_size, GL_UNSIGNED_INT, num_offsets)) == NULL ||
+            compute_lib_ssbo_init(&(sort->offsets_ssbo), NULL, num_offsets) != GL_NO_ERROR ||
+            compute_lib_ssbo_init(&(sort->keys_temp_ssbo), NULL, max_length) != GL_NO_ERROR ||
+            (values && compute_lib_ssbo_init(&(sort->values_temp_ssbo), NULL, max_length) != GL_NO_ERROR)) {
+        compute_lib_shaders_sort_destroy(sort);
+        return NULL;
+    }
+
+    return sort;
+}
+
+/// Binds the buffer to the binding point of the sort programs.
+static inline GLuint compute_lib_shaders_sort_bind(compute_lib_ssbo_t* ssbo, GLint binding)
+{
+    compute_lib_ssbo_t bound_ssbo = *ssbo;
+    bound_ssbo.resource.value = binding;
+    return compute_lib_ssbo_bind(&bound_ssbo);
+}
+
+/// Sorts the first length keys of the SSBO in place (and reorders the payload values the same way).
+/// \param keys_ssbo Keys SSBO of the type used for initialization.
+/// \param values_ssbo Payload values SSBO (any 32-bit type), NULL if initialized without values.
+/// \param key_bits Number of the lowest key bits to be sorted by, multiple of 8 (32 to sort by whole keys). Ignored for int and float keys.
+static inline GLuint compute_lib_shaders_sort_dispatch(compute_lib_shaders_sort_t* sort, compute_lib_ssbo_t* keys_ssbo, compute_lib_ssbo_t* values_ssbo, GLuint length, GLuint key_bits)
+{
+    if (sort->key_type != GL_UNSIGNED_INT || key_bits > 32 || key_bits % 8 != 0) {
+        key_bits = 32;
+    }
+
+    compute_lib_ssbo_t* keys[2] = { keys_ssbo, &(sort->keys_temp_ssbo) };
+    compute_lib_ssbo_t* values[2] = { values_ssbo, &(sort->values_temp_ssbo) };
+    GLuint groups = compute_lib_shaders_sort_groups(sort, length);
+    GLuint errors_cnt = 0;
+
+    for (GLuint shift = 0; shift < key_bits; shift += COMPUTE_LIB_SHADERS_SORT_RADIX_BITS) {
+        int src = (shift / COMPUTE_LIB_SHADERS_SORT_RADIX_BITS) % 2;
+        errors_cnt += compute_lib_shaders_sort_bind(keys[src], 0);
+        errors_cnt += compute_lib_shaders_sort_bind(&(sort->offsets_ssbo), 4);
+        errors_cnt += compute_lib_uniform_write(&(sort->count_program), &(sort->count_length_uniform), &length);
+        errors_cnt += compute_lib_uniform_write(&(sort->count_program), &(sort->count_shift_uniform), &shift);
+        errors_cnt += compute_lib_program_dispatch(&(sort->count_program), groups * sort->count_program.local_size_x, 1, 1);
+
+        errors_cnt += compute_lib_shaders_scan_dispatch(sort->scan, &(sort->offsets_ssbo), &(sort->offsets_ssbo), groups << COMPUTE_LIB_SHADERS_SORT_RADIX_BITS, GL_FALSE);
+
+        errors_cnt += compute_lib_shaders_sort_bind(keys[src], 0);
+        errors_cnt += compute_lib_shaders_sort_bind(keys[1 - src], 1);
+        if (sort->values) {
+            errors_cnt += compute_lib_shaders_sort_bind(values[src], 2);
+            errors_cnt += compute_lib_shaders_sort_bind(values[1 - src], 3);
+        }
+        errors_cnt += compute_lib_shaders_sort_bind(&(sort->offsets_ssbo), 4);
+        errors_cnt += compute_lib_uniform_write(&(sort->scatter_program), &(sort->scatter_length_uniform), &length);
+        errors_cnt += compute_lib_uniform_write(&(sort->scatter_program), &(sort->scatter_shift_uniform), &shift);
+        errors_cnt += compute_lib_program_dispatch(&(sort->scatter_program), groups * sort->scatter_program.local_size_x, 1, 1);
+    }
+
+    return errors_cnt;
+}
+
+#endif // GLES32COMPUTELIB_SORT_H
@@ -0,0 +1,258 @@
+/// \file stereo.h
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Header file of the GLES3ComputeLib library implementation of SAD/census stereo block matching with left-right consistency check and sub-pixel disparity.
+/// \copyright GNU Public License.
+
+#pragma once
+
+#ifndef GLES32COMPUTELIB_STEREO_H
+#define GLES32COMPUTELIB_STEREO_H
+
+#define _GNU_SOURCE // asprintf
+#include <stdio.h>
+
+#include "compute_lib.h"
+
+/// Number of fractional bits of the output disparity (must match SUBPIXEL_SCALE of the shaders).
+#define COMPUTE_LIB_SHADERS_STEREO_SUBPIXEL_BITS 4
+/// Output disparity of pixels without a valid match.
+#define COMPUTE_LIB_SHADERS_STEREO_INVALID_DISPARITY 0xFFFF
+/// Maximum block size (side of the square matching window).
+#define COMPUTE_LIB_SHADERS_STEREO_MAX_BLOCK_SIZE 15
+/// Maximum number of shared memory elements of the matching pass (feature tiles and partial costs, 16 kB).
+#define COMPUTE_LIB_SHADERS_STEREO_MAX_SHARED_ELEMENTS 4096
+
+extern char _binary_src_shaders_stereo_features_comp_start[];
+extern char _binary_src_shaders_stereo_match_comp_start[];
+extern char _binary_src_shaders_stereo_check_comp_start[];
+
+/// Enumeration of block matching costs.
+enum compute_lib_shaders_stereo_method_e {
+    /// Sum of absolute differences of luma.
+    COMPUTE_LIB_SHADERS_STEREO_SAD = 0,
+    /// Sum of Hamming distances of 5x5 census transforms of luma.
+    COMPUTE_LIB_SHADERS_STEREO_CENSUS = 1
+};
+
+/// Structure of the stereo block matching instance.
+/// Rectified images are transformed to per-pixel features (luma or census bits), block costs of all disparities are aggregated
+/// in shared memory by each work group and the best disparity is refined by a parabola fit. With the left-right check enabled,
+/// disparities of the right image are computed as well and inconsistent left disparities are invalidated.
+typedef struct compute_lib_shaders_stereo_s {
+    compute_lib_program_t features_program;
+    compute_lib_program_t left_match_program;
+    compute_lib_program_t right_match_program;
+    compute_lib_program_t check_program;
+    /// Left and right input RGBA8 images (rectified).
+    compute_lib_image2d_t left_input_image2d;
+    compute_lib_image2d_t right_input_image2d;
+    /// Per-pixel features (R32UI) of the left and right images.
+    compute_lib_image2d_t left_features_image2d;
+    compute_lib_image2d_t right_features_image2d;
+    /// Disparities of the left and right images before the consistency check (RGBA16UI, only with the check enabled).
+    compute_lib_image2d_t left_disparity_image2d;
+    compute_lib_image2d_t right_disparity_image2d;
+    /// Output disparity of the left image (RGBA16UI), red is the disparity with COMPUTE_LIB_SHADERS_STEREO_SUBPIXEL_BITS fractional bits
+    /// (COMPUTE_LIB_SHADERS_STEREO_INVALID_DISPARITY if not valid), green is the block cost of the best integer disparity (saturated).
+    compute_lib_image2d_t output_image2d;
+    compute_lib_uniform_t max_difference_uniform;
+    /// Matching cost (compute_lib_shaders_stereo_method_e).
+    GLenum method;
+    int min_disparity;
+    int num_disparities;
+    GLboolean lr_check;
+} compute_lib_shaders_stereo_t;
+
+
+static inline void compute_lib_shaders_stereo_destroy(compute_lib_shaders_stereo_t* stereo)
+{
+    compute_lib_image2d_destroy(&(stereo->left_input_image2d));
+    compute_lib_image2d_destroy(&(stereo->right_input_image2d));
+    compute_lib_image2d_destroy(&(stereo->left_features_image2d));
+    compute_lib_image2d_destroy(&(stereo->right_features_image2d));
+    compute_lib_image2d_destroy(&(stereo->left_disparity_image2d));
+    compute_lib_image2d_destroy(&(stereo->right_disparity_image2d));
+    compute_lib_image2d_destroy(&(stereo->output_image2d));
+    compute_lib_program_destroy(&(stereo->features_program), GL_TRUE);
+    compute_lib_program_destroy(&(stereo->left_match_program), GL_TRUE);
+    compute_lib_program_destroy(&(stereo->right_match_program), GL_TRUE);
+    compute_lib_program_destroy(&(stereo->check_program), GL_TRUE);
+    free(stereo);
+}
+
+/// Gets a copy of the image bound under another name, binding point and access in the shader.
+static inline compute_lib_image2d_t compute_lib_shaders_stereo_image2d_as(compute_lib_image2d_t* image2d, const GLchar* name, GLint binding, GLenum access)
+{
+    compute_lib_image2d_t copy = *image2d;
+    copy.resource = COMPUTE_LIB_RESOURCE_NEW(name, GL_IMAGE_2D);
+    copy.resource.value = binding;
+    copy.access = access;
+    return copy;
+}
+
+/// Initializes the stereo block matching instance.
+/// \param method Matching cost (compute_lib_shaders_stereo_method_e).
+/// \param block_size Side of the square matching window (odd, 3 to COMPUTE_LIB_SHADERS_STEREO_MAX_BLOCK_SIZE).
+/// \param min_disparity Lowest tested disparity (non-negative, left pixel x matches right pixel x - disparity).
+/// \param num_disparities Number of tested disparities.
+/// \param lr_check Enables the left-right consistency check.
+static inline compute_lib_shaders_stereo_t* compute_lib_shaders_stereo_init(compute_lib_instance_t* inst, int local_size_x, int local_size_y, int image_width, int image_height,
+        GLenum method, int block_size, int min_disparity, int num_disparities, GLboolean lr_check)
+{
+    int tile_size_x = local_size_x + block_size - 1, tile_size_y = local_size_y + block_size - 1;
+    if (block_size < 3 || block_size > COMPUTE_LIB_SHADERS_STEREO_MAX_BLOCK_SIZE || (block_size & 1) == 0 || min_disparity < 0 || num_disparities < 1 ||
+            (min_disparity + num_disparities) * (1 << COMPUTE_LIB_SHADERS_STEREO_SUBPIXEL_BITS) >= COMPUTE_LIB_SHADERS_STEREO_INVALID_DISPARITY ||
+            tile_size_y * (3 * tile_size_x + num_disparities - 1) + local_size_y * tile_size_x > COMPUTE_LIB_SHADERS_STEREO_MAX_SHARED_ELEMENTS) {
+        return NULL;
+    }
+
+    compute_lib_shaders_stereo_t* stereo = (compute_lib_shaders_stereo_t*) malloc(sizeof(compute_lib_shaders_stereo_t));
+    stereo->method = method;
+    stereo->min_disparity = min_disparity;
+    stereo->num_disparities = num_disparities;
+    stereo->lr_check = lr_check;
+
+    stereo->left_input_image2d = COMPUTE_LIB_IMAGE2D_NEW("left_input_image2d", GL_TEXTURE0, image_width, image_height, GL_READ_ONLY, 4, GL_UNSIGNED_BYTE);
+    stereo->left_input_image2d.resource.value = 0;
+    compute_lib_image2d_setup_format(&(stereo->left_input_image2d));
+    stereo->right_input_image2d = COMPUTE_LIB_IMAGE2D_NEW("right_input_image2d", GL_TEXTURE1, image_width, image_height, GL_READ_ONLY, 4, GL_UNSIGNED_BYTE);
+    stereo->right_input_image2d.resource.value = 1;
+    compute_lib_image2d_setup_format(&(stereo->right_input_image2d));
+
+    stereo->left_features_image2d = COMPUTE_LIB_IMAGE2D_NEW("left_features_image2d", GL_TEXTURE2, image_width, image_height, GL_WRITE_ONLY, 1, GL_UNSIGNED_INT);
+    stereo->left_features_image2d.resource.value = 2;
+    compute_lib_image2d_setup_format(&(stereo->left_features_image2d));
+    stereo->right_features_image2d = COMPUTE_LIB_IMAGE2D_NEW("right_features_image2d", GL_TEXTURE3, image_width, image_height, GL_WRITE_ONLY, 1, GL_UNSIGNED_INT);
+    stereo->right_features_image2d.resource.value = 3;
+    compute_lib_image2d_setup_format(&(stereo->right_features_image2d));
+
+    stereo->left_disparity_image2d = COMPUTE_LIB_IMAGE2D_NEW("left_disparity_image2d", GL_TEXTURE4, image_width, image_height, GL_WRITE_ONLY, 4, GL_UNSIGNED_SHORT);
+    stereo->left_disparity_image2d.resource.value = 4;
+    compute_lib_image2d_setup_format(&(stereo->left_disparity_image2d));
+    stereo->right_disparity_image2d = COMPUTE_LIB_IMAGE2D_NEW("right_disparity_image2d", GL_TEXTURE5, image_width, image_height, GL_WRITE_ONLY, 4, GL_UNSIGNED_SHORT);
+    stereo->right_disparity_image2d.resource.value = 5;
+    compute_lib_image2d_setup_format(&(stereo->right_disparity_image2d));
+    stereo->output_image2d = COMPUTE_LIB_IMAGE2D_NEW("output_image2d", GL_TEXTURE6, image_width, image_height, GL_WRITE_ONLY, 4, GL_UNSIGNED_SHORT);
+    stereo->output_image2d.resource.value = 6;
+    compute_lib_image2d_setup_format(&(stereo->output_image2d));
+
+    stereo->features_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+    stereo->left_match_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+    stereo->right_match_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+    stereo->check_program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+
+    // matching programs read the features of the reference and the other image, the left one writes directly to the output without the check
+    compute_lib_image2d_t left_reference_image2d = compute_lib_shaders_stereo_image2d_as(&(stereo->left_features_image2d), "reference_image2d", 2, GL_READ_ONLY);
+    compute_lib_image2d_t right_matched_image2d = compute_lib_shaders_stereo_image2d_as(&(stereo->right_features_image2d), "matched_image2d", 3, GL_READ_ONLY);
+    compute_lib_image2d_t right_reference_image2d = compute_lib_shaders_stereo_image2d_as(&(stereo->right_features_image2d), "reference_image2d", 3, GL_READ_ONLY);
+    compute_lib_image2d_t left_matched_image2d = compute_lib_shaders_stereo_image2d_as(&(stereo->left_features_image2d), "matched_image2d", 2, GL_READ_ONLY);
+    compute_lib_image2d_t left_output_image2d = compute_lib_shaders_stereo_image2d_as(&(stereo->left_disparity_image2d), "disparity_image2d", 4, GL_WRITE_ONLY);
+    compute_lib_image2d_t right_output_image2d = compute_lib_shaders_stereo_image2d_as(&(stereo->right_disparity_image2d), "disparity_image2d", 5, GL_WRITE_ONLY);
+    compute_lib_image2d_t left_check_image2d = stereo->left_disparity_image2d;
+    left_check_image2d.access = GL_READ_ONLY;
+    compute_lib_image2d_t right_check_image2d = stereo->right_disparity_image2d;
+    right_check_image2d.access = GL_READ_ONLY;
+
+    GLchar* program_layout_str = compute_lib_program_glsl_layout(&(stereo->features_program));
+    GLchar* left_input_image2d_layout_str = compute_lib_image2d_glsl_layout(&(stereo->left_input_image2d));
+    GLchar* right_input_image2d_layout_str = compute_lib_image2d_glsl_layout(&(stereo->right_input_image2d));
+    GLchar* left_features_image2d_layout_str = compute_lib_image2d_glsl_layout(&(stereo->left_features_image2d));
+    GLchar* right_features_image2d_layout_str = compute_lib_image2d_glsl_layout(&(stereo->right_features_image2d));
+    GLchar* left_reference_image2d_layout_str = compute_lib_image2d_glsl_layout(&left_reference_image2d);
+    GLchar* right_matched_image2d_layout_str = compute_lib_image2d_glsl_layout(&right_matched_image2d);
+    GLchar* right_reference_image2d_layout_str = compute_lib_image2d_glsl_layout(&right_reference_image2d);
+    GLchar* left_matched_image2d_layout_str = compute_lib_image2d_glsl_layout(&left_matched_image2d);
+    GLchar* left_output_image2d_layout_str = compute_lib_image2d_glsl_layout(&left_output_image2d);
+    GLchar* right_output_image2d_layout_str = compute_lib_image2d_glsl_layout(&right_output_image2d);
+    GLchar* left_check_image2d_layout_str = compute_lib_image2d_glsl_layout(&left_check_image2d);
+    GLchar* right_check_image2d_layout_str = compute_lib_image2d_glsl_layout(&right_check_image2d);
+    GLchar* output_image2d_layout_str = compute_lib_image2d_glsl_layout(&(stereo->output_image2d));
+    asprintf(&(stereo->features_program.source), _binary_src_shaders_stereo_features_comp_start, program_layout_str, left_input_image2d_layout_str, right_input_image2d_layout_str,
+             left_features_image2d_layout_str, right_features_image2d_layout_str, method);
+    asprintf(&(stereo->left_match_program.source), _binary_src_shaders_stereo_match_comp_start, program_layout_str, left_reference_image2d_layout_str, right_matched_image2d_layout_str,
+             left_output_image2d_layout_str, method, 0, block_size / 2, min_disparity, num_disparities);
+    asprintf(&(stereo->right_match_program.source), _binary_src_shaders_stereo_match_comp_start, program_layout_str, right_reference_image2d_layout_str, left_matched_image2d_layout_str,
+             right_output_image2d_layout_str, method, 1, block_size / 2, min_disparity, num_disparities);
+    asprintf(&(stereo->check_program.source), _binary_src_shaders_stereo_check_comp_start, program_layout_str, left_check_image2d_layout_str, right_check_image2d_layout_str, output_image2d_layout_str);
+    free(program_layout_str);
+    free(left_input_image2d_layout_str);
+    free(right_input_image2d_layout_str);
+    free(left_features_image2d_layout_str);
+    free(right_features_image2d_layout_str);
+    free(left_reference_image2d_layout_str);
+    free(right_matched_image2d_layout_str);
+    free(right_reference_image2d_layout_str);
+    free(left_matched_image2d_layout_str);
+    free(left_output_image2d_layout_str);
+    free(right_output_image2d_layout_str);
+    free(left_check_image2d_layout_str);
+    free(right_check_image2d_layout_str);
+    free(output_image2d_layout_str);
+
+    if (compute_lib_program_init(&(stereo->features_program)) != GL_NO_ERROR ||
+            compute_lib_program_init(&(stereo->left_match_program)) != GL_NO_ERROR ||
+            (lr_check && compute_lib_program_init(&(stereo->right_match_program)) != GL_NO_ERROR) ||
+            (lr_check && compute_lib_program_init(&(stereo->check_program)) != GL_NO_ERROR)) {
+        compute_lib_shaders_stereo_destroy(stereo);
+        return NULL;
+    }
+
+    stereo->max_difference_uniform = COMPUTE_LIB_UNIFORM_NEW("stereo_max_difference");
+    if (lr_check && compute_lib_uniform_init(&(stereo->check_program), &(stereo->max_difference_uniform)) != GL_NO_ERROR) {
+        compute_lib_shaders_stereo_destroy(stereo);
+        return NULL;
+    }
+
+    if (compute_lib_image2d_init(&(stereo->left_input_image2d), 0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(stereo->right_input_image2d), 0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(stereo->left_features_image2d), 0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(stereo->right_features_image2d), 0) != GL_NO_ERROR ||
+            (lr_check && compute_lib_image2d_init(&(stereo->left_disparity_image2d), GL_COLOR_ATTACHMENT0) != GL_NO_ERROR) ||
+            (lr_check && compute_lib_image2d_init(&(stereo->right_disparity_image2d), GL_COLOR_ATTACHMENT0) != GL_NO_ERROR) ||
+            compute_lib_image2d_init(&(stereo->output_image2d), GL_COLOR_ATTACHMENT0) != GL_NO_ERROR) {
+        compute_lib_shaders_stereo_destroy(stereo);
+        return NULL;
+    }
+
+    return stereo;
+}
+
+/// Computes the disparity of the left input image into the output image.
+/// \param max_lr_difference Maximum difference of the left and right disparities in pixels (used only with the left-right check).
+static inline GLuint compute_lib_shaders_stereo_dispatch(compute_lib_shaders_stereo_t* stereo, GLfloat max_lr_difference)
+{
+    int width = stereo->left_input_image2d.width, height = stereo->left_input_image2d.height;
+    GLuint errors_cnt = compute_lib_image2d_bind(&(stereo->left_input_image2d)) + compute_lib_image2d_bind(&(stereo->right_input_image2d));
+    errors_cnt += compute_lib_image2d_bind(&(stereo->left_features_image2d)) + compute_lib_image2d_bind(&(stereo->right_features_image2d));
+    errors_cnt += compute_lib_program_dispatch(&(stereo->features_program), width, height, 1);
+
+    compute_lib_image2d_t left_features_image2d = stereo->left_features_image2d;
+    left_features_image2d.access = GL_READ_ONLY;
+    compute_lib_image2d_t right_features_image2d = stereo->right_features_image2d;
+    right_features_image2d.access = GL_READ_ONLY;
+    errors_cnt += compute_lib_image2d_bind(&left_features_image2d) + compute_lib_image2d_bind(&right_features_image2d);
+
+    if (!stereo->lr_check) {
+        compute_lib_image2d_t output_image2d = compute_lib_shaders_stereo_image2d_as(&(stereo->output_image2d), "disparity_image2d", stereo->left_disparity_image2d.resource.value, GL_WRITE_ONLY);
+        errors_cnt += compute_lib_image2d_bind(&output_image2d);
+        errors_cnt += compute_lib_program_dispatch(&(stereo->left_match_program), width, height, 1);
+        return errors_cnt;
+    }
+
+    errors_cnt += compute_lib_image2d_bind(&(stereo->left_disparity_image2d)) + compute_lib_image2d_bind(&(stereo->right_disparity_image2d));
+    errors_cnt += compute_lib_program_dispatch(&(stereo->left_match_program), width, height, 1);
+    errors_cnt += compute_lib_program_dispatch(&(stereo->right_match_program), width, height, 1);
+
+    GLuint max_difference = (max_lr_difference > 0.0f) ? (GLuint) (max_lr_difference * (1 << COMPUTE_LIB_SHADERS_STEREO_SUBPIXEL_BITS) + 0.5f) : 0;
+    compute_lib_image2d_t left_disparity_image2d = stereo->left_disparity_image2d;
+    left_disparity_image2d.access = GL_READ_ONLY;
+    compute_lib_image2d_t right_disparity_image2d = stereo->right_disparity_image2d;
+    right_disparity_image2d.access = GL_READ_ONLY;
+    errors_cnt += compute_lib_uniform_write(&(stereo->check_program), &(stereo->max_difference_uniform), &max_difference);
+    errors_cnt += compute_lib_image2d_bind(&left_disparity_image2d) + compute_lib_image2d_bind(&right_disparity_image2d) + compute_lib_image2d_bind(&(stereo->output_image2d));
+    errors_cnt += compute_lib_program_dispatch(&(stereo->check_program), width, height, 1);
+    return errors_cnt;
+}
+
+#endif // GLES32COMPUTELIB_STEREO_H
@@ -0,0 +1,251 @@
+/// \file warp.h
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Header file of the GLES3ComputeLib library implementation of image resizing (nearest, bilinear, area) and affine/perspective warps.
+/// \copyright GNU Public License.
+
+#pragma once
+
+#ifndef GLES32COMPUTELIB_WARP_H
+#define GLES32COMPUTELIB_WARP_H
+
+#define _GNU_SOURCE // asprintf
+#include <stdio.h>
+
+#include "compute_lib.h"
+
+extern char _binary_src_shaders_resize_comp_start[];
+extern char _binary_src_shaders_warp_comp_start[];
+/// GLSL function sample_input() shared by the warp and remap programs.
+extern char _binary_src_shaders_warp_sample_glsl_start[];
+
+/// Enumeration of interpolation methods.
+enum compute_lib_shaders_warp_method_e {
+    /// Nearest input pixel (texel fetch).
+    COMPUTE_LIB_SHADERS_WARP_NEAREST = 0,
+    /// Bilinear interpolation by the texture sampler (hardware filtering).
+    COMPUTE_LIB_SHADERS_WARP_BILINEAR = 1,
+    /// Average of the input pixels covered by the output pixel weighted by the covered area (resize only).
+    COMPUTE_LIB_SHADERS_WARP_AREA = 2
+};
+
+/// Structure of the resize instance.
+/// Input image is read through a sampler bound to its texture unit, output pixel centres are mapped to input pixel centres.
+typedef struct compute_lib_shaders_resize_s {
+    compute_lib_program_t program;
+    /// Input image (normalised RGBA8 or RGBA32F) sampled by the program.
+    compute_lib_image2d_t input_image2d;
+    /// Output image of the same format.
+    compute_lib_image2d_t output_image2d;
+    /// Interpolation method (compute_lib_shaders_warp_method_e).
+    GLenum method;
+} compute_lib_shaders_resize_t;
+
+/// Structure of the warp instance.
+/// Each output pixel is mapped to the input image by the inverse of the transformation passed as a uniform,
+/// pixels mapped outside of the input image get the border value.
+typedef struct compute_lib_shaders_warp_s {
+    compute_lib_program_t program;
+    /// Input image (normalised RGBA8 or RGBA32F) sampled by the program.
+    compute_lib_image2d_t input_image2d;
+    /// Output image of the same format.
+    compute_lib_image2d_t output_image2d;
+    /// Inverse transformation (mat3) mapping output pixel coordinates to input pixel coordinates.
+    compute_lib_uniform_t warp_matrix_uniform;
+    /// Border value (vec4, normalised for RGBA8 images).
+    compute_lib_uniform_t warp_border_uniform;
+    /// Interpolation method (compute_lib_shaders_warp_method_e).
+    GLenum method;
+} compute_lib_shaders_warp_t;
+
+
+/// Prepares RGBA image used by resize and warp programs. 8-bit images are stored normalised (RGBA8) to be filterable by samplers.
+static inline void compute_lib_shaders_warp_setup_image(compute_lib_image2d_t* image2d, GLint binding, GLenum filter)
+{
+    image2d->resource.value = binding;
+    image2d->texture_filter = filter;
+    compute_lib_image2d_setup_format(image2d);
+    if (image2d->type == GL_UNSIGNED_BYTE) {
+        image2d->internal_format = GL_RGBA8;
+        image2d->format = GL_RGBA;
+        image2d->compatibility_format = gl3_get_image2d_compatibility_format(GL_RGBA8);
+    }
+}
+
+static inline void compute_lib_shaders_resize_destroy(compute_lib_shaders_resize_t* resize)
+{
+    compute_lib_image2d_destroy(&(resize->input_image2d));
+    compute_lib_image2d_destroy(&(resize->output_image2d));
+    compute_lib_program_destroy(&(resize->program), GL_TRUE);
+    free(resize);
+}
+
+/// Initializes the resize instance.
+/// \param type Pixel component type, GL_UNSIGNED_BYTE (RGBA8) or GL_FLOAT (RGBA32F, bilinear method requires OES_texture_float_linear).
+/// \param method Interpolation method (compute_lib_shaders_warp_method_e).
+static inline compute_lib_shaders_resize_t* compute_lib_shaders_resize_init(compute_lib_instance_t* inst, int local_size_x, int local_size_y, int input_width, int input_height, int output_width, int output_height, GLenum type, GLenum method)
+{
+    if ((type != GL_UNSIGNED_BYTE && type != GL_FLOAT) || method > COMPUTE_LIB_SHADERS_WARP_AREA) {
+        return NULL;
+    }
+
+    compute_lib_shaders_resize_t* resize = (compute_lib_shaders_resize_t*) malloc(sizeof(compute_lib_shaders_resize_t));
+    resize->method = method;
+
+    resize->input_image2d = COMPUTE_LIB_IMAGE2D_NEW("input_image2d", GL_TEXTURE0, input_width, input_height, GL_READ_ONLY, 4, type);
+    compute_lib_shaders_warp_setup_image(&(resize->input_image2d), 0, (method == COMPUTE_LIB_SHADERS_WARP_BILINEAR) ? GL_LINEAR : GL_NEAREST);
+
+    resize->output_image2d = COMPUTE_LIB_IMAGE2D_NEW("output_image2d", GL_TEXTURE1, output_width, output_height, GL_WRITE_ONLY, 4, type);
+    compute_lib_shaders_warp_setup_image(&(resize->output_image2d), 1, GL_NEAREST);
+
+    resize->program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+
+    GLchar* program_layout_str = compute_lib_program_glsl_layout(&(resize->program));
+    GLchar* input_sampler_layout_str = compute_lib_image2d_glsl_sampler_layout(&(resize->input_image2d));
+    GLchar* output_image2d_layout_str = compute_lib_image2d_glsl_layout(&(resize->output_image2d));
+    asprintf(&(resize->program.source), _binary_src_shaders_resize_comp_start, program_layout_str, input_sampler_layout_str, output_image2d_layout_str, method);
+    free(program_layout_str);
+    free(input_sampler_layout_str);
+    free(output_image2d_layout_str);
+
+    if (compute_lib_program_init(&(resize->program)) != GL_NO_ERROR) {
+        compute_lib_shaders_resize_destroy(resize);
+        return NULL;
+    }
+
+    if (compute_lib_image2d_init(&(resize->input_image2d), 0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(resize->output_image2d), GL_COLOR_ATTACHMENT0) != GL_NO_ERROR) {
+        compute_lib_shaders_resize_destroy(resize);
+        return NULL;
+    }
+
+    return resize;
+}
+
+/// Resizes the input image to the dimensions of the output image.
+static inline GLuint compute_lib_shaders_resize_dispatch(compute_lib_shaders_resize_t* resize)
+{
+    GLuint errors_cnt = compute_lib_image2d_bind_sampler(&(resize->input_image2d)) + compute_lib_image2d_bind(&(resize->output_image2d));
+    errors_cnt += compute_lib_program_dispatch(&(resize->program), resize->output_image2d.width, resize->output_image2d.height, 1);
+    return errors_cnt;
+}
+
+static inline void compute_lib_shaders_warp_destroy(compute_lib_shaders_warp_t* warp)
+{
+    compute_lib_image2d_destroy(&(warp->input_image2d));
+    compute_lib_image2d_destroy(&(warp->output_image2d));
+    compute_lib_program_destroy(&(warp->program), GL_TRUE);
+    free(warp);
+}
+
+/// Initializes the warp instance.
+/// \param type Pixel component type, GL_UNSIGNED_BYTE (RGBA8) or GL_FLOAT (RGBA32F, bilinear method requires OES_texture_float_linear).
+/// \param method Interpolation method, COMPUTE_LIB_SHADERS_WARP_NEAREST or COMPUTE_LIB_SHADERS_WARP_BILINEAR.
+static inline compute_lib_shaders_warp_t* compute_lib_shaders_warp_init(compute_lib_instance_t* inst, int local_size_x, int local_size_y, int input_width, int input_height, int output_width, int output_height, GLenum type, GLenum method)
+{
+    if ((type != GL_UNSIGNED_BYTE && type != GL_FLOAT) || method > COMPUTE_LIB_SHADERS_WARP_BILINEAR) {
+        return NULL;
+    }
+
+    compute_lib_shaders_warp_t* warp = (compute_lib_shaders_warp_t*) malloc(sizeof(compute_lib_shaders_warp_t));
+    warp->method = method;
+
+    warp->input_image2d = COMPUTE_LIB_IMAGE2D_NEW("input_image2d", GL_TEXTURE0, input_width, input_height, GL_READ_ONLY, 4, type);
+    compute_lib_shaders_warp_setup_image(&(warp->input_image2d), 0, (method == COMPUTE_LIB_SHADERS_WARP_BILINEAR) ? GL_LINEAR : GL_NEAREST);
+
+    warp->output_image2d = COMPUTE_LIB_IMAGE2D_NEW("output_image2d", GL_TEXTURE1, output_width, output_height, GL_WRITE_ONLY, 4, type);
+    compute_lib_shaders_warp_setup_image(&(warp->output_image2d), 1, GL_NEAREST);
+
+    warp->program = COMPUTE_LIB_PROGRAM_NEW(inst, NULL, local_size_x, local_size_y, 1);
+
+    GLchar* program_layout_str = compute_lib_program_glsl_layout(&(warp->program));
+    GLchar* input_sampler_layout_str = compute_lib_image2d_glsl_sampler_layout(&(warp->input_image2d));
+    GLchar* output_image2d_layout_str = compute_lib_image2d_glsl_layout(&(warp->output_image2d));
+    asprintf(&(warp->program.source), _binary_src_shaders_warp_comp_start, program_layout_str, input_sampler_layout_str, output_image2d_layout_str, method,
+             _binary_src_shaders_warp_sample_glsl_start);
+    free(program_layout_str);
+    free(input_sampler_layout_str);
+    free(output_image2d_layout_str);
+
+    if (compute_lib_program_init(&(warp->program)) != GL_NO_ERROR) {
+        compute_lib_shaders_warp_destroy(warp);
+        return NULL;
+    }
+
+    warp->warp_matrix_uniform = COMPUTE_LIB_UNIFORM_NEW("warp_matrix");
+    warp->warp_border_uniform = COMPUTE_LIB_UNIFORM_NEW("warp_border");
+    if (compute_lib_uniform_init(&(warp->program), &(warp->warp_matrix_uniform)) != GL_NO_ERROR ||
+            compute_lib_uniform_init(&(warp->program), &(warp->warp_border_uniform)) != GL_NO_ERROR) {
+        compute_lib_shaders_warp_destroy(warp);
+        return NULL;
+    }
+
+    if (compute_lib_image2d_init(&(warp->input_image2d), 0) != GL_NO_ERROR ||
+            compute_lib_image2d_init(&(warp->output_image2d), GL_COLOR_ATTACHMENT0) != GL_NO_ERROR) {
+        compute_lib_shaders_warp_destroy(warp);
+        return NULL;
+    }
+
+    return warp;
+}
+
+/// Inverts row-major 3x3 matrix, returns GL_FALSE if the matrix is singular.
+static inline GLboolean compute_lib_shaders_warp_invert(const double* m, double* inv)
+{
+    inv[0] = m[4] * m[8] - m[5] * m[7];
+    inv[1] = m[2] * m[7] - m[1] * m[8];
+    inv[2] = m[1] * m[5] - m[2] * m[4];
+    inv[3] = m[5] * m[6] - m[3] * m[8];
+    inv[4] = m[0] * m[8] - m[2] * m[6];
+    inv[5] = m[2] * m[3] - m[0] * m[5];
+    inv[6] = m[3] * m[7] - m[4] * m[6];
+    inv[7] = m[1] * m[6] - m[0] * m[7];
+    inv[8] = m[0] * m[4] - m[1] * m[3];
+    double det = m[0] * inv[0] + m[1] * inv[3] + m[2] * inv[6];
+    if (det == 0.0) {
+        return GL_FALSE;
+    }
+    for (int i = 0; i < 9; i++) {
+        inv[i] /= det;
+    }
+    return GL_TRUE;
+}
+
+/// Warps the input image by the perspective transformation (homography) of input pixel coordinates to output pixel coordinates.
+/// \param matrix Row-major 3x3 transformation matrix.
+/// \param border Border value of RGBA components (normalised for RGBA8 images).
+static inline GLuint compute_lib_shaders_warp_perspective(compute_lib_shaders_warp_t* warp, const float* matrix, const float* border)
+{
+    double m[9], inv[9];
+    for (int i = 0; i < 9; i++) {
+        m[i] = matrix[i];
+    }
+    if (!compute_lib_shaders_warp_invert(m, inv)) {
+        return 1;
+    }
+
+    // GLSL matrices are column-major
+    GLfloat warp_matrix[9];
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) {
+            warp_matrix[3 * c + r] = (GLfloat) inv[3 * r + c];
+        }
+    }
+
+    GLuint errors_cnt = compute_lib_uniform_write(&(warp->program), &(warp->warp_matrix_uniform), warp_matrix);
+    errors_cnt += compute_lib_uniform_write(&(warp->program), &(warp->warp_border_uniform), (void*) border);
+    errors_cnt += compute_lib_image2d_bind_sampler(&(warp->input_image2d)) + compute_lib_image2d_bind(&(warp->output_image2d));
+    errors_cnt += compute_lib_program_dispatch(&(warp->program), warp->output_image2d.width, warp->output_image2d.height, 1);
+    return errors_cnt;
+}
+
+/// Warps the input image by the affine transformation of input pixel coordinates to output pixel coordinates.
+/// \param matrix Row-major 2x3 transformation matrix.
+/// \param border Border value of RGBA components (normalised for RGBA8 images).
+static inline GLuint compute_lib_shaders_warp_affine(compute_lib_shaders_warp_t* warp, const float* matrix, const float* border)
+{
+    float perspective_matrix[9] = { matrix[0], matrix[1], matrix[2], matrix[3], matrix[4], matrix[5], 0.0f, 0.0f, 1.0f };
+    return compute_lib_shaders_warp_perspective(warp, perspective_matrix, border);
+}
+
+#endif // GLES32COMPUTELIB_WARP_H
@@ -0,0 +1,21 @@
+/// \file timer.h
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief This header file provides a monotonic wall clock used for timing measurements in tests and benchmarks.
+/// \copyright GNU Public License.
+
+#ifndef GLES32COMPUTELIB_TIMER_H
+#define GLES32COMPUTELIB_TIMER_H
+
+#include <time.h>
+
+
+/// Returns the time of the monotonic clock in milliseconds.
+static inline double time_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec * 1e-6;
+}
+
+#endif // GLES32COMPUTELIB_TIMER_H
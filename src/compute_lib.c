@@ -338,7 +338,7 @@ process_errors:
 GLuint compute_lib_program_dispatch(compute_lib_program_t* program, GLuint size_x, GLuint size_y, GLuint size_z)
 {
     glUseProgram(program->handle);
-    glDispatchCompute(size_x / program->local_size_x, size_y / program->local_size_y, size_z / program->local_size_z);
+    glDispatchCompute((size_x + program->local_size_x - 1) / program->local_size_x, (size_y + program->local_size_y - 1) / program->local_size_y, (size_z + program->local_size_z - 1) / program->local_size_z);
     glMemoryBarrier(GL_ALL_BARRIER_BITS);
     glUseProgram(0);
     return compute_lib_gl_errors_count();
@@ -651,10 +651,14 @@ GLuint compute_lib_image2d_init(compute_lib_image2d_t* image2d, GLenum framebuff
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, image2d->texture_wrap);
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, image2d->texture_wrap);
+    // integer textures are incomplete for samplers unless nearest filtering is used
+    if (image2d->format == GL_RED_INTEGER || image2d->format == GL_RG_INTEGER || image2d->format == GL_RGB_INTEGER || image2d->format == GL_RGBA_INTEGER) {
+        image2d->texture_filter = GL_NEAREST;
+    }
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, image2d->texture_filter);
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, image2d->texture_filter);
-    glTexStorage2D(GL_TEXTURE_2D, 1, image2d->internal_format, image2d->width, image2d->height);
-    glBindImageTexture(image2d->resource.value, image2d->handle, 0, GL_FALSE, 0, image2d->access, image2d->compatibility_format);
+    glTexStorage2D(GL_TEXTURE_2D, image2d->levels, image2d->internal_format, image2d->width, image2d->height);
+    glBindImageTexture(image2d->resource.value, image2d->handle, image2d->level, GL_FALSE, 0, image2d->access, image2d->compatibility_format);
     size_t type_size = gl3_get_type_size(image2d->type);
     image2d->px_size = type_size * image2d->num_components;
     image2d->data_size = image2d->px_size * image2d->width * image2d->height;
@@ -667,6 +671,12 @@ GLuint compute_lib_image2d_init(compute_lib_image2d_t* image2d, GLenum framebuff
     return compute_lib_gl_errors_count();
 }
 
+void compute_lib_image2d_level_size(compute_lib_image2d_t* image2d, GLint level, GLsizei* width, GLsizei* height)
+{
+    *width = (image2d->width >> level) > 0 ? (image2d->width >> level) : 1;
+    *height = (image2d->height >> level) > 0 ? (image2d->height >> level) : 1;
+}
+
 GLchar* compute_lib_image2d_glsl_layout(compute_lib_image2d_t* image2d)
 {
     char* str;
@@ -674,6 +684,32 @@ GLchar* compute_lib_image2d_glsl_layout(compute_lib_image2d_t* image2d)
     return str;
 }
 
+GLchar* compute_lib_image2d_glsl_sampler_layout(compute_lib_image2d_t* image2d)
+{
+    char* str;
+    asprintf(&str, "layout(binding=%d) uniform highp %s %s", image2d->texture - GL_TEXTURE0, gl3_get_glsl_sampler2d_type(image2d->compatibility_format), image2d->resource.name);
+    return str;
+}
+
+GLuint compute_lib_image2d_bind(compute_lib_image2d_t* image2d)
+{
+    glBindImageTexture(image2d->resource.value, image2d->handle, image2d->level, GL_FALSE, 0, image2d->access, image2d->compatibility_format);
+    return compute_lib_gl_errors_count();
+}
+
+GLuint compute_lib_image2d_bind_level(compute_lib_image2d_t* image2d, GLint level)
+{
+    image2d->level = level;
+    return compute_lib_image2d_bind(image2d);
+}
+
+GLuint compute_lib_image2d_bind_sampler(compute_lib_image2d_t* image2d)
+{
+    glActiveTexture(image2d->texture);
+    glBindTexture(GL_TEXTURE_2D, image2d->handle);
+    return compute_lib_gl_errors_count();
+}
+
 GLuint compute_lib_image2d_destroy(compute_lib_image2d_t* image2d)
 {
     compute_lib_framebuffer_destroy(&(image2d->framebuffer));
@@ -721,18 +757,32 @@ GLuint compute_lib_image2d_reset_patch(compute_lib_image2d_t* image2d, void* px_
 
 GLuint compute_lib_image2d_write(compute_lib_image2d_t* image2d, void* image_data)
 {
+    return compute_lib_image2d_write_level(image2d, 0, image_data);
+}
+
+GLuint compute_lib_image2d_write_level(compute_lib_image2d_t* image2d, GLint level, void* image_data)
+{
+    GLsizei width, height;
+    compute_lib_image2d_level_size(image2d, level, &width, &height);
     glBindTexture(GL_TEXTURE_2D, image2d->handle);
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image2d->width, image2d->height, image2d->format, image2d->type, image_data);
+    glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, image2d->format, image2d->type, image_data);
     return compute_lib_gl_errors_count();
 }
 
 GLuint compute_lib_image2d_read(compute_lib_image2d_t* image2d, void* image_data)
+{
+    return compute_lib_image2d_read_level(image2d, 0, image_data);
+}
+
+GLuint compute_lib_image2d_read_level(compute_lib_image2d_t* image2d, GLint level, void* image_data)
 {
     if (image2d->framebuffer.handle != 0) {
+        GLsizei width, height;
+        compute_lib_image2d_level_size(image2d, level, &width, &height);
         glBindTexture(GL_TEXTURE_2D, image2d->handle);
         glBindFramebuffer(GL_FRAMEBUFFER, image2d->framebuffer.handle);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, image2d->framebuffer.attachment, GL_TEXTURE_2D, image2d->handle, 0);
-        glReadPixels(0, 0, image2d->width, image2d->height, image2d->format, image2d->type, image_data);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, image2d->framebuffer.attachment, GL_TEXTURE_2D, image2d->handle, level);
+        glReadPixels(0, 0, width, height, image2d->format, image2d->type, image_data);
     }
     return compute_lib_gl_errors_count();
 }
@@ -815,6 +865,12 @@ GLuint compute_lib_ssbo_destroy(compute_lib_ssbo_t* ssbo)
     return compute_lib_gl_errors_count();
 }
 
+GLuint compute_lib_ssbo_bind(compute_lib_ssbo_t* ssbo)
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, ssbo->resource.value, ssbo->handle);
+    return compute_lib_gl_errors_count();
+}
+
 GLchar* compute_lib_ssbo_glsl_layout(compute_lib_ssbo_t* ssbo)
 {
     char* str;
@@ -2008,6 +2008,16 @@ GLenum gl3_get_image2d_compatibility_format(GLenum internal_format)
         case GL_RGB16F:
         case GL_RGBA16F:
             return GL_RGBA16F;
+        case GL_R8:
+        case GL_RG8:
+        case GL_RGB8:
+        case GL_RGBA8:
+            return GL_RGBA8;
+        case GL_R8_SNORM:
+        case GL_RG8_SNORM:
+        case GL_RGB8_SNORM:
+        case GL_RGBA8_SNORM:
+            return GL_RGBA8_SNORM;
         case GL_R32F:
             return GL_R32F;
         case GL_RG32F:
@@ -2075,6 +2085,30 @@ const GLchar* gl3_get_glsl_image2d_type(GLenum compatibility_format)
     }
 }
 
+const GLchar* gl3_get_glsl_sampler2d_type(GLenum compatibility_format)
+{
+    switch(compatibility_format) {
+        case GL_RGBA32F:
+        case GL_RGBA16F:
+        case GL_R32F:
+        case GL_RGBA8:
+        case GL_RGBA8_SNORM:
+            return "sampler2D";
+        case GL_RGBA32UI:
+        case GL_RGBA16UI:
+        case GL_RGBA8UI:
+        case GL_R32UI:
+            return "usampler2D";
+        case GL_RGBA32I:
+        case GL_RGBA16I:
+        case GL_RGBA8I:
+        case GL_R32I:
+            return "isampler2D";
+        default:
+            return 0;
+    }
+}
+
 const GLchar* gl3_get_glsl_image2d_format_qualifier(GLenum compatibility_format)
 {
     switch(compatibility_format) {
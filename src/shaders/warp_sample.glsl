@@ -0,0 +1,30 @@
+// Input sampling of the warp and remap programs (inserted into their sources after the input sampler and METHOD definitions)
+
+// samples the input image at input pixel coordinates, the border value is used outside of the image
+vec4 sample_input(vec2 src, vec4 border)
+{
+    ivec2 size_in = textureSize(input_image2d, 0);
+
+#if METHOD == METHOD_NEAREST
+    ivec2 src_px = ivec2(floor(src + 0.5f));
+    if (all(greaterThanEqual(src_px, ivec2(0))) && all(lessThan(src_px, size_in))) {
+        return texelFetch(input_image2d, src_px, 0);
+    }
+#else
+    if (all(greaterThan(src, vec2(-1.0f))) && all(lessThan(src, vec2(size_in)))) {
+        // sampler interpolates between pixel centres, the border is blended in at the image edges
+        if (src.x < 0.0f || src.y < 0.0f || src.x > float(size_in.x - 1) || src.y > float(size_in.y - 1)) {
+            vec2 f = fract(src);
+            ivec2 p0 = ivec2(floor(src));
+            vec4 v00 = (p0.x >= 0 && p0.y >= 0 && p0.x < size_in.x && p0.y < size_in.y) ? texelFetch(input_image2d, p0, 0) : border;
+            vec4 v10 = (p0.x + 1 < size_in.x && p0.y >= 0 && p0.y < size_in.y) ? texelFetch(input_image2d, p0 + ivec2(1, 0), 0) : border;
+            vec4 v01 = (p0.x >= 0 && p0.x < size_in.x && p0.y + 1 < size_in.y) ? texelFetch(input_image2d, p0 + ivec2(0, 1), 0) : border;
+            vec4 v11 = (p0.x + 1 < size_in.x && p0.y + 1 < size_in.y) ? texelFetch(input_image2d, p0 + ivec2(1, 1), 0) : border;
+            return mix(mix(v00, v10, f.x), mix(v01, v11, f.x), f.y);
+        }
+        return textureLod(input_image2d, (src + 0.5f) / vec2(size_in), 0.0f);
+    }
+#endif
+
+    return border;
+}
@@ -0,0 +1,276 @@
+/// \file test_background.c
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Test source file for GLES3ComputeLib library implementation of background subtraction (output image is the foreground mask of the last frame of a synthetic video).
+/// \copyright GNU Public License.
+
+#include "shaders/background.h"
+#include "utils/image.h"
+#include "utils/timer.h"
+
+#include <math.h>
+#include <stdint.h>
+
+#define LOCAL_SIZE_X 16
+#define LOCAL_SIZE_Y 16
+
+#define NUM_FRAMES 24
+#define LEARNING_RATE 0.05f
+#define THRESHOLD 2.5f
+
+
+static int clampi(int value, int low, int high)
+{
+    return (value < low) ? low : ((value > high) ? high : value);
+}
+
+static GLuint luma(rgba_t px)
+{
+    return (77 * px.r + 150 * px.g + 29 * px.b + 128) >> 8;
+}
+
+/// Renders a frame of the synthetic video: the input image with small noise and a square with inverted colors jumping over the image
+/// (its recent positions do not overlap, so the model is not updated by the square again before recovering).
+static void render_frame(const rgba_t* img_data, int width, int height, int frame, rgba_t* frame_data, unsigned char* ground_truth)
+{
+    int size = height / 6, x0 = ((frame * 7) % NUM_FRAMES) * (width - size) / (NUM_FRAMES - 1), y0 = ((frame * 5) % 8) * (height - size) / 7;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            rgba_t px = img_data[y * width + x];
+            uint32_t hash = ((uint32_t) x * 73856093u) ^ ((uint32_t) y * 19349663u) ^ ((uint32_t) frame * 83492791u);
+            int noise = (int) ((hash >> 8) % 7) - 3;
+            rgba_t out = { clampi(px.r + noise, 0, 255), clampi(px.g + noise, 0, 255), clampi(px.b + noise, 0, 255), 255 };
+            GLboolean inside = frame > 0 && x >= x0 && x < x0 + size && y >= y0 && y < y0 + size;
+            if (inside) {
+                out = (rgba_t) { 255 - px.r, 255 - px.g, 255 - px.b, 255 };
+            }
+            frame_data[y * width + x] = out;
+            // 1 at clearly visible foreground (in luma, which is the only channel of the mixture), 2 at the rest of the square
+            ground_truth[y * width + x] = inside ? ((abs((int) luma(out) - (int) luma(px)) > 48) ? 1 : 2) : 0;
+        }
+    }
+}
+
+/// Updates the model and classifies the frame on CPU.
+static void background_reference(const rgba_t* frame_data, int width, int height, GLenum method, GLboolean initialize, float* model, unsigned char* mask)
+{
+    const float initial_variance = 225.0f, min_variance = 16.0f, background_ratio = 0.7f, alpha = LEARNING_RATE, t2 = THRESHOLD * THRESHOLD;
+    for (int i = 0; i < width * height; i++) {
+        rgba_t px = frame_data[i];
+        GLboolean foreground = GL_FALSE;
+        if (method == COMPUTE_LIB_SHADERS_BACKGROUND_RUNNING_AVERAGE) {
+            float* m = &model[4 * i];
+            float color[3] = { px.r, px.g, px.b };
+            if (initialize) {
+                m[0] = color[0]; m[1] = color[1]; m[2] = color[2]; m[3] = initial_variance;
+            } else {
+                float difference[3] = { color[0] - m[0], color[1] - m[1], color[2] - m[2] };
+                float distance = (difference[0] * difference[0] + difference[1] * difference[1] + difference[2] * difference[2]) / 3.0f;
+                foreground = distance > t2 * m[3];
+                for (int c = 0; c < 3; c++) {
+                    m[c] += alpha * difference[c];
+                }
+                m[3] = fmaxf(m[3] + alpha * (distance - m[3]), min_variance);
+            }
+        } else {
+            float (*components)[4] = (float (*)[4]) &model[4 * COMPUTE_LIB_SHADERS_BACKGROUND_MAX_COMPONENTS * i];
+            float value = (float) luma(px);
+            if (initialize) {
+                for (int k = 0; k < COMPUTE_LIB_SHADERS_BACKGROUND_MAX_COMPONENTS; k++) {
+                    components[k][0] = (k == 0) ? 1.0f : 0.0f;
+                    components[k][1] = (k == 0) ? value : 0.0f;
+                    components[k][2] = initial_variance;
+                }
+            } else {
+                int matched = -1;
+                float cumulative_weight = 0.0f, total_weight = 0.0f;
+                foreground = GL_TRUE;
+                for (int k = 0; k < COMPUTE_LIB_SHADERS_BACKGROUND_MAX_COMPONENTS; k++) {
+                    float difference = value - components[k][1];
+                    if (matched < 0 && components[k][0] > 0.0f && difference * difference <= t2 * components[k][2]) {
+                        matched = k;
+                        foreground = cumulative_weight >= background_ratio;
+                    }
+                    cumulative_weight += components[k][0];
+                }
+                for (int k = 0; k < COMPUTE_LIB_SHADERS_BACKGROUND_MAX_COMPONENTS; k++) {
+                    components[k][0] = (1.0f - alpha) * components[k][0] + ((k == matched) ? alpha : 0.0f);
+                    if (k == matched) {
+                        float rate = fminf(alpha / components[k][0], 1.0f), difference = value - components[k][1];
+                        components[k][1] += rate * difference;
+                        components[k][2] = fmaxf(components[k][2] + rate * (difference * difference - components[k][2]), min_variance);
+                    }
+                    total_weight += components[k][0];
+                }
+                if (matched < 0) {
+                    float* last = components[COMPUTE_LIB_SHADERS_BACKGROUND_MAX_COMPONENTS - 1];
+                    total_weight += alpha - last[0];
+                    last[0] = alpha; last[1] = value; last[2] = initial_variance;
+                }
+                for (int k = 0; k < COMPUTE_LIB_SHADERS_BACKGROUND_MAX_COMPONENTS; k++) {
+                    components[k][0] /= total_weight;
+                    components[k][3] = components[k][0] / sqrtf(components[k][2]);
+                }
+                for (int k = 1; k < COMPUTE_LIB_SHADERS_BACKGROUND_MAX_COMPONENTS; k++) {
+                    for (int j = k; j > 0 && components[j][3] > components[j - 1][3]; j--) {
+                        float component[4];
+                        memcpy(component, components[j], sizeof(component));
+                        memcpy(components[j], components[j - 1], sizeof(component));
+                        memcpy(components[j - 1], component, sizeof(component));
+                    }
+                }
+            }
+        }
+        mask[i] = foreground ? 255 : 0;
+    }
+}
+
+static int compare_tiles(const void* a, const void* b)
+{
+    GLuint ka = ((const GLuint*) a)[0], kb = ((const GLuint*) b)[0];
+    return (ka > kb) - (ka < kb);
+}
+
+/// Checks the changed tiles list against the tiles of the GPU mask (exact foreground counts).
+static int check_tiles(const rgba_t* mask_data, int width, int height, GLuint* tiles, GLuint num_tiles)
+{
+    int tiles_x = (width + LOCAL_SIZE_X - 1) / LOCAL_SIZE_X, tiles_y = (height + LOCAL_SIZE_Y - 1) / LOCAL_SIZE_Y;
+    GLuint* expected = (GLuint*) malloc(2 * tiles_x * tiles_y * sizeof(GLuint));
+    GLuint num_expected = 0;
+    for (int ty = 0; ty < tiles_y; ty++) {
+        for (int tx = 0; tx < tiles_x; tx++) {
+            GLuint count = 0;
+            for (int y = ty * LOCAL_SIZE_Y; y < (ty + 1) * LOCAL_SIZE_Y && y < height; y++) {
+                for (int x = tx * LOCAL_SIZE_X; x < (tx + 1) * LOCAL_SIZE_X && x < width; x++) {
+                    count += mask_data[y * width + x].r != 0;
+                }
+            }
+            if (count > 0) {
+                expected[2 * num_expected] = ((GLuint) ty << 16) | (GLuint) tx;
+                expected[2 * num_expected + 1] = count;
+                num_expected++;
+            }
+        }
+    }
+    qsort(tiles, num_tiles, 2 * sizeof(GLuint), compare_tiles);
+    int errors = (num_tiles != num_expected) || memcmp(tiles, expected, 2 * num_tiles * sizeof(GLuint)) != 0;
+    free(expected);
+    return errors;
+}
+
+/// Processes the synthetic video, compares the masks with CPU and evaluates the detection of the moving square.
+static int test_background(compute_lib_instance_t* inst, rgba_t* img_data, int width, int height, GLenum method, GLboolean list_tiles, rgba_t* output_img_data)
+{
+    compute_lib_shaders_background_t* background;
+    if ((background = compute_lib_shaders_background_init(inst, LOCAL_SIZE_X, LOCAL_SIZE_Y, width, height, method, list_tiles)) == NULL) {
+        return -1;
+    }
+
+    int num_components = (method == COMPUTE_LIB_SHADERS_BACKGROUND_MOG) ? COMPUTE_LIB_SHADERS_BACKGROUND_MAX_COMPONENTS : 1;
+    rgba_t* frame_data = (rgba_t*) malloc(width * height * sizeof(rgba_t));
+    rgba_t* mask_data = (rgba_t*) malloc(width * height * sizeof(rgba_t));
+    unsigned char* ground_truth = (unsigned char*) malloc(width * height);
+    unsigned char* expected = (unsigned char*) malloc(width * height);
+    float* model = (float*) malloc(4 * num_components * width * height * sizeof(float));
+    GLuint* tiles = (GLuint*) malloc(2 * (background->max_tiles + 1) * sizeof(GLuint));
+
+    GLuint errors_cnt = 0;
+    int mismatches = 0, tile_errors = 0;
+    long true_positives = 0, visible = 0, false_positives = 0;
+    double gpu_ms = 0.0, cpu_ms = 0.0;
+    for (int frame = 0; frame < NUM_FRAMES; frame++) {
+        render_frame(img_data, width, height, frame, frame_data, ground_truth);
+        errors_cnt += compute_lib_image2d_write(&(background->input_image2d), frame_data);
+        glFinish();
+        double start = time_now_ms();
+        errors_cnt += compute_lib_shaders_background_dispatch(background, LEARNING_RATE, THRESHOLD);
+        glFinish();
+        gpu_ms += time_now_ms() - start;
+        errors_cnt += compute_lib_image2d_read(&(background->mask_image2d), mask_data);
+
+        start = time_now_ms();
+        background_reference(frame_data, width, height, method, frame == 0, model, expected);
+        cpu_ms += time_now_ms() - start;
+
+        for (int i = 0; i < width * height; i++) {
+            mismatches += (mask_data[i].r != 0) != (expected[i] != 0);
+            if (frame > 0) {
+                visible += ground_truth[i] == 1;
+                true_positives += ground_truth[i] == 1 && mask_data[i].r != 0;
+                false_positives += ground_truth[i] == 0 && mask_data[i].r != 0;
+            }
+        }
+        if (list_tiles) {
+            GLuint num_tiles;
+            errors_cnt += compute_lib_shaders_background_read_tiles(background, tiles, &num_tiles);
+            tile_errors += check_tiles(mask_data, width, height, tiles, num_tiles);
+        }
+    }
+
+    // masks may differ at pixels on the threshold boundary due to the GPU floating point precision
+    long pixels = (long) NUM_FRAMES * width * height;
+    int errors = mismatches > pixels / 1000 || tile_errors > 0 || true_positives < 0.9 * visible || false_positives > pixels / 100;
+    printf("%-16s tiles %d: %d mask mismatches, %5.1f %% recall, %ld false positives, %d tile errors, GPU %7.3f ms/frame, CPU %8.3f ms/frame, %d errors\r\n",
+           (method == COMPUTE_LIB_SHADERS_BACKGROUND_MOG) ? "MoG" : "running average", list_tiles, mismatches, 100.0 * true_positives / visible, false_positives,
+           tile_errors, gpu_ms / NUM_FRAMES, cpu_ms / NUM_FRAMES, errors);
+
+    if (output_img_data != NULL) {
+        memcpy(output_img_data, mask_data, width * height * sizeof(rgba_t));
+    }
+
+    compute_lib_shaders_background_destroy(background);
+    free(frame_data);
+    free(mask_data);
+    free(ground_truth);
+    free(expected);
+    free(model);
+    free(tiles);
+    return (errors_cnt != GL_NO_ERROR) ? -1 : errors;
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <path to input image> <path to output image>\r\n", argv[0]);
+        return 1;
+    }
+
+    rgba_t* input_img_data;
+    int width, height;
+    printf("Loading image: %s\r\n", argv[1]);
+    if (!image_load(argv[1], &width, &height, 4, (unsigned char**) &input_img_data)) {
+        fprintf(stderr, "Failed to load image file!\r\n");
+        return 2;
+    }
+    printf("Loaded image with size %dx%d px.\r\n", width, height);
+
+    printf("Initializing compute library instance.\r\n");
+    compute_lib_instance_t inst = COMPUTE_LIB_INSTANCE_NEW("/dev/dri/renderD128");
+    if (compute_lib_init(&inst) != GL_NO_ERROR) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 3;
+    }
+
+    rgba_t* output_img_data = (rgba_t*) malloc(width * height * sizeof(rgba_t));
+    int errors = 0;
+    errors += test_background(&inst, input_img_data, width, height, COMPUTE_LIB_SHADERS_BACKGROUND_RUNNING_AVERAGE, GL_FALSE, NULL);
+    errors += test_background(&inst, input_img_data, width, height, COMPUTE_LIB_SHADERS_BACKGROUND_RUNNING_AVERAGE, GL_TRUE, NULL);
+    errors += test_background(&inst, input_img_data, width, height, COMPUTE_LIB_SHADERS_BACKGROUND_MOG, GL_TRUE, output_img_data);
+    if (errors != 0) {
+        fprintf(stderr, "Background subtraction test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 4;
+    }
+
+    printf("Writing output image: %s\r\n", argv[2]);
+    if (!image_save(argv[2], width, height, 4, (unsigned char*) output_img_data)) {
+        fprintf(stderr, "Failed to write image file!\r\n");
+        return 5;
+    }
+
+    compute_lib_deinit(&inst);
+    free(output_img_data);
+
+    printf("Program Done.\r\n");
+}
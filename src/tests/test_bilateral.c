@@ -0,0 +1,165 @@
+/// \file test_bilateral.c
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Test source file for GLES3ComputeLib library implementation of the bilateral filter (output image is the filtered input image).
+/// \copyright GNU Public License.
+
+#include "shaders/bilateral.h"
+#include "utils/image.h"
+#include "utils/timer.h"
+
+#include <math.h>
+
+#define LOCAL_SIZE_X 16
+#define LOCAL_SIZE_Y 16
+
+
+static int clampi(int value, int low, int high)
+{
+    return (value < low) ? low : ((value > high) ? high : value);
+}
+
+/// Filters RGB channels on CPU with the same weights as the GPU (input values are floats, alpha is copied).
+static void bilateral_reference(const float* input, int width, int height, int radius, const float* weights, int range_lut_size, float range_scale, GLboolean interpolate, float* output)
+{
+    int window_size = 2 * radius + 1;
+    const float* range_weights = weights + window_size * window_size;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const float* center = &input[4 * (y * width + x)];
+            double sum[3] = { 0.0, 0.0, 0.0 }, weight_sum = 0.0;
+            for (int j = -radius; j <= radius; j++) {
+                for (int i = -radius; i <= radius; i++) {
+                    const float* value = &input[4 * (clampi(y + j, 0, height - 1) * width + clampi(x + i, 0, width - 1))];
+                    float distance = (fabsf(value[0] - center[0]) + fabsf(value[1] - center[1]) + fabsf(value[2] - center[2])) * range_scale;
+                    float range_weight;
+                    if (interpolate) {
+                        float index = fminf(distance, range_lut_size - 1);
+                        int k = (int) index;
+                        k = (k > range_lut_size - 2) ? range_lut_size - 2 : k;
+                        range_weight = range_weights[k] + (range_weights[k + 1] - range_weights[k]) * (index - k);
+                    } else {
+                        range_weight = range_weights[(int) distance];
+                    }
+                    double weight = (double) weights[(j + radius) * window_size + i + radius] * range_weight;
+                    for (int c = 0; c < 3; c++) {
+                        sum[c] += weight * value[c];
+                    }
+                    weight_sum += weight;
+                }
+            }
+            for (int c = 0; c < 3; c++) {
+                output[4 * (y * width + x) + c] = (float) (sum[c] / weight_sum);
+            }
+            output[4 * (y * width + x) + 3] = center[3];
+        }
+    }
+}
+
+/// Filters the image on GPU and compares it with CPU, RGBA8 results may differ by rounding, RGBA32F ones by the float precision.
+static int test_bilateral(compute_lib_instance_t* inst, rgba_t* img_data, int width, int height, GLenum type, int radius, GLfloat sigma_spatial, GLfloat sigma_range, rgba_t* output_img_data)
+{
+    compute_lib_shaders_bilateral_t* bilateral;
+    if ((bilateral = compute_lib_shaders_bilateral_init(inst, LOCAL_SIZE_X, LOCAL_SIZE_Y, width, height, type, radius, sigma_spatial, sigma_range)) == NULL) {
+        return -1;
+    }
+
+    int window_size = 2 * radius + 1;
+    float* input = (float*) malloc(4 * width * height * sizeof(float));
+    float* expected = (float*) malloc(4 * width * height * sizeof(float));
+    float* output = (float*) malloc(4 * width * height * sizeof(float));
+    rgba_t* output8 = (rgba_t*) malloc(width * height * sizeof(rgba_t));
+    float* weights = (float*) malloc((window_size * window_size + bilateral->range_lut_size) * sizeof(float));
+    // float images hold values from 0 to 1
+    float value_scale = (type == GL_FLOAT) ? 1.0f / 255.0f : 1.0f;
+    for (int i = 0; i < width * height; i++) {
+        input[4 * i] = img_data[i].r * value_scale;
+        input[4 * i + 1] = img_data[i].g * value_scale;
+        input[4 * i + 2] = img_data[i].b * value_scale;
+        input[4 * i + 3] = img_data[i].a * value_scale;
+    }
+
+    GLuint errors_cnt = compute_lib_image2d_write(&(bilateral->input_image2d), (type == GL_FLOAT) ? (void*) input : (void*) img_data);
+    errors_cnt += compute_lib_shaders_bilateral_dispatch(bilateral);
+    glFinish();
+    double start = time_now_ms();
+    errors_cnt += compute_lib_shaders_bilateral_dispatch(bilateral);
+    errors_cnt += compute_lib_image2d_read(&(bilateral->output_image2d), (type == GL_FLOAT) ? (void*) output : (void*) output8);
+    double gpu_ms = time_now_ms() - start;
+
+    start = time_now_ms();
+    compute_lib_shaders_bilateral_weights(bilateral, sigma_spatial, sigma_range, weights);
+    bilateral_reference(input, width, height, radius, weights, bilateral->range_lut_size, bilateral->range_scale, type == GL_FLOAT, expected);
+    double cpu_ms = time_now_ms() - start;
+
+    int errors = 0;
+    double max_difference = 0.0;
+    for (int i = 0; i < 4 * width * height; i++) {
+        float value = (type == GL_FLOAT) ? output[i] : ((unsigned char*) output8)[i];
+        double difference = fabs(value - expected[i]);
+        max_difference = (difference > max_difference) ? difference : max_difference;
+        errors += difference > ((type == GL_FLOAT) ? 1e-4 : 0.5 + 1e-3);
+    }
+    printf("%-7s radius %d, sigmas %4.1f px %6.3f: max difference %.6f, GPU %8.3f ms, CPU %9.3f ms, %d errors\r\n", (type == GL_FLOAT) ? "RGBA32F" : "RGBA8", radius, sigma_spatial, sigma_range,
+           max_difference, gpu_ms, cpu_ms, errors);
+
+    if (output_img_data != NULL) {
+        memcpy(output_img_data, output8, width * height * sizeof(rgba_t));
+    }
+
+    compute_lib_shaders_bilateral_destroy(bilateral);
+    free(input);
+    free(expected);
+    free(output);
+    free(output8);
+    free(weights);
+    return (errors_cnt != GL_NO_ERROR) ? -1 : errors;
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <path to input image> <path to output image>\r\n", argv[0]);
+        return 1;
+    }
+
+    rgba_t* input_img_data;
+    int width, height;
+    printf("Loading image: %s\r\n", argv[1]);
+    if (!image_load(argv[1], &width, &height, 4, (unsigned char**) &input_img_data)) {
+        fprintf(stderr, "Failed to load image file!\r\n");
+        return 2;
+    }
+    printf("Loaded image with size %dx%d px.\r\n", width, height);
+
+    printf("Initializing compute library instance.\r\n");
+    compute_lib_instance_t inst = COMPUTE_LIB_INSTANCE_NEW("/dev/dri/renderD128");
+    if (compute_lib_init(&inst) != GL_NO_ERROR) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 3;
+    }
+
+    rgba_t* output_img_data = (rgba_t*) malloc(width * height * sizeof(rgba_t));
+    int errors = 0;
+    errors += test_bilateral(&inst, input_img_data, width, height, GL_UNSIGNED_BYTE, 2, 1.5f, 20.0f, NULL);
+    errors += test_bilateral(&inst, input_img_data, width, height, GL_UNSIGNED_BYTE, 5, 3.0f, 40.0f, output_img_data);
+    errors += test_bilateral(&inst, input_img_data, width, height, GL_FLOAT, 2, 1.5f, 0.08f, NULL);
+    errors += test_bilateral(&inst, input_img_data, width, height, GL_FLOAT, 5, 3.0f, 0.15f, NULL);
+    if (errors != 0) {
+        fprintf(stderr, "Bilateral filter test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 4;
+    }
+
+    printf("Writing output image: %s\r\n", argv[2]);
+    if (!image_save(argv[2], width, height, 4, (unsigned char*) output_img_data)) {
+        fprintf(stderr, "Failed to write image file!\r\n");
+        return 5;
+    }
+
+    compute_lib_deinit(&inst);
+    free(output_img_data);
+
+    printf("Program Done.\r\n");
+}
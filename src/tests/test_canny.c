@@ -0,0 +1,196 @@
+/// \file test_canny.c
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Test source file for GLES3ComputeLib library implementation of Canny edge detection (output image is the edge map).
+/// \copyright GNU Public License.
+
+#include "shaders/canny.h"
+#include "utils/image.h"
+#include "utils/timer.h"
+
+#include <math.h>
+
+#define LOCAL_SIZE_X 16
+#define LOCAL_SIZE_Y 16
+
+
+/// Computes Sobel gradients (zero at the border) on CPU, interleaved x and y derivatives.
+static void gradient_reference(const rgba_t* img_data, int width, int height, float* gradient)
+{
+    float* luma = (float*) malloc(width * height * sizeof(float));
+    for (int i = 0; i < width * height; i++) {
+        luma[i] = (float) ((77 * img_data[i].r + 150 * img_data[i].g + 29 * img_data[i].b + 128) >> 8);
+    }
+    memset(gradient, 0, 2 * width * height * sizeof(float));
+    for (int y = 1; y < height - 1; y++) {
+        for (int x = 1; x < width - 1; x++) {
+            const float* l = &luma[y * width + x];
+            gradient[2 * (y * width + x)] = (l[-width + 1] + 2.0f * l[1] + l[width + 1]) - (l[-width - 1] + 2.0f * l[-1] + l[width - 1]);
+            gradient[2 * (y * width + x) + 1] = (l[width - 1] + 2.0f * l[width] + l[width + 1]) - (l[-width - 1] + 2.0f * l[-width] + l[-width + 1]);
+        }
+    }
+    free(luma);
+}
+
+/// Computes the edge map on CPU (hysteresis by flood fill from strong pixels), returns the number of edge pixels.
+static int canny_reference(const float* gradient, int width, int height, float low_threshold, float high_threshold, unsigned char* edges)
+{
+    static const int directions[4][2] = { { 1, 0 }, { 1, 1 }, { 0, 1 }, { 1, -1 } };
+    unsigned char* state = (unsigned char*) calloc(width * height, 1);
+    int* stack = (int*) malloc(width * height * sizeof(int));
+    int top = 0, num_edges = 0;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            float gx = gradient[2 * (y * width + x)], gy = gradient[2 * (y * width + x) + 1];
+            float ax = fabsf(gx), ay = fabsf(gy);
+            int sector = (ay <= 0.41421356f * ax) ? 0 : ((ax <= 0.41421356f * ay) ? 2 : ((gx * gy > 0.0f) ? 1 : 3));
+            float m = gx * gx + gy * gy, neighbours[2] = { 0.0f, 0.0f };
+            for (int k = 0; k < 2; k++) {
+                int nx = x + (2 * k - 1) * directions[sector][0], ny = y + (2 * k - 1) * directions[sector][1];
+                if (nx >= 0 && ny >= 0 && nx < width && ny < height) {
+                    float ngx = gradient[2 * (ny * width + nx)], ngy = gradient[2 * (ny * width + nx) + 1];
+                    neighbours[k] = ngx * ngx + ngy * ngy;
+                }
+            }
+            if (m > low_threshold * low_threshold && m > neighbours[0] && m >= neighbours[1]) {
+                state[y * width + x] = (m > high_threshold * high_threshold) ? 2 : 1;
+                if (state[y * width + x] == 2) {
+                    stack[top++] = y * width + x;
+                }
+            }
+        }
+    }
+    while (top > 0) {
+        int p = stack[--top], x = p % width, y = p / width;
+        for (int j = -1; j <= 1; j++) {
+            for (int k = -1; k <= 1; k++) {
+                int nx = x + k, ny = y + j;
+                if (nx >= 0 && ny >= 0 && nx < width && ny < height && state[ny * width + nx] == 1) {
+                    state[ny * width + nx] = 2;
+                    stack[top++] = ny * width + nx;
+                }
+            }
+        }
+    }
+    for (int i = 0; i < width * height; i++) {
+        edges[i] = (state[i] == 2) ? 255 : 0;
+        num_edges += state[i] == 2;
+    }
+    free(state);
+    free(stack);
+    return num_edges;
+}
+
+/// Detects edges, compares the gradient, edge map and edge pixel list with CPU.
+static int test_canny(compute_lib_instance_t* inst, rgba_t* img_data, int width, int height, float low_threshold, float high_threshold, int max_edge_pixels, rgba_t* output_img_data)
+{
+    compute_lib_shaders_canny_t* canny;
+    if ((canny = compute_lib_shaders_canny_init(inst, LOCAL_SIZE_X, LOCAL_SIZE_Y, width, height, max_edge_pixels)) == NULL) {
+        return -1;
+    }
+
+    rgba_t* result = (rgba_t*) malloc(width * height * sizeof(rgba_t));
+    float* gradient = (float*) malloc(4 * width * height * sizeof(float));
+    float* expected_gradient = (float*) malloc(2 * width * height * sizeof(float));
+    unsigned char* expected = (unsigned char*) malloc(width * height);
+    GLuint* pixels = (GLuint*) malloc(((max_edge_pixels > 0) ? max_edge_pixels : 1) * sizeof(GLuint));
+    GLuint num_pixels = 0, total_pixels = 0;
+
+    GLuint errors_cnt = compute_lib_image2d_write(&(canny->input_image2d), img_data);
+    errors_cnt += compute_lib_shaders_canny_dispatch(canny, low_threshold, high_threshold);
+    glFinish();
+    double start = time_now_ms();
+    errors_cnt += compute_lib_shaders_canny_dispatch(canny, low_threshold, high_threshold);
+    if (max_edge_pixels > 0) {
+        errors_cnt += compute_lib_shaders_canny_read_edges(canny, pixels, &num_pixels, &total_pixels);
+    } else {
+        errors_cnt += compute_lib_image2d_read(&(canny->output_image2d), result);
+    }
+    double gpu_ms = time_now_ms() - start;
+    errors_cnt += compute_lib_image2d_read(&(canny->output_image2d), result);
+    errors_cnt += compute_lib_image2d_read(&(canny->gradient_image2d), gradient);
+
+    start = time_now_ms();
+    gradient_reference(img_data, width, height, expected_gradient);
+    int expected_num_edges = canny_reference(expected_gradient, width, height, low_threshold, high_threshold, expected);
+    double cpu_ms = time_now_ms() - start;
+
+    int errors = 0;
+    for (int i = 0; i < width * height; i++) {
+        errors += gradient[4 * i] != expected_gradient[2 * i] || gradient[4 * i + 1] != expected_gradient[2 * i + 1];
+        errors += result[i].r != expected[i] || result[i].g != expected[i] || result[i].b != expected[i] || result[i].a != 255;
+    }
+    // listed pixels are distinct edge pixels
+    if (max_edge_pixels > 0) {
+        errors += (int) total_pixels != expected_num_edges || (int) num_pixels != ((expected_num_edges < max_edge_pixels) ? expected_num_edges : max_edge_pixels);
+        for (GLuint i = 0; i < num_pixels; i++) {
+            int x = pixels[i] & 0xFFFF, y = pixels[i] >> 16;
+            if (x >= width || y >= height || expected[y * width + x] != 255) {
+                errors++;
+            } else {
+                expected[y * width + x] = 1;
+            }
+        }
+    }
+    printf("Canny thresholds %5.1f/%5.1f, list capacity %7d: %6d edge pixels, %2d hysteresis iterations, GPU %8.3f ms, CPU %8.3f ms, %d errors\r\n",
+           low_threshold, high_threshold, max_edge_pixels, expected_num_edges, canny->iterations, gpu_ms, cpu_ms, errors);
+    if (output_img_data != NULL) {
+        memcpy(output_img_data, result, width * height * sizeof(rgba_t));
+    }
+
+    compute_lib_shaders_canny_destroy(canny);
+    free(result);
+    free(gradient);
+    free(expected_gradient);
+    free(expected);
+    free(pixels);
+    return (errors_cnt != GL_NO_ERROR) ? -1 : errors;
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <path to input image> <path to output image>\r\n", argv[0]);
+        return 1;
+    }
+
+    rgba_t* input_img_data;
+    int width, height;
+    printf("Loading image: %s\r\n", argv[1]);
+    if (!image_load(argv[1], &width, &height, 4, (unsigned char**) &input_img_data)) {
+        fprintf(stderr, "Failed to load image file!\r\n");
+        return 2;
+    }
+    printf("Loaded image with size %dx%d px.\r\n", width, height);
+
+    printf("Initializing compute library instance.\r\n");
+    compute_lib_instance_t inst = COMPUTE_LIB_INSTANCE_NEW("/dev/dri/renderD128");
+    if (compute_lib_init(&inst) != GL_NO_ERROR) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 3;
+    }
+
+    rgba_t* output_img_data = (rgba_t*) malloc(width * height * sizeof(rgba_t));
+    int errors = 0;
+    errors += test_canny(&inst, input_img_data, width, height, 20.0f, 60.0f, 0, NULL);
+    errors += test_canny(&inst, input_img_data, width, height, 50.0f, 150.0f, width * height, NULL);
+    errors += test_canny(&inst, input_img_data, width, height, 10.0f, 200.0f, 1000, NULL);
+    errors += test_canny(&inst, input_img_data, width, height, 40.0f, 120.0f, width * height, output_img_data);
+    if (errors != 0) {
+        fprintf(stderr, "Canny edge detection test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 4;
+    }
+
+    printf("Writing output image: %s\r\n", argv[2]);
+    if (!image_save(argv[2], width, height, 4, (unsigned char*) output_img_data)) {
+        fprintf(stderr, "Failed to write image file!\r\n");
+        return 5;
+    }
+
+    compute_lib_deinit(&inst);
+    free(output_img_data);
+
+    printf("Program Done.\r\n");
+}
@@ -0,0 +1,190 @@
+/// \file test_ccl.c
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Test source file for GLES3ComputeLib library implementation of connected-component labelling (output image shows components of the thresholded red channel in pseudo-colours).
+/// \copyright GNU Public License.
+
+#include "shaders/ccl.h"
+#include "utils/image.h"
+#include "utils/timer.h"
+
+#include <math.h>
+
+#define LOCAL_SIZE_X 16
+#define LOCAL_SIZE_Y 8
+
+#define THRESHOLD 128
+
+
+/// Labels components on CPU by flood fill (labels are component index + 1 in raster order of the first pixel), returns the number of components.
+static GLuint ccl_reference(const rgba_t* img_data, int width, int height, int connectivity, GLuint* labels, compute_lib_shaders_ccl_component_t* components)
+{
+    static const int offsets[8][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 }, { -1, -1 }, { 1, -1 }, { -1, 1 }, { 1, 1 } };
+    int* stack = (int*) malloc(width * height * sizeof(int));
+    GLuint num_components = 0;
+    memset(labels, 0, width * height * sizeof(GLuint));
+    for (int i = 0; i < width * height; i++) {
+        if (labels[i] != 0 || img_data[i].r < THRESHOLD) {
+            continue;
+        }
+        compute_lib_shaders_ccl_component_t* c = &components[num_components++];
+        double m10 = 0.0, m01 = 0.0, m20 = 0.0, m11 = 0.0, m02 = 0.0;
+        *c = (compute_lib_shaders_ccl_component_t) { .min_x = width, .min_y = height };
+        int top = 0;
+        stack[top++] = i;
+        labels[i] = num_components;
+        while (top > 0) {
+            int p = stack[--top], x = p % width, y = p / width;
+            c->area++;
+            c->min_x = (x < (int) c->min_x) ? (GLuint) x : c->min_x;
+            c->min_y = (y < (int) c->min_y) ? (GLuint) y : c->min_y;
+            c->max_x = (x > (int) c->max_x) ? (GLuint) x : c->max_x;
+            c->max_y = (y > (int) c->max_y) ? (GLuint) y : c->max_y;
+            m10 += x;
+            m01 += y;
+            m20 += (double) x * x;
+            m11 += (double) x * y;
+            m02 += (double) y * y;
+            for (int k = 0; k < connectivity; k++) {
+                int nx = x + offsets[k][0], ny = y + offsets[k][1];
+                if (nx >= 0 && ny >= 0 && nx < width && ny < height && labels[ny * width + nx] == 0 && img_data[ny * width + nx].r >= THRESHOLD) {
+                    labels[ny * width + nx] = num_components;
+                    stack[top++] = ny * width + nx;
+                }
+            }
+        }
+        c->centroid_x = m10 / c->area;
+        c->centroid_y = m01 / c->area;
+        c->mu20 = m20 - c->centroid_x * m10;
+        c->mu11 = m11 - c->centroid_x * m01;
+        c->mu02 = m02 - c->centroid_y * m01;
+    }
+    free(stack);
+    return num_components;
+}
+
+static int moments_differ(double a, double b)
+{
+    return fabs(a - b) > 1e-6 * fmax(1.0, fabs(b));
+}
+
+/// Labels the thresholded red channel, checks that GPU components are the CPU components (in any order) with equal statistics.
+static int test_ccl(compute_lib_instance_t* inst, rgba_t* img_data, int width, int height, int connectivity, int max_components, GLuint* output_labels)
+{
+    compute_lib_shaders_ccl_t* ccl;
+    if ((ccl = compute_lib_shaders_ccl_init(inst, LOCAL_SIZE_X, LOCAL_SIZE_Y, width, height, connectivity, max_components)) == NULL) {
+        return -1;
+    }
+
+    compute_lib_shaders_ccl_component_t* components = (compute_lib_shaders_ccl_component_t*) malloc(width * height * sizeof(compute_lib_shaders_ccl_component_t));
+    compute_lib_shaders_ccl_component_t* expected = (compute_lib_shaders_ccl_component_t*) malloc(width * height * sizeof(compute_lib_shaders_ccl_component_t));
+    GLuint* labels = (GLuint*) malloc(width * height * sizeof(GLuint));
+    GLuint* expected_labels = (GLuint*) malloc(width * height * sizeof(GLuint));
+    GLuint num_components = 0;
+
+    GLuint errors_cnt = compute_lib_image2d_write(&(ccl->input_image2d), img_data);
+    errors_cnt += compute_lib_shaders_ccl_dispatch(ccl, THRESHOLD);
+    glFinish();
+    double start = time_now_ms();
+    errors_cnt += compute_lib_shaders_ccl_dispatch(ccl, THRESHOLD);
+    errors_cnt += compute_lib_shaders_ccl_read(ccl, components, &num_components);
+    double gpu_ms = time_now_ms() - start;
+    errors_cnt += compute_lib_image2d_read(&(ccl->output_image2d), labels);
+
+    start = time_now_ms();
+    GLuint expected_num_components = ccl_reference(img_data, width, height, connectivity, expected_labels, expected);
+    double cpu_ms = time_now_ms() - start;
+
+    // GPU components are matched to CPU components by their pixels
+    int errors = (ccl->num_components != expected_num_components) + (num_components != ((expected_num_components < (GLuint) max_components) ? expected_num_components : (GLuint) max_components));
+    GLuint* matches = (GLuint*) calloc(expected_num_components + 1, sizeof(GLuint));
+    GLuint* matched = (GLuint*) calloc(ccl->num_components + 1, sizeof(GLuint));
+    for (int i = 0; i < width * height && errors == 0; i++) {
+        if ((labels[i] == 0) != (expected_labels[i] == 0) || labels[i] > ccl->num_components) {
+            errors++;
+        } else if (labels[i] != 0 && matches[expected_labels[i]] == 0 && matched[labels[i]] == 0) {
+            matches[expected_labels[i]] = labels[i];
+            matched[labels[i]] = expected_labels[i];
+        } else if (labels[i] != 0) {
+            errors += matches[expected_labels[i]] != labels[i];
+        }
+    }
+    for (GLuint i = 1; i <= expected_num_components && errors == 0; i++) {
+        if (matches[i] > num_components) {
+            continue;
+        }
+        compute_lib_shaders_ccl_component_t* c = &components[matches[i] - 1];
+        compute_lib_shaders_ccl_component_t* e = &expected[i - 1];
+        errors += c->area != e->area || c->min_x != e->min_x || c->min_y != e->min_y || c->max_x != e->max_x || c->max_y != e->max_y;
+        errors += moments_differ(c->centroid_x, e->centroid_x) || moments_differ(c->centroid_y, e->centroid_y);
+        errors += moments_differ(c->mu20, e->mu20) || moments_differ(c->mu11, e->mu11) || moments_differ(c->mu02, e->mu02);
+    }
+    printf("%d-connectivity, capacity %7d: %6u components (%6u stored), GPU labelling + table read %8.3f ms, CPU flood fill %8.3f ms, %d errors\r\n",
+           connectivity, max_components, ccl->num_components, num_components, gpu_ms, cpu_ms, errors);
+    if (output_labels != NULL) {
+        memcpy(output_labels, labels, width * height * sizeof(GLuint));
+    }
+
+    compute_lib_shaders_ccl_destroy(ccl);
+    free(components);
+    free(expected);
+    free(labels);
+    free(expected_labels);
+    free(matches);
+    free(matched);
+    return (errors_cnt != GL_NO_ERROR) ? -1 : errors;
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <path to input image> <path to output image>\r\n", argv[0]);
+        return 1;
+    }
+
+    rgba_t* input_img_data;
+    int width, height;
+    printf("Loading image: %s\r\n", argv[1]);
+    if (!image_load(argv[1], &width, &height, 4, (unsigned char**) &input_img_data)) {
+        fprintf(stderr, "Failed to load image file!\r\n");
+        return 2;
+    }
+    printf("Loaded image with size %dx%d px.\r\n", width, height);
+
+    printf("Initializing compute library instance.\r\n");
+    compute_lib_instance_t inst = COMPUTE_LIB_INSTANCE_NEW("/dev/dri/renderD128");
+    if (compute_lib_init(&inst) != GL_NO_ERROR) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 3;
+    }
+
+    GLuint* output_labels = (GLuint*) malloc(width * height * sizeof(GLuint));
+    int errors = 0;
+    errors += test_ccl(&inst, input_img_data, width, height, 4, width * height, NULL);
+    errors += test_ccl(&inst, input_img_data, width, height, 8, width * height, output_labels);
+    errors += test_ccl(&inst, input_img_data, width, height, 8, 16, NULL);
+    if (errors != 0) {
+        fprintf(stderr, "Connected-component labelling test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 4;
+    }
+
+    rgba_t* output_img_data = (rgba_t*) calloc(width * height, sizeof(rgba_t));
+    for (int i = 0; i < width * height; i++) {
+        GLuint hash = output_labels[i] * 2654435761u;
+        output_img_data[i] = (output_labels[i] == 0) ? (rgba_t) { 0, 0, 0, 255 } : (rgba_t) { hash >> 24, hash >> 16, hash >> 8, 255 };
+    }
+
+    printf("Writing output image: %s\r\n", argv[2]);
+    if (!image_save(argv[2], width, height, 4, (unsigned char*) output_img_data)) {
+        fprintf(stderr, "Failed to write image file!\r\n");
+        return 5;
+    }
+
+    compute_lib_deinit(&inst);
+    free(output_labels);
+    free(output_img_data);
+
+    printf("Program Done.\r\n");
+}
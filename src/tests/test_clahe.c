@@ -0,0 +1,192 @@
+/// \file test_clahe.c
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Test source file for GLES3ComputeLib library implementation of CLAHE (output image is the equalised darkened input image).
+/// \copyright GNU Public License.
+
+#include "shaders/clahe.h"
+#include "utils/image.h"
+#include "utils/timer.h"
+
+#include <math.h>
+
+#define LOCAL_SIZE_X 16
+#define LOCAL_SIZE_Y 16
+
+
+static GLuint pixel_value(rgba_t px, GLenum mode)
+{
+    return (mode == COMPUTE_LIB_SHADERS_HISTOGRAM_RED) ? px.r : (GLuint) ((77 * px.r + 150 * px.g + 29 * px.b + 128) >> 8);
+}
+
+/// Computes clipped histograms and look-up tables of all tiles on CPU.
+static void lut_reference(const rgba_t* img_data, int width, int height, compute_lib_shaders_clahe_t* clahe, float clip_limit, GLuint* lut)
+{
+    for (int ty = 0; ty < clahe->tiles_y; ty++) {
+        for (int tx = 0; tx < clahe->tiles_x; tx++) {
+            GLuint* bins = &lut[(ty * clahe->tiles_x + tx) * 256];
+            int x0 = tx * clahe->tile_width, y0 = ty * clahe->tile_height;
+            int x1 = (x0 + clahe->tile_width < width) ? x0 + clahe->tile_width : width, y1 = (y0 + clahe->tile_height < height) ? y0 + clahe->tile_height : height;
+            int area = (x1 - x0) * (y1 - y0);
+            memset(bins, 0, 256 * sizeof(GLuint));
+            for (int y = y0; y < y1; y++) {
+                for (int x = x0; x < x1; x++) {
+                    bins[pixel_value(img_data[y * width + x], clahe->mode)]++;
+                }
+            }
+            if (clip_limit > 0.0f) {
+                GLuint limit = (GLuint) (clip_limit * (float) area / 256.0f), excess = 0;
+                limit = (limit < 1) ? 1 : limit;
+                for (int b = 0; b < 256; b++) {
+                    if (bins[b] > limit) {
+                        excess += bins[b] - limit;
+                        bins[b] = limit;
+                    }
+                }
+                GLuint residual = excess % 256;
+                for (int b = 0; b < 256; b++) {
+                    bins[b] += excess / 256;
+                }
+                if (residual > 0) {
+                    GLuint step = (256 / residual > 1) ? 256 / residual : 1;
+                    for (GLuint b = 0; b < 256 && residual > 0; b += step, residual--) {
+                        bins[b]++;
+                    }
+                }
+            }
+            GLuint cdf = 0;
+            for (int b = 0; b < 256; b++) {
+                cdf += bins[b];
+                GLuint value = (GLuint) ((float) cdf * (255.0f / (float) area) + 0.5f);
+                bins[b] = (value > 255) ? 255 : value;
+            }
+        }
+    }
+}
+
+/// Interpolates the look-up tables of the nearest tiles on CPU.
+static void apply_reference(const rgba_t* img_data, int width, int height, compute_lib_shaders_clahe_t* clahe, const GLuint* lut, unsigned char* output)
+{
+    for (int y = 0; y < height; y++) {
+        float ty = (y + 0.5f) / clahe->tile_height - 0.5f;
+        int ty0 = (int) floorf(ty), ty1 = (ty0 + 1 < clahe->tiles_y) ? ty0 + 1 : clahe->tiles_y - 1;
+        float wy = ty - ty0;
+        ty0 = (ty0 < 0) ? 0 : ty0;
+        for (int x = 0; x < width; x++) {
+            float tx = (x + 0.5f) / clahe->tile_width - 0.5f;
+            int tx0 = (int) floorf(tx), tx1 = (tx0 + 1 < clahe->tiles_x) ? tx0 + 1 : clahe->tiles_x - 1;
+            float wx = tx - tx0;
+            tx0 = (tx0 < 0) ? 0 : tx0;
+            GLuint value = pixel_value(img_data[y * width + x], clahe->mode);
+            float top = lut[(ty0 * clahe->tiles_x + tx0) * 256 + value] * (1.0f - wx) + lut[(ty0 * clahe->tiles_x + tx1) * 256 + value] * wx;
+            float bottom = lut[(ty1 * clahe->tiles_x + tx0) * 256 + value] * (1.0f - wx) + lut[(ty1 * clahe->tiles_x + tx1) * 256 + value] * wx;
+            output[y * width + x] = (unsigned char) (top * (1.0f - wy) + bottom * wy + 0.5f);
+        }
+    }
+}
+
+/// Equalises the image on GPU and compares the look-up tables (exactly) and the output (interpolation may differ by rounding) with CPU.
+static int test_clahe(compute_lib_instance_t* inst, rgba_t* img_data, int width, int height, GLenum mode, int tiles_x, int tiles_y, GLfloat clip_limit, rgba_t* output_img_data)
+{
+    compute_lib_shaders_clahe_t* clahe;
+    if ((clahe = compute_lib_shaders_clahe_init(inst, LOCAL_SIZE_X, LOCAL_SIZE_Y, width, height, mode, tiles_x, tiles_y)) == NULL) {
+        return -1;
+    }
+
+    int lut_length = tiles_x * tiles_y * 256;
+    GLuint* lut = (GLuint*) malloc(lut_length * sizeof(GLuint));
+    GLuint* expected_lut = (GLuint*) malloc(lut_length * sizeof(GLuint));
+    rgba_t* output = (rgba_t*) malloc(width * height * sizeof(rgba_t));
+    unsigned char* expected = (unsigned char*) malloc(width * height);
+
+    GLuint errors_cnt = compute_lib_image2d_write(&(clahe->input_image2d), img_data);
+    errors_cnt += compute_lib_shaders_clahe_dispatch(clahe, clip_limit);
+    glFinish();
+    double start = time_now_ms();
+    errors_cnt += compute_lib_shaders_clahe_dispatch(clahe, clip_limit);
+    errors_cnt += compute_lib_image2d_read(&(clahe->output_image2d), output);
+    double gpu_ms = time_now_ms() - start;
+    errors_cnt += compute_lib_ssbo_read(&(clahe->lut_ssbo), lut, lut_length);
+
+    start = time_now_ms();
+    lut_reference(img_data, width, height, clahe, clip_limit, expected_lut);
+    apply_reference(img_data, width, height, clahe, expected_lut, expected);
+    double cpu_ms = time_now_ms() - start;
+
+    int lut_mismatches = 0, pixel_mismatches = 0;
+    for (int i = 0; i < lut_length; i++) {
+        lut_mismatches += lut[i] != expected_lut[i];
+    }
+    for (int i = 0; i < width * height; i++) {
+        pixel_mismatches += abs((int) output[i].r - (int) expected[i]) > 1 || output[i].g != output[i].r || output[i].b != output[i].r || output[i].a != 255;
+    }
+    printf("Mode %d, %2dx%-2d tiles, clip limit %.1f: %d look-up table mismatches, %d pixel mismatches, GPU %7.3f ms, CPU %7.3f ms\r\n", mode, tiles_x, tiles_y, clip_limit,
+           lut_mismatches, pixel_mismatches, gpu_ms, cpu_ms);
+
+    if (output_img_data != NULL) {
+        memcpy(output_img_data, output, width * height * sizeof(rgba_t));
+    }
+
+    compute_lib_shaders_clahe_destroy(clahe);
+    free(lut);
+    free(expected_lut);
+    free(output);
+    free(expected);
+    return (errors_cnt != GL_NO_ERROR) ? -1 : lut_mismatches + pixel_mismatches;
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <path to input image> <path to output image>\r\n", argv[0]);
+        return 1;
+    }
+
+    rgba_t* input_img_data;
+    int width, height;
+    printf("Loading image: %s\r\n", argv[1]);
+    if (!image_load(argv[1], &width, &height, 4, (unsigned char**) &input_img_data)) {
+        fprintf(stderr, "Failed to load image file!\r\n");
+        return 2;
+    }
+    printf("Loaded image with size %dx%d px.\r\n", width, height);
+
+    printf("Initializing compute library instance.\r\n");
+    compute_lib_instance_t inst = COMPUTE_LIB_INSTANCE_NEW("/dev/dri/renderD128");
+    if (compute_lib_init(&inst) != GL_NO_ERROR) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 3;
+    }
+
+    // low-light version of the input
+    rgba_t* dark_img_data = (rgba_t*) malloc(width * height * sizeof(rgba_t));
+    for (int i = 0; i < width * height; i++) {
+        rgba_t px = input_img_data[i];
+        dark_img_data[i] = (rgba_t) { px.r / 4, px.g / 4, px.b / 4, px.a };
+    }
+
+    rgba_t* output_img_data = (rgba_t*) malloc(width * height * sizeof(rgba_t));
+    int errors = 0;
+    errors += test_clahe(&inst, input_img_data, width, height, COMPUTE_LIB_SHADERS_HISTOGRAM_LUMA, 8, 8, 2.0f, NULL);
+    errors += test_clahe(&inst, dark_img_data, width, height, COMPUTE_LIB_SHADERS_HISTOGRAM_RED, 7, 5, 4.0f, NULL);
+    errors += test_clahe(&inst, dark_img_data, width, height, COMPUTE_LIB_SHADERS_HISTOGRAM_LUMA, 4, 4, 0.0f, NULL);
+    errors += test_clahe(&inst, dark_img_data, width, height, COMPUTE_LIB_SHADERS_HISTOGRAM_LUMA, 8, 8, 3.0f, output_img_data);
+    if (errors != 0) {
+        fprintf(stderr, "CLAHE test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 4;
+    }
+
+    printf("Writing output image: %s\r\n", argv[2]);
+    if (!image_save(argv[2], width, height, 4, (unsigned char*) output_img_data)) {
+        fprintf(stderr, "Failed to write image file!\r\n");
+        return 5;
+    }
+
+    compute_lib_deinit(&inst);
+    free(output_img_data);
+    free(dark_img_data);
+
+    printf("Program Done.\r\n");
+}
@@ -0,0 +1,306 @@
+/// \file test_color.c
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Test source file for GLES3ComputeLib library implementation of Bayer demosaicing and YUV conversions (output image is edge-aware demosaiced RGGB mosaic of the input image).
+/// \copyright GNU Public License.
+
+#include "shaders/color.h"
+#include "utils/image.h"
+#include "utils/timer.h"
+
+#include <math.h>
+
+#define LOCAL_SIZE_X 16
+#define LOCAL_SIZE_Y 4
+
+static const char* pattern_names[] = { "RGGB", "BGGR", "GRBG", "GBRG" };
+static const char* format_names[] = { "I420", "NV12", "YUYV", "GRAY" };
+static const char* standard_names[] = { "BT.601", "BT.709", "BT.601 full" };
+
+
+static double psnr(const rgba_t* a, const rgba_t* b, int length)
+{
+    double sum = 0.0;
+    for (int i = 0; i < length; i++) {
+        double dr = a[i].r - b[i].r, dg = a[i].g - b[i].g, db = a[i].b - b[i].b;
+        sum += dr * dr + dg * dg + db * db;
+    }
+    return (sum == 0.0) ? INFINITY : 10.0 * log10(255.0 * 255.0 * 3.0 * length / sum);
+}
+
+static inline float mirrored_raw(const GLubyte* raw, int width, int height, int x, int y)
+{
+    x = abs(x);
+    y = abs(y);
+    x = (x > 2 * (width - 1) - x) ? 2 * (width - 1) - x : x;
+    y = (y > 2 * (height - 1) - y) ? 2 * (height - 1) - y : y;
+    return raw[y * width + x];
+}
+
+/// Computes the bilinear demosaicing on CPU.
+static void demosaic_reference(const GLubyte* raw, rgba_t* dst, int width, int height, int red_x, int red_y)
+{
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int red_row = (y & 1) == red_y;
+            int red = red_row && (x & 1) == red_x;
+            int blue = !red_row && (x & 1) != red_x;
+            float c = mirrored_raw(raw, width, height, x, y);
+            float cross = 0.25f * (mirrored_raw(raw, width, height, x - 1, y) + mirrored_raw(raw, width, height, x + 1, y) +
+                                   mirrored_raw(raw, width, height, x, y - 1) + mirrored_raw(raw, width, height, x, y + 1));
+            float diagonal = 0.25f * (mirrored_raw(raw, width, height, x - 1, y - 1) + mirrored_raw(raw, width, height, x + 1, y - 1) +
+                                      mirrored_raw(raw, width, height, x - 1, y + 1) + mirrored_raw(raw, width, height, x + 1, y + 1));
+            float horizontal = 0.5f * (mirrored_raw(raw, width, height, x - 1, y) + mirrored_raw(raw, width, height, x + 1, y));
+            float vertical = 0.5f * (mirrored_raw(raw, width, height, x, y - 1) + mirrored_raw(raw, width, height, x, y + 1));
+            float r, g, b;
+            if (red) {
+                r = c; g = cross; b = diagonal;
+            } else if (blue) {
+                r = diagonal; g = cross; b = c;
+            } else if (red_row) {
+                r = horizontal; g = c; b = vertical;
+            } else {
+                r = vertical; g = c; b = horizontal;
+            }
+            dst[y * width + x] = (rgba_t) { (unsigned char) (r + 0.5f), (unsigned char) (g + 0.5f), (unsigned char) (b + 0.5f), 255 };
+        }
+    }
+}
+
+/// Mosaics the image with the pattern, demosaics it with both methods, checks bilinear result against CPU and measured colours of the edge-aware result.
+static int test_demosaic(compute_lib_instance_t* inst, const rgba_t* img_data, int width, int height, GLenum pattern, rgba_t* output_img_data)
+{
+    static const int red_positions[4][2] = { { 0, 0 }, { 1, 1 }, { 1, 0 }, { 0, 1 } };
+    int red_x = red_positions[pattern][0], red_y = red_positions[pattern][1];
+    GLubyte* raw = (GLubyte*) malloc(width * height);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const rgba_t* p = &img_data[y * width + x];
+            int red_row = (y & 1) == red_y;
+            raw[y * width + x] = (red_row && (x & 1) == red_x) ? p->r : ((!red_row && (x & 1) != red_x) ? p->b : p->g);
+        }
+    }
+
+    rgba_t* result = (rgba_t*) malloc(width * height * sizeof(rgba_t));
+    rgba_t* expected = (rgba_t*) malloc(width * height * sizeof(rgba_t));
+    demosaic_reference(raw, expected, width, height, red_x, red_y);
+    double method_psnr[2];
+    double method_ms[2];
+    int errors = 0;
+    for (GLenum method = COMPUTE_LIB_SHADERS_DEMOSAIC_BILINEAR; method <= COMPUTE_LIB_SHADERS_DEMOSAIC_EDGE_AWARE; method++) {
+        compute_lib_shaders_demosaic_t* demosaic;
+        if ((demosaic = compute_lib_shaders_demosaic_init(inst, LOCAL_SIZE_X, LOCAL_SIZE_Y, width, height, pattern, method)) == NULL) {
+            errors = -1;
+            break;
+        }
+        GLuint errors_cnt = compute_lib_image2d_write(&(demosaic->raw_image2d), raw);
+        errors_cnt += compute_lib_shaders_demosaic_dispatch(demosaic);
+        glFinish();
+        double start = time_now_ms();
+        errors_cnt += compute_lib_shaders_demosaic_dispatch(demosaic);
+        glFinish();
+        method_ms[method] = time_now_ms() - start;
+        errors_cnt += compute_lib_image2d_read(&(demosaic->output_image2d), result);
+        compute_lib_shaders_demosaic_destroy(demosaic);
+        if (errors_cnt != GL_NO_ERROR) {
+            errors = -1;
+            break;
+        }
+
+        method_psnr[method] = psnr(img_data, result, width * height);
+        if (method == COMPUTE_LIB_SHADERS_DEMOSAIC_BILINEAR) {
+            for (int i = 0; i < width * height; i++) {
+                errors += result[i].r != expected[i].r || result[i].g != expected[i].g || result[i].b != expected[i].b || result[i].a != 255;
+            }
+        } else {
+            // measured colour of each pixel is kept
+            for (int i = 0; i < width * height; i++) {
+                int x = i % width, y = i / width, red_row = (y & 1) == red_y;
+                GLubyte value = (red_row && (x & 1) == red_x) ? result[i].r : ((!red_row && (x & 1) != red_x) ? result[i].b : result[i].g);
+                errors += value != raw[i] || result[i].a != 255;
+            }
+            if (output_img_data != NULL) {
+                memcpy(output_img_data, result, width * height * sizeof(rgba_t));
+            }
+        }
+    }
+
+    if (errors == 0) {
+        printf("Demosaic %s: bilinear %.3f ms (PSNR %.2f dB), edge-aware %.3f ms (PSNR %.2f dB)\r\n", pattern_names[pattern],
+               method_ms[0], method_psnr[0], method_ms[1], method_psnr[1]);
+    }
+
+    free(raw);
+    free(result);
+    free(expected);
+    return errors;
+}
+
+/// Converts the image to the YUV frame and back, checks the frame and the decoded image against CPU, prints PSNR of the round trip.
+static int test_yuv(compute_lib_instance_t* inst, const rgba_t* img_data, int width, int height, GLenum format, GLenum standard)
+{
+    compute_lib_shaders_yuv_t* yuv;
+    if ((yuv = compute_lib_shaders_yuv_init(inst, LOCAL_SIZE_X, LOCAL_SIZE_Y, width, height, format, standard)) == NULL) {
+        return -1;
+    }
+
+    // CPU reference of the frame uses the same matrices (chroma of the average colour)
+    GLfloat to_yuv[9], to_rgb[9], offset[3];
+    compute_lib_shaders_yuv_matrices(standard, to_yuv, to_rgb, offset);
+    GLubyte* expected = (GLubyte*) malloc(yuv->frame_size);
+    GLubyte* frame = (GLubyte*) malloc((yuv->frame_size + 3) / 4 * 4);
+    int luma_size = width * height, chroma_width = width / 2;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const rgba_t* p = &img_data[y * width + x];
+            float luma = to_yuv[0] * p->r + to_yuv[3] * p->g + to_yuv[6] * p->b + offset[0];
+            int i = (format == COMPUTE_LIB_SHADERS_YUV_YUYV) ? 2 * (y * width + x) : y * width + x;
+            expected[i] = (GLubyte) fminf(fmaxf(luma + 0.5f, 0.0f), 255.0f);
+        }
+    }
+    if (format != COMPUTE_LIB_SHADERS_YUV_GRAY) {
+        int block_height = (format == COMPUTE_LIB_SHADERS_YUV_YUYV) ? 1 : 2;
+        for (int y = 0; y < height / block_height; y++) {
+            for (int x = 0; x < chroma_width; x++) {
+                float rgb[3] = { 0.0f, 0.0f, 0.0f };
+                for (int j = 0; j < block_height; j++) {
+                    const rgba_t* p = &img_data[(block_height * y + j) * width + 2 * x];
+                    rgb[0] += p[0].r + p[1].r;
+                    rgb[1] += p[0].g + p[1].g;
+                    rgb[2] += p[0].b + p[1].b;
+                }
+                float u = (to_yuv[1] * rgb[0] + to_yuv[4] * rgb[1] + to_yuv[7] * rgb[2]) / (2 * block_height) + offset[1];
+                float v = (to_yuv[2] * rgb[0] + to_yuv[5] * rgb[1] + to_yuv[8] * rgb[2]) / (2 * block_height) + offset[2];
+                GLubyte ub = (GLubyte) fminf(fmaxf(u + 0.5f, 0.0f), 255.0f), vb = (GLubyte) fminf(fmaxf(v + 0.5f, 0.0f), 255.0f);
+                if (format == COMPUTE_LIB_SHADERS_YUV_I420) {
+                    expected[luma_size + y * chroma_width + x] = ub;
+                    expected[luma_size + luma_size / 4 + y * chroma_width + x] = vb;
+                } else if (format == COMPUTE_LIB_SHADERS_YUV_NV12) {
+                    expected[luma_size + 2 * (y * chroma_width + x)] = ub;
+                    expected[luma_size + 2 * (y * chroma_width + x) + 1] = vb;
+                } else {
+                    expected[4 * (y * chroma_width + x) + 1] = ub;
+                    expected[4 * (y * chroma_width + x) + 3] = vb;
+                }
+            }
+        }
+    }
+
+    rgba_t* result = (rgba_t*) malloc(width * height * sizeof(rgba_t));
+    GLuint errors_cnt = compute_lib_image2d_write(&(yuv->rgba_image2d), (void*) img_data);
+    double start = time_now_ms();
+    errors_cnt += compute_lib_shaders_yuv_from_rgb(yuv);
+    glFinish();
+    double from_rgb_ms = time_now_ms() - start;
+    errors_cnt += compute_lib_ssbo_read(&(yuv->frame_ssbo), frame, (yuv->frame_size + 3) / 4);
+    errors_cnt += compute_lib_shaders_yuv_write(yuv, frame);
+    start = time_now_ms();
+    errors_cnt += compute_lib_shaders_yuv_to_rgb(yuv);
+    glFinish();
+    double to_rgb_ms = time_now_ms() - start;
+    errors_cnt += compute_lib_image2d_read(&(yuv->rgba_image2d), result);
+
+    int errors = 0;
+    for (int i = 0; i < yuv->frame_size; i++) {
+        errors += abs(frame[i] - expected[i]) > 1;
+    }
+    // conversion to RGB is checked against CPU decoding of the frame (grey frame has zero chroma)
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            float yuv[3] = { frame[y * width + x], offset[1], offset[2] };
+            int chroma = (y / 2) * chroma_width + x / 2;
+            if (format == COMPUTE_LIB_SHADERS_YUV_I420) {
+                yuv[1] = frame[luma_size + chroma];
+                yuv[2] = frame[luma_size + luma_size / 4 + chroma];
+            } else if (format == COMPUTE_LIB_SHADERS_YUV_NV12) {
+                yuv[1] = frame[luma_size + 2 * chroma];
+                yuv[2] = frame[luma_size + 2 * chroma + 1];
+            } else if (format == COMPUTE_LIB_SHADERS_YUV_YUYV) {
+                int pair = y * chroma_width + x / 2;
+                yuv[0] = frame[4 * pair + 2 * (x & 1)];
+                yuv[1] = frame[4 * pair + 1];
+                yuv[2] = frame[4 * pair + 3];
+            }
+            const rgba_t* p = &result[y * width + x];
+            GLubyte channels[3] = { p->r, p->g, p->b };
+            for (int c = 0; c < 3; c++) {
+                float value = to_rgb[c] * (yuv[0] - offset[0]) + to_rgb[3 + c] * (yuv[1] - offset[1]) + to_rgb[6 + c] * (yuv[2] - offset[2]);
+                errors += fabsf(fminf(fmaxf(value + 0.5f, 0.0f), 255.0f) - channels[c]) > 1.5f;
+            }
+        }
+    }
+    double round_trip_psnr = psnr(img_data, result, width * height);
+    printf("YUV %s (%s): from RGB %.3f ms, to RGB %.3f ms, round trip PSNR %.2f dB, %d errors\r\n", format_names[format], standard_names[standard],
+           from_rgb_ms, to_rgb_ms, round_trip_psnr, errors);
+
+    compute_lib_shaders_yuv_destroy(yuv);
+    free(expected);
+    free(frame);
+    free(result);
+    return (errors_cnt != GL_NO_ERROR) ? -1 : errors;
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <path to input image> <path to output image>\r\n", argv[0]);
+        return 1;
+    }
+
+    rgba_t* input_img_data;
+    int width, height;
+    printf("Loading image: %s\r\n", argv[1]);
+    if (!image_load(argv[1], &width, &height, 4, (unsigned char**) &input_img_data)) {
+        fprintf(stderr, "Failed to load image file!\r\n");
+        return 2;
+    }
+    printf("Loaded image with size %dx%d px.\r\n", width, height);
+
+    printf("Initializing compute library instance.\r\n");
+    compute_lib_instance_t inst = COMPUTE_LIB_INSTANCE_NEW("/dev/dri/renderD128");
+    if (compute_lib_init(&inst) != GL_NO_ERROR) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 3;
+    }
+
+    rgba_t* output_img_data = (rgba_t*) calloc(width * height, sizeof(rgba_t));
+    int errors = 0;
+    for (GLenum pattern = COMPUTE_LIB_SHADERS_BAYER_RGGB; pattern <= COMPUTE_LIB_SHADERS_BAYER_GBRG; pattern++) {
+        errors += test_demosaic(&inst, input_img_data, width, height, pattern, (pattern == COMPUTE_LIB_SHADERS_BAYER_RGGB) ? output_img_data : NULL);
+    }
+    if (errors != 0) {
+        fprintf(stderr, "Demosaicing test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 4;
+    }
+
+    // YUV frames have even dimensions, the image is cropped
+    int even_width = width & ~1, even_height = height & ~1;
+    rgba_t* even_img_data = (rgba_t*) malloc(even_width * even_height * sizeof(rgba_t));
+    for (int y = 0; y < even_height; y++) {
+        memcpy(&even_img_data[y * even_width], &input_img_data[y * width], even_width * sizeof(rgba_t));
+    }
+    for (GLenum format = COMPUTE_LIB_SHADERS_YUV_I420; format <= COMPUTE_LIB_SHADERS_YUV_GRAY; format++) {
+        for (GLenum standard = COMPUTE_LIB_SHADERS_YUV_BT601; standard <= COMPUTE_LIB_SHADERS_YUV_BT601_FULL; standard++) {
+            errors += test_yuv(&inst, even_img_data, even_width, even_height, format, standard);
+        }
+    }
+    if (errors != 0) {
+        fprintf(stderr, "YUV conversion test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 5;
+    }
+
+    printf("Writing output image: %s\r\n", argv[2]);
+    if (!image_save(argv[2], width, height, 4, (unsigned char*) output_img_data)) {
+        fprintf(stderr, "Failed to write image file!\r\n");
+        return 6;
+    }
+
+    compute_lib_deinit(&inst);
+    free(even_img_data);
+    free(output_img_data);
+
+    printf("Program Done.\r\n");
+}
@@ -55,7 +55,7 @@ int main(int argc, char* argv[])
         compute_lib_error_queue_flush(&inst, stderr);
         return 5;
     }
-    if (compute_lib_program_dispatch(&(conv2d->program), width, height, 1) != GL_NO_ERROR) {
+    if (compute_lib_shaders_conv2d_dispatch(conv2d) != GL_NO_ERROR) {
         compute_lib_error_queue_flush(&inst, stderr);
         return 6;
     }
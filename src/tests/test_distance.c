@@ -0,0 +1,298 @@
+/// \file test_distance.c
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Test source file for GLES3ComputeLib library implementation of the Euclidean distance transform (including benchmark of image sizes and obstacle densities).
+/// \copyright GNU Public License.
+
+#include "shaders/distance.h"
+#include "utils/image.h"
+#include "utils/timer.h"
+
+#include <math.h>
+#include <stdint.h>
+
+#define LOCAL_SIZE 64
+
+// pixels darker than the threshold are obstacles of the input image
+#define OBSTACLE_LUMA 96
+// every n-th pixel of the CPU reference is verified by brute force
+#define BRUTE_FORCE_STEP 97
+
+#define BENCHMARK_REPETITIONS 5
+
+
+static uint32_t xorshift32(uint32_t* state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+/// Computes squared distances to the nearest obstacle on CPU (separable lower envelope of parabolas), -1 if there is no obstacle.
+static void distance_reference(const rgba_t* mask, int width, int height, int64_t* distances)
+{
+    int64_t* columns = (int64_t*) malloc(width * height * sizeof(int64_t));
+    int* vertices = (int*) malloc(width * sizeof(int));
+    double* boundaries = (double*) malloc((width + 1) * sizeof(double));
+    for (int x = 0; x < width; x++) {
+        int64_t d = -1;
+        for (int y = 0; y < height; y++) {
+            d = (mask[y * width + x].r != 0) ? 0 : ((d < 0) ? d : d + 1);
+            columns[y * width + x] = d;
+        }
+        for (int y = height - 2; y >= 0; y--) {
+            d = (d < 0) ? d : d + 1;
+            if (columns[y * width + x] >= 0 && (d < 0 || columns[y * width + x] < d)) {
+                d = columns[y * width + x];
+            }
+            columns[y * width + x] = d;
+        }
+    }
+    for (int y = 0; y < height; y++) {
+        const int64_t* f = &columns[y * width];
+        int k = -1;
+        for (int q = 0; q < width; q++) {
+            if (f[q] < 0) {
+                continue;
+            }
+            double s = -INFINITY;
+            while (k >= 0) {
+                int v = vertices[k];
+                s = ((double) (f[q] * f[q] + q * q) - (double) (f[v] * f[v] + v * v)) / (2.0 * (q - v));
+                if (s > boundaries[k]) {
+                    break;
+                }
+                k--;
+            }
+            k++;
+            vertices[k] = q;
+            boundaries[k] = (k == 0) ? -INFINITY : s;
+        }
+        for (int x = 0, j = 0; x < width; x++) {
+            if (k < 0) {
+                distances[y * width + x] = -1;
+                continue;
+            }
+            while (j < k && boundaries[j + 1] < x) {
+                j++;
+            }
+            int v = vertices[j];
+            distances[y * width + x] = (int64_t) (x - v) * (x - v) + f[v] * f[v];
+        }
+    }
+    free(columns);
+    free(vertices);
+    free(boundaries);
+}
+
+/// Verifies the CPU reference by brute force on a subset of pixels.
+static int brute_force_check(const rgba_t* mask, int width, int height, const int64_t* distances)
+{
+    int errors = 0;
+    for (int i = 0; i < width * height; i += BRUTE_FORCE_STEP) {
+        int64_t best = -1;
+        for (int j = 0; j < width * height; j++) {
+            if (mask[j].r != 0) {
+                int64_t dx = i % width - j % width, dy = i / width - j / width;
+                if (best < 0 || dx * dx + dy * dy < best) {
+                    best = dx * dx + dy * dy;
+                }
+            }
+        }
+        errors += best != distances[i];
+    }
+    return errors;
+}
+
+/// Compares the GPU output with the squared distances of CPU (float within rounding of the square root, fixed point within one step).
+static int compare_output(const void* output, GLenum type, int width, int height, const int64_t* distances, float* max_error)
+{
+    int errors = 0, stride = 4 * ((width + 3) / 4);
+    *max_error = 0.0f;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int64_t d2 = distances[y * width + x];
+            if (type == GL_FLOAT) {
+                float value = ((const float*) output)[y * width + x];
+                float error = (d2 < 0) ? (isinf(value) ? 0.0f : INFINITY) : fabsf(value - (float) sqrt((double) d2));
+                *max_error = fmaxf(*max_error, error);
+                errors += error > 1e-5f * fmaxf(1.0f, value);
+            } else {
+                int value = ((const GLushort*) output)[y * stride + x];
+                int expected = (d2 < 0) ? COMPUTE_LIB_SHADERS_DISTANCE_INFINITY : (int) (sqrt((double) d2) * (1 << COMPUTE_LIB_SHADERS_DISTANCE_FRACTION_BITS) + 0.5);
+                *max_error = fmaxf(*max_error, (float) abs(value - expected));
+                errors += abs(value - expected) > 1 || (d2 < 0) != (value == COMPUTE_LIB_SHADERS_DISTANCE_INFINITY);
+            }
+        }
+    }
+    return errors;
+}
+
+/// Transforms the mask on GPU and compares the result with CPU.
+static int test_distance(compute_lib_instance_t* inst, const rgba_t* mask, int width, int height, GLenum type, const char* name, GLboolean brute_force, float* output)
+{
+    compute_lib_shaders_distance_t* distance;
+    if ((distance = compute_lib_shaders_distance_init(inst, LOCAL_SIZE, width, height, type)) == NULL) {
+        return -1;
+    }
+
+    void* result = malloc(width * height * sizeof(float) + 8 * height);
+    int64_t* expected = (int64_t*) malloc(width * height * sizeof(int64_t));
+
+    GLuint errors_cnt = compute_lib_image2d_write(&(distance->input_image2d), (void*) mask);
+    glFinish();
+    double start = time_now_ms();
+    errors_cnt += compute_lib_shaders_distance_dispatch(distance);
+    errors_cnt += compute_lib_image2d_read(&(distance->output_image2d), result);
+    double gpu_ms = time_now_ms() - start;
+
+    start = time_now_ms();
+    distance_reference(mask, width, height, expected);
+    double cpu_ms = time_now_ms() - start;
+
+    float max_error;
+    int errors = compare_output(result, type, width, height, expected, &max_error);
+    int reference_errors = brute_force ? brute_force_check(mask, width, height, expected) : 0;
+    printf("%-8s %s: max. error %g, %d errors, %d reference errors, GPU %8.3f ms, CPU %8.3f ms\r\n", name, (type == GL_FLOAT) ? "R32F     " : "16-bit FP",
+           max_error, errors, reference_errors, gpu_ms, cpu_ms);
+
+    if (output != NULL) {
+        for (int i = 0; i < width * height; i++) {
+            output[i] = (type == GL_FLOAT) ? ((float*) result)[i] : NAN;
+        }
+    }
+
+    compute_lib_shaders_distance_destroy(distance);
+    free(result);
+    free(expected);
+    return (errors_cnt != GL_NO_ERROR) ? -1 : errors + reference_errors;
+}
+
+/// Measures the transform of random obstacles with the given density (average of repeated dispatches, the result is compared with CPU).
+static int benchmark_distance(compute_lib_instance_t* inst, int size, float density, GLenum type)
+{
+    compute_lib_shaders_distance_t* distance;
+    if ((distance = compute_lib_shaders_distance_init(inst, LOCAL_SIZE, size, size, type)) == NULL) {
+        return -1;
+    }
+
+    rgba_t* mask = (rgba_t*) malloc(size * size * sizeof(rgba_t));
+    void* result = malloc(size * size * sizeof(float) + 8 * size);
+    int64_t* expected = (int64_t*) malloc(size * size * sizeof(int64_t));
+    uint32_t state = 0x12345678;
+    for (int i = 0; i < size * size; i++) {
+        unsigned char value = ((xorshift32(&state) & 0xFFFFFF) < density * 0x1000000) ? 255 : 0;
+        mask[i] = (rgba_t) { value, value, value, 255 };
+    }
+
+    GLuint errors_cnt = compute_lib_image2d_write(&(distance->input_image2d), mask);
+    errors_cnt += compute_lib_shaders_distance_dispatch(distance);
+    glFinish();
+    double start = time_now_ms();
+    for (int i = 0; i < BENCHMARK_REPETITIONS; i++) {
+        errors_cnt += compute_lib_shaders_distance_dispatch(distance);
+    }
+    glFinish();
+    double gpu_ms = (time_now_ms() - start) / BENCHMARK_REPETITIONS;
+    errors_cnt += compute_lib_image2d_read(&(distance->output_image2d), result);
+
+    start = time_now_ms();
+    distance_reference(mask, size, size, expected);
+    double cpu_ms = time_now_ms() - start;
+
+    float max_error;
+    int errors = compare_output(result, type, size, size, expected, &max_error);
+    printf("%4dx%-4d %5.1f %% obstacles, %s: GPU %8.3f ms (%7.1f Mpx/s), CPU %8.3f ms, %d errors\r\n", size, size, 100.0f * density, (type == GL_FLOAT) ? "R32F     " : "16-bit FP",
+           gpu_ms, size * size / (gpu_ms * 1e3), cpu_ms, errors);
+
+    compute_lib_shaders_distance_destroy(distance);
+    free(mask);
+    free(result);
+    free(expected);
+    return (errors_cnt != GL_NO_ERROR) ? -1 : errors;
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <path to input image> <path to output image>\r\n", argv[0]);
+        return 1;
+    }
+
+    rgba_t* input_img_data;
+    int width, height;
+    printf("Loading image: %s\r\n", argv[1]);
+    if (!image_load(argv[1], &width, &height, 4, (unsigned char**) &input_img_data)) {
+        fprintf(stderr, "Failed to load image file!\r\n");
+        return 2;
+    }
+    printf("Loaded image with size %dx%d px.\r\n", width, height);
+
+    printf("Initializing compute library instance.\r\n");
+    compute_lib_instance_t inst = COMPUTE_LIB_INSTANCE_NEW("/dev/dri/renderD128");
+    if (compute_lib_init(&inst) != GL_NO_ERROR) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 3;
+    }
+
+    // obstacles of the input image, an empty mask and a single obstacle pixel
+    rgba_t* mask = (rgba_t*) malloc(width * height * sizeof(rgba_t));
+    float* output = (float*) malloc(width * height * sizeof(float));
+    int errors = 0;
+    for (int i = 0; i < width * height; i++) {
+        unsigned char value = ((77 * input_img_data[i].r + 150 * input_img_data[i].g + 29 * input_img_data[i].b + 128) >> 8 < OBSTACLE_LUMA) ? 255 : 0;
+        mask[i] = (rgba_t) { value, value, value, 255 };
+    }
+    errors += test_distance(&inst, mask, width, height, GL_FLOAT, "image", GL_TRUE, output);
+    errors += test_distance(&inst, mask, width, height, GL_UNSIGNED_SHORT, "image", GL_FALSE, NULL);
+    memset(mask, 0, width * height * sizeof(rgba_t));
+    errors += test_distance(&inst, mask, width, height, GL_FLOAT, "empty", GL_FALSE, NULL);
+    errors += test_distance(&inst, mask, width, height, GL_UNSIGNED_SHORT, "empty", GL_FALSE, NULL);
+    mask[(height / 3) * width + width / 5].r = 255;
+    errors += test_distance(&inst, mask, width, height, GL_FLOAT, "single", GL_TRUE, NULL);
+    errors += test_distance(&inst, mask, width, height, GL_UNSIGNED_SHORT, "single", GL_FALSE, NULL);
+    if (errors != 0) {
+        fprintf(stderr, "Distance transform test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 4;
+    }
+
+    printf("Benchmarking distance transform (%d runs each):\r\n", BENCHMARK_REPETITIONS);
+    int sizes[] = { 256, 512, 1024, 2048 };
+    float densities[] = { 0.001f, 0.01f, 0.1f, 0.5f };
+    for (int i = 0; i < (int) (sizeof(sizes) / sizeof(sizes[0])); i++) {
+        for (int j = 0; j < (int) (sizeof(densities) / sizeof(densities[0])); j++) {
+            errors += benchmark_distance(&inst, sizes[i], densities[j], GL_FLOAT);
+            errors += benchmark_distance(&inst, sizes[i], densities[j], GL_UNSIGNED_SHORT);
+        }
+    }
+    if (errors != 0) {
+        fprintf(stderr, "Distance transform benchmark failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 5;
+    }
+
+    // distances of the input image obstacles scaled to the maximum
+    float max_distance = 0.0f;
+    for (int i = 0; i < width * height; i++) {
+        max_distance = (isinf(output[i])) ? max_distance : fmaxf(max_distance, output[i]);
+    }
+    for (int i = 0; i < width * height; i++) {
+        unsigned char value = (unsigned char) (255.0f * fminf(output[i] / fmaxf(max_distance, 1.0f), 1.0f));
+        input_img_data[i] = (rgba_t) { value, value, value, 255 };
+    }
+
+    printf("Writing output image: %s\r\n", argv[2]);
+    if (!image_save(argv[2], width, height, 4, (unsigned char*) input_img_data)) {
+        fprintf(stderr, "Failed to write image file!\r\n");
+        return 6;
+    }
+
+    compute_lib_deinit(&inst);
+    free(mask);
+    free(output);
+
+    printf("Program Done.\r\n");
+}
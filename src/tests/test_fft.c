@@ -0,0 +1,186 @@
+/// \file test_fft.c
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Test source file for GLES3ComputeLib library implementation of 2D FFT and FFT-based 2D convolution (including direct vs. FFT break-even benchmark).
+/// \copyright GNU Public License.
+
+#include "shaders/conv2d.h"
+#include "utils/image.h"
+#include "utils/timer.h"
+
+#include <math.h>
+
+#define LOCAL_SIZE_X 16
+#define LOCAL_SIZE_Y 16
+
+#define DFT_WIDTH 64
+#define DFT_HEIGHT 32
+
+#define BENCHMARK_REPETITIONS 10
+#define BENCHMARK_MAX_KERNEL_SIZE 31
+// both methods truncate the result after the same offset, results of the test kernel are multiples of 1/8 far from the truncation points, so they match exactly
+#define MAX_DIFFERENCE 0
+
+
+/// Compares GPU forward 2D FFT of random data with naive CPU DFT and checks the inverse round trip.
+static int test_fft_accuracy(compute_lib_instance_t* inst)
+{
+    compute_lib_shaders_fft_t* fft;
+    if ((fft = compute_lib_shaders_fft_init(inst, 64, DFT_WIDTH, DFT_HEIGHT)) == NULL) {
+        return 1;
+    }
+
+    int n = DFT_WIDTH * DFT_HEIGHT;
+    float* data = (float*) malloc(2 * n * sizeof(float));
+    float* result = (float*) malloc(2 * n * sizeof(float));
+    for (int i = 0; i < 2 * n; i++) {
+        data[i] = (float) rand() / RAND_MAX - 0.5f;
+    }
+
+    compute_lib_ssbo_write(&(fft->data_ssbo), data, 2 * n);
+    compute_lib_shaders_fft_transform(fft, GL_FALSE);
+    compute_lib_ssbo_read(&(fft->data_ssbo), result, 2 * n);
+
+    double max_error = 0.0;
+    for (int v = 0; v < DFT_HEIGHT; v++) {
+        for (int u = 0; u < DFT_WIDTH; u++) {
+            double re = 0.0, im = 0.0;
+            for (int y = 0; y < DFT_HEIGHT; y++) {
+                for (int x = 0; x < DFT_WIDTH; x++) {
+                    double a = -2.0 * M_PI * ((double) u * x / DFT_WIDTH + (double) v * y / DFT_HEIGHT);
+                    re += data[2 * (y * DFT_WIDTH + x)] * cos(a) - data[2 * (y * DFT_WIDTH + x) + 1] * sin(a);
+                    im += data[2 * (y * DFT_WIDTH + x)] * sin(a) + data[2 * (y * DFT_WIDTH + x) + 1] * cos(a);
+                }
+            }
+            max_error = fmax(max_error, fabs(re - result[2 * (v * DFT_WIDTH + u)]));
+            max_error = fmax(max_error, fabs(im - result[2 * (v * DFT_WIDTH + u) + 1]));
+        }
+    }
+    printf("FFT %dx%d: maximum absolute error against CPU DFT: %g\r\n", DFT_WIDTH, DFT_HEIGHT, max_error);
+
+    compute_lib_shaders_fft_transform(fft, GL_TRUE);
+    compute_lib_ssbo_read(&(fft->data_ssbo), result, 2 * n);
+    double max_roundtrip_error = 0.0;
+    for (int i = 0; i < 2 * n; i++) {
+        max_roundtrip_error = fmax(max_roundtrip_error, fabs(result[i] / n - data[i]));
+    }
+    printf("FFT %dx%d: maximum absolute round trip error: %g\r\n", DFT_WIDTH, DFT_HEIGHT, max_roundtrip_error);
+
+    free(data);
+    free(result);
+    compute_lib_shaders_fft_destroy(fft);
+    return (max_error > 1e-2 || max_roundtrip_error > 1e-4) ? 2 : 0;
+}
+
+/// Runs the convolution repeatedly and returns the average time of a single run in milliseconds.
+static double benchmark_conv2d(compute_lib_shaders_conv2d_t* conv2d)
+{
+    compute_lib_shaders_conv2d_dispatch(conv2d);
+    glFinish();
+    double start = time_now_ms();
+    for (int i = 0; i < BENCHMARK_REPETITIONS; i++) {
+        compute_lib_shaders_conv2d_dispatch(conv2d);
+    }
+    glFinish();
+    return (time_now_ms() - start) / BENCHMARK_REPETITIONS;
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <path to input image> <path to output image>\r\n", argv[0]);
+        return 1;
+    }
+
+    rgba_t* input_img_data;
+    int width, height;
+    printf("Loading image: %s\r\n", argv[1]);
+    if (!image_load(argv[1], &width, &height, 4, (unsigned char**) &input_img_data)) {
+        fprintf(stderr, "Failed to load image file!\r\n");
+        return 2;
+    }
+    printf("Loaded image with size %dx%d px.\r\n", width, height);
+
+    printf("Initializing compute library instance.\r\n");
+    compute_lib_instance_t inst = COMPUTE_LIB_INSTANCE_NEW("/dev/dri/renderD128");
+    if (compute_lib_init(&inst) != GL_NO_ERROR) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 3;
+    }
+
+    if (test_fft_accuracy(&inst) != 0) {
+        fprintf(stderr, "FFT accuracy test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 4;
+    }
+
+    float even_kernel[16] = { 0.0f };
+    if (compute_lib_shaders_conv2d_init_ex(&inst, LOCAL_SIZE_X, LOCAL_SIZE_Y, width, height, even_kernel, 16, GL_TRUE) != NULL ||
+            compute_lib_shaders_conv2d_init_ex(&inst, LOCAL_SIZE_X, LOCAL_SIZE_Y, width, height, even_kernel, 10, GL_TRUE) != NULL) {
+        fprintf(stderr, "Kernel which is not an odd square was accepted!\r\n");
+        return 8;
+    }
+
+    rgba_t* direct_img_data = (rgba_t*) calloc(width * height, sizeof(rgba_t));
+    rgba_t* fft_img_data = (rgba_t*) calloc(width * height, sizeof(rgba_t));
+    int break_even = 0;
+
+    printf("Benchmarking direct vs. FFT convolution (%d runs each):\r\n", BENCHMARK_REPETITIONS);
+    for (int kernel_size = 3; kernel_size <= BENCHMARK_MAX_KERNEL_SIZE; kernel_size += 4) {
+        int kernel_length = kernel_size * kernel_size;
+        // asymmetric kernel (checks the orientation of the FFT path), run time does not depend on the values
+        float* kernel = (float*) calloc(kernel_length, sizeof(float));
+        kernel[kernel_length / 2] = 0.5f;
+        kernel[0] = 0.25f;
+        kernel[kernel_size - 1] = 0.125f;
+        kernel[kernel_length - kernel_size + 1] = 0.125f;
+
+        compute_lib_shaders_conv2d_t* direct = compute_lib_shaders_conv2d_init_ex(&inst, LOCAL_SIZE_X, LOCAL_SIZE_Y, width, height, kernel, kernel_length, GL_FALSE);
+        compute_lib_shaders_conv2d_t* fft = compute_lib_shaders_conv2d_init_ex(&inst, LOCAL_SIZE_X, LOCAL_SIZE_Y, width, height, kernel, kernel_length, GL_TRUE);
+        free(kernel);
+        if (direct == NULL || fft == NULL) {
+            compute_lib_error_queue_flush(&inst, stderr);
+            return 5;
+        }
+
+        compute_lib_image2d_write(&(direct->input_image2d), input_img_data);
+        compute_lib_image2d_write(&(fft->input_image2d), input_img_data);
+        double direct_ms = benchmark_conv2d(direct);
+        double fft_ms = benchmark_conv2d(fft);
+
+        compute_lib_image2d_read(&(direct->output_image2d), direct_img_data);
+        compute_lib_image2d_read(&(fft->output_image2d), fft_img_data);
+        int max_diff = 0;
+        for (int i = 0; i < width * height; i++) {
+            int diff = abs((int) direct_img_data[i].r - (int) fft_img_data[i].r);
+            if (diff > max_diff) max_diff = diff;
+        }
+        printf("Kernel %2dx%-2d (area %4d): direct %8.3f ms, FFT %8.3f ms, max difference %d\r\n", kernel_size, kernel_size, kernel_length, direct_ms, fft_ms, max_diff);
+        if (max_diff > MAX_DIFFERENCE) {
+            fprintf(stderr, "Direct and FFT convolution results differ!\r\n");
+            return 7;
+        }
+        if (break_even == 0 && fft_ms < direct_ms) {
+            break_even = kernel_length;
+        }
+
+        if (kernel_size == BENCHMARK_MAX_KERNEL_SIZE) {
+            printf("Writing output image: %s\r\n", argv[2]);
+            if (!image_save(argv[2], width, height, 4, (unsigned char*) fft_img_data)) {
+                fprintf(stderr, "Failed to write image file!\r\n");
+                return 6;
+            }
+        }
+
+        compute_lib_shaders_conv2d_destroy(direct);
+        compute_lib_shaders_conv2d_destroy(fft);
+    }
+    printf("Measured break-even kernel area: %d (COMPUTE_LIB_SHADERS_CONV2D_FFT_MIN_KERNEL_AREA = %d)\r\n", break_even, COMPUTE_LIB_SHADERS_CONV2D_FFT_MIN_KERNEL_AREA);
+
+    compute_lib_deinit(&inst);
+    free(direct_img_data);
+    free(fft_img_data);
+
+    printf("Program Done.\r\n");
+}
@@ -0,0 +1,145 @@
+/// \file test_filterbank.c
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Test source file for GLES3ComputeLib library implementation of filter-bank 2D convolution.
+/// \copyright GNU Public License.
+
+#include "shaders/filterbank.h"
+#include "utils/image.h"
+
+#include <float.h>
+#include <math.h>
+
+#define LOCAL_SIZE_X 16
+#define LOCAL_SIZE_Y 16
+
+#define KERNEL_SIZE 9
+#define NUM_KERNELS 8
+
+// error of a response against CPU (summation order differs) relative to the round-off bound of float summation of KERNEL_SIZE^2 terms
+// (KERNEL_SIZE^2 * FLT_EPSILON * L1 norm of the kernel * 255), both GPU and CPU sums are within the bound
+#define MAX_RELATIVE_ERROR 2.0f
+
+
+/// Fills a bank of zero-mean Gabor kernels with equally spaced orientations.
+static void gabor_bank(float* kernels, int kernel_size, int num_kernels)
+{
+    int span = (kernel_size - 1) / 2;
+    float sigma = span / 2.0f, lambda = span, mean;
+    for (int k = 0; k < num_kernels; k++) {
+        float theta = (float) M_PI * k / num_kernels;
+        float* kernel = kernels + k * kernel_size * kernel_size;
+        mean = 0.0f;
+        for (int y = -span; y <= span; y++) {
+            for (int x = -span; x <= span; x++) {
+                float xr = x * cosf(theta) + y * sinf(theta);
+                float yr = -x * sinf(theta) + y * cosf(theta);
+                kernel[(y + span) * kernel_size + (x + span)] = expf(-(xr*xr + yr*yr) / (2.0f * sigma * sigma)) * cosf(2.0f * (float) M_PI * xr / lambda);
+                mean += kernel[(y + span) * kernel_size + (x + span)];
+            }
+        }
+        mean /= kernel_size * kernel_size;
+        for (int i = 0; i < kernel_size * kernel_size; i++) {
+            kernel[i] -= mean;
+        }
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <path to input image> <path to output image>\r\n", argv[0]);
+        return 1;
+    }
+
+    float* kernels = (float*) malloc(NUM_KERNELS * KERNEL_SIZE * KERNEL_SIZE * sizeof(float));
+    gabor_bank(kernels, KERNEL_SIZE, NUM_KERNELS);
+    printf("Using filter bank of %d Gabor kernels with %dx%d elements.\r\n", NUM_KERNELS, KERNEL_SIZE, KERNEL_SIZE);
+
+    rgba_t* input_img_data;
+    int width, height;
+    printf("Loading image: %s\r\n", argv[1]);
+    if (!image_load(argv[1], &width, &height, 4, (unsigned char**) &input_img_data)) {
+        fprintf(stderr, "Failed to load image file!\r\n");
+        return 2;
+    }
+    printf("Loaded image with size %dx%d px.\r\n", width, height);
+
+    printf("Initializing compute library instance.\r\n");
+    compute_lib_instance_t inst = COMPUTE_LIB_INSTANCE_NEW("/dev/dri/renderD128");
+    if (compute_lib_init(&inst) != GL_NO_ERROR) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 3;
+    }
+
+    printf("Initializing filterbank instance.\r\n");
+    compute_lib_shaders_filterbank_t* filterbank;
+    if ((filterbank = compute_lib_shaders_filterbank_init(&inst, LOCAL_SIZE_X, LOCAL_SIZE_Y, width, height, kernels, KERNEL_SIZE, NUM_KERNELS)) == NULL) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 4;
+    }
+
+    printf("Running filterbank program.\r\n");
+    if (compute_lib_image2d_write(&(filterbank->input_image2d), input_img_data) != GL_NO_ERROR) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 5;
+    }
+    if (compute_lib_program_dispatch(&(filterbank->program), width, height, 1) != GL_NO_ERROR) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 6;
+    }
+
+    vec4_t* output_data = (vec4_t*) calloc(width * height * filterbank->num_layers, sizeof(vec4_t));
+    if (compute_lib_image2d_read(&(filterbank->output_image2d), output_data) != GL_NO_ERROR) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 7;
+    }
+
+    // compare with CPU reference (edge-clamped convolution of the red channel) and store absolute responses
+    unsigned char* output_img_data = (unsigned char*) calloc(width * height * NUM_KERNELS, sizeof(unsigned char));
+    int span = (KERNEL_SIZE - 1) / 2;
+    float max_error = 0.0f, max_relative_error = 0.0f;
+    for (int k = 0; k < NUM_KERNELS; k++) {
+        float l1_norm = 0.0f;
+        for (int i = 0; i < KERNEL_SIZE * KERNEL_SIZE; i++) {
+            l1_norm += fabsf(kernels[k * KERNEL_SIZE * KERNEL_SIZE + i]);
+        }
+        float summation_bound = KERNEL_SIZE * KERNEL_SIZE * FLT_EPSILON * l1_norm * 255.0f;
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                float ref = 0.0f;
+                for (int ky = -span; ky <= span; ky++) {
+                    for (int kx = -span; kx <= span; kx++) {
+                        int sx = x + kx < 0 ? 0 : (x + kx >= width ? width - 1 : x + kx);
+                        int sy = y + ky < 0 ? 0 : (y + ky >= height ? height - 1 : y + ky);
+                        ref += input_img_data[sy * width + sx].r * kernels[(k * KERNEL_SIZE + ky + span) * KERNEL_SIZE + kx + span];
+                    }
+                }
+                float res = ((GLfloat*) &(output_data[((k / 4) * height + y) * width + x]))[k % 4];
+                if (fabsf(res - ref) > max_error) max_error = fabsf(res - ref);
+                if (fabsf(res - ref) / summation_bound > max_relative_error) max_relative_error = fabsf(res - ref) / summation_bound;
+                output_img_data[(k * height + y) * width + x] = fabsf(res) > 255.0f ? 255 : (unsigned char) fabsf(res);
+            }
+        }
+    }
+    printf("Maximum absolute error against CPU reference: %f (%f of the float summation bound)\r\n", max_error, max_relative_error);
+    if (max_relative_error > MAX_RELATIVE_ERROR) {
+        fprintf(stderr, "Filterbank test failed!\r\n");
+        return 8;
+    }
+
+    printf("Writing output image: %s\r\n", argv[2]);
+    if (!image_save(argv[2], width, height * NUM_KERNELS, 1, output_img_data)) {
+        fprintf(stderr, "Failed to write image file!\r\n");
+        return 9;
+    }
+
+    compute_lib_shaders_filterbank_destroy(filterbank);
+    compute_lib_deinit(&inst);
+    free(output_img_data);
+    free(output_data);
+    free(kernels);
+
+    printf("Program Done.\r\n");
+}
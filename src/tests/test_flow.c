@@ -0,0 +1,364 @@
+/// \file test_flow.c
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Test source file for GLES3ComputeLib library implementation of pyramidal Lucas-Kanade optical flow (output image is the dense flow of a synthetically translated frame).
+/// \copyright GNU Public License.
+
+#include "shaders/flow.h"
+#include "utils/image.h"
+#include "utils/timer.h"
+
+#include <math.h>
+#include <stdint.h>
+
+#define LOCAL_SIZE_X 16
+#define LOCAL_SIZE_Y 8
+// sparse work group of a non-power-of-two size (reduction of partial sums)
+#define ODD_LOCAL_SIZE_X 12
+#define ODD_LOCAL_SIZE_Y 5
+
+#define NUM_LEVELS 4
+// translation of each frame relative to the previous one
+#define SHIFT_X 5.3f
+#define SHIFT_Y -3.6f
+// spacing of the tracked points and margin of the evaluated area
+#define POINTS_STEP 12
+#define MARGIN 24
+
+// constants of the shader
+#define EPSILON 0.01f
+#define MIN_EIGENVALUE 0.01f
+
+
+static int clampi(int value, int low, int high)
+{
+    return (value < low) ? low : ((value > high) ? high : value);
+}
+
+/// Renders the frame translated by the given shift (bilinear interpolation, edges clamped).
+static void render_frame(const rgba_t* img_data, int width, int height, float shift_x, float shift_y, rgba_t* frame_data)
+{
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            float sx = x - shift_x, sy = y - shift_y;
+            int x0 = (int) floorf(sx), y0 = (int) floorf(sy);
+            float fx = sx - x0, fy = sy - y0;
+            const unsigned char* p00 = (const unsigned char*) &img_data[clampi(y0, 0, height - 1) * width + clampi(x0, 0, width - 1)];
+            const unsigned char* p01 = (const unsigned char*) &img_data[clampi(y0, 0, height - 1) * width + clampi(x0 + 1, 0, width - 1)];
+            const unsigned char* p10 = (const unsigned char*) &img_data[clampi(y0 + 1, 0, height - 1) * width + clampi(x0, 0, width - 1)];
+            const unsigned char* p11 = (const unsigned char*) &img_data[clampi(y0 + 1, 0, height - 1) * width + clampi(x0 + 1, 0, width - 1)];
+            unsigned char* out = (unsigned char*) &frame_data[y * width + x];
+            for (int c = 0; c < 4; c++) {
+                float top = p00[c] + fx * (p01[c] - p00[c]), bottom = p10[c] + fx * (p11[c] - p10[c]);
+                out[c] = (unsigned char) (top + fy * (bottom - top) + 0.5f);
+            }
+        }
+    }
+}
+
+/// Reads all levels of the pyramid as luma.
+static GLuint read_levels(compute_lib_shaders_pyramid_t* pyramid, float** levels, rgba_t* level_data)
+{
+    GLuint errors_cnt = 0;
+    for (int level = 0; level < NUM_LEVELS; level++) {
+        GLsizei width, height;
+        compute_lib_image2d_level_size(&(pyramid->image2d), level, &width, &height);
+        errors_cnt += compute_lib_image2d_read_level(&(pyramid->image2d), level, level_data);
+        for (int i = 0; i < width * height; i++) {
+            levels[level][i] = 0.299f * level_data[i].r + 0.587f * level_data[i].g + 0.114f * level_data[i].b;
+        }
+    }
+    return errors_cnt;
+}
+
+static float sample(const float* img, int width, int height, float x, float y)
+{
+    float x_floor = floorf(x), y_floor = floorf(y), fx = x - x_floor, fy = y - y_floor;
+    int x0 = clampi((int) x_floor, 0, width - 1), x1 = clampi((int) x_floor + 1, 0, width - 1);
+    int y0 = clampi((int) y_floor, 0, height - 1), y1 = clampi((int) y_floor + 1, 0, height - 1);
+    float top = img[y0 * width + x0] + fx * (img[y0 * width + x1] - img[y0 * width + x0]);
+    float bottom = img[y1 * width + x0] + fx * (img[y1 * width + x1] - img[y1 * width + x0]);
+    return top + fy * (bottom - top);
+}
+
+/// Solves the Lucas-Kanade window centered at the given position of one level on CPU, returns 0 if the window has no texture.
+static int solve_reference(const float* previous, const float* next, int width, int height, float cx, float cy, float guess_x, float guess_y, int radius,
+                           int max_iterations, float* flow_x, float* flow_y, float* error, float* patch, float* gradients)
+{
+    int size = 2 * radius + 1, patch_size = size + 2;
+    for (int i = 0; i < patch_size * patch_size; i++) {
+        patch[i] = sample(previous, width, height, cx + i % patch_size - radius - 1, cy + i / patch_size - radius - 1);
+    }
+    float gxx = 0.0f, gxy = 0.0f, gyy = 0.0f;
+    for (int i = 0; i < size * size; i++) {
+        int p = (i / size + 1) * patch_size + i % size + 1;
+        float ix = 0.5f * (patch[p + 1] - patch[p - 1]), iy = 0.5f * (patch[p + patch_size] - patch[p - patch_size]);
+        gradients[2 * i] = ix;
+        gradients[2 * i + 1] = iy;
+        gxx += ix * ix;
+        gxy += ix * iy;
+        gyy += iy * iy;
+    }
+    *flow_x = 0.0f;
+    *flow_y = 0.0f;
+    *error = 0.0f;
+    if ((gxx + gyy - sqrtf((gxx - gyy) * (gxx - gyy) + 4.0f * gxy * gxy)) / (2.0f * size * size) < MIN_EIGENVALUE) {
+        return 0;
+    }
+    float det = gxx * gyy - gxy * gxy;
+    for (int k = 0; k < max_iterations; k++) {
+        float bx = 0.0f, by = 0.0f, sum = 0.0f;
+        for (int i = 0; i < size * size; i++) {
+            float diff = patch[(i / size + 1) * patch_size + i % size + 1] -
+                         sample(next, width, height, cx + guess_x + *flow_x + i % size - radius, cy + guess_y + *flow_y + i / size - radius);
+            bx += diff * gradients[2 * i];
+            by += diff * gradients[2 * i + 1];
+            sum += fabsf(diff);
+        }
+        float dx = (gyy * bx - gxy * by) / det, dy = (gxx * by - gxy * bx) / det;
+        *flow_x += dx;
+        *flow_y += dy;
+        *error = sum / (size * size);
+        if (dx * dx + dy * dy < EPSILON * EPSILON) {
+            break;
+        }
+    }
+    return 1;
+}
+
+/// Tracks the points from the coarsest level on CPU (tracks hold position x, y, status and error).
+static void sparse_reference(float** previous, float** next, int width, int height, const float* points, int num_points, int radius, int max_iterations, float* tracks)
+{
+    float* patch = (float*) malloc((2 * radius + 3) * (2 * radius + 3) * sizeof(float));
+    float* gradients = (float*) malloc(2 * (2 * radius + 1) * (2 * radius + 1) * sizeof(float));
+    for (int p = 0; p < num_points; p++) {
+        float guess_x = 0.0f, guess_y = 0.0f, flow_x = 0.0f, flow_y = 0.0f, error = 0.0f;
+        int tracked = 1;
+        for (int level = NUM_LEVELS - 1; level >= 0; level--) {
+            int level_width = width, level_height = height;
+            for (int i = 0; i < level; i++) {
+                level_width = (level_width / 2 > 1) ? level_width / 2 : 1;
+                level_height = (level_height / 2 > 1) ? level_height / 2 : 1;
+            }
+            float scale = 1.0f / (1 << level);
+            flow_x = flow_y = error = 0.0f;
+            if (tracked) {
+                tracked = solve_reference(previous[level], next[level], level_width, level_height, points[2 * p] * scale, points[2 * p + 1] * scale, guess_x, guess_y,
+                                          radius, max_iterations, &flow_x, &flow_y, &error, patch, gradients);
+            }
+            if (level > 0) {
+                guess_x = 2.0f * (guess_x + flow_x);
+                guess_y = 2.0f * (guess_y + flow_y);
+            }
+        }
+        float x = points[2 * p] + guess_x + flow_x, y = points[2 * p + 1] + guess_y + flow_y;
+        tracks[4 * p] = x;
+        tracks[4 * p + 1] = y;
+        tracks[4 * p + 2] = (tracked && x >= 0.0f && y >= 0.0f && x <= width - 1 && y <= height - 1) ? 1.0f : 0.0f;
+        tracks[4 * p + 3] = error;
+    }
+    free(patch);
+    free(gradients);
+}
+
+/// Computes the dense flow of every level from the coarsest one on CPU (flow holds x, y, status and error).
+static void dense_reference(float** previous, float** next, int width, int height, int radius, int max_iterations, float* flow)
+{
+    float* patch = (float*) malloc((2 * radius + 3) * (2 * radius + 3) * sizeof(float));
+    float* gradients = (float*) malloc(2 * (2 * radius + 1) * (2 * radius + 1) * sizeof(float));
+    float* coarse = (float*) malloc(2 * width * height * sizeof(float));
+    float* fine = (float*) malloc(2 * width * height * sizeof(float));
+    int coarse_width = 0, coarse_height = 0;
+    for (int level = NUM_LEVELS - 1; level >= 0; level--) {
+        int level_width = width, level_height = height;
+        for (int i = 0; i < level; i++) {
+            level_width = (level_width / 2 > 1) ? level_width / 2 : 1;
+            level_height = (level_height / 2 > 1) ? level_height / 2 : 1;
+        }
+        for (int y = 0; y < level_height; y++) {
+            for (int x = 0; x < level_width; x++) {
+                float guess_x = 0.0f, guess_y = 0.0f, flow_x, flow_y, error;
+                if (level < NUM_LEVELS - 1) {
+                    guess_x = 2.0f * sample(coarse, coarse_width, coarse_height, 0.5f * x, 0.5f * y);
+                    guess_y = 2.0f * sample(coarse + coarse_width * coarse_height, coarse_width, coarse_height, 0.5f * x, 0.5f * y);
+                }
+                int tracked = solve_reference(previous[level], next[level], level_width, level_height, x, y, guess_x, guess_y, radius, max_iterations,
+                                              &flow_x, &flow_y, &error, patch, gradients);
+                fine[y * level_width + x] = guess_x + flow_x;
+                fine[level_width * level_height + y * level_width + x] = guess_y + flow_y;
+                if (level == 0) {
+                    float* out = &flow[4 * (y * width + x)];
+                    out[0] = guess_x + flow_x;
+                    out[1] = guess_y + flow_y;
+                    out[2] = tracked ? 1.0f : 0.0f;
+                    out[3] = error;
+                }
+            }
+        }
+        float* tmp = coarse;
+        coarse = fine;
+        fine = tmp;
+        coarse_width = level_width;
+        coarse_height = level_height;
+    }
+    free(patch);
+    free(gradients);
+    free(coarse);
+    free(fine);
+}
+
+/// Tracks three frames (each translated by the shift), so the second dispatch reuses the pyramid of the middle frame as the reference.
+/// Results are compared with CPU (on the same pyramid levels) and evaluated against the translation.
+static int test_flow(compute_lib_instance_t* inst, rgba_t* img_data, int width, int height, int local_size_x, int local_size_y, GLenum mode, int radius, int max_iterations,
+        rgba_t* output_img_data)
+{
+    int num_points = ((width - 2 * MARGIN) / POINTS_STEP + 1) * ((height - 2 * MARGIN) / POINTS_STEP + 1);
+    compute_lib_shaders_flow_t* flow;
+    if ((flow = compute_lib_shaders_flow_init(inst, local_size_x, local_size_y, width, height, mode, NUM_LEVELS, radius, max_iterations, num_points)) == NULL) {
+        return -1;
+    }
+
+    rgba_t* frame_data = (rgba_t*) malloc(width * height * sizeof(rgba_t));
+    rgba_t* level_data = (rgba_t*) malloc(width * height * sizeof(rgba_t));
+    float* result = (float*) malloc(4 * width * height * sizeof(float));
+    float* expected = (float*) malloc(4 * width * height * sizeof(float));
+    float* points = (float*) malloc(2 * num_points * sizeof(float));
+    float* previous_levels[NUM_LEVELS];
+    float* next_levels[NUM_LEVELS];
+    for (int level = 0; level < NUM_LEVELS; level++) {
+        previous_levels[level] = (float*) malloc(width * height * sizeof(float));
+        next_levels[level] = (float*) malloc(width * height * sizeof(float));
+    }
+
+    GLuint errors_cnt = compute_lib_shaders_flow_frame(flow, img_data);
+    int errors = 0;
+    for (int frame = 1; frame <= 2; frame++) {
+        // points of the sparse mode start at a grid of the previous frame
+        int p = 0;
+        for (int y = MARGIN; y <= height - MARGIN; y += POINTS_STEP) {
+            for (int x = MARGIN; x <= width - MARGIN; x += POINTS_STEP) {
+                points[2 * p] = x + (frame - 1) * SHIFT_X + 0.25f;
+                points[2 * p + 1] = y + (frame - 1) * SHIFT_Y + 0.75f;
+                p++;
+            }
+        }
+        if (mode == COMPUTE_LIB_SHADERS_FLOW_SPARSE) {
+            errors_cnt += compute_lib_shaders_flow_write_points(flow, points, num_points);
+        }
+        render_frame(img_data, width, height, frame * SHIFT_X, frame * SHIFT_Y, frame_data);
+
+        glFinish();
+        double start = time_now_ms();
+        errors_cnt += compute_lib_shaders_flow_frame(flow, frame_data);
+        errors_cnt += compute_lib_shaders_flow_dispatch(flow);
+        if (mode == COMPUTE_LIB_SHADERS_FLOW_SPARSE) {
+            errors_cnt += compute_lib_shaders_flow_read_tracks(flow, result);
+        } else {
+            errors_cnt += compute_lib_image2d_read(&(flow->flow_image2d), result);
+        }
+        double gpu_ms = time_now_ms() - start;
+
+        errors_cnt += read_levels(flow->pyramids[1 - flow->current], previous_levels, level_data);
+        errors_cnt += read_levels(flow->pyramids[flow->current], next_levels, level_data);
+        start = time_now_ms();
+        if (mode == COMPUTE_LIB_SHADERS_FLOW_SPARSE) {
+            sparse_reference(previous_levels, next_levels, width, height, points, num_points, radius, max_iterations, expected);
+        } else {
+            dense_reference(previous_levels, next_levels, width, height, radius, max_iterations, expected);
+        }
+        double cpu_ms = time_now_ms() - start;
+
+        // matching statuses and flows with CPU (iterations may stop one step apart), tracked points within 0.25 px of the translation
+        int num_results = (mode == COMPUTE_LIB_SHADERS_FLOW_SPARSE) ? num_points : width * height;
+        int mismatches = 0, evaluated = 0, tracked = 0, accurate = 0;
+        for (int i = 0; i < num_results; i++) {
+            float* res = &result[4 * i];
+            float* exp = &expected[4 * i];
+            float dx = res[0] - exp[0], dy = res[1] - exp[1];
+            mismatches += res[2] != exp[2] || dx * dx + dy * dy > 0.02f * 0.02f;
+            float flow_x = res[0], flow_y = res[1];
+            if (mode == COMPUTE_LIB_SHADERS_FLOW_SPARSE) {
+                flow_x -= points[2 * i];
+                flow_y -= points[2 * i + 1];
+            } else if (i % width < MARGIN || i % width >= width - MARGIN || i / width < MARGIN || i / width >= height - MARGIN) {
+                continue;
+            }
+            evaluated++;
+            if (res[2] > 0.0f) {
+                tracked++;
+                accurate += (flow_x - SHIFT_X) * (flow_x - SHIFT_X) + (flow_y - SHIFT_Y) * (flow_y - SHIFT_Y) < 0.25f * 0.25f;
+            }
+        }
+        errors += mismatches > num_results / 100 || tracked < 0.9 * evaluated || accurate < 0.9 * tracked;
+        printf("%-6s flow, frame %d, %3d invocations, %2dx%-2d window, %d levels, %2d iterations: %5.1f %% tracked, %5.1f %% accurate, %d mismatches, GPU %8.3f ms, CPU %9.3f ms\r\n",
+               (mode == COMPUTE_LIB_SHADERS_FLOW_SPARSE) ? "sparse" : "dense", frame, local_size_x * local_size_y, 2 * radius + 1, 2 * radius + 1, NUM_LEVELS, max_iterations,
+               100.0 * tracked / evaluated, 100.0 * accurate / tracked, mismatches, gpu_ms, cpu_ms);
+    }
+
+    if (output_img_data != NULL) {
+        for (int i = 0; i < width * height; i++) {
+            float* res = &result[4 * i];
+            output_img_data[i] = (res[2] > 0.0f) ? (rgba_t) { (unsigned char) clampi(128 + (int) (16.0f * res[0]), 0, 255), (unsigned char) clampi(128 + (int) (16.0f * res[1]), 0, 255), 128, 255 } :
+                                 (rgba_t) { 0, 0, 0, 255 };
+        }
+    }
+
+    compute_lib_shaders_flow_destroy(flow);
+    free(frame_data);
+    free(level_data);
+    free(result);
+    free(expected);
+    free(points);
+    for (int level = 0; level < NUM_LEVELS; level++) {
+        free(previous_levels[level]);
+        free(next_levels[level]);
+    }
+    return (errors_cnt != GL_NO_ERROR) ? -1 : errors;
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <path to input image> <path to output image>\r\n", argv[0]);
+        return 1;
+    }
+
+    rgba_t* input_img_data;
+    int width, height;
+    printf("Loading image: %s\r\n", argv[1]);
+    if (!image_load(argv[1], &width, &height, 4, (unsigned char**) &input_img_data)) {
+        fprintf(stderr, "Failed to load image file!\r\n");
+        return 2;
+    }
+    printf("Loaded image with size %dx%d px.\r\n", width, height);
+
+    printf("Initializing compute library instance.\r\n");
+    compute_lib_instance_t inst = COMPUTE_LIB_INSTANCE_NEW("/dev/dri/renderD128");
+    if (compute_lib_init(&inst) != GL_NO_ERROR) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 3;
+    }
+
+    rgba_t* output_img_data = (rgba_t*) malloc(width * height * sizeof(rgba_t));
+    int errors = 0;
+    errors += test_flow(&inst, input_img_data, width, height, LOCAL_SIZE_X, LOCAL_SIZE_Y, COMPUTE_LIB_SHADERS_FLOW_SPARSE, 7, 20, NULL);
+    errors += test_flow(&inst, input_img_data, width, height, ODD_LOCAL_SIZE_X, ODD_LOCAL_SIZE_Y, COMPUTE_LIB_SHADERS_FLOW_SPARSE, 7, 20, NULL);
+    errors += test_flow(&inst, input_img_data, width, height, LOCAL_SIZE_X, LOCAL_SIZE_Y, COMPUTE_LIB_SHADERS_FLOW_DENSE, 4, 8, output_img_data);
+    if (errors != 0) {
+        fprintf(stderr, "Optical flow test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 4;
+    }
+
+    printf("Writing output image: %s\r\n", argv[2]);
+    if (!image_save(argv[2], width, height, 4, (unsigned char*) output_img_data)) {
+        fprintf(stderr, "Failed to write image file!\r\n");
+        return 5;
+    }
+
+    compute_lib_deinit(&inst);
+    free(output_img_data);
+
+    printf("Program Done.\r\n");
+}
@@ -0,0 +1,260 @@
+/// \file test_gemm.c
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Test source file for GLES3ComputeLib library implementation of tiled matrix multiplication and matrix-vector product (including GFLOP/s benchmark of tile configurations).
+/// \copyright GNU Public License.
+
+#include "shaders/gemm.h"
+#include "utils/image.h"
+#include "utils/timer.h"
+
+#include <math.h>
+
+#define TEST_M 130
+#define TEST_N 75
+#define TEST_K 67
+#define TEST_ALPHA 0.5f
+#define TEST_BETA -2.0f
+
+#define BATCH_SIZE 3
+#define BATCH_COUNT 10000
+
+#define BENCHMARK_SIZE 512
+#define BENCHMARK_REPETITIONS 5
+
+
+static float* random_matrix(int length)
+{
+    float* data = (float*) malloc(length * sizeof(float));
+    for (int i = 0; i < length; i++) {
+        data[i] = (float) rand() / RAND_MAX - 0.5f;
+    }
+    return data;
+}
+
+/// CPU reference of C = alpha * op(A) * op(B) + beta * C.
+static void cpu_gemm(const float* a, const float* b, float* c, int m, int n, int k, int transpose_a, int transpose_b, float alpha, float beta)
+{
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j < n; j++) {
+            double sum = 0.0;
+            for (int l = 0; l < k; l++) {
+                sum += (double) (transpose_a ? a[l * m + i] : a[i * k + l]) * (transpose_b ? b[j * k + l] : b[l * n + j]);
+            }
+            c[i * n + j] = alpha * sum + beta * c[i * n + j];
+        }
+    }
+}
+
+static float max_abs_difference(const float* a, const float* b, int length)
+{
+    float max_diff = 0.0f;
+    for (int i = 0; i < length; i++) {
+        max_diff = fmaxf(max_diff, fabsf(a[i] - b[i]));
+    }
+    return max_diff;
+}
+
+/// Checks all transpositions with alpha/beta, batched multiplication and both matrix-vector products against CPU, returns -1 on GL errors.
+static int test_gemm_accuracy(compute_lib_shaders_gemm_t* gemm)
+{
+    int failures = 0;
+    float* a = random_matrix(TEST_M * TEST_K);
+    float* b = random_matrix(TEST_K * TEST_N);
+    float* c = random_matrix(TEST_M * TEST_N);
+    float* ref = (float*) malloc(TEST_M * TEST_N * sizeof(float));
+    float* result = (float*) malloc(TEST_M * TEST_N * sizeof(float));
+
+    compute_lib_ssbo_t a_ssbo = COMPUTE_LIB_SSBO_NEW("a_ssbo", GL_FLOAT, GL_STATIC_DRAW);
+    compute_lib_ssbo_t b_ssbo = COMPUTE_LIB_SSBO_NEW("b_ssbo", GL_FLOAT, GL_STATIC_DRAW);
+    compute_lib_ssbo_t c_ssbo = COMPUTE_LIB_SSBO_NEW("c_ssbo", GL_FLOAT, GL_DYNAMIC_COPY);
+    // writes bind the buffers, the dispatches rebind them to the bindings of their programs
+    a_ssbo.resource.value = 0;
+    b_ssbo.resource.value = 1;
+    c_ssbo.resource.value = 2;
+    GLuint errors_cnt = compute_lib_ssbo_init(&a_ssbo, a, TEST_M * TEST_K);
+    errors_cnt += compute_lib_ssbo_init(&b_ssbo, b, TEST_K * TEST_N);
+    errors_cnt += compute_lib_ssbo_init(&c_ssbo, c, TEST_M * TEST_N);
+
+    for (int transposes = 0; transposes < 4; transposes++) {
+        int transpose_a = transposes & 1, transpose_b = transposes >> 1;
+        memcpy(ref, c, TEST_M * TEST_N * sizeof(float));
+        cpu_gemm(a, b, ref, TEST_M, TEST_N, TEST_K, transpose_a, transpose_b, TEST_ALPHA, TEST_BETA);
+        errors_cnt += compute_lib_ssbo_write(&c_ssbo, c, TEST_M * TEST_N);
+        errors_cnt += compute_lib_shaders_gemm_dispatch(gemm, &a_ssbo, &b_ssbo, &c_ssbo, TEST_M, TEST_N, TEST_K, transpose_a, transpose_b, TEST_ALPHA, TEST_BETA);
+        errors_cnt += compute_lib_ssbo_read(&c_ssbo, result, TEST_M * TEST_N);
+        float error = max_abs_difference(ref, result, TEST_M * TEST_N);
+        printf("SGEMM %dx%dx%d (transpose A %d, B %d): maximum absolute error %g\r\n", TEST_M, TEST_N, TEST_K, transpose_a, transpose_b, error);
+        failures += error > 1e-4f;
+    }
+
+    // matrix-vector products reuse A with x from B and y from C
+    for (int transpose = 0; transpose <= 1; transpose++) {
+        int rows = transpose ? TEST_K : TEST_M;
+        memcpy(ref, c, rows * sizeof(float));
+        cpu_gemm(a, b, ref, transpose ? TEST_K : TEST_M, 1, transpose ? TEST_M : TEST_K, transpose, 0, TEST_ALPHA, TEST_BETA);
+        errors_cnt += compute_lib_ssbo_write(&c_ssbo, c, rows);
+        errors_cnt += compute_lib_shaders_gemm_gemv(gemm, &a_ssbo, &b_ssbo, &c_ssbo, TEST_M, TEST_K, transpose, TEST_ALPHA, TEST_BETA);
+        errors_cnt += compute_lib_ssbo_read(&c_ssbo, result, rows);
+        float error = max_abs_difference(ref, result, rows);
+        printf("SGEMV %dx%d (transpose %d): maximum absolute error %g\r\n", TEST_M, TEST_K, transpose, error);
+        failures += error > 1e-4f;
+    }
+
+    // batch of small matrices (e.g. homographies)
+    int batch_length = BATCH_SIZE * BATCH_SIZE * BATCH_COUNT;
+    float* batch_a = random_matrix(batch_length);
+    float* batch_b = random_matrix(batch_length);
+    float* batch_ref = (float*) calloc(batch_length, sizeof(float));
+    float* batch_result = (float*) malloc(batch_length * sizeof(float));
+    for (int i = 0; i < BATCH_COUNT; i++) {
+        int offset = i * BATCH_SIZE * BATCH_SIZE;
+        cpu_gemm(batch_a + offset, batch_b + offset, batch_ref + offset, BATCH_SIZE, BATCH_SIZE, BATCH_SIZE, 0, 1, 1.0f, 0.0f);
+    }
+    errors_cnt += compute_lib_ssbo_write(&a_ssbo, batch_a, batch_length);
+    errors_cnt += compute_lib_ssbo_write(&b_ssbo, batch_b, batch_length);
+    errors_cnt += compute_lib_ssbo_write(&c_ssbo, NULL, batch_length);
+    errors_cnt += compute_lib_shaders_gemm_batched(gemm, &a_ssbo, &b_ssbo, &c_ssbo, BATCH_SIZE, BATCH_SIZE, BATCH_SIZE, GL_FALSE, GL_TRUE, 1.0f, 0.0f, BATCH_COUNT);
+    errors_cnt += compute_lib_ssbo_read(&c_ssbo, batch_result, batch_length);
+    float error = max_abs_difference(batch_ref, batch_result, batch_length);
+    printf("Batched SGEMM of %d matrices %dx%d: maximum absolute error %g\r\n", BATCH_COUNT, BATCH_SIZE, BATCH_SIZE, error);
+    failures += error > 1e-5f;
+
+    compute_lib_ssbo_destroy(&a_ssbo);
+    compute_lib_ssbo_destroy(&b_ssbo);
+    compute_lib_ssbo_destroy(&c_ssbo);
+    free(a);
+    free(b);
+    free(c);
+    free(ref);
+    free(result);
+    free(batch_a);
+    free(batch_b);
+    free(batch_ref);
+    free(batch_result);
+    return (errors_cnt != GL_NO_ERROR) ? -1 : failures;
+}
+
+/// Measures GFLOP/s of square matrix multiplication with the provided tiling.
+static int benchmark_gemm(compute_lib_instance_t* inst, int tile, int tile_k, int work, const float* a, const float* b)
+{
+    compute_lib_shaders_gemm_t* gemm;
+    if ((gemm = compute_lib_shaders_gemm_init_ex(inst, tile, tile_k, work, 64)) == NULL) {
+        return 1;
+    }
+
+    int length = BENCHMARK_SIZE * BENCHMARK_SIZE;
+    compute_lib_ssbo_t a_ssbo = COMPUTE_LIB_SSBO_NEW("a_ssbo", GL_FLOAT, GL_STATIC_DRAW);
+    compute_lib_ssbo_t b_ssbo = COMPUTE_LIB_SSBO_NEW("b_ssbo", GL_FLOAT, GL_STATIC_DRAW);
+    compute_lib_ssbo_t c_ssbo = COMPUTE_LIB_SSBO_NEW("c_ssbo", GL_FLOAT, GL_DYNAMIC_COPY);
+    compute_lib_ssbo_init(&a_ssbo, (void*) a, length);
+    compute_lib_ssbo_init(&b_ssbo, (void*) b, length);
+    compute_lib_ssbo_init(&c_ssbo, NULL, length);
+
+    compute_lib_shaders_gemm_dispatch(gemm, &a_ssbo, &b_ssbo, &c_ssbo, BENCHMARK_SIZE, BENCHMARK_SIZE, BENCHMARK_SIZE, GL_FALSE, GL_FALSE, 1.0f, 0.0f);
+    glFinish();
+    double start = time_now_ms();
+    for (int i = 0; i < BENCHMARK_REPETITIONS; i++) {
+        compute_lib_shaders_gemm_dispatch(gemm, &a_ssbo, &b_ssbo, &c_ssbo, BENCHMARK_SIZE, BENCHMARK_SIZE, BENCHMARK_SIZE, GL_FALSE, GL_FALSE, 1.0f, 0.0f);
+    }
+    glFinish();
+    double ms = (time_now_ms() - start) / BENCHMARK_REPETITIONS;
+    double gflops = 2.0 * BENCHMARK_SIZE * BENCHMARK_SIZE * BENCHMARK_SIZE / (ms * 1e6);
+    printf("Tile %2d, tile K %2d, work %d: %8.3f ms, %7.2f GFLOP/s\r\n", tile, tile_k, work, ms, gflops);
+
+    compute_lib_ssbo_destroy(&a_ssbo);
+    compute_lib_ssbo_destroy(&b_ssbo);
+    compute_lib_ssbo_destroy(&c_ssbo);
+    compute_lib_shaders_gemm_destroy(gemm);
+    return 0;
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <path to input image> <path to output image>\r\n", argv[0]);
+        return 1;
+    }
+
+    rgba_t* input_img_data;
+    int width, height;
+    printf("Loading image: %s\r\n", argv[1]);
+    if (!image_load(argv[1], &width, &height, 4, (unsigned char**) &input_img_data)) {
+        fprintf(stderr, "Failed to load image file!\r\n");
+        return 2;
+    }
+    printf("Loaded image with size %dx%d px.\r\n", width, height);
+
+    printf("Initializing compute library instance.\r\n");
+    compute_lib_instance_t inst = COMPUTE_LIB_INSTANCE_NEW("/dev/dri/renderD128");
+    if (compute_lib_init(&inst) != GL_NO_ERROR) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 3;
+    }
+
+    printf("Initializing gemm instance.\r\n");
+    compute_lib_shaders_gemm_t* gemm;
+    if ((gemm = compute_lib_shaders_gemm_init(&inst)) == NULL) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 4;
+    }
+
+    if (test_gemm_accuracy(gemm) != 0) {
+        fprintf(stderr, "Matrix multiplication accuracy test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 5;
+    }
+
+    printf("Benchmarking SGEMM %dx%dx%d (%d runs each):\r\n", BENCHMARK_SIZE, BENCHMARK_SIZE, BENCHMARK_SIZE, BENCHMARK_REPETITIONS);
+    float* a = random_matrix(BENCHMARK_SIZE * BENCHMARK_SIZE);
+    float* b = random_matrix(BENCHMARK_SIZE * BENCHMARK_SIZE);
+    int configs[][3] = { { 16, 16, 1 }, { 16, 16, 2 }, { 32, 16, 2 }, { 32, 16, 4 }, { 64, 16, 4 }, { 64, 8, 8 } };
+    for (int i = 0; i < (int) (sizeof(configs) / sizeof(configs[0])); i++) {
+        if (benchmark_gemm(&inst, configs[i][0], configs[i][1], configs[i][2], a, b) != 0) {
+            compute_lib_error_queue_flush(&inst, stderr);
+            return 6;
+        }
+    }
+
+    // grayscale image projected to its row space: C = A * A^T, normalized to 8 bits
+    int size = (width < height) ? width : height;
+    float* image = (float*) malloc(size * size * sizeof(float));
+    float* gram = (float*) malloc(size * size * sizeof(float));
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            image[y * size + x] = input_img_data[y * width + x].r / 255.0f;
+        }
+    }
+    compute_lib_ssbo_t image_ssbo = COMPUTE_LIB_SSBO_NEW("image_ssbo", GL_FLOAT, GL_STATIC_DRAW);
+    compute_lib_ssbo_t gram_ssbo = COMPUTE_LIB_SSBO_NEW("gram_ssbo", GL_FLOAT, GL_DYNAMIC_COPY);
+    compute_lib_ssbo_init(&image_ssbo, image, size * size);
+    compute_lib_ssbo_init(&gram_ssbo, NULL, size * size);
+    if (compute_lib_shaders_gemm_dispatch(gemm, &image_ssbo, &image_ssbo, &gram_ssbo, size, size, size, GL_FALSE, GL_TRUE, 1.0f / size, 0.0f) != GL_NO_ERROR ||
+            compute_lib_ssbo_read(&gram_ssbo, gram, size * size) != GL_NO_ERROR) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 7;
+    }
+    unsigned char* output_img_data = (unsigned char*) calloc(size * size, sizeof(unsigned char));
+    for (int i = 0; i < size * size; i++) {
+        output_img_data[i] = (unsigned char) fminf(255.0f, 255.0f * gram[i]);
+    }
+
+    printf("Writing output image: %s\r\n", argv[2]);
+    if (!image_save(argv[2], size, size, 1, output_img_data)) {
+        fprintf(stderr, "Failed to write image file!\r\n");
+        return 8;
+    }
+
+    compute_lib_ssbo_destroy(&image_ssbo);
+    compute_lib_ssbo_destroy(&gram_ssbo);
+    compute_lib_shaders_gemm_destroy(gemm);
+    compute_lib_deinit(&inst);
+    free(a);
+    free(b);
+    free(image);
+    free(gram);
+    free(output_img_data);
+
+    printf("Program Done.\r\n");
+}
@@ -0,0 +1,199 @@
+/// \file test_guided.c
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Test source file for GLES3ComputeLib library implementation of the guided filter (output image is the self-guided filtered input image).
+/// \copyright GNU Public License.
+
+#include "shaders/guided.h"
+#include "utils/image.h"
+#include "utils/timer.h"
+
+#include <math.h>
+
+#define LOCAL_SIZE 64
+
+
+/// Computes means of num_channels interleaved channels over windows clipped to the image on CPU (by a summed-area table).
+static void box_mean_reference(const double* input, int width, int height, int num_channels, int radius, double* output)
+{
+    double* sat = (double*) calloc((width + 1) * (height + 1) * num_channels, sizeof(double));
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            for (int c = 0; c < num_channels; c++) {
+                sat[((y + 1) * (width + 1) + x + 1) * num_channels + c] = input[(y * width + x) * num_channels + c] + sat[(y * (width + 1) + x + 1) * num_channels + c] +
+                        sat[((y + 1) * (width + 1) + x) * num_channels + c] - sat[(y * (width + 1) + x) * num_channels + c];
+            }
+        }
+    }
+    for (int y = 0; y < height; y++) {
+        int y0 = (y - radius < 0) ? 0 : y - radius, y1 = (y + radius >= height) ? height : y + radius + 1;
+        for (int x = 0; x < width; x++) {
+            int x0 = (x - radius < 0) ? 0 : x - radius, x1 = (x + radius >= width) ? width : x + radius + 1;
+            for (int c = 0; c < num_channels; c++) {
+                double sum = sat[(y1 * (width + 1) + x1) * num_channels + c] - sat[(y0 * (width + 1) + x1) * num_channels + c] -
+                             sat[(y1 * (width + 1) + x0) * num_channels + c] + sat[(y0 * (width + 1) + x0) * num_channels + c];
+                output[(y * width + x) * num_channels + c] = sum / ((x1 - x0) * (y1 - y0));
+            }
+        }
+    }
+    free(sat);
+}
+
+/// Filters RGB channels of the input by the guide luma on CPU (alpha is copied).
+static void guided_reference(const float* input, const float* guide, int width, int height, int radius, double epsilon, float* output)
+{
+    // moments: input RGB, guide luma, products of input RGB and guide luma, squared guide luma
+    double* moments = (double*) malloc(8 * width * height * sizeof(double));
+    double* means = (double*) malloc(8 * width * height * sizeof(double));
+    double* luma = (double*) malloc(width * height * sizeof(double));
+    for (int i = 0; i < width * height; i++) {
+        luma[i] = 0.299 * guide[4 * i] + 0.587 * guide[4 * i + 1] + 0.114 * guide[4 * i + 2];
+        for (int c = 0; c < 3; c++) {
+            moments[8 * i + c] = input[4 * i + c];
+            moments[8 * i + 4 + c] = input[4 * i + c] * luma[i];
+        }
+        moments[8 * i + 3] = luma[i];
+        moments[8 * i + 7] = luma[i] * luma[i];
+    }
+    box_mean_reference(moments, width, height, 8, radius, means);
+
+    // coefficients a and b of RGB channels
+    for (int i = 0; i < width * height; i++) {
+        double* m = &means[8 * i];
+        double variance = fmax(m[7] - m[3] * m[3], 0.0);
+        for (int c = 0; c < 3; c++) {
+            double a = (m[4 + c] - m[3] * m[c]) / (variance + epsilon);
+            moments[8 * i + c] = a;
+            moments[8 * i + 4 + c] = m[c] - a * m[3];
+        }
+        moments[8 * i + 3] = moments[8 * i + 7] = 0.0;
+    }
+    box_mean_reference(moments, width, height, 8, radius, means);
+
+    for (int i = 0; i < width * height; i++) {
+        for (int c = 0; c < 3; c++) {
+            output[4 * i + c] = (float) (means[8 * i + c] * luma[i] + means[8 * i + 4 + c]);
+        }
+        output[4 * i + 3] = input[4 * i + 3];
+    }
+    free(moments);
+    free(means);
+    free(luma);
+}
+
+/// Filters the image on GPU and compares it with CPU, RGBA8 results may differ by rounding, RGBA32F ones by the float precision of the sliding sums.
+/// \param self_guided The input image guides itself, otherwise the guide is the input with inverted colors.
+static int test_guided(compute_lib_instance_t* inst, rgba_t* img_data, int width, int height, GLenum type, int radius, GLfloat epsilon, GLboolean self_guided, rgba_t* output_img_data)
+{
+    compute_lib_shaders_guided_t* guided;
+    if ((guided = compute_lib_shaders_guided_init(inst, LOCAL_SIZE, width, height, type)) == NULL) {
+        return -1;
+    }
+
+    float* input = (float*) malloc(4 * width * height * sizeof(float));
+    float* guide = (float*) malloc(4 * width * height * sizeof(float));
+    float* expected = (float*) malloc(4 * width * height * sizeof(float));
+    float* output = (float*) malloc(4 * width * height * sizeof(float));
+    rgba_t* guide8 = (rgba_t*) malloc(width * height * sizeof(rgba_t));
+    rgba_t* output8 = (rgba_t*) malloc(width * height * sizeof(rgba_t));
+    // float images hold values from 0 to 1
+    float value_scale = (type == GL_FLOAT) ? 1.0f / 255.0f : 1.0f;
+    for (int i = 0; i < width * height; i++) {
+        rgba_t px = img_data[i];
+        guide8[i] = self_guided ? px : (rgba_t) { 255 - px.r, 255 - px.g, 255 - px.b, px.a };
+        for (int c = 0; c < 4; c++) {
+            input[4 * i + c] = ((unsigned char*) &px)[c] * value_scale;
+            guide[4 * i + c] = ((unsigned char*) &guide8[i])[c] * value_scale;
+        }
+    }
+
+    GLuint errors_cnt = compute_lib_image2d_write(&(guided->input_image2d), (type == GL_FLOAT) ? (void*) input : (void*) img_data);
+    errors_cnt += compute_lib_image2d_write(&(guided->guide_image2d), (type == GL_FLOAT) ? (void*) guide : (void*) guide8);
+    errors_cnt += compute_lib_shaders_guided_dispatch(guided, radius, epsilon);
+    glFinish();
+    double start = time_now_ms();
+    errors_cnt += compute_lib_shaders_guided_dispatch(guided, radius, epsilon);
+    errors_cnt += compute_lib_image2d_read(&(guided->output_image2d), (type == GL_FLOAT) ? (void*) output : (void*) output8);
+    double gpu_ms = time_now_ms() - start;
+
+    start = time_now_ms();
+    guided_reference(input, guide, width, height, radius, epsilon, expected);
+    double cpu_ms = time_now_ms() - start;
+
+    int errors = 0;
+    double max_difference = 0.0;
+    for (int i = 0; i < 4 * width * height; i++) {
+        float value = output[i];
+        if (type != GL_FLOAT) {
+            value = ((unsigned char*) output8)[i];
+            expected[i] = fminf(fmaxf(expected[i], 0.0f), 255.0f);
+        }
+        double difference = fabs(value - expected[i]);
+        max_difference = (difference > max_difference) ? difference : max_difference;
+        errors += difference > ((type == GL_FLOAT) ? 1e-3 : 1.0);
+    }
+    printf("%-7s radius %2d, epsilon %8.4f, %-11s: max difference %.6f, GPU %8.3f ms, CPU %8.3f ms, %d errors\r\n", (type == GL_FLOAT) ? "RGBA32F" : "RGBA8", radius, epsilon,
+           self_guided ? "self-guided" : "guided", max_difference, gpu_ms, cpu_ms, errors);
+
+    if (output_img_data != NULL) {
+        memcpy(output_img_data, output8, width * height * sizeof(rgba_t));
+    }
+
+    compute_lib_shaders_guided_destroy(guided);
+    free(input);
+    free(guide);
+    free(expected);
+    free(output);
+    free(guide8);
+    free(output8);
+    return (errors_cnt != GL_NO_ERROR) ? -1 : errors;
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <path to input image> <path to output image>\r\n", argv[0]);
+        return 1;
+    }
+
+    rgba_t* input_img_data;
+    int width, height;
+    printf("Loading image: %s\r\n", argv[1]);
+    if (!image_load(argv[1], &width, &height, 4, (unsigned char**) &input_img_data)) {
+        fprintf(stderr, "Failed to load image file!\r\n");
+        return 2;
+    }
+    printf("Loaded image with size %dx%d px.\r\n", width, height);
+
+    printf("Initializing compute library instance.\r\n");
+    compute_lib_instance_t inst = COMPUTE_LIB_INSTANCE_NEW("/dev/dri/renderD128");
+    if (compute_lib_init(&inst) != GL_NO_ERROR) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 3;
+    }
+
+    rgba_t* output_img_data = (rgba_t*) malloc(width * height * sizeof(rgba_t));
+    int errors = 0;
+    errors += test_guided(&inst, input_img_data, width, height, GL_UNSIGNED_BYTE, 2, 100.0f, GL_TRUE, NULL);
+    errors += test_guided(&inst, input_img_data, width, height, GL_UNSIGNED_BYTE, 16, 100.0f, GL_FALSE, NULL);
+    errors += test_guided(&inst, input_img_data, width, height, GL_FLOAT, 4, 0.01f, GL_FALSE, NULL);
+    errors += test_guided(&inst, input_img_data, width, height, GL_FLOAT, 16, 0.001f, GL_TRUE, NULL);
+    errors += test_guided(&inst, input_img_data, width, height, GL_UNSIGNED_BYTE, 8, 400.0f, GL_TRUE, output_img_data);
+    if (errors != 0) {
+        fprintf(stderr, "Guided filter test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 4;
+    }
+
+    printf("Writing output image: %s\r\n", argv[2]);
+    if (!image_save(argv[2], width, height, 4, (unsigned char*) output_img_data)) {
+        fprintf(stderr, "Failed to write image file!\r\n");
+        return 5;
+    }
+
+    compute_lib_deinit(&inst);
+    free(output_img_data);
+
+    printf("Program Done.\r\n");
+}
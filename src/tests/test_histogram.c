@@ -0,0 +1,129 @@
+/// \file test_histogram.c
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Test source file for GLES3ComputeLib library implementation of image histograms and histogram equalisation.
+/// \copyright GNU Public License.
+
+#include "shaders/histogram.h"
+#include "utils/image.h"
+
+#define LOCAL_SIZE_X 16
+#define LOCAL_SIZE_Y 16
+
+#define NUM_BINS 256
+#define RGBA_NUM_BINS 64
+
+
+/// Computes histograms on GPU and compares bins and equalisation look-up tables with CPU.
+static int test_histogram_mode(compute_lib_shaders_histogram_t* histogram, rgba_t* img_data, int width, int height)
+{
+    int length = histogram->num_histograms * histogram->num_bins;
+    GLuint* bins = (GLuint*) calloc(length, sizeof(GLuint));
+    GLuint* lut = (GLuint*) calloc(length, sizeof(GLuint));
+    GLuint* ref_bins = (GLuint*) calloc(length, sizeof(GLuint));
+
+    compute_lib_image2d_write(&(histogram->input_image2d), img_data);
+    compute_lib_shaders_histogram_dispatch(histogram);
+    compute_lib_shaders_histogram_equalize(histogram);
+    compute_lib_ssbo_read(&(histogram->histogram_ssbo), bins, length);
+    compute_lib_ssbo_read(&(histogram->lut_ssbo), lut, length);
+
+    for (int i = 0; i < width * height; i++) {
+        rgba_t px = img_data[i];
+        if (histogram->mode == COMPUTE_LIB_SHADERS_HISTOGRAM_RED) {
+            ref_bins[px.r * histogram->num_bins / 256]++;
+        } else if (histogram->mode == COMPUTE_LIB_SHADERS_HISTOGRAM_LUMA) {
+            ref_bins[((77 * px.r + 150 * px.g + 29 * px.b + 128) >> 8) * histogram->num_bins / 256]++;
+        } else {
+            ref_bins[px.r * histogram->num_bins / 256]++;
+            ref_bins[histogram->num_bins + px.g * histogram->num_bins / 256]++;
+            ref_bins[2 * histogram->num_bins + px.b * histogram->num_bins / 256]++;
+            ref_bins[3 * histogram->num_bins + px.a * histogram->num_bins / 256]++;
+        }
+    }
+
+    int bin_mismatches = 0, lut_mismatches = 0;
+    for (int h = 0; h < histogram->num_histograms; h++) {
+        GLuint* ref = ref_bins + h * histogram->num_bins;
+        GLuint total = 0, cdf = 0, cdf_min = 0;
+        for (int b = 0; b < histogram->num_bins; b++) {
+            total += ref[b];
+            if (cdf_min == 0) cdf_min = ref[b];
+        }
+        for (int b = 0; b < histogram->num_bins; b++) {
+            cdf += ref[b];
+            GLuint ref_lut = 255;
+            if (total > cdf_min) {
+                ref_lut = (cdf <= cdf_min) ? 0 : (GLuint) ((double) (cdf - cdf_min) / (total - cdf_min) * 255.0 + 0.5);
+            }
+            bin_mismatches += bins[h * histogram->num_bins + b] != ref[b];
+            lut_mismatches += abs((int) lut[h * histogram->num_bins + b] - (int) ref_lut) > 1;
+        }
+    }
+    printf("Mode %d with %d bins: %d bin mismatches, %d look-up table mismatches against CPU reference\r\n", histogram->mode, histogram->num_bins, bin_mismatches, lut_mismatches);
+
+    free(bins);
+    free(lut);
+    free(ref_bins);
+    return bin_mismatches + lut_mismatches;
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <path to input image> <path to output image>\r\n", argv[0]);
+        return 1;
+    }
+
+    rgba_t* input_img_data;
+    int width, height;
+    printf("Loading image: %s\r\n", argv[1]);
+    if (!image_load(argv[1], &width, &height, 4, (unsigned char**) &input_img_data)) {
+        fprintf(stderr, "Failed to load image file!\r\n");
+        return 2;
+    }
+    printf("Loaded image with size %dx%d px.\r\n", width, height);
+
+    printf("Initializing compute library instance.\r\n");
+    compute_lib_instance_t inst = COMPUTE_LIB_INSTANCE_NEW("/dev/dri/renderD128");
+    if (compute_lib_init(&inst) != GL_NO_ERROR) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 3;
+    }
+
+    printf("Initializing histogram instances.\r\n");
+    compute_lib_shaders_histogram_t* luma;
+    compute_lib_shaders_histogram_t* rgba;
+    if ((luma = compute_lib_shaders_histogram_init(&inst, LOCAL_SIZE_X, LOCAL_SIZE_Y, width, height, COMPUTE_LIB_SHADERS_HISTOGRAM_LUMA, NUM_BINS)) == NULL ||
+            (rgba = compute_lib_shaders_histogram_init(&inst, LOCAL_SIZE_X, LOCAL_SIZE_Y, width, height, COMPUTE_LIB_SHADERS_HISTOGRAM_RGBA, RGBA_NUM_BINS)) == NULL) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 4;
+    }
+
+    printf("Running histogram programs.\r\n");
+    if (test_histogram_mode(luma, input_img_data, width, height) != 0 || test_histogram_mode(rgba, input_img_data, width, height) != 0) {
+        fprintf(stderr, "Histogram test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 5;
+    }
+
+    rgba_t* output_img_data = (rgba_t*) calloc(width * height, sizeof(rgba_t));
+    if (compute_lib_image2d_read(&(luma->output_image2d), output_img_data) != GL_NO_ERROR) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 6;
+    }
+
+    printf("Writing output image: %s\r\n", argv[2]);
+    if (!image_save(argv[2], width, height, 4, (unsigned char*) output_img_data)) {
+        fprintf(stderr, "Failed to write image file!\r\n");
+        return 7;
+    }
+
+    compute_lib_shaders_histogram_destroy(luma);
+    compute_lib_shaders_histogram_destroy(rgba);
+    compute_lib_deinit(&inst);
+    free(output_img_data);
+
+    printf("Program Done.\r\n");
+}
@@ -0,0 +1,250 @@
+/// \file test_keypoints.c
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Test source file for GLES3ComputeLib library implementation of keypoint detection (output image is the input with FAST keypoints limited per cell marked in red).
+/// \copyright GNU Public License.
+
+#include "shaders/keypoints.h"
+#include "utils/image.h"
+#include "utils/timer.h"
+
+#include <math.h>
+
+#define LOCAL_SIZE_X 16
+#define LOCAL_SIZE_Y 8
+
+/// Maximum fraction of keypoints differing from the CPU reference for float responses (rounding may break near ties).
+#define MAX_MISMATCH_RATIO 5e-3
+
+static const char* method_names[] = { "FAST-9", "Harris", "Shi-Tomasi" };
+
+
+/// Computes the response image on CPU.
+static void response_reference(const rgba_t* img_data, int width, int height, GLenum method, float threshold, float* response)
+{
+    static const int circle[16][2] = { { 0, -3 }, { 1, -3 }, { 2, -2 }, { 3, -1 }, { 3, 0 }, { 3, 1 }, { 2, 2 }, { 1, 3 },
+                                       { 0, 3 }, { -1, 3 }, { -2, 2 }, { -3, 1 }, { -3, 0 }, { -3, -1 }, { -2, -2 }, { -1, -3 } };
+    float* luma = (float*) malloc(width * height * sizeof(float));
+    for (int i = 0; i < width * height; i++) {
+        luma[i] = (float) ((77 * img_data[i].r + 150 * img_data[i].g + 29 * img_data[i].b + 128) >> 8);
+    }
+    int border = (method == COMPUTE_LIB_SHADERS_KEYPOINTS_FAST) ? 3 : 2;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            float res = 0.0f;
+            if (x >= border && y >= border && x < width - border && y < height - border) {
+                if (method == COMPUTE_LIB_SHADERS_KEYPOINTS_FAST) {
+                    float c = luma[y * width + x], bright_score = 0.0f, dark_score = 0.0f;
+                    int bright[32] = { 0 }, dark[32] = { 0 }, bright_arc = 0, dark_arc = 0;
+                    for (int i = 0; i < 16; i++) {
+                        float d = luma[(y + circle[i][1]) * width + x + circle[i][0]] - c;
+                        bright[i] = bright[i + 16] = d > threshold;
+                        dark[i] = dark[i + 16] = -d > threshold;
+                        bright_score += bright[i] ? d - threshold : 0.0f;
+                        dark_score += dark[i] ? -d - threshold : 0.0f;
+                    }
+                    for (int i = 0, bright_run = 0, dark_run = 0; i < 32; i++) {
+                        bright_run = bright[i] ? bright_run + 1 : 0;
+                        dark_run = dark[i] ? dark_run + 1 : 0;
+                        bright_arc |= bright_run >= 9;
+                        dark_arc |= dark_run >= 9;
+                    }
+                    res = fmaxf(bright_arc ? bright_score : 0.0f, dark_arc ? dark_score : 0.0f);
+                } else {
+                    float m[3] = { 0.0f, 0.0f, 0.0f };
+                    for (int j = -1; j <= 1; j++) {
+                        for (int k = -1; k <= 1; k++) {
+                            const float* l = &luma[(y + j) * width + x + k];
+                            float gx = (l[-width + 1] + 2.0f * l[1] + l[width + 1]) - (l[-width - 1] + 2.0f * l[-1] + l[width - 1]);
+                            float gy = (l[width - 1] + 2.0f * l[width] + l[width + 1]) - (l[-width - 1] + 2.0f * l[-width] + l[-width + 1]);
+                            gx *= 1.0f / 2040.0f;
+                            gy *= 1.0f / 2040.0f;
+                            m[0] += gx * gx;
+                            m[1] += gy * gy;
+                            m[2] += gx * gy;
+                        }
+                    }
+                    if (method == COMPUTE_LIB_SHADERS_KEYPOINTS_HARRIS) {
+                        res = m[0] * m[1] - m[2] * m[2] - 0.04f * (m[0] + m[1]) * (m[0] + m[1]);
+                    } else {
+                        res = 0.5f * (m[0] + m[1]) - sqrtf(0.25f * (m[0] - m[1]) * (m[0] - m[1]) + m[2] * m[2]);
+                    }
+                }
+            }
+            response[y * width + x] = res;
+        }
+    }
+    free(luma);
+}
+
+/// Selects local maxima on CPU (limited to the strongest ones of each cell), marks them in the mask, returns their number.
+static int select_reference(const float* response, int width, int height, float threshold, int nms_radius, int cell_size, int per_cell, unsigned char* mask)
+{
+    int num_keypoints = 0;
+    int* candidates = (int*) malloc(cell_size * cell_size * sizeof(int));
+    memset(mask, 0, width * height);
+    for (int cy = 0; cy < height; cy += cell_size) {
+        for (int cx = 0; cx < width; cx += cell_size) {
+            int num_candidates = 0;
+            for (int y = cy; y < cy + cell_size && y < height; y++) {
+                for (int x = cx; x < cx + cell_size && x < width; x++) {
+                    float r = response[y * width + x];
+                    int is_maximum = r > threshold;
+                    for (int j = -nms_radius; j <= nms_radius && is_maximum; j++) {
+                        for (int k = -nms_radius; k <= nms_radius && is_maximum; k++) {
+                            int nx = x + k, ny = y + j;
+                            float n = (nx >= 0 && ny >= 0 && nx < width && ny < height) ? response[ny * width + nx] : 0.0f;
+                            is_maximum = !(n > r || ((j < 0 || (j == 0 && k < 0)) && n == r));
+                        }
+                    }
+                    if (is_maximum) {
+                        candidates[num_candidates++] = y * width + x;
+                    }
+                }
+            }
+            // candidates are in raster order, ties are broken by it
+            for (int i = 0; i < num_candidates; i++) {
+                int rank = 0;
+                for (int j = 0; j < num_candidates; j++) {
+                    float a = response[candidates[i]], b = response[candidates[j]];
+                    rank += b > a || (b == a && j < i);
+                }
+                if (per_cell == 0 || rank < per_cell) {
+                    mask[candidates[i]] = 1;
+                    num_keypoints++;
+                }
+            }
+        }
+    }
+    free(candidates);
+    return num_keypoints;
+}
+
+static int test_keypoints(compute_lib_instance_t* inst, rgba_t* img_data, int width, int height, GLenum method, float threshold, int nms_radius, int cell_size, int per_cell, int max_keypoints, unsigned char* output_mask)
+{
+    compute_lib_shaders_keypoints_t* keypoints;
+    if ((keypoints = compute_lib_shaders_keypoints_init(inst, LOCAL_SIZE_X, LOCAL_SIZE_Y, width, height, method, nms_radius, cell_size, per_cell, max_keypoints)) == NULL) {
+        return -1;
+    }
+
+    compute_lib_shaders_keypoint_t* output = (compute_lib_shaders_keypoint_t*) malloc(max_keypoints * sizeof(compute_lib_shaders_keypoint_t));
+    float* response = (float*) malloc(width * height * sizeof(float));
+    unsigned char* mask = (unsigned char*) malloc(width * height);
+    GLuint num_keypoints = 0;
+
+    GLuint errors_cnt = compute_lib_image2d_write(&(keypoints->input_image2d), img_data);
+    errors_cnt += compute_lib_shaders_keypoints_dispatch(keypoints, threshold);
+    glFinish();
+    double start = time_now_ms();
+    errors_cnt += compute_lib_shaders_keypoints_dispatch(keypoints, threshold);
+    errors_cnt += compute_lib_shaders_keypoints_read(keypoints, output, &num_keypoints);
+    double gpu_ms = time_now_ms() - start;
+
+    start = time_now_ms();
+    response_reference(img_data, width, height, method, threshold, response);
+    int expected_num_keypoints = select_reference(response, width, height, (method == COMPUTE_LIB_SHADERS_KEYPOINTS_FAST) ? 0.0f : threshold, nms_radius, cell_size, per_cell, mask);
+    double cpu_ms = time_now_ms() - start;
+
+    // stored keypoints must be expected ones (each once) with the same response, all of them if none were dropped
+    int mismatches = 0;
+    for (GLuint i = 0; i < num_keypoints; i++) {
+        int x = (int) output[i].x, y = (int) output[i].y;
+        if (x < 0 || y < 0 || x >= width || y >= height || mask[y * width + x] != 1 ||
+                fabsf(output[i].response - response[y * width + x]) > 1e-4f * fmaxf(1e-3f, fabsf(response[y * width + x]))) {
+            mismatches++;
+        } else {
+            mask[y * width + x] = 2;
+        }
+    }
+    if ((int) num_keypoints == max_keypoints) {
+        mismatches += (int) keypoints->num_keypoints < max_keypoints;
+    } else {
+        mismatches += abs((int) num_keypoints - expected_num_keypoints);
+    }
+    int errors = (method == COMPUTE_LIB_SHADERS_KEYPOINTS_FAST) ? mismatches : (mismatches > expected_num_keypoints * MAX_MISMATCH_RATIO);
+    printf("%-10s NMS %dx%d, cell %2d, %2d per cell: %6u keypoints (%6u stored), GPU detection + read %8.3f ms, CPU %8.3f ms, %d mismatches\r\n",
+           method_names[method], 2 * nms_radius + 1, 2 * nms_radius + 1, cell_size, per_cell, keypoints->num_keypoints, num_keypoints, gpu_ms, cpu_ms, mismatches);
+    if (output_mask != NULL) {
+        memset(output_mask, 0, width * height);
+        for (GLuint i = 0; i < num_keypoints; i++) {
+            output_mask[(int) output[i].y * width + (int) output[i].x] = 1;
+        }
+    }
+
+    compute_lib_shaders_keypoints_destroy(keypoints);
+    free(output);
+    free(response);
+    free(mask);
+    return (errors_cnt != GL_NO_ERROR) ? -1 : errors;
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <path to input image> <path to output image>\r\n", argv[0]);
+        return 1;
+    }
+
+    rgba_t* input_img_data;
+    int width, height;
+    printf("Loading image: %s\r\n", argv[1]);
+    if (!image_load(argv[1], &width, &height, 4, (unsigned char**) &input_img_data)) {
+        fprintf(stderr, "Failed to load image file!\r\n");
+        return 2;
+    }
+    printf("Loaded image with size %dx%d px.\r\n", width, height);
+
+    printf("Initializing compute library instance.\r\n");
+    compute_lib_instance_t inst = COMPUTE_LIB_INSTANCE_NEW("/dev/dri/renderD128");
+    if (compute_lib_init(&inst) != GL_NO_ERROR) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 3;
+    }
+
+    int capacity = width * height / 4;
+    int errors = 0;
+    errors += test_keypoints(&inst, input_img_data, width, height, COMPUTE_LIB_SHADERS_KEYPOINTS_FAST, 20.0f, 1, 32, 0, capacity, NULL);
+    errors += test_keypoints(&inst, input_img_data, width, height, COMPUTE_LIB_SHADERS_KEYPOINTS_FAST, 20.0f, 3, 16, 0, capacity, NULL);
+    errors += test_keypoints(&inst, input_img_data, width, height, COMPUTE_LIB_SHADERS_KEYPOINTS_FAST, 10.0f, 2, 24, 5, 100, NULL);
+    errors += test_keypoints(&inst, input_img_data, width, height, COMPUTE_LIB_SHADERS_KEYPOINTS_HARRIS, 1e-4f, 2, 32, 0, capacity, NULL);
+    errors += test_keypoints(&inst, input_img_data, width, height, COMPUTE_LIB_SHADERS_KEYPOINTS_SHI_TOMASI, 1e-2f, 1, 32, 8, capacity, NULL);
+    // odd cells hold up to ceil(cell_size / 2)^2 maxima, all of them are kept
+    errors += test_keypoints(&inst, input_img_data, width, height, COMPUTE_LIB_SHADERS_KEYPOINTS_HARRIS, 0.0f, 1, 3, 4, capacity, NULL);
+    errors += test_keypoints(&inst, input_img_data, width, height, COMPUTE_LIB_SHADERS_KEYPOINTS_FAST, 1.0f, 1, 5, 9, capacity, NULL);
+    if (errors != 0) {
+        fprintf(stderr, "Keypoint detection test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 4;
+    }
+
+    unsigned char* mask = (unsigned char*) malloc(width * height);
+    if (test_keypoints(&inst, input_img_data, width, height, COMPUTE_LIB_SHADERS_KEYPOINTS_FAST, 20.0f, 2, 32, 4, capacity, mask) != 0) {
+        fprintf(stderr, "Keypoint detection test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 5;
+    }
+    rgba_t* output_img_data = (rgba_t*) malloc(width * height * sizeof(rgba_t));
+    memcpy(output_img_data, input_img_data, width * height * sizeof(rgba_t));
+    for (int y = 1; y < height - 1; y++) {
+        for (int x = 1; x < width - 1; x++) {
+            if (mask[y * width + x]) {
+                for (int k = -1; k <= 1; k++) {
+                    output_img_data[y * width + x + k] = output_img_data[(y + k) * width + x] = (rgba_t) { 255, 0, 0, 255 };
+                }
+            }
+        }
+    }
+
+    printf("Writing output image: %s\r\n", argv[2]);
+    if (!image_save(argv[2], width, height, 4, (unsigned char*) output_img_data)) {
+        fprintf(stderr, "Failed to write image file!\r\n");
+        return 6;
+    }
+
+    compute_lib_deinit(&inst);
+    free(mask);
+    free(output_img_data);
+
+    printf("Program Done.\r\n");
+}
@@ -0,0 +1,243 @@
+/// \file test_match.c
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Test source file for GLES3ComputeLib library implementation of template matching (output image is the normalized NCC response map).
+/// \copyright GNU Public License.
+
+#include "shaders/match.h"
+#include "utils/image.h"
+#include "utils/timer.h"
+
+#include <math.h>
+#include <stdint.h>
+
+#define LOCAL_SIZE_X 16
+#define LOCAL_SIZE_Y 16
+
+#define BENCHMARK_ITERATIONS 20
+
+#define BLOB_IMAGE_SIZE 128
+#define BLOB_SIGMA 4.0
+
+
+static int luma(rgba_t px)
+{
+    return (77 * px.r + 150 * px.g + 29 * px.b + 128) >> 8;
+}
+
+/// Computes the response map on CPU (64-bit integer sums, double precision correlation).
+static void match_reference(const rgba_t* img_data, int width, int height, const rgba_t* template_data, int template_width, int template_height,
+                            int origin_x, int origin_y, int response_width, int response_height, GLenum method, double* response)
+{
+    int64_t n = template_width * template_height;
+    for (int v = 0; v < response_height; v++) {
+        for (int u = 0; u < response_width; u++) {
+            int64_t sum_i = 0, sum_ii = 0, sum_it = 0, sum_t = 0, sum_tt = 0;
+            for (int y = 0; y < template_height; y++) {
+                for (int x = 0; x < template_width; x++) {
+                    int ix = origin_x + u + x, iy = origin_y + v + y;
+                    ix = (ix < 0) ? 0 : ((ix >= width) ? width - 1 : ix);
+                    iy = (iy < 0) ? 0 : ((iy >= height) ? height - 1 : iy);
+                    int64_t i = luma(img_data[iy * width + ix]), t = luma(template_data[y * template_width + x]);
+                    sum_i += i;
+                    sum_ii += i * i;
+                    sum_it += i * t;
+                    sum_t += t;
+                    sum_tt += t * t;
+                }
+            }
+            if (method == COMPUTE_LIB_SHADERS_MATCH_SSD) {
+                response[v * response_width + u] = (double) (sum_ii - 2 * sum_it + sum_tt);
+            } else {
+                double variance_i = (double) (n * sum_ii - sum_i * sum_i), variance_t = (double) (n * sum_tt - sum_t * sum_t);
+                response[v * response_width + u] = (variance_i > 0.0 && variance_t > 0.0) ? (double) (n * sum_it - sum_i * sum_t) / sqrt(variance_i * variance_t) : 0.0;
+            }
+        }
+    }
+}
+
+static float peak_offset(float previous, float center, float next)
+{
+    float curvature = previous - 2.0f * center + next;
+    if (curvature == 0.0f) {
+        return 0.0f;
+    }
+    float offset = 0.5f * (previous - next) / curvature;
+    return (offset < -0.5f) ? -0.5f : ((offset > 0.5f) ? 0.5f : offset);
+}
+
+/// Matches the template cut from the image at (template_x, template_y) within the search window, compares the response map with CPU
+/// and the reduced and refined best match with the extreme of the GPU response map.
+static int test_match(compute_lib_instance_t* inst, rgba_t* img_data, int width, int height, int template_x, int template_y, int template_width, int template_height,
+                      int origin_x, int origin_y, int search_width, int search_height, GLenum method, rgba_t* output_img_data)
+{
+    compute_lib_shaders_match_t* match;
+    if ((match = compute_lib_shaders_match_init(inst, LOCAL_SIZE_X, LOCAL_SIZE_Y, width, height, template_width, template_height, search_width, search_height, method)) == NULL) {
+        return -1;
+    }
+
+    int response_width = match->response_image2d.width, response_height = match->response_image2d.height;
+    rgba_t* template_data = (rgba_t*) malloc(template_width * template_height * sizeof(rgba_t));
+    GLfloat* response = (GLfloat*) malloc(response_width * response_height * sizeof(GLfloat));
+    double* expected = (double*) malloc(response_width * response_height * sizeof(double));
+    for (int y = 0; y < template_height; y++) {
+        memcpy(&template_data[y * template_width], &img_data[(template_y + y) * width + template_x], template_width * sizeof(rgba_t));
+    }
+
+    compute_lib_shaders_match_result_t result;
+    GLuint errors_cnt = compute_lib_image2d_write(&(match->input_image2d), img_data);
+    errors_cnt += compute_lib_image2d_write(&(match->template_image2d), template_data);
+    errors_cnt += compute_lib_shaders_match_dispatch(match, origin_x, origin_y);
+    errors_cnt += compute_lib_shaders_match_read(match, &result);
+    double start = time_now_ms();
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        errors_cnt += compute_lib_shaders_match_dispatch(match, origin_x, origin_y);
+        errors_cnt += compute_lib_shaders_match_read(match, &result);
+    }
+    double gpu_ms = (time_now_ms() - start) / BENCHMARK_ITERATIONS;
+    errors_cnt += compute_lib_image2d_read(&(match->response_image2d), response);
+
+    start = time_now_ms();
+    match_reference(img_data, width, height, template_data, template_width, template_height, origin_x, origin_y, response_width, response_height, method, expected);
+    double cpu_ms = time_now_ms() - start;
+
+    // SSD is exact up to float rounding of the sum, NCC is rounded from exact integer moments
+    int errors = 0, best = 0;
+    for (int i = 0; i < response_width * response_height; i++) {
+        errors += (method == COMPUTE_LIB_SHADERS_MATCH_SSD) ? response[i] != (GLfloat) expected[i] : fabs(response[i] - expected[i]) > 1e-5;
+        if ((method == COMPUTE_LIB_SHADERS_MATCH_SSD) ? response[i] < response[best] : response[i] > response[best]) {
+            best = i;
+        }
+    }
+    int bx = best % response_width, by = best / response_width;
+    float expected_x = origin_x + bx, expected_y = origin_y + by;
+    if (bx > 0 && bx < response_width - 1) {
+        expected_x += peak_offset(response[best - 1], response[best], response[best + 1]);
+    }
+    if (by > 0 && by < response_height - 1) {
+        expected_y += peak_offset(response[best - response_width], response[best], response[best + response_width]);
+    }
+    errors += result.score != response[best] || fabsf(result.x - expected_x) > 1e-4f || fabsf(result.y - expected_y) > 1e-4f;
+    // the template cut from the image is found at its place (if it lies within the search window)
+    errors += fabsf(result.x - template_x) > 0.5f || fabsf(result.y - template_y) > 0.5f;
+    printf("%s %2dx%2d template, %3dx%3d window at (%4d, %4d): match (%8.3f, %8.3f) score %10.4f, GPU %7.3f ms, CPU %8.3f ms, %d errors\r\n",
+           (method == COMPUTE_LIB_SHADERS_MATCH_SSD) ? "SSD" : "NCC", template_width, template_height, search_width, search_height, origin_x, origin_y,
+           result.x, result.y, result.score, gpu_ms, cpu_ms, errors);
+
+    if (output_img_data != NULL) {
+        memset(output_img_data, 0, width * height * sizeof(rgba_t));
+        for (int y = 0; y < response_height && y < height; y++) {
+            for (int x = 0; x < response_width && x < width; x++) {
+                unsigned char value = (unsigned char) (127.5f + 127.5f * response[y * response_width + x]);
+                output_img_data[y * width + x] = (rgba_t) { value, value, value, 255 };
+            }
+        }
+    }
+
+    compute_lib_shaders_match_destroy(match);
+    free(template_data);
+    free(response);
+    free(expected);
+    return (errors_cnt != GL_NO_ERROR) ? -1 : errors;
+}
+
+/// Matches a Gaussian blob template against a blob at a sub-pixel position, the refined match must be close to it.
+static int test_match_subpixel(compute_lib_instance_t* inst, double blob_x, double blob_y)
+{
+    int template_size = 17, half = template_size / 2;
+    compute_lib_shaders_match_t* match;
+    if ((match = compute_lib_shaders_match_init(inst, LOCAL_SIZE_X, LOCAL_SIZE_Y, BLOB_IMAGE_SIZE, BLOB_IMAGE_SIZE, template_size, template_size, 48, 48, COMPUTE_LIB_SHADERS_MATCH_NCC)) == NULL) {
+        return -1;
+    }
+
+    rgba_t* img_data = (rgba_t*) malloc(BLOB_IMAGE_SIZE * BLOB_IMAGE_SIZE * sizeof(rgba_t));
+    rgba_t* template_data = (rgba_t*) malloc(template_size * template_size * sizeof(rgba_t));
+    for (int y = 0; y < BLOB_IMAGE_SIZE; y++) {
+        for (int x = 0; x < BLOB_IMAGE_SIZE; x++) {
+            double d2 = (x - blob_x) * (x - blob_x) + (y - blob_y) * (y - blob_y);
+            unsigned char value = (unsigned char) (20.0 + 220.0 * exp(-d2 / (2.0 * BLOB_SIGMA * BLOB_SIGMA)) + 0.5);
+            img_data[y * BLOB_IMAGE_SIZE + x] = (rgba_t) { value, value, value, 255 };
+        }
+    }
+    for (int y = 0; y < template_size; y++) {
+        for (int x = 0; x < template_size; x++) {
+            double d2 = (x - half) * (x - half) + (y - half) * (y - half);
+            unsigned char value = (unsigned char) (20.0 + 220.0 * exp(-d2 / (2.0 * BLOB_SIGMA * BLOB_SIGMA)) + 0.5);
+            template_data[y * template_size + x] = (rgba_t) { value, value, value, 255 };
+        }
+    }
+
+    compute_lib_shaders_match_result_t result;
+    GLuint errors_cnt = compute_lib_image2d_write(&(match->input_image2d), img_data);
+    errors_cnt += compute_lib_image2d_write(&(match->template_image2d), template_data);
+    errors_cnt += compute_lib_shaders_match_dispatch(match, (int) blob_x - 24, (int) blob_y - 24);
+    errors_cnt += compute_lib_shaders_match_read(match, &result);
+
+    double error_x = result.x + half - blob_x, error_y = result.y + half - blob_y;
+    int errors = fabs(error_x) > 0.15 || fabs(error_y) > 0.15;
+    printf("Blob at (%6.2f, %6.2f): refined match error (%6.3f, %6.3f) px, score %.4f, %d errors\r\n", blob_x, blob_y, error_x, error_y, result.score, errors);
+
+    compute_lib_shaders_match_destroy(match);
+    free(img_data);
+    free(template_data);
+    return (errors_cnt != GL_NO_ERROR) ? -1 : errors;
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <path to input image> <path to output image>\r\n", argv[0]);
+        return 1;
+    }
+
+    rgba_t* input_img_data;
+    int width, height;
+    printf("Loading image: %s\r\n", argv[1]);
+    if (!image_load(argv[1], &width, &height, 4, (unsigned char**) &input_img_data)) {
+        fprintf(stderr, "Failed to load image file!\r\n");
+        return 2;
+    }
+    printf("Loaded image with size %dx%d px.\r\n", width, height);
+
+    printf("Initializing compute library instance.\r\n");
+    compute_lib_instance_t inst = COMPUTE_LIB_INSTANCE_NEW("/dev/dri/renderD128");
+    if (compute_lib_init(&inst) != GL_NO_ERROR) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 3;
+    }
+
+    rgba_t* output_img_data = (rgba_t*) malloc(width * height * sizeof(rgba_t));
+    int tx = width / 2 + 13, ty = height / 2 - 7;
+    int errors = 0;
+    errors += test_match(&inst, input_img_data, width, height, tx, ty, 24, 20, tx - 37, ty - 29, 96, 80, COMPUTE_LIB_SHADERS_MATCH_SSD, NULL);
+    errors += test_match(&inst, input_img_data, width, height, tx, ty, 24, 20, tx - 37, ty - 29, 96, 80, COMPUTE_LIB_SHADERS_MATCH_NCC, NULL);
+    errors += test_match(&inst, input_img_data, width, height, tx, ty, 32, 32, tx - 100, ty - 90, 240, 200, COMPUTE_LIB_SHADERS_MATCH_NCC, NULL);
+    // search window partially outside of the image
+    errors += test_match(&inst, input_img_data, width, height, 3, 5, 15, 11, -20, -12, 64, 48, COMPUTE_LIB_SHADERS_MATCH_SSD, NULL);
+    errors += test_match(&inst, input_img_data, width, height, 3, 5, 15, 11, -20, -12, 64, 48, COMPUTE_LIB_SHADERS_MATCH_NCC, output_img_data);
+    if (errors != 0) {
+        fprintf(stderr, "Template matching test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 4;
+    }
+
+    errors += test_match_subpixel(&inst, 60.3, 50.7);
+    errors += test_match_subpixel(&inst, 71.75, 64.2);
+    if (errors != 0) {
+        fprintf(stderr, "Sub-pixel template matching test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 5;
+    }
+
+    printf("Writing output image: %s\r\n", argv[2]);
+    if (!image_save(argv[2], width, height, 4, (unsigned char*) output_img_data)) {
+        fprintf(stderr, "Failed to write image file!\r\n");
+        return 6;
+    }
+
+    compute_lib_deinit(&inst);
+    free(output_img_data);
+
+    printf("Program Done.\r\n");
+}
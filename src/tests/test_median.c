@@ -0,0 +1,199 @@
+/// \file test_median.c
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Test source file for GLES3ComputeLib library implementation of median and rank filters (output image is 5x5 median of the red channel with salt-and-pepper noise).
+/// \copyright GNU Public License.
+
+#include "shaders/median.h"
+#include "utils/image.h"
+#include "utils/timer.h"
+
+#define LOCAL_SIZE_X 16
+#define LOCAL_SIZE_Y 4
+
+#define NOISE_PERCENT 10
+
+static const char* method_names[] = { "auto", "network", "histogram" };
+
+
+static int compare_uint(const void* a, const void* b)
+{
+    GLuint x = *(const GLuint*) a, y = *(const GLuint*) b;
+    return (x > y) - (x < y);
+}
+
+/// Computes the rank filter on CPU (border is replicated).
+static void median_reference(const GLuint* src, GLuint* dst, int width, int height, int window_size, int rank)
+{
+    int span = (window_size - 1) / 2;
+    GLuint* window = (GLuint*) malloc(window_size * window_size * sizeof(GLuint));
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int i = 0;
+            for (int j = -span; j <= span; j++) {
+                for (int k = -span; k <= span; k++) {
+                    int px = x + k, py = y + j;
+                    px = (px < 0) ? 0 : ((px >= width) ? width - 1 : px);
+                    py = (py < 0) ? 0 : ((py >= height) ? height - 1 : py);
+                    window[i++] = src[py * width + px];
+                }
+            }
+            qsort(window, i, sizeof(GLuint), compare_uint);
+            dst[y * width + x] = window[rank];
+        }
+    }
+    free(window);
+}
+
+static int test_median(compute_lib_instance_t* inst, const GLuint* values, int width, int height, GLenum type, int window_size, int rank, GLenum method, GLuint* output_values)
+{
+    compute_lib_shaders_median_t* median;
+    if ((median = compute_lib_shaders_median_init_ex(inst, LOCAL_SIZE_X, LOCAL_SIZE_Y, width, height, type, window_size, rank, method)) == NULL) {
+        return -1;
+    }
+
+    // input is uploaded in its storage type
+    void* input_data = malloc(width * height * sizeof(GLushort));
+    for (int i = 0; i < width * height; i++) {
+        if (type == GL_UNSIGNED_BYTE) {
+            ((GLubyte*) input_data)[i] = (GLubyte) values[i];
+        } else {
+            ((GLushort*) input_data)[i] = (GLushort) values[i];
+        }
+    }
+
+    GLuint* result = (GLuint*) malloc(width * height * sizeof(GLuint));
+    GLuint* expected = (GLuint*) malloc(width * height * sizeof(GLuint));
+    GLuint errors_cnt = compute_lib_image2d_write(&(median->input_image2d), input_data);
+    errors_cnt += compute_lib_shaders_median_dispatch(median);
+    glFinish();
+    double start = time_now_ms();
+    errors_cnt += compute_lib_shaders_median_dispatch(median);
+    glFinish();
+    double gpu_ms = time_now_ms() - start;
+    errors_cnt += compute_lib_image2d_read(&(median->output_image2d), result);
+
+    median_reference(values, expected, width, height, window_size, median->rank);
+    int errors = 0;
+    for (int i = 0; i < width * height; i++) {
+        errors += result[i] != expected[i];
+    }
+    printf("%2d-bit %2dx%-2d rank %3d (%s): %8.3f ms, %d errors\r\n", (type == GL_UNSIGNED_BYTE) ? 8 : 16, window_size, window_size, median->rank, method_names[median->method], gpu_ms, errors);
+    if (output_values != NULL) {
+        memcpy(output_values, result, width * height * sizeof(GLuint));
+    }
+
+    compute_lib_shaders_median_destroy(median);
+    free(input_data);
+    free(result);
+    free(expected);
+    return (errors_cnt != GL_NO_ERROR) ? -1 : errors;
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <path to input image> <path to output image>\r\n", argv[0]);
+        return 1;
+    }
+
+    rgba_t* input_img_data;
+    int width, height;
+    printf("Loading image: %s\r\n", argv[1]);
+    if (!image_load(argv[1], &width, &height, 4, (unsigned char**) &input_img_data)) {
+        fprintf(stderr, "Failed to load image file!\r\n");
+        return 2;
+    }
+    printf("Loaded image with size %dx%d px.\r\n", width, height);
+
+    printf("Initializing compute library instance.\r\n");
+    compute_lib_instance_t inst = COMPUTE_LIB_INSTANCE_NEW("/dev/dri/renderD128");
+    if (compute_lib_init(&inst) != GL_NO_ERROR) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 3;
+    }
+
+    // red channel with salt-and-pepper noise, 16-bit values extend it by pseudo-random lower bits
+    GLuint* values8 = (GLuint*) malloc(width * height * sizeof(GLuint));
+    GLuint* values16 = (GLuint*) malloc(width * height * sizeof(GLuint));
+    for (int i = 0; i < width * height; i++) {
+        int noise = rand() % 100;
+        values8[i] = (noise < NOISE_PERCENT / 2) ? 0 : ((noise < NOISE_PERCENT) ? 255 : input_img_data[i].r);
+        values16[i] = (values8[i] << 8) | (rand() & 0xFF);
+    }
+
+    int errors = 0;
+    for (int window_size = 3; window_size <= 15; window_size += 2) {
+        if (window_size <= 7) {
+            errors += test_median(&inst, values8, width, height, GL_UNSIGNED_BYTE, window_size, -1, COMPUTE_LIB_SHADERS_MEDIAN_NETWORK, NULL);
+        }
+        errors += test_median(&inst, values8, width, height, GL_UNSIGNED_BYTE, window_size, -1, COMPUTE_LIB_SHADERS_MEDIAN_HISTOGRAM, NULL);
+    }
+    errors += test_median(&inst, values8, width, height, GL_UNSIGNED_BYTE, 5, 0, COMPUTE_LIB_SHADERS_MEDIAN_NETWORK, NULL);
+    errors += test_median(&inst, values8, width, height, GL_UNSIGNED_BYTE, 5, 24, COMPUTE_LIB_SHADERS_MEDIAN_NETWORK, NULL);
+    errors += test_median(&inst, values8, width, height, GL_UNSIGNED_BYTE, 9, 10, COMPUTE_LIB_SHADERS_MEDIAN_HISTOGRAM, NULL);
+    errors += test_median(&inst, values8, width, height, GL_UNSIGNED_BYTE, 9, 70, COMPUTE_LIB_SHADERS_MEDIAN_HISTOGRAM, NULL);
+    // work groups of the histogram method are clamped to fit into shared memory
+    compute_lib_shaders_median_t* clamped = compute_lib_shaders_median_init_ex(&inst, 16, 16, width, height, GL_UNSIGNED_BYTE, 9, -1, COMPUTE_LIB_SHADERS_MEDIAN_HISTOGRAM);
+    if (clamped == NULL || clamped->program.local_size_x != COMPUTE_LIB_SHADERS_MEDIAN_MAX_HISTOGRAM_LOCAL_SIZE) {
+        errors++;
+    }
+    if (clamped != NULL) {
+        compute_lib_shaders_median_destroy(clamped);
+    }
+    if (errors != 0) {
+        fprintf(stderr, "8-bit median test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 4;
+    }
+
+    for (int window_size = 3; window_size <= 15; window_size += 2) {
+        if (window_size <= 7) {
+            errors += test_median(&inst, values16, width, height, GL_UNSIGNED_SHORT, window_size, -1, COMPUTE_LIB_SHADERS_MEDIAN_NETWORK, NULL);
+        }
+        errors += test_median(&inst, values16, width, height, GL_UNSIGNED_SHORT, window_size, -1, COMPUTE_LIB_SHADERS_MEDIAN_HISTOGRAM, NULL);
+    }
+    errors += test_median(&inst, values16, width, height, GL_UNSIGNED_SHORT, 7, 3, COMPUTE_LIB_SHADERS_MEDIAN_NETWORK, NULL);
+    errors += test_median(&inst, values16, width, height, GL_UNSIGNED_SHORT, 9, 10, COMPUTE_LIB_SHADERS_MEDIAN_HISTOGRAM, NULL);
+    errors += test_median(&inst, values16, width, height, GL_UNSIGNED_SHORT, 15, 200, COMPUTE_LIB_SHADERS_MEDIAN_HISTOGRAM, NULL);
+    errors += test_median(&inst, values16, width, height, GL_UNSIGNED_SHORT, 15, -1, COMPUTE_LIB_SHADERS_MEDIAN_AUTO, NULL);
+    // two histogram levels halve the work group
+    clamped = compute_lib_shaders_median_init_ex(&inst, 16, 16, width, height, GL_UNSIGNED_SHORT, 9, -1, COMPUTE_LIB_SHADERS_MEDIAN_HISTOGRAM);
+    if (clamped == NULL || clamped->program.local_size_x != COMPUTE_LIB_SHADERS_MEDIAN_MAX_HISTOGRAM_LOCAL_SIZE / 2) {
+        errors++;
+    }
+    if (clamped != NULL) {
+        compute_lib_shaders_median_destroy(clamped);
+    }
+    if (errors != 0) {
+        fprintf(stderr, "16-bit median test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 5;
+    }
+
+    GLuint* output_values = (GLuint*) malloc(width * height * sizeof(GLuint));
+    if (test_median(&inst, values8, width, height, GL_UNSIGNED_BYTE, 5, -1, COMPUTE_LIB_SHADERS_MEDIAN_AUTO, output_values) != 0) {
+        fprintf(stderr, "Median test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 6;
+    }
+    rgba_t* output_img_data = (rgba_t*) calloc(width * height, sizeof(rgba_t));
+    for (int i = 0; i < width * height; i++) {
+        output_img_data[i] = (rgba_t) { output_values[i], output_values[i], output_values[i], 255 };
+    }
+
+    printf("Writing output image: %s\r\n", argv[2]);
+    if (!image_save(argv[2], width, height, 4, (unsigned char*) output_img_data)) {
+        fprintf(stderr, "Failed to write image file!\r\n");
+        return 7;
+    }
+
+    compute_lib_deinit(&inst);
+    free(values8);
+    free(values16);
+    free(output_values);
+    free(output_img_data);
+
+    printf("Program Done.\r\n");
+}
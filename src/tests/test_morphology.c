@@ -0,0 +1,225 @@
+/// \file test_morphology.c
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Test source file for GLES3ComputeLib library implementation of morphological operations (output image is the grey opening by disk mask).
+/// \copyright GNU Public License.
+
+#include "shaders/morphology.h"
+#include "utils/image.h"
+#include "utils/timer.h"
+
+#include <string.h>
+
+#define LOCAL_SIZE_X 16
+#define LOCAL_SIZE_Y 8
+
+#define BINARY_THRESHOLD 128
+#define DISK_SIZE 11
+
+static const char* op_names[] = { "erode", "dilate", "open", "close" };
+
+
+/// Erodes or dilates single channel image on CPU by the mask (pixels outside of the image are ignored, dilation uses the reflected mask).
+static void morphology_reference_apply(const unsigned char* src, unsigned char* dst, int width, int height, const GLubyte* mask, int mask_width, int mask_height, int dilate)
+{
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            unsigned char res = dilate ? 0 : 255;
+            for (int j = 0; j < mask_height; j++) {
+                for (int i = 0; i < mask_width; i++) {
+                    int sign = dilate ? -1 : 1;
+                    int px = x + sign * (i - (mask_width - 1) / 2), py = y + sign * (j - (mask_height - 1) / 2);
+                    if (mask[j * mask_width + i] == 0 || px < 0 || py < 0 || px >= width || py >= height) {
+                        continue;
+                    }
+                    unsigned char value = src[py * width + px];
+                    res = dilate ? (value > res ? value : res) : (value < res ? value : res);
+                }
+            }
+            dst[y * width + x] = res;
+        }
+    }
+}
+
+/// Rectangular masks are applied separably (row and column of ones), so that large elements are checked in reasonable time.
+static void morphology_reference_erode_dilate(const unsigned char* src, unsigned char* dst, int width, int height, const GLubyte* mask, int mask_width, int mask_height, int dilate)
+{
+    int rectangular = 1;
+    for (int i = 0; i < mask_width * mask_height; i++) {
+        rectangular &= mask[i] != 0;
+    }
+    if (!rectangular) {
+        morphology_reference_apply(src, dst, width, height, mask, mask_width, mask_height, dilate);
+        return;
+    }
+    unsigned char* temp = (unsigned char*) malloc(width * height);
+    morphology_reference_apply(src, temp, width, height, mask, mask_width, 1, dilate);
+    morphology_reference_apply(temp, dst, width, height, mask, 1, mask_height, dilate);
+    free(temp);
+}
+
+static void morphology_reference(const unsigned char* src, unsigned char* dst, int width, int height, const GLubyte* mask, int mask_width, int mask_height, GLenum op)
+{
+    unsigned char* temp = (unsigned char*) malloc(width * height);
+    switch (op) {
+        case COMPUTE_LIB_SHADERS_MORPHOLOGY_ERODE:
+        case COMPUTE_LIB_SHADERS_MORPHOLOGY_DILATE:
+            morphology_reference_erode_dilate(src, dst, width, height, mask, mask_width, mask_height, op == COMPUTE_LIB_SHADERS_MORPHOLOGY_DILATE);
+            break;
+        default:
+            morphology_reference_erode_dilate(src, temp, width, height, mask, mask_width, mask_height, op == COMPUTE_LIB_SHADERS_MORPHOLOGY_CLOSE);
+            morphology_reference_erode_dilate(temp, dst, width, height, mask, mask_width, mask_height, op == COMPUTE_LIB_SHADERS_MORPHOLOGY_OPEN);
+            break;
+    }
+    free(temp);
+}
+
+/// Runs the operation on GPU and compares the red channel (grey) or unpacked bits (binary) with CPU reference.
+static int test_morphology(compute_lib_instance_t* inst, rgba_t* img_data, int width, int height, GLboolean binary, GLenum op, const GLubyte* mask, int mask_width, int mask_height, GLboolean use_mask,
+                           rgba_t* output_img_data)
+{
+    compute_lib_shaders_morphology_t* morphology;
+    if (use_mask) {
+        morphology = compute_lib_shaders_morphology_init_mask(inst, LOCAL_SIZE_X, LOCAL_SIZE_Y, width, height, binary, op, mask, mask_width, mask_height);
+    } else {
+        morphology = compute_lib_shaders_morphology_init(inst, LOCAL_SIZE_X, LOCAL_SIZE_Y, width, height, binary, op, mask_width, mask_height);
+    }
+    if (morphology == NULL) {
+        return -1;
+    }
+
+    unsigned char* src = (unsigned char*) malloc(width * height);
+    unsigned char* expected = (unsigned char*) malloc(width * height);
+    rgba_t* result = (rgba_t*) malloc(width * height * sizeof(rgba_t));
+    for (int i = 0; i < width * height; i++) {
+        src[i] = binary ? ((img_data[i].r >= BINARY_THRESHOLD) ? 255 : 0) : img_data[i].r;
+    }
+    morphology_reference(src, expected, width, height, mask, mask_width, mask_height, op);
+
+    GLuint errors_cnt;
+    double start = time_now_ms();
+    if (binary) {
+        errors_cnt = compute_lib_image2d_write(&(morphology->rgba_image2d), img_data);
+        errors_cnt += compute_lib_shaders_morphology_pack(morphology, BINARY_THRESHOLD);
+        // warm-up run, then the timed one
+        errors_cnt += compute_lib_shaders_morphology_dispatch(morphology);
+        glFinish();
+        start = time_now_ms();
+        errors_cnt += compute_lib_shaders_morphology_dispatch(morphology);
+        glFinish();
+        double gpu_ms = time_now_ms() - start;
+        errors_cnt += compute_lib_shaders_morphology_unpack(morphology);
+        errors_cnt += compute_lib_image2d_read(&(morphology->rgba_image2d), result);
+        printf("Binary %s %dx%d %s: %.3f ms, ", op_names[op], mask_width, mask_height, use_mask ? "mask" : "rectangle", gpu_ms);
+    } else {
+        errors_cnt = compute_lib_image2d_write(&(morphology->input_image2d), img_data);
+        errors_cnt += compute_lib_shaders_morphology_dispatch(morphology);
+        glFinish();
+        start = time_now_ms();
+        errors_cnt += compute_lib_shaders_morphology_dispatch(morphology);
+        glFinish();
+        double gpu_ms = time_now_ms() - start;
+        errors_cnt += compute_lib_image2d_read(&(morphology->output_image2d), result);
+        printf("Grey %s %dx%d %s: %.3f ms, ", op_names[op], mask_width, mask_height, use_mask ? "mask" : "rectangle", gpu_ms);
+    }
+
+    int errors = 0;
+    for (int i = 0; i < width * height; i++) {
+        errors += result[i].r != expected[i];
+    }
+    printf("%d errors\r\n", errors);
+    if (output_img_data != NULL) {
+        memcpy(output_img_data, result, width * height * sizeof(rgba_t));
+    }
+
+    compute_lib_shaders_morphology_destroy(morphology);
+    free(src);
+    free(expected);
+    free(result);
+    return (errors_cnt != GL_NO_ERROR) ? -1 : errors;
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <path to input image> <path to output image>\r\n", argv[0]);
+        return 1;
+    }
+
+    rgba_t* input_img_data;
+    int width, height;
+    printf("Loading image: %s\r\n", argv[1]);
+    if (!image_load(argv[1], &width, &height, 4, (unsigned char**) &input_img_data)) {
+        fprintf(stderr, "Failed to load image file!\r\n");
+        return 2;
+    }
+    printf("Loaded image with size %dx%d px.\r\n", width, height);
+
+    printf("Initializing compute library instance.\r\n");
+    compute_lib_instance_t inst = COMPUTE_LIB_INSTANCE_NEW("/dev/dri/renderD128");
+    if (compute_lib_init(&inst) != GL_NO_ERROR) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 3;
+    }
+
+    static const int rect_sizes[][2] = { { 3, 3 }, { 15, 7 }, { 31, 31 }, { 101, 101 } };
+    for (int binary = 0; binary <= 1; binary++) {
+        for (int s = 0; s < (int) (sizeof(rect_sizes) / sizeof(rect_sizes[0])); s++) {
+            int mask_width = rect_sizes[s][0], mask_height = rect_sizes[s][1];
+            GLubyte* mask = (GLubyte*) malloc(mask_width * mask_height);
+            memset(mask, 1, mask_width * mask_height);
+            for (GLenum op = COMPUTE_LIB_SHADERS_MORPHOLOGY_ERODE; op <= COMPUTE_LIB_SHADERS_MORPHOLOGY_CLOSE; op++) {
+                if (test_morphology(&inst, input_img_data, width, height, binary, op, mask, mask_width, mask_height, GL_FALSE, NULL) != 0) {
+                    fprintf(stderr, "Morphology with rectangular element failed!\r\n");
+                    compute_lib_error_queue_flush(&inst, stderr);
+                    return 4;
+                }
+            }
+            free(mask);
+        }
+    }
+
+    GLubyte disk[DISK_SIZE * DISK_SIZE];
+    for (int y = 0; y < DISK_SIZE; y++) {
+        for (int x = 0; x < DISK_SIZE; x++) {
+            int dx = x - DISK_SIZE / 2, dy = y - DISK_SIZE / 2;
+            disk[y * DISK_SIZE + x] = dx * dx + dy * dy <= (DISK_SIZE / 2) * (DISK_SIZE / 2);
+        }
+    }
+    rgba_t* output_img_data = (rgba_t*) calloc(width * height, sizeof(rgba_t));
+    for (GLenum op = COMPUTE_LIB_SHADERS_MORPHOLOGY_ERODE; op <= COMPUTE_LIB_SHADERS_MORPHOLOGY_CLOSE; op++) {
+        if (test_morphology(&inst, input_img_data, width, height, GL_TRUE, op, disk, DISK_SIZE, DISK_SIZE, GL_TRUE, NULL) != 0 ||
+                test_morphology(&inst, input_img_data, width, height, GL_FALSE, op, disk, DISK_SIZE, DISK_SIZE, GL_TRUE, (op == COMPUTE_LIB_SHADERS_MORPHOLOGY_OPEN) ? output_img_data : NULL) != 0) {
+            fprintf(stderr, "Morphology with mask failed!\r\n");
+            compute_lib_error_queue_flush(&inst, stderr);
+            return 5;
+        }
+    }
+
+    // asymmetric mask (anchor at the corner of the L-shape, even width), dilation must use the reflected mask
+    static const GLubyte corner[3 * 4] = {
+        1, 1, 1, 1,
+        0, 1, 0, 0,
+        0, 1, 0, 0
+    };
+    for (GLenum op = COMPUTE_LIB_SHADERS_MORPHOLOGY_ERODE; op <= COMPUTE_LIB_SHADERS_MORPHOLOGY_CLOSE; op++) {
+        if (test_morphology(&inst, input_img_data, width, height, GL_TRUE, op, corner, 4, 3, GL_TRUE, NULL) != 0 ||
+                test_morphology(&inst, input_img_data, width, height, GL_FALSE, op, corner, 4, 3, GL_TRUE, NULL) != 0) {
+            fprintf(stderr, "Morphology with asymmetric mask failed!\r\n");
+            compute_lib_error_queue_flush(&inst, stderr);
+            return 5;
+        }
+    }
+
+    printf("Writing output image: %s\r\n", argv[2]);
+    if (!image_save(argv[2], width, height, 4, (unsigned char*) output_img_data)) {
+        fprintf(stderr, "Failed to write image file!\r\n");
+        return 6;
+    }
+
+    compute_lib_deinit(&inst);
+    free(output_img_data);
+
+    printf("Program Done.\r\n");
+}
@@ -0,0 +1,165 @@
+/// \file test_pyramid.c
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Test source file for GLES3ComputeLib library implementation of image pyramids (output image contains all levels of the Gaussian pyramid).
+/// \copyright GNU Public License.
+
+#include "shaders/pyramid.h"
+#include "utils/image.h"
+
+#include <math.h>
+#include <string.h>
+
+#define LOCAL_SIZE_X 16
+#define LOCAL_SIZE_Y 16
+
+static const float gaussian_weights[5] = { 1, 4, 6, 4, 1 };
+
+
+static inline int clamp_int(int value, int max)
+{
+    return (value < 0) ? 0 : ((value > max) ? max : value);
+}
+
+/// Computes one pixel component of the coarser level on CPU.
+static float pyramid_reference(const float* src, int width, int height, int x, int y, int c, GLenum method)
+{
+    float res = 0.0f;
+    if (method == COMPUTE_LIB_SHADERS_PYRAMID_GAUSSIAN) {
+        for (int j = -2; j <= 2; j++) {
+            for (int i = -2; i <= 2; i++) {
+                int px = clamp_int(2 * x + i, width - 1), py = clamp_int(2 * y + j, height - 1);
+                res += gaussian_weights[i + 2] * gaussian_weights[j + 2] * src[4 * (py * width + px) + c];
+            }
+        }
+        return res / 256.0f;
+    }
+    for (int j = 0; j <= 1; j++) {
+        for (int i = 0; i <= 1; i++) {
+            int px = clamp_int(2 * x + i, width - 1), py = clamp_int(2 * y + j, height - 1);
+            res += src[4 * (py * width + px) + c];
+        }
+    }
+    return res / 4.0f;
+}
+
+/// Builds the pyramid on GPU and checks each level against CPU downsampling of the previous GPU level.
+/// The levels of the 8-bit pyramid are copied into the output image (level 0 on the left, coarser levels stacked on the right).
+static int test_pyramid(compute_lib_instance_t* inst, rgba_t* img_data, int width, int height, GLenum type, GLenum method, rgba_t* output_img_data)
+{
+    compute_lib_shaders_pyramid_t* pyramid;
+    if ((pyramid = compute_lib_shaders_pyramid_init(inst, LOCAL_SIZE_X, LOCAL_SIZE_Y, width, height, type, method, 0)) == NULL) {
+        return -1;
+    }
+
+    GLuint errors_cnt = 0;
+    float* levels[2] = { (float*) malloc(width * height * 4 * sizeof(float)), (float*) malloc(width * height * 4 * sizeof(float)) };
+    unsigned char* level_data = (unsigned char*) malloc(width * height * 4 * sizeof(float));
+    if (type == GL_FLOAT) {
+        for (int i = 0; i < 4 * width * height; i++) {
+            levels[0][i] = ((unsigned char*) img_data)[i] / 255.0f;
+        }
+        errors_cnt += compute_lib_image2d_write(&(pyramid->image2d), levels[0]);
+    } else {
+        for (int i = 0; i < 4 * width * height; i++) {
+            levels[0][i] = ((unsigned char*) img_data)[i];
+        }
+        errors_cnt += compute_lib_image2d_write(&(pyramid->image2d), img_data);
+    }
+    errors_cnt += compute_lib_shaders_pyramid_dispatch(pyramid);
+
+    float tolerance = (type == GL_FLOAT) ? 1e-5f : 1.0f;
+    float max_error = 0.0f;
+    int errors = 0, offset_y = 0;
+    for (int level = 1; level < pyramid->num_levels; level++) {
+        GLsizei prev_width, prev_height, level_width, level_height;
+        compute_lib_image2d_level_size(&(pyramid->image2d), level - 1, &prev_width, &prev_height);
+        compute_lib_image2d_level_size(&(pyramid->image2d), level, &level_width, &level_height);
+        errors_cnt += compute_lib_image2d_read_level(&(pyramid->image2d), level, level_data);
+
+        float* prev = levels[(level - 1) & 1];
+        float* curr = levels[level & 1];
+        for (int i = 0; i < 4 * level_width * level_height; i++) {
+            curr[i] = (type == GL_FLOAT) ? ((float*) level_data)[i] : level_data[i];
+            int p = i / 4;
+            float error = fabsf(curr[i] - pyramid_reference(prev, prev_width, prev_height, p % level_width, p / level_width, i % 4, method));
+            max_error = (error > max_error) ? error : max_error;
+            errors += error > tolerance;
+        }
+
+        if (output_img_data != NULL) {
+            for (int y = 0; y < level_height; y++) {
+                memcpy(&output_img_data[(offset_y + y) * (width + width / 2) + width], &level_data[4 * y * level_width], 4 * level_width);
+            }
+            offset_y += level_height;
+        }
+    }
+    printf("%s pyramid (%s) with %d levels: max. error %g, %d errors\r\n", (method == COMPUTE_LIB_SHADERS_PYRAMID_GAUSSIAN) ? "Gaussian" : "Box", (type == GL_FLOAT) ? "RGBA32F" : "RGBA8", pyramid->num_levels, max_error, errors);
+
+    if (output_img_data != NULL) {
+        for (int y = 0; y < height; y++) {
+            memcpy(&output_img_data[y * (width + width / 2)], &img_data[y * width], 4 * width);
+        }
+    }
+
+    compute_lib_shaders_pyramid_destroy(pyramid);
+    free(levels[0]);
+    free(levels[1]);
+    free(level_data);
+    return (errors_cnt != GL_NO_ERROR) ? -1 : errors;
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <path to input image> <path to output image>\r\n", argv[0]);
+        return 1;
+    }
+
+    rgba_t* input_img_data;
+    int width, height;
+    printf("Loading image: %s\r\n", argv[1]);
+    if (!image_load(argv[1], &width, &height, 4, (unsigned char**) &input_img_data)) {
+        fprintf(stderr, "Failed to load image file!\r\n");
+        return 2;
+    }
+    printf("Loaded image with size %dx%d px.\r\n", width, height);
+
+    printf("Initializing compute library instance.\r\n");
+    compute_lib_instance_t inst = COMPUTE_LIB_INSTANCE_NEW("/dev/dri/renderD128");
+    if (compute_lib_init(&inst) != GL_NO_ERROR) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 3;
+    }
+
+    int output_width = width + width / 2;
+    rgba_t* output_img_data = (rgba_t*) calloc(output_width * height, sizeof(rgba_t));
+    if (test_pyramid(&inst, input_img_data, width, height, GL_UNSIGNED_BYTE, COMPUTE_LIB_SHADERS_PYRAMID_GAUSSIAN, output_img_data) != 0) {
+        fprintf(stderr, "Gaussian pyramid test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 4;
+    }
+    if (test_pyramid(&inst, input_img_data, width, height, GL_UNSIGNED_BYTE, COMPUTE_LIB_SHADERS_PYRAMID_BOX, NULL) != 0) {
+        fprintf(stderr, "Box pyramid test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 5;
+    }
+    if (test_pyramid(&inst, input_img_data, width, height, GL_FLOAT, COMPUTE_LIB_SHADERS_PYRAMID_GAUSSIAN, NULL) != 0 ||
+            test_pyramid(&inst, input_img_data, width, height, GL_FLOAT, COMPUTE_LIB_SHADERS_PYRAMID_BOX, NULL) != 0) {
+        fprintf(stderr, "Float pyramid test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 6;
+    }
+
+    printf("Writing output image: %s\r\n", argv[2]);
+    if (!image_save(argv[2], output_width, height, 4, (unsigned char*) output_img_data)) {
+        fprintf(stderr, "Failed to write image file!\r\n");
+        return 7;
+    }
+
+    compute_lib_deinit(&inst);
+    free(output_img_data);
+
+    printf("Program Done.\r\n");
+}
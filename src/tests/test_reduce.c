@@ -0,0 +1,218 @@
+/// \file test_reduce.c
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Test source file for GLES3ComputeLib library implementation of parallel reductions (sum, min/argmin, max/argmax).
+/// \copyright GNU Public License.
+
+#include "shaders/reduce.h"
+#include "utils/image.h"
+
+#include <math.h>
+#include <string.h>
+
+#define LOCAL_SIZE 256
+
+#define SSBO_LENGTH 10000000
+// half-size of the crosses marking argmin/argmax in the output image
+#define MARKER_SPAN 6
+
+
+/// Draws a cross of the given colour centred at the pixel index.
+static void draw_marker(rgba_t* img_data, int width, int height, GLuint index, rgba_t color)
+{
+    int cx = index % width, cy = index / width;
+    for (int d = -MARKER_SPAN; d <= MARKER_SPAN; d++) {
+        if (cx + d >= 0 && cx + d < width) img_data[cy * width + cx + d] = color;
+        if (cy + d >= 0 && cy + d < height) img_data[(cy + d) * width + cx] = color;
+    }
+}
+
+/// Reduces red channel of the image by all operators and compares the results with CPU, GPU argmin (blue) and argmax (green) are marked in the output image.
+static int test_reduce_image2d(compute_lib_instance_t* inst, rgba_t* img_data, int width, int height, rgba_t* output_img_data)
+{
+    compute_lib_image2d_t image2d = COMPUTE_LIB_IMAGE2D_NEW("image2d", GL_TEXTURE0, width, height, GL_READ_ONLY, 4, GL_UNSIGNED_BYTE);
+    image2d.resource.value = 0;
+    compute_lib_image2d_setup_format(&image2d);
+    if (compute_lib_image2d_init(&image2d, 0) != GL_NO_ERROR || compute_lib_image2d_write(&image2d, img_data) != GL_NO_ERROR) {
+        return 1;
+    }
+
+    GLuint ref_sum = 0, ref_min = 255, ref_max = 0, ref_argmin = 0, ref_argmax = 0;
+    for (int i = 0; i < width * height; i++) {
+        ref_sum += img_data[i].r;
+        if (img_data[i].r < ref_min) { ref_min = img_data[i].r; ref_argmin = i; }
+        if (img_data[i].r > ref_max) { ref_max = img_data[i].r; ref_argmax = i; }
+    }
+    GLuint ref_values[3] = { ref_sum, ref_min, ref_max };
+    GLuint ref_indices[3] = { 0, ref_argmin, ref_argmax };
+
+    int failures = 0;
+    for (GLenum op = COMPUTE_LIB_SHADERS_REDUCE_SUM; op <= COMPUTE_LIB_SHADERS_REDUCE_MAX; op++) {
+        compute_lib_shaders_reduce_t* reduce;
+        if ((reduce = compute_lib_shaders_reduce_init(inst, LOCAL_SIZE, op, &image2d, NULL, width * height)) == NULL) {
+            compute_lib_image2d_destroy(&image2d);
+            return 1;
+        }
+        GLuint value = 0, index = 0;
+        compute_lib_shaders_reduce_image2d(reduce, &image2d);
+        compute_lib_shaders_reduce_read(reduce, &value, &index);
+        printf("Image %dx%d op %d: GPU value %u (index %u), CPU value %u (index %u)\r\n", width, height, op, value, index, ref_values[op], ref_indices[op]);
+        failures += value != ref_values[op] || (op != COMPUTE_LIB_SHADERS_REDUCE_SUM && index != ref_indices[op]);
+        if (op != COMPUTE_LIB_SHADERS_REDUCE_SUM && index < (GLuint) (width * height)) {
+            draw_marker(output_img_data, width, height, index, (op == COMPUTE_LIB_SHADERS_REDUCE_MIN) ? (rgba_t) { 0, 0, 255, 255 } : (rgba_t) { 0, 255, 0, 255 });
+        }
+        compute_lib_shaders_reduce_destroy(reduce);
+    }
+
+    compute_lib_image2d_destroy(&image2d);
+    return failures;
+}
+
+/// Reduces red channel of a float copy of the image (values scaled to [0, 1]) by all operators and compares the results with CPU.
+static int test_reduce_float_image2d(compute_lib_instance_t* inst, rgba_t* img_data, int width, int height)
+{
+    GLfloat* float_data = (GLfloat*) malloc(4 * width * height * sizeof(GLfloat));
+    double ref_sum = 0.0;
+    GLfloat ref_min = INFINITY, ref_max = -INFINITY;
+    GLuint ref_argmin = 0, ref_argmax = 0;
+    for (int i = 0; i < width * height; i++) {
+        // fractional offset makes the extremes unique
+        float_data[4 * i] = img_data[i].r / 255.0f + (i % 1000) * 1e-7f;
+        float_data[4 * i + 1] = float_data[4 * i + 2] = float_data[4 * i + 3] = 0.0f;
+        ref_sum += float_data[4 * i];
+        if (float_data[4 * i] < ref_min) { ref_min = float_data[4 * i]; ref_argmin = i; }
+        if (float_data[4 * i] > ref_max) { ref_max = float_data[4 * i]; ref_argmax = i; }
+    }
+
+    compute_lib_image2d_t image2d = COMPUTE_LIB_IMAGE2D_NEW("image2d", GL_TEXTURE0, width, height, GL_READ_ONLY, 4, GL_FLOAT);
+    image2d.resource.value = 0;
+    compute_lib_image2d_setup_format(&image2d);
+    if (compute_lib_image2d_init(&image2d, 0) != GL_NO_ERROR || compute_lib_image2d_write(&image2d, float_data) != GL_NO_ERROR) {
+        free(float_data);
+        return 1;
+    }
+
+    double ref_values[3] = { ref_sum, ref_min, ref_max };
+    GLuint ref_indices[3] = { 0, ref_argmin, ref_argmax };
+
+    int failures = 0;
+    for (GLenum op = COMPUTE_LIB_SHADERS_REDUCE_SUM; op <= COMPUTE_LIB_SHADERS_REDUCE_MAX; op++) {
+        compute_lib_shaders_reduce_t* reduce;
+        if ((reduce = compute_lib_shaders_reduce_init(inst, LOCAL_SIZE, op, &image2d, NULL, width * height)) == NULL) {
+            compute_lib_image2d_destroy(&image2d);
+            free(float_data);
+            return 1;
+        }
+        GLfloat value = 0.0f;
+        GLuint index = 0;
+        compute_lib_shaders_reduce_image2d(reduce, &image2d);
+        compute_lib_shaders_reduce_read(reduce, &value, &index);
+        printf("Float image %dx%d op %d: GPU value %f (index %u), CPU value %f (index %u)\r\n", width, height, op, value, index, ref_values[op], ref_indices[op]);
+        if (op == COMPUTE_LIB_SHADERS_REDUCE_SUM) {
+            failures += fabs(value - ref_sum) / ref_sum > 1e-5;
+        } else {
+            failures += value != (GLfloat) ref_values[op] || index != ref_indices[op];
+        }
+        compute_lib_shaders_reduce_destroy(reduce);
+    }
+
+    compute_lib_image2d_destroy(&image2d);
+    free(float_data);
+    return failures;
+}
+
+/// Reduces large float and int SSBOs (several passes) and compares the results with CPU.
+static int test_reduce_ssbo(compute_lib_instance_t* inst)
+{
+    GLfloat* float_data = (GLfloat*) malloc(SSBO_LENGTH * sizeof(GLfloat));
+    GLint* int_data = (GLint*) malloc(SSBO_LENGTH * sizeof(GLint));
+    double ref_float_sum = 0.0;
+    GLint ref_int_min = INT32_MAX;
+    GLuint ref_int_argmin = 0;
+    for (int i = 0; i < SSBO_LENGTH; i++) {
+        float_data[i] = (float) rand() / RAND_MAX;
+        int_data[i] = rand() - RAND_MAX / 2;
+        ref_float_sum += float_data[i];
+        if (int_data[i] < ref_int_min) { ref_int_min = int_data[i]; ref_int_argmin = i; }
+    }
+
+    compute_lib_ssbo_t float_ssbo = COMPUTE_LIB_SSBO_NEW("float_ssbo", GL_FLOAT, GL_STATIC_DRAW);
+    compute_lib_ssbo_t int_ssbo = COMPUTE_LIB_SSBO_NEW("int_ssbo", GL_INT, GL_STATIC_DRAW);
+    compute_lib_shaders_reduce_t* float_sum = NULL;
+    compute_lib_shaders_reduce_t* int_min = NULL;
+    int failures = 1;
+    if (compute_lib_ssbo_init(&float_ssbo, float_data, SSBO_LENGTH) == GL_NO_ERROR && compute_lib_ssbo_init(&int_ssbo, int_data, SSBO_LENGTH) == GL_NO_ERROR &&
+            (float_sum = compute_lib_shaders_reduce_init(inst, LOCAL_SIZE, COMPUTE_LIB_SHADERS_REDUCE_SUM, NULL, &float_ssbo, SSBO_LENGTH)) != NULL &&
+            (int_min = compute_lib_shaders_reduce_init(inst, LOCAL_SIZE, COMPUTE_LIB_SHADERS_REDUCE_MIN, NULL, &int_ssbo, SSBO_LENGTH)) != NULL) {
+        GLfloat sum = 0.0f;
+        GLint min = 0;
+        GLuint argmin = 0;
+        compute_lib_shaders_reduce_ssbo(float_sum, &float_ssbo, SSBO_LENGTH);
+        compute_lib_shaders_reduce_read(float_sum, &sum, NULL);
+        compute_lib_shaders_reduce_ssbo(int_min, &int_ssbo, SSBO_LENGTH);
+        compute_lib_shaders_reduce_read(int_min, &min, &argmin);
+        printf("Float SSBO of %d elements: GPU sum %f, CPU sum %f (relative error %g)\r\n", SSBO_LENGTH, sum, ref_float_sum, fabs(sum - ref_float_sum) / ref_float_sum);
+        printf("Int SSBO of %d elements: GPU min %d (index %u), CPU min %d (index %u)\r\n", SSBO_LENGTH, min, argmin, ref_int_min, ref_int_argmin);
+        failures = (fabs(sum - ref_float_sum) / ref_float_sum > 1e-5) + (min != ref_int_min || argmin != ref_int_argmin);
+    }
+
+    if (float_sum != NULL) compute_lib_shaders_reduce_destroy(float_sum);
+    if (int_min != NULL) compute_lib_shaders_reduce_destroy(int_min);
+    compute_lib_ssbo_destroy(&float_ssbo);
+    compute_lib_ssbo_destroy(&int_ssbo);
+    free(float_data);
+    free(int_data);
+    return failures;
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <path to input image> <path to output image>\r\n", argv[0]);
+        return 1;
+    }
+
+    rgba_t* input_img_data;
+    int width, height;
+    printf("Loading image: %s\r\n", argv[1]);
+    if (!image_load(argv[1], &width, &height, 4, (unsigned char**) &input_img_data)) {
+        fprintf(stderr, "Failed to load image file!\r\n");
+        return 2;
+    }
+    printf("Loaded image with size %dx%d px.\r\n", width, height);
+
+    printf("Initializing compute library instance.\r\n");
+    compute_lib_instance_t inst = COMPUTE_LIB_INSTANCE_NEW("/dev/dri/renderD128");
+    if (compute_lib_init(&inst) != GL_NO_ERROR) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 3;
+    }
+
+    printf("Running image reductions.\r\n");
+    rgba_t* output_img_data = (rgba_t*) malloc(width * height * sizeof(rgba_t));
+    memcpy(output_img_data, input_img_data, width * height * sizeof(rgba_t));
+    if (test_reduce_image2d(&inst, input_img_data, width, height, output_img_data) != 0 || test_reduce_float_image2d(&inst, input_img_data, width, height) != 0) {
+        fprintf(stderr, "Image reduction test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 4;
+    }
+
+    printf("Running SSBO reductions.\r\n");
+    if (test_reduce_ssbo(&inst) != 0) {
+        fprintf(stderr, "SSBO reduction test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 5;
+    }
+
+    printf("Writing output image: %s\r\n", argv[2]);
+    if (!image_save(argv[2], width, height, 4, (unsigned char*) output_img_data)) {
+        fprintf(stderr, "Failed to write image file!\r\n");
+        return 6;
+    }
+
+    compute_lib_deinit(&inst);
+    free(output_img_data);
+
+    printf("Program Done.\r\n");
+}
@@ -0,0 +1,160 @@
+/// \file test_remap.c
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Test source file for GLES3ComputeLib library implementation of image remapping (output image is the input undistorted by a synthetic camera model).
+/// \copyright GNU Public License.
+
+#include "shaders/remap.h"
+#include "utils/image.h"
+#include "utils/timer.h"
+
+#include <math.h>
+
+#define LOCAL_SIZE_X 16
+#define LOCAL_SIZE_Y 16
+
+/// Maximum fraction of output components above the tolerance, the map is evaluated in the same precision on both sides,
+/// but the sampler may weight texels with fewer fractional bits than the CPU bilinear interpolation.
+#define MAX_MISMATCH_RATIO 1e-3
+
+
+static inline float input_value(rgba_t* img_data, int width, int height, int x, int y, int c, const float* border)
+{
+    if (x < 0 || y < 0 || x >= width || y >= height) {
+        return border[c] * 255.0f;
+    }
+    return ((unsigned char*) &img_data[y * width + x])[c];
+}
+
+/// Computes one component of the remapped image on CPU.
+static float remap_reference(rgba_t* img_data, int width, int height, float fx, float fy, int c, GLenum method, const float* border)
+{
+    if (method == COMPUTE_LIB_SHADERS_WARP_NEAREST) {
+        return input_value(img_data, width, height, (int) floorf(fx + 0.5f), (int) floorf(fy + 0.5f), c, border);
+    }
+    if (fx <= -1.0f || fy <= -1.0f || fx >= width || fy >= height) {
+        return border[c] * 255.0f;
+    }
+    int x0 = (int) floorf(fx), y0 = (int) floorf(fy);
+    float ax = fx - x0, ay = fy - y0;
+    float top = input_value(img_data, width, height, x0, y0, c, border) * (1 - ax) + input_value(img_data, width, height, x0 + 1, y0, c, border) * ax;
+    float bottom = input_value(img_data, width, height, x0, y0 + 1, c, border) * (1 - ax) + input_value(img_data, width, height, x0 + 1, y0 + 1, c, border) * ax;
+    return top * (1 - ay) + bottom * ay;
+}
+
+/// Undistorts the image by the cached map, compares the result with CPU remap of the same (quantised) map.
+static int test_remap(compute_lib_instance_t* inst, rgba_t* img_data, int width, int height, const compute_lib_shaders_remap_camera_t* camera, GLenum map_type, GLenum method, float tolerance, rgba_t* output_img_data)
+{
+    compute_lib_shaders_remap_t* remap;
+    if ((remap = compute_lib_shaders_remap_init(inst, LOCAL_SIZE_X, LOCAL_SIZE_Y, width, height, width, height, GL_UNSIGNED_BYTE, map_type, method)) == NULL) {
+        return 1;
+    }
+
+    const float border[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    double start = time_now_ms();
+    GLuint errors_cnt = compute_lib_shaders_remap_init_undistort(remap, camera, NULL);
+    double map_ms = time_now_ms() - start;
+    unsigned char* output_data = (unsigned char*) malloc(width * height * 4);
+    errors_cnt += compute_lib_image2d_write(&(remap->input_image2d), img_data);
+    errors_cnt += compute_lib_shaders_remap_dispatch(remap, border);
+    glFinish();
+    start = time_now_ms();
+    errors_cnt += compute_lib_shaders_remap_dispatch(remap, border);
+    glFinish();
+    double remap_ms = time_now_ms() - start;
+    errors_cnt += compute_lib_image2d_read(&(remap->output_image2d), output_data);
+    if (errors_cnt != GL_NO_ERROR) {
+        compute_lib_shaders_remap_destroy(remap);
+        free(output_data);
+        return 1;
+    }
+
+    float* map = (float*) malloc(2 * width * height * sizeof(float));
+    compute_lib_shaders_remap_undistort_map(camera, NULL, width, height, map);
+    float scale = 1 << COMPUTE_LIB_SHADERS_REMAP_FIXED_POINT_BITS;
+    int mismatches = 0;
+    float max_error = 0.0f;
+    for (int i = 0; i < 4 * width * height; i++) {
+        int p = i / 4;
+        float fx = map[2 * p], fy = map[2 * p + 1];
+        if (map_type == GL_SHORT) {
+            fx = floorf(fx * scale + 0.5f) / scale;
+            fy = floorf(fy * scale + 0.5f) / scale;
+        }
+        float error = fabsf(output_data[i] - remap_reference(img_data, width, height, fx, fy, i % 4, method, border));
+        max_error = fmaxf(error, max_error);
+        mismatches += error > tolerance;
+    }
+    if (output_img_data != NULL) {
+        memcpy(output_img_data, output_data, width * height * 4);
+    }
+
+    printf("Remap %s map (%s): map built in %.3f ms, remap %.3f ms, max. error %g, %d of %d components above tolerance\r\n", (map_type == GL_FLOAT) ? "RG32F" : "RG16I",
+           (method == COMPUTE_LIB_SHADERS_WARP_NEAREST) ? "nearest" : "bilinear", map_ms, remap_ms, max_error, mismatches, 4 * width * height);
+
+    compute_lib_shaders_remap_destroy(remap);
+    free(output_data);
+    free(map);
+    return mismatches > 4 * width * height * MAX_MISMATCH_RATIO;
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <path to input image> <path to output image>\r\n", argv[0]);
+        return 1;
+    }
+
+    rgba_t* input_img_data;
+    int width, height;
+    printf("Loading image: %s\r\n", argv[1]);
+    if (!image_load(argv[1], &width, &height, 4, (unsigned char**) &input_img_data)) {
+        fprintf(stderr, "Failed to load image file!\r\n");
+        return 2;
+    }
+    printf("Loaded image with size %dx%d px.\r\n", width, height);
+
+    printf("Initializing compute library instance.\r\n");
+    compute_lib_instance_t inst = COMPUTE_LIB_INSTANCE_NEW("/dev/dri/renderD128");
+    if (compute_lib_init(&inst) != GL_NO_ERROR) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 3;
+    }
+
+    // synthetic wide-angle camera with barrel distortion and slight tangential distortion
+    compute_lib_shaders_remap_camera_t camera = {
+        .fx = 0.8 * width, .fy = 0.8 * width, .cx = 0.5 * width - 3.5, .cy = 0.5 * height + 2.0,
+        .k1 = -0.28, .k2 = 0.09, .k3 = -0.01, .p1 = 1e-3, .p2 = -6e-4
+    };
+
+    // hardware bilinear filtering may use fixed-point weights (8 bits of sub-texel precision at least)
+    rgba_t* output_img_data = (rgba_t*) calloc(width * height, sizeof(rgba_t));
+    int errors = 0;
+    errors += test_remap(&inst, input_img_data, width, height, &camera, GL_FLOAT, COMPUTE_LIB_SHADERS_WARP_NEAREST, 0.0f, NULL);
+    errors += test_remap(&inst, input_img_data, width, height, &camera, GL_SHORT, COMPUTE_LIB_SHADERS_WARP_NEAREST, 0.0f, NULL);
+    errors += test_remap(&inst, input_img_data, width, height, &camera, GL_SHORT, COMPUTE_LIB_SHADERS_WARP_BILINEAR, 2.0f, NULL);
+    errors += test_remap(&inst, input_img_data, width, height, &camera, GL_FLOAT, COMPUTE_LIB_SHADERS_WARP_BILINEAR, 2.0f, output_img_data);
+    // fixed-point maps cover coordinates up to COMPUTE_LIB_SHADERS_REMAP_FIXED_POINT_MAX_SIZE only
+    if (compute_lib_shaders_remap_init(&inst, LOCAL_SIZE_X, LOCAL_SIZE_Y, COMPUTE_LIB_SHADERS_REMAP_FIXED_POINT_MAX_SIZE + 1, height, width, height, GL_UNSIGNED_BYTE, GL_SHORT,
+                                       COMPUTE_LIB_SHADERS_WARP_NEAREST) != NULL) {
+        fprintf(stderr, "Fixed-point map of a too large input was accepted!\r\n");
+        errors++;
+    }
+    if (errors != 0) {
+        fprintf(stderr, "Remap test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 4;
+    }
+
+    printf("Writing output image: %s\r\n", argv[2]);
+    if (!image_save(argv[2], width, height, 4, (unsigned char*) output_img_data)) {
+        fprintf(stderr, "Failed to write image file!\r\n");
+        return 5;
+    }
+
+    compute_lib_deinit(&inst);
+    free(output_img_data);
+
+    printf("Program Done.\r\n");
+}
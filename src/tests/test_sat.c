@@ -0,0 +1,166 @@
+/// \file test_sat.c
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Test source file for GLES3ComputeLib library implementation of summed-area tables and O(1) box filter.
+/// \copyright GNU Public License.
+
+#include "shaders/sat.h"
+#include "utils/image.h"
+
+#include <math.h>
+
+#define SCAN_LOCAL_SIZE 64
+#define LOCAL_SIZE_X 16
+#define LOCAL_SIZE_Y 16
+
+#define BOX_RADIUS_X 7
+#define BOX_RADIUS_Y 5
+
+// integer tables give exact box sums, only the float division and the float output round
+#define MAX_MEAN_ERROR 1e-3f
+#define MAX_VARIANCE_ERROR 1e-2f
+// float tables: round-off of a table element relative to the sum of the whole image, box statistics are checked against the bound derived from it
+#define MAX_FLOAT_TABLE_ERROR 1e-5f
+
+
+/// Computes summed-area tables and box statistics of the red channel (RGBA8 input) or of the red channel scaled to [0, 1] (R32F input)
+/// and compares them with CPU references.
+static int test_sat(compute_lib_instance_t* inst, rgba_t* img_data, int width, int height, GLenum input_type, unsigned char* output_img_data)
+{
+    compute_lib_shaders_sat_t* sat;
+    if ((sat = compute_lib_shaders_sat_init(inst, SCAN_LOCAL_SIZE, LOCAL_SIZE_X, LOCAL_SIZE_Y, width, height, input_type)) == NULL) {
+        return -1;
+    }
+
+    double* values = (double*) malloc(width * height * sizeof(double));
+    float* float_input = (float*) malloc(width * height * sizeof(float));
+    for (int i = 0; i < width * height; i++) {
+        float_input[i] = img_data[i].r / 255.0f;
+        values[i] = (input_type == GL_FLOAT) ? (double) float_input[i] : (double) img_data[i].r;
+    }
+
+    GLuint errors_cnt = compute_lib_image2d_write(&(sat->input_image2d), (input_type == GL_FLOAT) ? (void*) float_input : (void*) img_data);
+    errors_cnt += compute_lib_shaders_sat_dispatch(sat);
+    errors_cnt += compute_lib_shaders_sat_box_filter(sat, BOX_RADIUS_X, BOX_RADIUS_Y);
+
+    GLuint* sat_data = (GLuint*) calloc(width * height, sizeof(GLuint));
+    vec4_t* box_data = (vec4_t*) calloc(width * height, sizeof(vec4_t));
+    errors_cnt += compute_lib_image2d_read(&(sat->sat_image2d), sat_data);
+    errors_cnt += compute_lib_image2d_read(&(sat->output_image2d), box_data);
+
+    // CPU references: summed-area table (integer one wraps around the same way) and brute-force box statistics
+    double* ref_sat = (double*) calloc(width * height, sizeof(double));
+    GLuint* ref_uint_sat = (GLuint*) calloc(width * height, sizeof(GLuint));
+    double total = 0.0, sqtotal = 0.0;
+    for (int i = 0; i < width * height; i++) {
+        total += values[i];
+        sqtotal += values[i] * values[i];
+    }
+    int sat_mismatches = 0;
+    for (int y = 0; y < height; y++) {
+        double row_sum = 0.0;
+        GLuint row_uint_sum = 0;
+        for (int x = 0; x < width; x++) {
+            row_sum += values[y * width + x];
+            row_uint_sum += img_data[y * width + x].r;
+            ref_sat[y * width + x] = row_sum + (y > 0 ? ref_sat[(y - 1) * width + x] : 0.0);
+            ref_uint_sat[y * width + x] = row_uint_sum + (y > 0 ? ref_uint_sat[(y - 1) * width + x] : 0);
+            if (input_type == GL_FLOAT) {
+                float res = ((float*) sat_data)[y * width + x];
+                sat_mismatches += fabs(res - ref_sat[y * width + x]) > MAX_FLOAT_TABLE_ERROR * total;
+            } else {
+                sat_mismatches += ref_uint_sat[y * width + x] != sat_data[y * width + x];
+            }
+        }
+    }
+
+    float max_mean_error = 0.0f, max_variance_error = 0.0f;
+    int box_mismatches = 0;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            double sum = 0.0, sqsum = 0.0;
+            int count = 0;
+            for (int by = y - BOX_RADIUS_Y; by <= y + BOX_RADIUS_Y; by++) {
+                for (int bx = x - BOX_RADIUS_X; bx <= x + BOX_RADIUS_X; bx++) {
+                    if (bx < 0 || by < 0 || bx >= width || by >= height) continue;
+                    sum += values[by * width + bx];
+                    sqsum += values[by * width + bx] * values[by * width + bx];
+                    count++;
+                }
+            }
+            double mean = sum / count;
+            double variance = sqsum / count - mean * mean;
+            // each box sum combines four table elements
+            double mean_tolerance = (input_type == GL_FLOAT) ? 4.0 * MAX_FLOAT_TABLE_ERROR * total / count : MAX_MEAN_ERROR;
+            double variance_tolerance = (input_type == GL_FLOAT) ? 4.0 * MAX_FLOAT_TABLE_ERROR * sqtotal / count + 2.0 * mean * mean_tolerance : MAX_VARIANCE_ERROR;
+            vec4_t res = box_data[y * width + x];
+            max_mean_error = fmaxf(max_mean_error, fabs(res.y - mean));
+            max_variance_error = fmaxf(max_variance_error, fabs(res.z - variance));
+            box_mismatches += res.w != count || fabs(res.y - mean) > mean_tolerance || fabs(res.z - variance) > variance_tolerance;
+            if (output_img_data != NULL) {
+                output_img_data[y * width + x] = (unsigned char) res.y;
+            }
+        }
+    }
+    printf("%s tables: %d mismatches against CPU reference, box filter %dx%d: maximum mean error %f, maximum variance error %f, %d mismatches\r\n",
+           (input_type == GL_FLOAT) ? "R32F " : "R32UI", sat_mismatches, 2 * BOX_RADIUS_X + 1, 2 * BOX_RADIUS_Y + 1, max_mean_error, max_variance_error, box_mismatches);
+
+    compute_lib_shaders_sat_destroy(sat);
+    free(values);
+    free(float_input);
+    free(sat_data);
+    free(box_data);
+    free(ref_sat);
+    free(ref_uint_sat);
+    return (errors_cnt != GL_NO_ERROR) ? -1 : (sat_mismatches != 0) + (box_mismatches != 0);
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <path to input image> <path to output image>\r\n", argv[0]);
+        return 1;
+    }
+
+    rgba_t* input_img_data;
+    int width, height;
+    printf("Loading image: %s\r\n", argv[1]);
+    if (!image_load(argv[1], &width, &height, 4, (unsigned char**) &input_img_data)) {
+        fprintf(stderr, "Failed to load image file!\r\n");
+        return 2;
+    }
+    printf("Loaded image with size %dx%d px.\r\n", width, height);
+
+    printf("Initializing compute library instance.\r\n");
+    compute_lib_instance_t inst = COMPUTE_LIB_INSTANCE_NEW("/dev/dri/renderD128");
+    if (compute_lib_init(&inst) != GL_NO_ERROR) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 3;
+    }
+
+    unsigned char* output_img_data = (unsigned char*) calloc(width * height, sizeof(unsigned char));
+    int errors = 0;
+    errors += test_sat(&inst, input_img_data, width, height, GL_UNSIGNED_BYTE, output_img_data);
+    errors += test_sat(&inst, input_img_data, width, height, GL_FLOAT, NULL);
+    if (compute_lib_shaders_sat_init(&inst, SCAN_LOCAL_SIZE, LOCAL_SIZE_X, LOCAL_SIZE_Y, width, height, GL_UNSIGNED_SHORT) != NULL) {
+        fprintf(stderr, "Unsupported input type was accepted!\r\n");
+        errors++;
+    }
+    if (errors != 0) {
+        fprintf(stderr, "Summed-area table test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 4;
+    }
+
+    printf("Writing output image: %s\r\n", argv[2]);
+    if (!image_save(argv[2], width, height, 1, output_img_data)) {
+        fprintf(stderr, "Failed to write image file!\r\n");
+        return 5;
+    }
+
+    compute_lib_deinit(&inst);
+    free(output_img_data);
+
+    printf("Program Done.\r\n");
+}
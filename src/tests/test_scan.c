@@ -0,0 +1,189 @@
+/// \file test_scan.c
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Test source file for GLES3ComputeLib library implementation of prefix scans and stream compaction/partition.
+/// \copyright GNU Public License.
+
+#include "shaders/scan.h"
+#include "utils/image.h"
+#include "utils/timer.h"
+
+#define LOCAL_SIZE 256
+
+#define SSBO_LENGTH 20000000
+#define MASK_THRESHOLD 128
+
+
+/// Scans SSBO of small random numbers of the given type (exact also for floats) and compares both scan types with CPU.
+static int test_scan_type(compute_lib_instance_t* inst, GLenum type, GLuint length)
+{
+    compute_lib_shaders_scan_t* scan;
+    if ((scan = compute_lib_shaders_scan_init(inst, LOCAL_SIZE, type, length)) == NULL) {
+        return 1;
+    }
+
+    // 4-byte elements: uint, int or float
+    GLuint* data = (GLuint*) malloc(length * sizeof(GLuint));
+    GLuint* result = (GLuint*) malloc(length * sizeof(GLuint));
+    for (GLuint i = 0; i < length; i++) {
+        int value = rand() % 4 - ((type == GL_INT) ? 2 : 0);
+        if (type == GL_FLOAT) ((GLfloat*) data)[i] = (GLfloat) value;
+        else ((GLint*) data)[i] = value;
+    }
+
+    compute_lib_ssbo_t input_ssbo = COMPUTE_LIB_SSBO_NEW("input_ssbo", type, GL_STATIC_DRAW);
+    compute_lib_ssbo_t output_ssbo = COMPUTE_LIB_SSBO_NEW("output_ssbo", type, GL_DYNAMIC_READ);
+    compute_lib_ssbo_init(&input_ssbo, data, length);
+    compute_lib_ssbo_init(&output_ssbo, NULL, length);
+
+    int mismatches = 0;
+    for (int inclusive = 0; inclusive <= 1; inclusive++) {
+        glFinish();
+        double start = time_now_ms();
+        compute_lib_shaders_scan_dispatch(scan, &input_ssbo, &output_ssbo, length, inclusive);
+        glFinish();
+        double elapsed = time_now_ms() - start;
+        compute_lib_ssbo_read(&output_ssbo, result, length);
+
+        double sum = 0.0;
+        GLuint usum = 0;
+        for (GLuint i = 0; i < length; i++) {
+            if (inclusive) {
+                usum += data[i];
+                sum += (type == GL_FLOAT) ? ((GLfloat*) data)[i] : ((GLint*) data)[i];
+            }
+            if (type == GL_FLOAT) mismatches += ((GLfloat*) result)[i] != (GLfloat) sum;
+            else mismatches += result[i] != usum;
+            if (!inclusive) {
+                usum += data[i];
+                sum += (type == GL_FLOAT) ? ((GLfloat*) data)[i] : ((GLint*) data)[i];
+            }
+        }
+        printf("%s %s scan of %u elements (%d levels): %.3f ms, %d mismatches\r\n", inclusive ? "Inclusive" : "Exclusive", gl3_get_glsl_data_type(type), length, scan->num_levels, elapsed, mismatches);
+    }
+
+    compute_lib_ssbo_destroy(&input_ssbo);
+    compute_lib_ssbo_destroy(&output_ssbo);
+    compute_lib_shaders_scan_destroy(scan);
+    free(data);
+    free(result);
+    return mismatches;
+}
+
+/// Compacts indices of the thresholded image pixels and partitions the pixel values, compares both with CPU.
+static int test_compact(compute_lib_instance_t* inst, rgba_t* img_data, int width, int height, unsigned char* mask_img_data)
+{
+    GLuint length = width * height;
+    compute_lib_shaders_compact_t* compact_indices;
+    compute_lib_shaders_compact_t* partition_values;
+    if ((compact_indices = compute_lib_shaders_compact_init(inst, LOCAL_SIZE, GL_NONE, length)) == NULL ||
+            (partition_values = compute_lib_shaders_compact_init(inst, LOCAL_SIZE, GL_FLOAT, length)) == NULL) {
+        return 1;
+    }
+
+    GLuint* flags = (GLuint*) malloc(length * sizeof(GLuint));
+    GLfloat* values = (GLfloat*) malloc(length * sizeof(GLfloat));
+    GLuint* indices = (GLuint*) malloc(length * sizeof(GLuint));
+    GLfloat* partitioned = (GLfloat*) malloc(length * sizeof(GLfloat));
+    for (GLuint i = 0; i < length; i++) {
+        flags[i] = (img_data[i].r >= MASK_THRESHOLD) ? img_data[i].r : 0;
+        values[i] = (GLfloat) i;
+    }
+
+    compute_lib_ssbo_t flags_ssbo = COMPUTE_LIB_SSBO_NEW("flags_ssbo", GL_UNSIGNED_INT, GL_STATIC_DRAW);
+    compute_lib_ssbo_t values_ssbo = COMPUTE_LIB_SSBO_NEW("values_ssbo", GL_FLOAT, GL_STATIC_DRAW);
+    compute_lib_ssbo_t indices_ssbo = COMPUTE_LIB_SSBO_NEW("indices_ssbo", GL_UNSIGNED_INT, GL_DYNAMIC_READ);
+    compute_lib_ssbo_t partitioned_ssbo = COMPUTE_LIB_SSBO_NEW("partitioned_ssbo", GL_FLOAT, GL_DYNAMIC_READ);
+    compute_lib_ssbo_init(&flags_ssbo, flags, length);
+    compute_lib_ssbo_init(&values_ssbo, values, length);
+    compute_lib_ssbo_init(&indices_ssbo, NULL, length);
+    compute_lib_ssbo_init(&partitioned_ssbo, NULL, length);
+
+    GLuint count = 0, partition_count = 0;
+    compute_lib_shaders_compact_dispatch(compact_indices, &flags_ssbo, NULL, &indices_ssbo, length, GL_FALSE);
+    compute_lib_shaders_compact_read_count(compact_indices, &count);
+    compute_lib_ssbo_read(&indices_ssbo, indices, count);
+    compute_lib_shaders_compact_dispatch(partition_values, &flags_ssbo, &values_ssbo, &partitioned_ssbo, length, GL_TRUE);
+    compute_lib_shaders_compact_read_count(partition_values, &partition_count);
+    compute_lib_ssbo_read(&partitioned_ssbo, partitioned, length);
+
+    // stable order: selected pixels first, rejected pixels after them
+    GLuint ref_count = 0, mismatches = 0;
+    for (GLuint i = 0; i < length; i++) {
+        if (flags[i] != 0) {
+            mismatches += (ref_count >= count) || indices[ref_count] != i;
+            mismatches += partitioned[ref_count] != values[i];
+            ref_count++;
+        }
+        mask_img_data[i] = (flags[i] != 0) ? 255 : 0;
+    }
+    for (GLuint i = 0, j = ref_count; i < length; i++) {
+        if (flags[i] == 0) {
+            mismatches += partitioned[j++] != values[i];
+        }
+    }
+    printf("Compaction of %u pixels: %u selected (CPU %u, partition %u), %u mismatches\r\n", length, count, ref_count, partition_count, mismatches);
+
+    compute_lib_ssbo_destroy(&flags_ssbo);
+    compute_lib_ssbo_destroy(&values_ssbo);
+    compute_lib_ssbo_destroy(&indices_ssbo);
+    compute_lib_ssbo_destroy(&partitioned_ssbo);
+    compute_lib_shaders_compact_destroy(compact_indices);
+    compute_lib_shaders_compact_destroy(partition_values);
+    free(flags);
+    free(values);
+    free(indices);
+    free(partitioned);
+    return mismatches + (count != ref_count) + (partition_count != ref_count);
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <path to input image> <path to output image>\r\n", argv[0]);
+        return 1;
+    }
+
+    rgba_t* input_img_data;
+    int width, height;
+    printf("Loading image: %s\r\n", argv[1]);
+    if (!image_load(argv[1], &width, &height, 4, (unsigned char**) &input_img_data)) {
+        fprintf(stderr, "Failed to load image file!\r\n");
+        return 2;
+    }
+    printf("Loaded image with size %dx%d px.\r\n", width, height);
+
+    printf("Initializing compute library instance.\r\n");
+    compute_lib_instance_t inst = COMPUTE_LIB_INSTANCE_NEW("/dev/dri/renderD128");
+    if (compute_lib_init(&inst) != GL_NO_ERROR) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 3;
+    }
+
+    printf("Running scans.\r\n");
+    if (test_scan_type(&inst, GL_UNSIGNED_INT, SSBO_LENGTH) != 0 || test_scan_type(&inst, GL_INT, SSBO_LENGTH / 10) != 0 || test_scan_type(&inst, GL_FLOAT, SSBO_LENGTH / 10) != 0) {
+        fprintf(stderr, "Scan test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 4;
+    }
+
+    printf("Running compaction.\r\n");
+    unsigned char* output_img_data = (unsigned char*) calloc(width * height, sizeof(unsigned char));
+    if (test_compact(&inst, input_img_data, width, height, output_img_data) != 0) {
+        fprintf(stderr, "Compaction test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 5;
+    }
+
+    printf("Writing output image: %s\r\n", argv[2]);
+    if (!image_save(argv[2], width, height, 1, output_img_data)) {
+        fprintf(stderr, "Failed to write image file!\r\n");
+        return 6;
+    }
+
+    compute_lib_deinit(&inst);
+    free(output_img_data);
+
+    printf("Program Done.\r\n");
+}
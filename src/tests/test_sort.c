@@ -0,0 +1,169 @@
+/// \file test_sort.c
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Test source file for GLES3ComputeLib library implementation of radix sort (including benchmark against CPU qsort).
+/// \copyright GNU Public License.
+
+#include "shaders/sort.h"
+#include "utils/image.h"
+#include "utils/timer.h"
+
+#define LOCAL_SIZE 128
+
+#define BENCHMARK_MIN_LENGTH (1 << 10)
+#define BENCHMARK_MAX_LENGTH (1 << 22)
+
+
+static int compare_uint(const void* a, const void* b)
+{
+    GLuint x = *(const GLuint*) a, y = *(const GLuint*) b;
+    return (x > y) - (x < y);
+}
+
+/// Sorts random keys with their original indices as payload, checks order and stability, compares time with CPU qsort of keys.
+static int test_sort_uint(compute_lib_instance_t* inst, GLuint length, GLuint key_bits)
+{
+    compute_lib_shaders_sort_t* sort;
+    if ((sort = compute_lib_shaders_sort_init(inst, LOCAL_SIZE, GL_UNSIGNED_INT, GL_TRUE, GL_FALSE, length)) == NULL) {
+        return 1;
+    }
+
+    GLuint* keys = (GLuint*) malloc(length * sizeof(GLuint));
+    GLuint* indices = (GLuint*) malloc(length * sizeof(GLuint));
+    GLuint* sorted_keys = (GLuint*) malloc(length * sizeof(GLuint));
+    GLuint* sorted_indices = (GLuint*) malloc(length * sizeof(GLuint));
+    GLuint key_mask = (key_bits == 32) ? 0xFFFFFFFF : ((1u << key_bits) - 1);
+    for (GLuint i = 0; i < length; i++) {
+        keys[i] = (((GLuint) rand() << 16) ^ (GLuint) rand()) & key_mask;
+        indices[i] = i;
+    }
+
+    compute_lib_ssbo_t keys_ssbo = COMPUTE_LIB_SSBO_NEW("keys_ssbo", GL_UNSIGNED_INT, GL_DYNAMIC_COPY);
+    compute_lib_ssbo_t indices_ssbo = COMPUTE_LIB_SSBO_NEW("indices_ssbo", GL_UNSIGNED_INT, GL_DYNAMIC_COPY);
+    compute_lib_ssbo_init(&keys_ssbo, keys, length);
+    compute_lib_ssbo_init(&indices_ssbo, indices, length);
+
+    // warm-up run (programs are compiled lazily by some drivers), the data are uploaded again
+    compute_lib_shaders_sort_dispatch(sort, &keys_ssbo, &indices_ssbo, length, key_bits);
+    compute_lib_ssbo_write(&keys_ssbo, keys, length);
+    compute_lib_ssbo_write(&indices_ssbo, indices, length);
+    glFinish();
+    double start = time_now_ms();
+    compute_lib_shaders_sort_dispatch(sort, &keys_ssbo, &indices_ssbo, length, key_bits);
+    glFinish();
+    double gpu_ms = time_now_ms() - start;
+    compute_lib_ssbo_read(&keys_ssbo, sorted_keys, length);
+    compute_lib_ssbo_read(&indices_ssbo, sorted_indices, length);
+
+    int errors = 0;
+    for (GLuint i = 0; i < length; i++) {
+        errors += sorted_keys[i] != keys[sorted_indices[i]];
+        if (i > 0) {
+            errors += sorted_keys[i - 1] > sorted_keys[i];
+            errors += sorted_keys[i - 1] == sorted_keys[i] && sorted_indices[i - 1] > sorted_indices[i];
+        }
+    }
+
+    start = time_now_ms();
+    qsort(keys, length, sizeof(GLuint), compare_uint);
+    double cpu_ms = time_now_ms() - start;
+    printf("%8u keys (%2u bits): GPU radix sort %9.3f ms, CPU qsort %9.3f ms, %d errors\r\n", length, key_bits, gpu_ms, cpu_ms, errors);
+
+    compute_lib_ssbo_destroy(&keys_ssbo);
+    compute_lib_ssbo_destroy(&indices_ssbo);
+    compute_lib_shaders_sort_destroy(sort);
+    free(keys);
+    free(indices);
+    free(sorted_keys);
+    free(sorted_indices);
+    return errors;
+}
+
+/// Sorts pixel intensities as float keys in descending order without payload.
+static int test_sort_float_descending(compute_lib_instance_t* inst, rgba_t* img_data, GLuint length, rgba_t* output_img_data)
+{
+    compute_lib_shaders_sort_t* sort;
+    if ((sort = compute_lib_shaders_sort_init(inst, LOCAL_SIZE, GL_FLOAT, GL_FALSE, GL_TRUE, length)) == NULL) {
+        return 1;
+    }
+
+    GLfloat* keys = (GLfloat*) malloc(length * sizeof(GLfloat));
+    for (GLuint i = 0; i < length; i++) {
+        keys[i] = (img_data[i].r - 127.5f) / 127.5f;
+    }
+
+    compute_lib_ssbo_t keys_ssbo = COMPUTE_LIB_SSBO_NEW("keys_ssbo", GL_FLOAT, GL_DYNAMIC_COPY);
+    compute_lib_ssbo_init(&keys_ssbo, keys, length);
+    compute_lib_shaders_sort_dispatch(sort, &keys_ssbo, NULL, length, 32);
+    compute_lib_ssbo_read(&keys_ssbo, keys, length);
+
+    int errors = 0;
+    for (GLuint i = 0; i < length; i++) {
+        errors += i > 0 && keys[i - 1] < keys[i];
+        unsigned char value = (unsigned char) (keys[i] * 127.5f + 127.5f);
+        output_img_data[i] = (rgba_t) { value, value, value, 255 };
+    }
+    printf("Image intensities sorted as float keys in descending order: %d errors\r\n", errors);
+
+    compute_lib_ssbo_destroy(&keys_ssbo);
+    compute_lib_shaders_sort_destroy(sort);
+    free(keys);
+    return errors;
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <path to input image> <path to output image>\r\n", argv[0]);
+        return 1;
+    }
+
+    rgba_t* input_img_data;
+    int width, height;
+    printf("Loading image: %s\r\n", argv[1]);
+    if (!image_load(argv[1], &width, &height, 4, (unsigned char**) &input_img_data)) {
+        fprintf(stderr, "Failed to load image file!\r\n");
+        return 2;
+    }
+    printf("Loaded image with size %dx%d px.\r\n", width, height);
+
+    printf("Initializing compute library instance.\r\n");
+    compute_lib_instance_t inst = COMPUTE_LIB_INSTANCE_NEW("/dev/dri/renderD128");
+    if (compute_lib_init(&inst) != GL_NO_ERROR) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 3;
+    }
+
+    printf("Benchmarking GPU radix sort vs. CPU qsort:\r\n");
+    for (GLuint length = BENCHMARK_MIN_LENGTH; length <= BENCHMARK_MAX_LENGTH; length *= 4) {
+        if (test_sort_uint(&inst, length + 17, 32) != 0) {
+            fprintf(stderr, "Radix sort test failed!\r\n");
+            compute_lib_error_queue_flush(&inst, stderr);
+            return 4;
+        }
+    }
+    if (test_sort_uint(&inst, BENCHMARK_MAX_LENGTH, 16) != 0) {
+        fprintf(stderr, "Radix sort test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 4;
+    }
+
+    rgba_t* output_img_data = (rgba_t*) calloc(width * height, sizeof(rgba_t));
+    if (test_sort_float_descending(&inst, input_img_data, width * height, output_img_data) != 0) {
+        fprintf(stderr, "Float radix sort test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 5;
+    }
+
+    printf("Writing output image: %s\r\n", argv[2]);
+    if (!image_save(argv[2], width, height, 4, (unsigned char*) output_img_data)) {
+        fprintf(stderr, "Failed to write image file!\r\n");
+        return 6;
+    }
+
+    compute_lib_deinit(&inst);
+    free(output_img_data);
+
+    printf("Program Done.\r\n");
+}
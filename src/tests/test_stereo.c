@@ -0,0 +1,264 @@
+/// \file test_stereo.c
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Test source file for GLES3ComputeLib library implementation of stereo block matching (output image is the disparity of a synthetic pair, invalid pixels are red).
+/// \copyright GNU Public License.
+
+#include "shaders/stereo.h"
+#include "utils/image.h"
+#include "utils/timer.h"
+
+#include <math.h>
+#include <stdint.h>
+
+#define LOCAL_SIZE_X 16
+#define LOCAL_SIZE_Y 8
+
+// disparities of the synthetic scene (foreground rectangle over the background plane)
+#define FOREGROUND_DISPARITY 14
+#define BACKGROUND_DISPARITY 5
+
+
+static int clampi(int value, int low, int high)
+{
+    return (value < low) ? low : ((value > high) ? high : value);
+}
+
+static GLuint luma(rgba_t px)
+{
+    return (77 * px.r + 150 * px.g + 29 * px.b + 128) >> 8;
+}
+
+/// Computes luma or 5x5 census features on CPU.
+static void features_reference(const rgba_t* img_data, int width, int height, GLenum method, GLuint* features)
+{
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            GLuint center = luma(img_data[y * width + x]), bits = 0, bit = 0;
+            for (int j = -2; j <= 2 && method == COMPUTE_LIB_SHADERS_STEREO_CENSUS; j++) {
+                for (int i = -2; i <= 2; i++) {
+                    if (i != 0 || j != 0) {
+                        bits |= (GLuint) (luma(img_data[clampi(y + j, 0, height - 1) * width + clampi(x + i, 0, width - 1)]) < center) << bit;
+                        bit++;
+                    }
+                }
+            }
+            features[y * width + x] = (method == COMPUTE_LIB_SHADERS_STEREO_CENSUS) ? bits : center;
+        }
+    }
+}
+
+static int subpixel_offset(GLuint previous, GLuint best, GLuint next)
+{
+    int curvature = (int) previous - 2 * (int) best + (int) next;
+    if (curvature <= 0) {
+        return 0;
+    }
+    int n = 16 * ((int) previous - (int) next) + curvature, d = 2 * curvature;
+    int offset = (n >= 0) ? n / d : -((d - 1 - n) / d);
+    return clampi(offset, -8, 8);
+}
+
+/// Computes disparities (with fractional bits) and block costs on CPU, the reference image matches the other one at x - d (left) or x + d (right).
+static void match_reference(const GLuint* reference, const GLuint* other, int width, int height, GLenum method, int block_size, int min_disparity, int num_disparities,
+                            int direction, GLushort* disparity)
+{
+    int r = block_size / 2;
+    GLuint* costs = (GLuint*) malloc(num_disparities * sizeof(GLuint));
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int best = -1;
+            for (int k = 0; k < num_disparities; k++) {
+                int d = min_disparity + k;
+                costs[k] = 0xFFFFFFFF;
+                if (x + direction * d < 0 || x + direction * d >= width) {
+                    continue;
+                }
+                GLuint cost = 0;
+                for (int j = -r; j <= r; j++) {
+                    int yy = clampi(y + j, 0, height - 1);
+                    for (int i = -r; i <= r; i++) {
+                        GLuint a = reference[yy * width + clampi(x + i, 0, width - 1)], b = other[yy * width + clampi(x + i + direction * d, 0, width - 1)];
+                        cost += (method == COMPUTE_LIB_SHADERS_STEREO_CENSUS) ? (GLuint) __builtin_popcount(a ^ b) : (GLuint) abs((int) a - (int) b);
+                    }
+                }
+                costs[k] = cost;
+                if (best < 0 || cost < costs[best]) {
+                    best = k;
+                }
+            }
+            GLushort* px = &disparity[4 * (y * width + x)];
+            px[0] = COMPUTE_LIB_SHADERS_STEREO_INVALID_DISPARITY;
+            px[1] = 65535;
+            if (best >= 0) {
+                int offset = (best > 0 && best < num_disparities - 1 && costs[best - 1] != 0xFFFFFFFF && costs[best + 1] != 0xFFFFFFFF) ? subpixel_offset(costs[best - 1], costs[best], costs[best + 1]) : 0;
+                int value = (min_disparity + best) * 16 + offset;
+                px[0] = (GLushort) ((value < 0) ? 0 : value);
+                px[1] = (GLushort) ((costs[best] > 65535) ? 65535 : costs[best]);
+            }
+        }
+    }
+    free(costs);
+}
+
+/// Invalidates left disparities inconsistent with the right ones on CPU.
+static void check_reference(GLushort* left, const GLushort* right, int width, int height, GLuint max_difference)
+{
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            GLushort* px = &left[4 * (y * width + x)];
+            if (px[0] != COMPUTE_LIB_SHADERS_STEREO_INVALID_DISPARITY) {
+                int matched_x = x - (px[0] + 8) / 16;
+                GLuint r = (matched_x >= 0) ? right[4 * (y * width + matched_x)] : COMPUTE_LIB_SHADERS_STEREO_INVALID_DISPARITY;
+                if (r == COMPUTE_LIB_SHADERS_STEREO_INVALID_DISPARITY || (GLuint) abs((int) px[0] - (int) r) > max_difference) {
+                    px[0] = COMPUTE_LIB_SHADERS_STEREO_INVALID_DISPARITY;
+                }
+            }
+        }
+    }
+}
+
+/// Renders the right view of a synthetic scene: left image as the background plane and its central part as the foreground rectangle.
+static void render_right(const rgba_t* left_img_data, int width, int height, rgba_t* right_img_data, unsigned char* ground_truth)
+{
+    int x0 = width / 3, x1 = 2 * width / 3, y0 = height / 4, y1 = 3 * height / 4;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int foreground_x = x + FOREGROUND_DISPARITY;
+            if (y >= y0 && y < y1 && foreground_x >= x0 && foreground_x < x1) {
+                right_img_data[y * width + x] = left_img_data[y * width + foreground_x];
+            } else {
+                right_img_data[y * width + x] = left_img_data[y * width + clampi(x + BACKGROUND_DISPARITY, 0, width - 1)];
+            }
+            // ground truth of the left view, 0 for background pixels occluded in the right view
+            int background_x = x - BACKGROUND_DISPARITY + FOREGROUND_DISPARITY;
+            if (y >= y0 && y < y1 && x >= x0 && x < x1) {
+                ground_truth[y * width + x] = FOREGROUND_DISPARITY;
+            } else if (y >= y0 && y < y1 && background_x >= x0 && background_x < x1) {
+                ground_truth[y * width + x] = 0;
+            } else {
+                ground_truth[y * width + x] = BACKGROUND_DISPARITY;
+            }
+        }
+    }
+}
+
+/// Matches the synthetic stereo pair, compares the disparity with CPU and evaluates it against the ground truth.
+static int test_stereo(compute_lib_instance_t* inst, rgba_t* img_data, int width, int height, GLenum method, int block_size, int min_disparity, int num_disparities,
+                       GLboolean lr_check, rgba_t* output_img_data)
+{
+    compute_lib_shaders_stereo_t* stereo;
+    if ((stereo = compute_lib_shaders_stereo_init(inst, LOCAL_SIZE_X, LOCAL_SIZE_Y, width, height, method, block_size, min_disparity, num_disparities, lr_check)) == NULL) {
+        return -1;
+    }
+
+    rgba_t* right_img_data = (rgba_t*) malloc(width * height * sizeof(rgba_t));
+    unsigned char* ground_truth = (unsigned char*) malloc(width * height);
+    GLushort* disparity = (GLushort*) malloc(4 * width * height * sizeof(GLushort));
+    GLushort* expected = (GLushort*) malloc(4 * width * height * sizeof(GLushort));
+    GLushort* expected_right = (GLushort*) malloc(4 * width * height * sizeof(GLushort));
+    GLuint* left_features = (GLuint*) malloc(width * height * sizeof(GLuint));
+    GLuint* right_features = (GLuint*) malloc(width * height * sizeof(GLuint));
+    render_right(img_data, width, height, right_img_data, ground_truth);
+
+    GLuint errors_cnt = compute_lib_image2d_write(&(stereo->left_input_image2d), img_data);
+    errors_cnt += compute_lib_image2d_write(&(stereo->right_input_image2d), right_img_data);
+    errors_cnt += compute_lib_shaders_stereo_dispatch(stereo, 1.0f);
+    glFinish();
+    double start = time_now_ms();
+    errors_cnt += compute_lib_shaders_stereo_dispatch(stereo, 1.0f);
+    errors_cnt += compute_lib_image2d_read(&(stereo->output_image2d), disparity);
+    double gpu_ms = time_now_ms() - start;
+
+    start = time_now_ms();
+    features_reference(img_data, width, height, method, left_features);
+    features_reference(right_img_data, width, height, method, right_features);
+    match_reference(left_features, right_features, width, height, method, block_size, min_disparity, num_disparities, -1, expected);
+    if (lr_check) {
+        match_reference(right_features, left_features, width, height, method, block_size, min_disparity, num_disparities, 1, expected_right);
+        check_reference(expected, expected_right, width, height, 16);
+    }
+    double cpu_ms = time_now_ms() - start;
+
+    // exact comparison with CPU, accuracy of the visible pixels and invalidation of the occluded ones
+    int errors = 0, visible = 0, correct = 0, occluded = 0, invalidated = 0;
+    for (int i = 0; i < width * height; i++) {
+        errors += disparity[4 * i] != expected[4 * i] || disparity[4 * i + 1] != expected[4 * i + 1];
+        if (ground_truth[i] == 0) {
+            occluded++;
+            invalidated += disparity[4 * i] == COMPUTE_LIB_SHADERS_STEREO_INVALID_DISPARITY;
+        } else if (i % width >= min_disparity + num_disparities) {
+            visible++;
+            correct += disparity[4 * i] != COMPUTE_LIB_SHADERS_STEREO_INVALID_DISPARITY && abs(disparity[4 * i] - 16 * ground_truth[i]) <= 16;
+        }
+    }
+    errors += correct < 0.9 * visible || (lr_check && invalidated < 0.5 * occluded);
+    printf("%-6s %2dx%-2d block, disparities %2d-%2d, LR check %d: %5.1f %% visible correct, %5.1f %% occluded invalidated, GPU %8.3f ms, CPU %9.3f ms, %d errors\r\n",
+           (method == COMPUTE_LIB_SHADERS_STEREO_CENSUS) ? "census" : "SAD", block_size, block_size, min_disparity, min_disparity + num_disparities - 1, lr_check,
+           100.0 * correct / visible, 100.0 * invalidated / occluded, gpu_ms, cpu_ms, errors);
+
+    if (output_img_data != NULL) {
+        for (int i = 0; i < width * height; i++) {
+            unsigned char value = (unsigned char) clampi(disparity[4 * i] * 255 / (16 * (min_disparity + num_disparities)), 0, 255);
+            output_img_data[i] = (disparity[4 * i] == COMPUTE_LIB_SHADERS_STEREO_INVALID_DISPARITY) ? (rgba_t) { 255, 0, 0, 255 } : (rgba_t) { value, value, value, 255 };
+        }
+    }
+
+    compute_lib_shaders_stereo_destroy(stereo);
+    free(right_img_data);
+    free(ground_truth);
+    free(disparity);
+    free(expected);
+    free(expected_right);
+    free(left_features);
+    free(right_features);
+    return (errors_cnt != GL_NO_ERROR) ? -1 : errors;
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <path to input image> <path to output image>\r\n", argv[0]);
+        return 1;
+    }
+
+    rgba_t* input_img_data;
+    int width, height;
+    printf("Loading image: %s\r\n", argv[1]);
+    if (!image_load(argv[1], &width, &height, 4, (unsigned char**) &input_img_data)) {
+        fprintf(stderr, "Failed to load image file!\r\n");
+        return 2;
+    }
+    printf("Loaded image with size %dx%d px.\r\n", width, height);
+
+    printf("Initializing compute library instance.\r\n");
+    compute_lib_instance_t inst = COMPUTE_LIB_INSTANCE_NEW("/dev/dri/renderD128");
+    if (compute_lib_init(&inst) != GL_NO_ERROR) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 3;
+    }
+
+    rgba_t* output_img_data = (rgba_t*) malloc(width * height * sizeof(rgba_t));
+    int errors = 0;
+    errors += test_stereo(&inst, input_img_data, width, height, COMPUTE_LIB_SHADERS_STEREO_SAD, 7, 0, 32, GL_FALSE, NULL);
+    errors += test_stereo(&inst, input_img_data, width, height, COMPUTE_LIB_SHADERS_STEREO_SAD, 9, 2, 24, GL_TRUE, NULL);
+    errors += test_stereo(&inst, input_img_data, width, height, COMPUTE_LIB_SHADERS_STEREO_CENSUS, 5, 0, 32, GL_FALSE, NULL);
+    errors += test_stereo(&inst, input_img_data, width, height, COMPUTE_LIB_SHADERS_STEREO_CENSUS, 7, 0, 48, GL_TRUE, output_img_data);
+    if (errors != 0) {
+        fprintf(stderr, "Stereo block matching test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 4;
+    }
+
+    printf("Writing output image: %s\r\n", argv[2]);
+    if (!image_save(argv[2], width, height, 4, (unsigned char*) output_img_data)) {
+        fprintf(stderr, "Failed to write image file!\r\n");
+        return 5;
+    }
+
+    compute_lib_deinit(&inst);
+    free(output_img_data);
+
+    printf("Program Done.\r\n");
+}
@@ -0,0 +1,228 @@
+/// \file test_warp.c
+/// \author Vojtech Vrba (vrba.vojtech [at] fel.cvut.cz)
+/// \date May 2023
+/// \brief Test source file for GLES3ComputeLib library implementation of image resizing and warps (output image is the input rotated about its centre).
+/// \copyright GNU Public License.
+
+#include "shaders/warp.h"
+#include "utils/image.h"
+
+#include <math.h>
+
+#define LOCAL_SIZE_X 16
+#define LOCAL_SIZE_Y 16
+
+/// Maximum fraction of output components differing from the CPU reference by more than the tolerance (rounding of mapped coordinates may differ).
+#define MAX_MISMATCH_RATIO 1e-3
+
+
+static inline float input_value(rgba_t* img_data, int width, int height, int x, int y, int c, const float* border)
+{
+    if (x < 0 || y < 0 || x >= width || y >= height) {
+        return border[c] * 255.0f;
+    }
+    return ((unsigned char*) &img_data[y * width + x])[c];
+}
+
+/// Computes one component of the resized image on CPU.
+static float resize_reference(rgba_t* img_data, int width, int height, int output_width, int output_height, int x, int y, int c, GLenum method)
+{
+    float sx = (float) width / output_width, sy = (float) height / output_height;
+    if (method == COMPUTE_LIB_SHADERS_WARP_NEAREST) {
+        int px = (int) ((x + 0.5f) * sx), py = (int) ((y + 0.5f) * sy);
+        return input_value(img_data, width, height, px < width ? px : width - 1, py < height ? py : height - 1, c, NULL);
+    }
+    if (method == COMPUTE_LIB_SHADERS_WARP_BILINEAR) {
+        float fx = (x + 0.5f) * sx - 0.5f, fy = (y + 0.5f) * sy - 0.5f;
+        fx = (fx < 0.0f) ? 0.0f : ((fx > width - 1) ? width - 1 : fx);
+        fy = (fy < 0.0f) ? 0.0f : ((fy > height - 1) ? height - 1 : fy);
+        int x0 = (int) fx, y0 = (int) fy;
+        int x1 = (x0 + 1 < width) ? x0 + 1 : x0, y1 = (y0 + 1 < height) ? y0 + 1 : y0;
+        float ax = fx - x0, ay = fy - y0;
+        float top = input_value(img_data, width, height, x0, y0, c, NULL) * (1 - ax) + input_value(img_data, width, height, x1, y0, c, NULL) * ax;
+        float bottom = input_value(img_data, width, height, x0, y1, c, NULL) * (1 - ax) + input_value(img_data, width, height, x1, y1, c, NULL) * ax;
+        return top * (1 - ay) + bottom * ay;
+    }
+    float res = 0.0f;
+    float start_x = x * sx, start_y = y * sy;
+    float end_x = fminf(start_x + sx, width), end_y = fminf(start_y + sy, height);
+    for (int py = (int) start_y; py < end_y; py++) {
+        float wy = fminf(end_y, py + 1) - fmaxf(start_y, py);
+        for (int px = (int) start_x; px < end_x; px++) {
+            float wx = fminf(end_x, px + 1) - fmaxf(start_x, px);
+            res += wx * wy * input_value(img_data, width, height, px, py, c, NULL);
+        }
+    }
+    return res / (sx * sy);
+}
+
+/// Computes one component of the warped image on CPU (inverse is row-major 3x3 matrix mapping output to input coordinates).
+static float warp_reference(rgba_t* img_data, int width, int height, const double* inverse, int x, int y, int c, GLenum method, const float* border)
+{
+    double z = inverse[6] * x + inverse[7] * y + inverse[8];
+    float fx = (float) ((inverse[0] * x + inverse[1] * y + inverse[2]) / z);
+    float fy = (float) ((inverse[3] * x + inverse[4] * y + inverse[5]) / z);
+    if (method == COMPUTE_LIB_SHADERS_WARP_NEAREST) {
+        return input_value(img_data, width, height, (int) floorf(fx + 0.5f), (int) floorf(fy + 0.5f), c, border);
+    }
+    if (fx <= -1.0f || fy <= -1.0f || fx >= width || fy >= height) {
+        return border[c] * 255.0f;
+    }
+    int x0 = (int) floorf(fx), y0 = (int) floorf(fy);
+    float ax = fx - x0, ay = fy - y0;
+    float top = input_value(img_data, width, height, x0, y0, c, border) * (1 - ax) + input_value(img_data, width, height, x0 + 1, y0, c, border) * ax;
+    float bottom = input_value(img_data, width, height, x0, y0 + 1, c, border) * (1 - ax) + input_value(img_data, width, height, x0 + 1, y0 + 1, c, border) * ax;
+    return top * (1 - ay) + bottom * ay;
+}
+
+static int check_mismatches(const char* name, int mismatches, int length, float max_error)
+{
+    printf("%s: max. error %g, %d of %d components above tolerance\r\n", name, max_error, mismatches, length);
+    return mismatches > length * MAX_MISMATCH_RATIO;
+}
+
+static int test_resize(compute_lib_instance_t* inst, rgba_t* img_data, int width, int height, int output_width, int output_height, GLenum method, float tolerance)
+{
+    compute_lib_shaders_resize_t* resize;
+    if ((resize = compute_lib_shaders_resize_init(inst, LOCAL_SIZE_X, LOCAL_SIZE_Y, width, height, output_width, output_height, GL_UNSIGNED_BYTE, method)) == NULL) {
+        return 1;
+    }
+
+    unsigned char* output_data = (unsigned char*) malloc(output_width * output_height * 4);
+    if (compute_lib_image2d_write(&(resize->input_image2d), img_data) != GL_NO_ERROR ||
+            compute_lib_shaders_resize_dispatch(resize) != GL_NO_ERROR ||
+            compute_lib_image2d_read(&(resize->output_image2d), output_data) != GL_NO_ERROR) {
+        compute_lib_shaders_resize_destroy(resize);
+        free(output_data);
+        return 1;
+    }
+
+    int mismatches = 0;
+    float max_error = 0.0f;
+    for (int i = 0; i < 4 * output_width * output_height; i++) {
+        int p = i / 4;
+        float error = fabsf(output_data[i] - resize_reference(img_data, width, height, output_width, output_height, p % output_width, p / output_width, i % 4, method));
+        max_error = fmaxf(error, max_error);
+        mismatches += error > tolerance;
+    }
+
+    char name[64];
+    const char* method_names[] = { "nearest", "bilinear", "area" };
+    snprintf(name, sizeof(name), "Resize %dx%d -> %dx%d (%s)", width, height, output_width, output_height, method_names[method]);
+
+    compute_lib_shaders_resize_destroy(resize);
+    free(output_data);
+    return check_mismatches(name, mismatches, 4 * output_width * output_height, max_error);
+}
+
+/// Rotates the image about its centre and tilts it by a perspective term, output is saved for the bilinear method.
+static int test_warp(compute_lib_instance_t* inst, rgba_t* img_data, int width, int height, GLenum method, GLboolean perspective, float tolerance, rgba_t* output_img_data)
+{
+    compute_lib_shaders_warp_t* warp;
+    if ((warp = compute_lib_shaders_warp_init(inst, LOCAL_SIZE_X, LOCAL_SIZE_Y, width, height, width, height, GL_UNSIGNED_BYTE, method)) == NULL) {
+        return 1;
+    }
+
+    const float border[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    float angle = 30.0f * (float) M_PI / 180.0f, cx = width / 2.0f, cy = height / 2.0f;
+    float matrix[9] = {
+        cosf(angle), -sinf(angle), cx - cx * cosf(angle) + cy * sinf(angle),
+        sinf(angle), cosf(angle), cy - cx * sinf(angle) - cy * cosf(angle),
+        perspective ? 2e-4f : 0.0f, perspective ? -1e-4f : 0.0f, 1.0f
+    };
+    double m[9], inverse[9];
+    for (int i = 0; i < 9; i++) {
+        m[i] = matrix[i];
+    }
+    compute_lib_shaders_warp_invert(m, inverse);
+
+    unsigned char* output_data = (unsigned char*) malloc(width * height * 4);
+    GLuint errors_cnt = compute_lib_image2d_write(&(warp->input_image2d), img_data);
+    errors_cnt += perspective ? compute_lib_shaders_warp_perspective(warp, matrix, border) : compute_lib_shaders_warp_affine(warp, matrix, border);
+    errors_cnt += compute_lib_image2d_read(&(warp->output_image2d), output_data);
+    if (errors_cnt != GL_NO_ERROR) {
+        compute_lib_shaders_warp_destroy(warp);
+        free(output_data);
+        return 1;
+    }
+
+    int mismatches = 0;
+    float max_error = 0.0f;
+    for (int i = 0; i < 4 * width * height; i++) {
+        int p = i / 4;
+        float error = fabsf(output_data[i] - warp_reference(img_data, width, height, inverse, p % width, p / width, i % 4, method, border));
+        max_error = fmaxf(error, max_error);
+        mismatches += error > tolerance;
+    }
+    if (output_img_data != NULL) {
+        memcpy(output_img_data, output_data, width * height * 4);
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "Warp %s (%s)", perspective ? "perspective" : "affine", (method == COMPUTE_LIB_SHADERS_WARP_NEAREST) ? "nearest" : "bilinear");
+
+    compute_lib_shaders_warp_destroy(warp);
+    free(output_data);
+    return check_mismatches(name, mismatches, 4 * width * height, max_error);
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <path to input image> <path to output image>\r\n", argv[0]);
+        return 1;
+    }
+
+    rgba_t* input_img_data;
+    int width, height;
+    printf("Loading image: %s\r\n", argv[1]);
+    if (!image_load(argv[1], &width, &height, 4, (unsigned char**) &input_img_data)) {
+        fprintf(stderr, "Failed to load image file!\r\n");
+        return 2;
+    }
+    printf("Loaded image with size %dx%d px.\r\n", width, height);
+
+    printf("Initializing compute library instance.\r\n");
+    compute_lib_instance_t inst = COMPUTE_LIB_INSTANCE_NEW("/dev/dri/renderD128");
+    if (compute_lib_init(&inst) != GL_NO_ERROR) {
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 3;
+    }
+
+    // hardware bilinear filtering may use fixed-point weights (8 bits of sub-texel precision at least)
+    int errors = 0;
+    errors += test_resize(&inst, input_img_data, width, height, width * 2 / 3 + 1, height / 2 + 3, COMPUTE_LIB_SHADERS_WARP_NEAREST, 0.0f);
+    errors += test_resize(&inst, input_img_data, width, height, width * 2 / 3 + 1, height / 2 + 3, COMPUTE_LIB_SHADERS_WARP_BILINEAR, 2.0f);
+    errors += test_resize(&inst, input_img_data, width, height, width * 2 / 3 + 1, height / 2 + 3, COMPUTE_LIB_SHADERS_WARP_AREA, 1.0f);
+    errors += test_resize(&inst, input_img_data, width, height, width / 4, height / 4, COMPUTE_LIB_SHADERS_WARP_AREA, 1.0f);
+    errors += test_resize(&inst, input_img_data, width, height, width * 3 / 2, height * 5 / 3, COMPUTE_LIB_SHADERS_WARP_BILINEAR, 2.0f);
+    errors += test_resize(&inst, input_img_data, width, height, width * 3 / 2, height * 5 / 3, COMPUTE_LIB_SHADERS_WARP_AREA, 1.0f);
+    if (errors != 0) {
+        fprintf(stderr, "Resize test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 4;
+    }
+
+    rgba_t* output_img_data = (rgba_t*) calloc(width * height, sizeof(rgba_t));
+    errors += test_warp(&inst, input_img_data, width, height, COMPUTE_LIB_SHADERS_WARP_NEAREST, GL_FALSE, 0.0f, NULL);
+    errors += test_warp(&inst, input_img_data, width, height, COMPUTE_LIB_SHADERS_WARP_NEAREST, GL_TRUE, 0.0f, NULL);
+    errors += test_warp(&inst, input_img_data, width, height, COMPUTE_LIB_SHADERS_WARP_BILINEAR, GL_TRUE, 2.0f, NULL);
+    errors += test_warp(&inst, input_img_data, width, height, COMPUTE_LIB_SHADERS_WARP_BILINEAR, GL_FALSE, 2.0f, output_img_data);
+    if (errors != 0) {
+        fprintf(stderr, "Warp test failed!\r\n");
+        compute_lib_error_queue_flush(&inst, stderr);
+        return 5;
+    }
+
+    printf("Writing output image: %s\r\n", argv[2]);
+    if (!image_save(argv[2], width, height, 4, (unsigned char*) output_img_data)) {
+        fprintf(stderr, "Failed to write image file!\r\n");
+        return 6;
+    }
+
+    compute_lib_deinit(&inst);
+    free(output_img_data);
+
+    printf("Program Done.\r\n");
+}